@@ -0,0 +1,722 @@
+/**
+ * @file SentinelBench.cpp
+ * @brief Micro-benchmarks for Sentinel's performance-critical paths.
+ *
+ * @details Each benchmark runs a fixed number of timed iterations after a warm-up pass and
+ * reports the best and median iteration time together with a throughput figure:
+ * @code
+ * handle-filter/avx2      synthetic   500000 handles  best 0.412 ms  median 0.430 ms  1213.6 M handles/s  (budget 5 ms: ok)
+ * @endcode
+ *
+ * Benchmarks:
+ * - handle-filter: HandleFilter kernels over a synthetic table of the requested size and,
+ *   when NtQuerySystemInformation is available, over a live snapshot of this machine's
+ *   handle table. A full scan is expected to stay within a 5 ms budget.
+ * - handle-snapshot: ResourceAuditor::Snapshot on the live system.
+ * - region-hash: RegionHash SHA-256 and CRC32C kernels over a 16 MB buffer, the size of
+ *   a large module's code section.
+ * - handle-index: HandleIndex::Update diffing an unchanged synthetic table, the steady
+ *   state of every audit pass.
+ * - wire-batch: BatchEncoder/BatchDecoder round trip of small telemetry records, sealed
+ *   per record (the per-message framing of Module D) and per 32 KB batch, with and
+ *   without compression. Also reports frame bytes per record, and the round trip of a
+ *   metrics request answered by MetricsResponder.
+ * - vm-dispatch: an arithmetic loop through the interpreter, unverified (checked
+ *   handlers) and verified (unchecked handlers, superinstructions fused).
+ * - logger: end-to-end asynchronous Logger throughput (enqueue, consumer, file sink) for
+ *   1 to 64 producer threads, with the Block overflow policy so no record is dropped.
+ * - exception: RaiseException round trips without the Vectored Exception Handler, then
+ *   through HandlerRoutine with a filtered and with an interesting code. The handler's
+ *   own cost on the interesting path is reported from the crash.handler_ns metric, which
+ *   the filtered code must leave unchanged.
+ *
+ * With --json, every result is also written to a file for regression tracking between
+ * releases:
+ * @code
+ * {"tool": "SentinelBench", "iterations": 50, ..., "results": [
+ *   {"name": "handle-filter/avx2", "dataset": "synthetic", "unit": "handles", "items": 500000,
+ *    "bestMs": 0.412, "medianMs": 0.430, "perSecond": 1.16279e+09, "nsPerItem": 0.86,
+ *    "budgetMs": 5, "withinBudget": true}, ...]}
+ * @endcode
+ *
+ * The logger and exception benchmarks send log output to a file sink under %TEMP%\SentinelBench
+ * so that the console only shows results.
+ *
+ * Usage: SentinelBench [--json results.json] [synthetic-handle-count]
+ */
+
+#include "Sentinel/Bedrock/CrashInterceptor.hpp"
+#include "Sentinel/Comms/BatchCodec.hpp"
+#include "Sentinel/Comms/MetricsSnapshot.hpp"
+#include "Sentinel/Internals/HandleFilter.hpp"
+#include "Sentinel/Internals/HandleIndex.hpp"
+#include "Sentinel/Internals/ResourceAuditor.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+#include "Sentinel/Utils/Metrics.hpp"
+#include "Sentinel/Virtualization/Interpreter.hpp"
+#include "Sentinel/Virtualization/RegionHash.hpp"
+#include "Sentinel/Virtualization/Verifier.hpp"
+#include <Windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace Sentinel::Bedrock;
+using namespace Sentinel::Comms;
+using namespace Sentinel::Internals;
+using namespace Sentinel::Utils;
+using namespace Sentinel::Virtualization;
+
+// Timed iterations per benchmark, after one untimed warm-up
+static constexpr int ITERATIONS = 50;
+
+// Latency target for one full handle table scan
+static constexpr double SCAN_BUDGET_MS = 5.0;
+
+// Region hashed by the region-hash benchmarks
+static constexpr size_t HASH_REGION_BYTES = 16 * 1024 * 1024;
+
+// Records per iteration of the wire-batch benchmarks
+static constexpr size_t WIRE_RECORD_COUNT = 20000;
+
+// Metrics requests answered per iteration of the wire-batch/metrics benchmark
+static constexpr size_t METRICS_REQUEST_COUNT = 100;
+
+// Loop iterations per run of the vm-dispatch benchmarks (VM_LOOP_INSTRUCTIONS each)
+static constexpr uint64_t VM_LOOP_ITERATIONS = 1 << 18;
+static constexpr uint64_t VM_LOOP_INSTRUCTIONS = 18;
+
+// Records per iteration of the logger benchmarks, split across the producers. Each
+// iteration starts its threads, so fewer iterations are timed than elsewhere.
+static constexpr size_t LOGGER_RECORD_COUNT = 65536;
+static constexpr int LOGGER_ITERATIONS = 10;
+
+// Exceptions raised per iteration of the exception benchmarks
+static constexpr size_t EXCEPTION_COUNT = 1000;
+
+// Neither tracked nor interesting: counted as OTHER and passed on by the fast path
+static constexpr DWORD FILTERED_EXCEPTION_CODE = 0xE0424E43;
+
+struct BenchResult {
+    const char* name;
+    const char* dataset;
+    const char* unit;
+    size_t items;
+    double bestMs;
+    double medianMs;
+};
+
+static double ElapsedMs(const LARGE_INTEGER& start, const LARGE_INTEGER& end) {
+    static const double frequency = []() {
+        LARGE_INTEGER value;
+        QueryPerformanceFrequency(&value);
+        return static_cast<double>(value.QuadPart);
+    }();
+    return static_cast<double>(end.QuadPart - start.QuadPart) * 1000.0 / frequency;
+}
+
+// Best and median of per-iteration times
+static BenchResult Summarize(const char* name, const char* dataset, const char* unit, size_t items,
+                             std::vector<double>& samples) {
+    std::sort(samples.begin(), samples.end());
+    return BenchResult{name, dataset, unit, items, samples.front(), samples[samples.size() / 2]};
+}
+
+// Runs body() ITERATIONS times and summarizes the per-iteration times
+template <typename Body>
+static BenchResult Measure(const char* name, const char* dataset, const char* unit, size_t items, Body&& body) {
+    body();
+
+    std::vector<double> samples;
+    samples.reserve(ITERATIONS);
+    for (int i = 0; i < ITERATIONS; ++i) {
+        LARGE_INTEGER start;
+        LARGE_INTEGER end;
+        QueryPerformanceCounter(&start);
+        body();
+        QueryPerformanceCounter(&end);
+        samples.push_back(ElapsedMs(start, end));
+    }
+    return Summarize(name, dataset, unit, items, samples);
+}
+
+// Everything reported, for --json
+struct ReportedResult {
+    BenchResult result;
+    double budgetMs;
+};
+static std::vector<ReportedResult> reported;
+
+static double PerSecond(const BenchResult& result) {
+    return result.medianMs > 0.0 ? static_cast<double>(result.items) * 1000.0 / result.medianMs : 0.0;
+}
+
+static void Report(const BenchResult& result, double budgetMs) {
+    reported.push_back(ReportedResult{result, budgetMs});
+    const double perSecond = PerSecond(result);
+    std::printf("%-22s  %-10s  %8zu %s  best %.3f ms  median %.3f ms  %.1f M %s/s", result.name, result.dataset,
+                result.items, result.unit, result.bestMs, result.medianMs, perSecond / 1e6, result.unit);
+    if (budgetMs > 0.0) {
+        std::printf("  (budget %.0f ms: %s)", budgetMs, result.medianMs <= budgetMs ? "ok" : "EXCEEDED");
+    }
+    std::printf("\n");
+}
+
+// Names, datasets and units are string literals of this file, so they need no escaping
+static bool WriteJson(const wchar_t* path) {
+    FILE* file = nullptr;
+    if (_wfopen_s(&file, path, L"w") != 0 || file == nullptr) {
+        std::printf("Cannot open %ls for writing\n", path);
+        return false;
+    }
+    SYSTEM_INFO system;
+    GetSystemInfo(&system);
+    std::fprintf(file, "{\"tool\": \"SentinelBench\", \"iterations\": %d, \"logicalProcessors\": %lu, ", ITERATIONS,
+                 static_cast<unsigned long>(system.dwNumberOfProcessors));
+    std::fprintf(file, "\"avx2\": %s, \"shaNi\": %s, \"crc32c\": %s, \"vmDispatch\": \"%s\", \"results\": [",
+                 HandleFilter::IsAvx2Supported() ? "true" : "false", RegionHash::IsShaSupported() ? "true" : "false",
+                 RegionHash::IsCrc32cSupported() ? "true" : "false", Interpreter::GetDispatchMode());
+    for (size_t i = 0; i < reported.size(); ++i) {
+        const BenchResult& result = reported[i].result;
+        const double budgetMs = reported[i].budgetMs;
+        const double nsPerItem = result.items != 0 ? result.medianMs * 1e6 / static_cast<double>(result.items) : 0.0;
+        std::fprintf(file, "%s\n  {\"name\": \"%s\", \"dataset\": \"%s\", \"unit\": \"%s\", \"items\": %zu, ",
+                     i == 0 ? "" : ",", result.name, result.dataset, result.unit, result.items);
+        std::fprintf(file, "\"bestMs\": %.6f, \"medianMs\": %.6f, \"perSecond\": %.6g, \"nsPerItem\": %.4f",
+                     result.bestMs, result.medianMs, PerSecond(result), nsPerItem);
+        if (budgetMs > 0.0) {
+            std::fprintf(file, ", \"budgetMs\": %g, \"withinBudget\": %s", budgetMs,
+                         result.medianMs <= budgetMs ? "true" : "false");
+        }
+        std::fprintf(file, "}");
+    }
+    std::fprintf(file, "\n]}\n");
+    const bool written = std::ferror(file) == 0;
+    std::fclose(file);
+    return written;
+}
+
+// Spread of object addresses resembling a real table: many handles share few objects
+static std::vector<HandleTableEntry> BuildSyntheticTable(size_t count, const void* target) {
+    std::vector<HandleTableEntry> entries(count);
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < count; ++i) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        const uint32_t random = static_cast<uint32_t>(state >> 32);
+        HandleTableEntry& entry = entries[i];
+        entry.object = reinterpret_cast<PVOID>(static_cast<uintptr_t>(0xFFFF800000000000ull + (random % 200000) * 16));
+        entry.uniqueProcessId = 4 + (random % 400) * 4;
+        entry.handleValue = (i % 4096) * 4 + 4;
+        entry.grantedAccess = random & 0x1FFFFF;
+        entry.objectTypeIndex = static_cast<USHORT>(random % 64);
+        // Roughly one handle in ten thousand refers to the protected process
+        if (random % 10000 == 0) {
+            entry.object = const_cast<PVOID>(target);
+        }
+    }
+    return entries;
+}
+
+using FilterKernel = size_t (*)(const HandleTableEntry*, size_t, const HandleFilterQuery&, uint32_t*, size_t) noexcept;
+
+static void BenchFilterKernels(const char* dataset, const HandleTableEntry* entries, size_t count,
+                               const HandleFilterQuery& query) {
+    struct Kernel {
+        const char* name;
+        FilterKernel function;
+        bool available;
+    };
+    const Kernel kernels[] = {
+        {"handle-filter/scalar", &HandleFilter::FindScalar, true},
+        {"handle-filter/avx2", &HandleFilter::FindAvx2, HandleFilter::IsAvx2Supported()},
+    };
+
+    uint32_t matches[1024];
+    for (const Kernel& kernel : kernels) {
+        if (!kernel.available) {
+            std::printf("%-22s  %-10s  skipped (not supported by this processor)\n", kernel.name, dataset);
+            continue;
+        }
+        size_t found = 0;
+        BenchResult result = Measure(kernel.name, dataset, "handles", count, [&]() {
+            found = kernel.function(entries, count, query, matches, 1024);
+        });
+        Report(result, SCAN_BUDGET_MS);
+        std::printf("%-22s  %-10s  %zu matching handles\n", "", "", found);
+    }
+}
+
+// Region hash kernels reduced to a common signature; the result only keeps the call alive
+static uint32_t HashShaNi(const uint8_t* data, size_t length) {
+    return RegionHash::Sha256(data, length).bytes[0];
+}
+
+static uint32_t HashShaPortable(const uint8_t* data, size_t length) {
+    return RegionHash::Sha256Portable(data, length).bytes[0];
+}
+
+static uint32_t HashCrc32cHardware(const uint8_t* data, size_t length) {
+    return RegionHash::Crc32c(data, length);
+}
+
+static uint32_t HashCrc32cPortable(const uint8_t* data, size_t length) {
+    return RegionHash::Crc32cPortable(data, length);
+}
+
+static void BenchRegionHash() {
+    std::vector<uint8_t> region(HASH_REGION_BYTES);
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (uint8_t& byte : region) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        byte = static_cast<uint8_t>(state >> 56);
+    }
+
+    struct Kernel {
+        const char* name;
+        uint32_t (*function)(const uint8_t*, size_t);
+        bool available;
+    };
+    const Kernel kernels[] = {
+        {"region-hash/sha-ni", &HashShaNi, RegionHash::IsShaSupported()},
+        {"region-hash/sha256", &HashShaPortable, true},
+        {"region-hash/crc32c-hw", &HashCrc32cHardware, RegionHash::IsCrc32cSupported()},
+        {"region-hash/crc32c", &HashCrc32cPortable, true},
+    };
+
+    for (const Kernel& kernel : kernels) {
+        if (!kernel.available) {
+            std::printf("%-22s  %-10s  skipped (not supported by this processor)\n", kernel.name, "synthetic");
+            continue;
+        }
+        volatile uint32_t sink = 0;
+        BenchResult result = Measure(kernel.name, "synthetic", "bytes", region.size(), [&]() {
+            sink = kernel.function(region.data(), region.size());
+        });
+        Report(result, 0.0);
+    }
+}
+
+static void BenchWireBatch() {
+    // Handle-diff-like records: a few small integers each
+    std::vector<std::vector<uint8_t>> records(WIRE_RECORD_COUNT);
+    for (size_t i = 0; i < records.size(); ++i) {
+        uint8_t payload[32];
+        WireWriter writer(payload, sizeof(payload));
+        writer.PutUnsigned(4 * (i % 512) + 4);
+        writer.PutUnsigned(1000 + i % 37);
+        writer.PutSigned(static_cast<int64_t>(i % 5) - 2);
+        writer.PutUnsigned(0x1FFFFF);
+        records[i].assign(payload, payload + writer.GetSize());
+    }
+    uint8_t key[32] = {};
+
+    struct Variant {
+        const char* name;
+        bool perRecord;
+        bool compress;
+    };
+    const Variant variants[] = {
+        {"wire-batch/per-record", true, false},
+        {"wire-batch/batched", false, false},
+        {"wire-batch/xpress", false, true},
+    };
+
+    for (const Variant& variant : variants) {
+        BatchDecoder decoder;
+        BatchEncoder encoder;
+        BatchEncoderConfig config;
+        config.compress = variant.compress;
+        if (!decoder.Initialize(key, sizeof(key), config.maxBatchBytes) ||
+            !encoder.Initialize(key, sizeof(key), config, [&](const uint8_t* frame, size_t size) {
+                return decoder.Decode(frame, size, [](uint32_t, const uint8_t*, size_t) {});
+            })) {
+            std::printf("%-22s  %-10s  skipped (BCrypt or Compression API unavailable)\n", variant.name, "synthetic");
+            continue;
+        }
+        BenchResult result = Measure(variant.name, "synthetic", "records", records.size(), [&]() {
+            for (const std::vector<uint8_t>& record : records) {
+                encoder.Append(1, record.data(), record.size());
+                if (variant.perRecord) {
+                    encoder.Flush();
+                }
+            }
+            encoder.Flush();
+        });
+        Report(result, 0.0);
+        const BatchStats& stats = encoder.GetStats();
+        std::printf("%-22s  %-10s  %.1f frame bytes per record (%.1f plain)\n", variant.name, "synthetic",
+                    static_cast<double>(stats.frameBytes) / static_cast<double>(stats.records),
+                    static_cast<double>(stats.plainBytes) / static_cast<double>(stats.records));
+    }
+}
+
+static void BenchMetricsRequest() {
+    // One encoder/decoder pair per direction: requests go to the responder's session, and
+    // its snapshots come back to the requester
+    uint8_t key[32] = {};
+    const BatchEncoderConfig config;
+    BatchDecoder requestDecoder;
+    BatchDecoder replyDecoder;
+    BatchEncoder requestEncoder;
+    BatchEncoder replyEncoder;
+    MetricsResponder responder(replyEncoder);
+    size_t metricCount = 0;
+    size_t replyBytes = 0;
+    const bool ready =
+        requestDecoder.Initialize(key, sizeof(key), config.maxBatchBytes) &&
+        replyDecoder.Initialize(key, sizeof(key), config.maxBatchBytes) &&
+        replyEncoder.Initialize(key, sizeof(key), config, [&](const uint8_t* frame, size_t size) {
+            replyBytes = size;
+            return replyDecoder.Decode(frame, size, [&](uint32_t schemaId, const uint8_t* payload, size_t length) {
+                if (schemaId == SCHEMA_METRICS_SNAPSHOT) {
+                    metricCount = 0;
+                    DecodeMetricsSnapshot(payload, length, [&](const MetricSample&) { ++metricCount; });
+                }
+            });
+        }) &&
+        requestEncoder.Initialize(key, sizeof(key), config, [&](const uint8_t* frame, size_t size) {
+            return requestDecoder.Decode(frame, size, [&](uint32_t schemaId, const uint8_t* payload, size_t length) {
+                responder.OnRecord(schemaId, payload, length);
+            });
+        });
+    if (!ready) {
+        std::printf("%-22s  %-10s  skipped (BCrypt or Compression API unavailable)\n", "wire-batch/metrics",
+                    "registry");
+        return;
+    }
+
+    // The request payload is empty; a valid pointer keeps the memcpy of zero bytes defined
+    const uint8_t empty = 0;
+    Report(Measure("wire-batch/metrics", "registry", "requests", METRICS_REQUEST_COUNT, [&]() {
+        for (size_t i = 0; i < METRICS_REQUEST_COUNT; ++i) {
+            requestEncoder.Append(SCHEMA_METRICS_REQUEST, &empty, 0);
+            requestEncoder.Flush();
+        }
+    }), 0.0);
+    std::printf("%-22s  %-10s  %zu metrics in a %zu byte frame, %llu requests unanswered\n", "", "", metricCount,
+                replyBytes, static_cast<unsigned long long>(responder.GetFailedCount()));
+}
+
+static void BenchHandleIndex(const std::vector<HandleTableEntry>& synthetic) {
+    // Unique handle values, so every pass after the first reports no change at all
+    std::vector<HandleTableEntry> entries = synthetic;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        entries[i].handleValue = 4 * (i + 1);
+    }
+
+    HandleIndex index;
+    size_t events = 0;
+    auto classify = [](const HandleTableEntry&) { return HandleClassification{HandleVerdict::Authorized, 0}; };
+    BenchResult result = Measure("handle-index", "synthetic", "handles", entries.size(), [&]() {
+        events = index.Update(entries.data(), entries.size(), classify, [](const HandleEvent&) {});
+    });
+    Report(result, SCAN_BUDGET_MS);
+    std::printf("%-22s  %-10s  %zu events in the last pass\n", "", "", events);
+}
+
+// Appends one instruction in the bytecode encoding (operands little-endian)
+static void Emit(std::vector<uint8_t>& code, Opcode opcode, uint64_t operand = 0, size_t operandSize = 0) {
+    code.push_back(static_cast<uint8_t>(opcode));
+    for (size_t i = 0; i < operandSize; ++i) {
+        code.push_back(static_cast<uint8_t>(operand >> (8 * i)));
+    }
+}
+
+// r2 = (r2 ^ r1) * k; r3 += 7; while (++r1 < r0). The last two statements are the
+// AddRegImm and IncJltReg sequences, so the verified variant runs them fused.
+static std::vector<uint8_t> BuildDispatchLoop() {
+    std::vector<uint8_t> code;
+    Emit(code, Opcode::LoadReg, 2, 1);
+    Emit(code, Opcode::LoadReg, 1, 1);
+    Emit(code, Opcode::Xor);
+    Emit(code, Opcode::Push, 0x100000001B3ull, 8);
+    Emit(code, Opcode::Mul);
+    Emit(code, Opcode::StoreReg, 2, 1);
+    Emit(code, Opcode::LoadReg, 3, 1);
+    Emit(code, Opcode::Push, 7, 8);
+    Emit(code, Opcode::Add);
+    Emit(code, Opcode::StoreReg, 3, 1);
+    Emit(code, Opcode::LoadReg, 1, 1);
+    Emit(code, Opcode::Push, 1, 8);
+    Emit(code, Opcode::Add);
+    Emit(code, Opcode::Dup);
+    Emit(code, Opcode::StoreReg, 1, 1);
+    Emit(code, Opcode::LoadReg, 0, 1);
+    Emit(code, Opcode::LtU);
+    Emit(code, Opcode::Jnz, 0, 4);
+    Emit(code, Opcode::LoadReg, 2, 1);
+    Emit(code, Opcode::Halt);
+    return code;
+}
+
+static void BenchVmDispatch() {
+    const std::vector<uint8_t> code = BuildDispatchLoop();
+
+    struct Variant {
+        const char* name;
+        bool verify;
+    };
+    const Variant variants[] = {
+        {"vm-dispatch/checked", false},
+        {"vm-dispatch/verified", true},
+    };
+
+    for (const Variant& variant : variants) {
+        Program program;
+        if (!program.Decode(code.data(), code.size()) || (variant.verify && !Verifier::Verify(program))) {
+            std::printf("%-22s  %-10s  skipped (program rejected)\n", variant.name, "synthetic");
+            continue;
+        }
+        Interpreter vm;
+        vm.SetBranchBudget(VM_LOOP_ITERATIONS + 1);
+        ExecutionResult execution;
+        BenchResult result = Measure(variant.name, "synthetic", "instructions",
+                                     VM_LOOP_ITERATIONS * VM_LOOP_INSTRUCTIONS, [&]() {
+            vm.SetRegister(0, VM_LOOP_ITERATIONS);
+            vm.SetRegister(1, 0);
+            execution = vm.Execute(program);
+        });
+        Report(result, 0.0);
+        if (execution.status != VmStatus::Halted) {
+            std::printf("%-22s  %-10s  execution did not halt (status %u)\n", variant.name, "synthetic",
+                        static_cast<unsigned>(execution.status));
+        }
+    }
+}
+
+// A file sink keeps the console out of the measurement and out of the results
+static bool RedirectLogToFile() {
+    wchar_t temp[MAX_PATH];
+    const DWORD length = GetTempPathW(MAX_PATH, temp);
+    if (length == 0 || length >= MAX_PATH) {
+        return false;
+    }
+    MappedFileSinkConfig config;
+    config.directory = std::wstring(temp) + L"SentinelBench";
+    config.baseName = L"bench";
+    config.maxSegments = 2;
+    CreateDirectoryW(config.directory.c_str(), nullptr);
+    return Logger::EnableFileSink(config, false);
+}
+
+static void BenchLogger() {
+    AsyncLoggerConfig config;
+    config.overflowPolicy = OverflowPolicy::Block;
+    if (!Logger::EnableAsync(config)) {
+        std::printf("%-22s  %-10s  skipped (consumer thread unavailable)\n", "logger", "synthetic");
+        return;
+    }
+
+    // Named by thread count; string literals, as BenchResult keeps the pointer
+    struct Variant {
+        const char* name;
+        size_t threads;
+    };
+    const Variant variants[] = {
+        {"logger/1-thread", 1},   {"logger/2-threads", 2},   {"logger/4-threads", 4},   {"logger/8-threads", 8},
+        {"logger/16-threads", 16}, {"logger/32-threads", 32}, {"logger/64-threads", 64},
+    };
+
+    const std::string message = "SentinelBench logger throughput record with a typical message length";
+    for (const Variant& variant : variants) {
+        const size_t perThread = LOGGER_RECORD_COUNT / variant.threads;
+
+        // Thread creation is kept out of the measurement: producers wait for the start flag
+        auto run = [&]() {
+            std::atomic<bool> start{false};
+            std::vector<std::thread> producers;
+            producers.reserve(variant.threads);
+            for (size_t t = 0; t < variant.threads; ++t) {
+                producers.emplace_back([&]() {
+                    while (!start.load(std::memory_order_acquire)) {
+                        std::this_thread::yield();
+                    }
+                    for (size_t i = 0; i < perThread; ++i) {
+                        Logger::LogInfo(message);
+                    }
+                });
+            }
+            LARGE_INTEGER begin;
+            LARGE_INTEGER end;
+            QueryPerformanceCounter(&begin);
+            start.store(true, std::memory_order_release);
+            for (std::thread& producer : producers) {
+                producer.join();
+            }
+            Logger::Flush();
+            QueryPerformanceCounter(&end);
+            return ElapsedMs(begin, end);
+        };
+
+        run();
+        std::vector<double> samples;
+        samples.reserve(LOGGER_ITERATIONS);
+        for (int i = 0; i < LOGGER_ITERATIONS; ++i) {
+            samples.push_back(run());
+        }
+        Report(Summarize(variant.name, "synthetic", "records", perThread * variant.threads, samples), 0.0);
+    }
+    if (Logger::GetDroppedCount() != 0) {
+        std::printf("%-22s  %-10s  %llu records dropped\n", "logger", "synthetic",
+                    static_cast<unsigned long long>(Logger::GetDroppedCount()));
+    }
+    Logger::Shutdown();
+}
+
+// No C++ objects with destructors may live in a function that uses __try
+static void RaiseHandled(DWORD code) {
+    __try {
+        RaiseException(code, 0, 0, nullptr);
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+    }
+}
+
+static bool ReadHistogram(const char* name, HistogramSnapshot* out) {
+    MetricSample sample;
+    for (size_t index = 0; index < MetricsRegistry::GetCount(); ++index) {
+        if (MetricsRegistry::Read(index, &sample) && sample.kind == MetricKind::Histogram && sample.name == name) {
+            *out = sample.histogram;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void BenchExceptionHandler() {
+    // Baseline: the SEH round trip without any Vectored Exception Handler
+    Report(Measure("exception/no-veh", "raise", "exceptions", EXCEPTION_COUNT, [&]() {
+        for (size_t i = 0; i < EXCEPTION_COUNT; ++i) {
+            RaiseHandled(FILTERED_EXCEPTION_CODE);
+        }
+    }), 0.0);
+
+    CrashInterceptor interceptor;
+    if (!interceptor.Initialize()) {
+        std::printf("%-22s  %-10s  skipped (handler not registered)\n", "exception", "raise");
+        return;
+    }
+
+    // Interesting: every raise comes from the same site, so after the first record the
+    // handler runs its steady state of a dedup hit without publishing
+    struct Variant {
+        const char* name;
+        DWORD code;
+        bool timed;
+    };
+    const Variant variants[] = {
+        {"exception/filtered", FILTERED_EXCEPTION_CODE, false},
+        {"exception/interesting", static_cast<DWORD>(STATUS_ACCESS_VIOLATION), true},
+    };
+
+    // Static: HistogramSnapshot holds 4 KiB of buckets
+    static HistogramSnapshot before;
+    static HistogramSnapshot after;
+    for (const Variant& variant : variants) {
+        const bool haveBefore = ReadHistogram("crash.handler_ns", &before);
+        Report(Measure(variant.name, "raise", "exceptions", EXCEPTION_COUNT, [&]() {
+            for (size_t i = 0; i < EXCEPTION_COUNT; ++i) {
+                RaiseHandled(variant.code);
+            }
+        }), 0.0);
+
+        // Handler time alone, from the latencies recorded during this variant
+        if (haveBefore && ReadHistogram("crash.handler_ns", &after)) {
+            after.count -= before.count;
+            after.sum -= before.sum;
+            for (size_t bucket = 0; bucket < HISTOGRAM_BUCKET_COUNT; ++bucket) {
+                after.buckets[bucket] -= before.buckets[bucket];
+            }
+            // Filtered codes return before the latency timer, so the histogram must not move
+            if (!variant.timed) {
+                std::printf("%-22s  %-10s  crash.handler_ns unchanged: %s\n", "", "",
+                            after.count == 0 ? "ok" : "RECORDED");
+                continue;
+            }
+            std::printf("%-22s  %-10s  HandlerRoutine mean %llu ns  p50 %llu ns  p99 %llu ns\n", "", "",
+                        static_cast<unsigned long long>(after.Mean()),
+                        static_cast<unsigned long long>(after.ValueAtQuantile(0.5)),
+                        static_cast<unsigned long long>(after.ValueAtQuantile(0.99)));
+        }
+    }
+    CrashInterceptor::FlushCrashRecords();
+}
+
+static void BenchLive(HandleFilterQuery query) {
+    // Live table: the object of a handle this process holds to itself is the target
+    ResourceAuditor auditor;
+    if (!auditor.Initialize()) {
+        return;
+    }
+    BenchResult snapshot = Measure("handle-snapshot", "live", "handles", 0, [&]() { auditor.Snapshot(); });
+    snapshot.items = auditor.GetEntryCount();
+    Report(snapshot, 0.0);
+
+    HANDLE self = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, GetCurrentProcessId());
+    if (self == nullptr || !auditor.Snapshot()) {
+        std::printf("Live handle table unavailable; skipping live filter benchmark\n");
+        if (self != nullptr) {
+            CloseHandle(self);
+        }
+        return;
+    }
+    const HandleTableEntry* own = HandleFilter::FindHandle(auditor.GetEntries(), auditor.GetEntryCount(),
+                                                           GetCurrentProcessId(), reinterpret_cast<ULONG_PTR>(self));
+    if (own != nullptr) {
+        query.object = own->object;
+        query.excludedProcessId = GetCurrentProcessId();
+        BenchFilterKernels("live", auditor.GetEntries(), auditor.GetEntryCount(), query);
+    } else {
+        std::printf("Own process handle not found in the snapshot; skipping live filter benchmark\n");
+    }
+    CloseHandle(self);
+}
+
+int wmain(int argc, wchar_t* argv[]) {
+    size_t syntheticCount = 500000;
+    const wchar_t* jsonPath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::wcscmp(argv[i], L"--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else {
+            syntheticCount = static_cast<size_t>(_wtoi64(argv[i]));
+        }
+    }
+
+    std::printf("SentinelBench: %d iterations per benchmark, AVX2 %s, SHA-NI %s, VM dispatch %s\n", ITERATIONS,
+                HandleFilter::IsAvx2Supported() ? "available" : "not available",
+                RegionHash::IsShaSupported() ? "available" : "not available", Interpreter::GetDispatchMode());
+    if (!RedirectLogToFile()) {
+        std::printf("Log file sink unavailable; log output goes to the console\n");
+    }
+
+    // Synthetic table: reproducible and independent of the machine's current load
+    HandleFilterQuery query;
+    query.object = reinterpret_cast<const void*>(static_cast<uintptr_t>(0xFFFF8000DEADBEE0ull));
+    query.accessMask = PROCESS_VM_WRITE | PROCESS_CREATE_THREAD | PROCESS_DUP_HANDLE;
+    std::vector<HandleTableEntry> synthetic = BuildSyntheticTable(syntheticCount, query.object);
+    BenchFilterKernels("synthetic", synthetic.data(), synthetic.size(), query);
+    BenchHandleIndex(synthetic);
+    BenchRegionHash();
+    BenchWireBatch();
+    BenchMetricsRequest();
+    BenchVmDispatch();
+    BenchLogger();
+    BenchExceptionHandler();
+    BenchLive(query);
+
+    Logger::DisableFileSink();
+    if (jsonPath != nullptr) {
+        if (!WriteJson(jsonPath)) {
+            return 1;
+        }
+        std::printf("Results written to %ls\n", jsonPath);
+    }
+    return 0;
+}
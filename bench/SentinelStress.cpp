@@ -0,0 +1,378 @@
+/**
+ * @file SentinelStress.cpp
+ * @brief Exception-storm and logging contention stress harness.
+ *
+ * @details Grew out of the multithreaded demo in main.cpp: the same startup sequence
+ * (ETW provider, asynchronous Logger, CrashInterceptor), but held under sustained load
+ * instead of a few messages. Where SentinelBench times isolated kernels, this runs the
+ * whole process the way a hostile or broken target would:
+ * - Faulting threads take real hardware faults, alternating a guard page (re-armed after
+ *   each fault) and a PAGE_NOACCESS page, so every fault passes through HandlerRoutine,
+ *   the dedup table and the lock-free crash channel before SEH catches it.
+ * - Logging threads call Logger::Info as fast as they can for as long as faults are
+ *   being taken, so the async queue and the crash watchdog compete for the consumer.
+ * - A watchdog thread checks that every worker keeps making progress. A worker that does
+ *   not advance for --stall-ms is reported as a deadlock, and the process exits with
+ *   code 3 without waiting on anything the stalled thread may hold.
+ *
+ * At the end, per-operation latencies are reported for each kind of work:
+ * @code
+ * fault/guard-page         1000000 ops  mean 2311 ns  p50 2047 ns  p99 5119 ns  p99.9 12287 ns  max 88012 ns
+ * fault/access-violation   1000000 ops  mean 2140 ns  p50 2047 ns  p99 4607 ns  p99.9 10239 ns  max 61730 ns
+ * log                      8214933 ops  mean  412 ns  p50  319 ns  p99 1791 ns  p99.9  6143 ns  max 911204 ns
+ * @endcode
+ * followed by throughput, records dropped by the Logger and the crash channel, and a
+ * check that CrashInterceptor counted every fault that was taken.
+ *
+ * Log output goes to a file sink under %TEMP%\SentinelStress (the console would throttle
+ * the loggers to its own speed) unless --console is given.
+ *
+ * Usage: SentinelStress [--fault-threads 4] [--log-threads 4] [--faults 2000000]
+ *                       [--stall-ms 5000] [--no-rate-limit] [--block] [--console]
+ * - --no-rate-limit reports every fault instead of a burst per site, which floods the
+ *   crash channel rather than the dedup table.
+ * - --block selects OverflowPolicy::Block, so loggers wait for the consumer instead of
+ *   dropping records.
+ *
+ * Exit codes: 0 passed, 1 setup failed, 2 fault counts did not match, 3 deadlock.
+ */
+
+#include "Sentinel/Bedrock/CrashInterceptor.hpp"
+#include "Sentinel/Utils/EtwTrace.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+#include "Sentinel/Utils/Metrics.hpp"
+#include <Windows.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Sentinel::Bedrock;
+using namespace Sentinel::Utils;
+
+// Watchdog polling period
+static constexpr DWORD WATCHDOG_POLL_MS = 100;
+
+// Exit codes
+static constexpr int EXIT_SETUP_FAILED = 1;
+static constexpr int EXIT_COUNT_MISMATCH = 2;
+static constexpr int EXIT_DEADLOCK = 3;
+
+struct StressConfig {
+    size_t faultThreads = 4;
+    size_t logThreads = 4;
+    size_t faults = 2000000;
+    DWORD stallMs = 5000;
+    bool noRateLimit = false;
+    bool block = false;
+    bool console = false;
+};
+
+#pragma warning(push)
+#pragma warning(disable : 4324) // structure was padded due to alignment specifier
+
+// One per worker, on its own cache line so the watchdog's reads do not slow the worker
+struct alignas(64) WorkerProgress {
+    const char* role = nullptr;
+    size_t index = 0;
+    DWORD threadId = 0;
+    std::atomic<uint64_t> operations{0};
+    std::atomic<bool> finished{false};
+};
+
+#pragma warning(pop)
+
+// Latencies of every operation, in nanoseconds
+static Histogram guardPageLatency;
+static Histogram accessViolationLatency;
+static Histogram logLatency;
+
+// Faults taken, and accesses that did not fault: the page protection was not what this
+// harness set up
+static std::atomic<uint64_t> guardPageFaults{0};
+static std::atomic<uint64_t> accessViolationFaults{0};
+static std::atomic<uint64_t> missedFaults{0};
+
+static std::atomic<bool> faultingDone{false};
+static std::atomic<bool> watchdogStop{false};
+
+// Writes straight to stderr: a deadlocked Logger may hold the console or the CRT stream locks
+static void WriteDiagnostic(const char* text) {
+    DWORD written = 0;
+    WriteFile(GetStdHandle(STD_ERROR_HANDLE), text, static_cast<DWORD>(std::strlen(text)), &written, nullptr);
+}
+
+// No C++ objects with destructors may live in a function that uses __try
+static bool Touch(volatile const uint8_t* address) {
+    __try {
+        (void)*address;
+        return false;
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+        return true;
+    }
+}
+
+static LONGLONG Now() {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+static void FaultingThread(WorkerProgress& progress, size_t faults) {
+    progress.threadId = GetCurrentThreadId();
+
+    // Page 0 is the guard page, page 1 is never accessible
+    SYSTEM_INFO system;
+    GetSystemInfo(&system);
+    const size_t pageSize = system.dwPageSize;
+    auto* pages = static_cast<uint8_t*>(VirtualAlloc(nullptr, 2 * pageSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+    DWORD previous = 0;
+    if (pages == nullptr || !VirtualProtect(pages + pageSize, pageSize, PAGE_NOACCESS, &previous)) {
+        Logger::Error("Faulting thread {}: cannot set up fault pages (0x{:08X})", progress.index, GetLastError());
+        if (pages != nullptr) {
+            VirtualFree(pages, 0, MEM_RELEASE);
+        }
+        progress.finished.store(true, std::memory_order_release);
+        return;
+    }
+
+    for (size_t i = 0; i < faults; ++i) {
+        const bool guardPage = (i & 1) == 0;
+        if (guardPage && !VirtualProtect(pages, pageSize, PAGE_READWRITE | PAGE_GUARD, &previous)) {
+            missedFaults.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        const LONGLONG start = Now();
+        const bool faulted = Touch(guardPage ? pages : pages + pageSize);
+        const uint64_t elapsed = TicksToNanoseconds(Now() - start);
+        if (!faulted) {
+            missedFaults.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            (guardPage ? guardPageFaults : accessViolationFaults).fetch_add(1, std::memory_order_relaxed);
+        }
+        (guardPage ? guardPageLatency : accessViolationLatency).Record(elapsed);
+        progress.operations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    VirtualFree(pages, 0, MEM_RELEASE);
+    progress.finished.store(true, std::memory_order_release);
+}
+
+static void LoggingThread(WorkerProgress& progress) {
+    progress.threadId = GetCurrentThreadId();
+    uint64_t record = 0;
+    while (!faultingDone.load(std::memory_order_acquire)) {
+        const LONGLONG start = Now();
+        Logger::Info("Stress logger {} record {}", progress.index, record);
+        logLatency.Record(TicksToNanoseconds(Now() - start));
+        ++record;
+        progress.operations.fetch_add(1, std::memory_order_relaxed);
+    }
+    progress.finished.store(true, std::memory_order_release);
+}
+
+// Reports every worker that has not advanced for stallMs, then terminates the process
+static void WatchdogThread(std::vector<WorkerProgress>& workers, DWORD stallMs) {
+    std::vector<uint64_t> lastOperations(workers.size(), 0);
+    std::vector<ULONGLONG> lastAdvance(workers.size(), GetTickCount64());
+    while (!watchdogStop.load(std::memory_order_acquire)) {
+        Sleep(WATCHDOG_POLL_MS);
+        const ULONGLONG now = GetTickCount64();
+        bool stalled = false;
+        for (size_t i = 0; i < workers.size(); ++i) {
+            const uint64_t operations = workers[i].operations.load(std::memory_order_relaxed);
+            if (operations != lastOperations[i] || workers[i].finished.load(std::memory_order_acquire)) {
+                lastOperations[i] = operations;
+                lastAdvance[i] = now;
+            } else if (now - lastAdvance[i] >= stallMs) {
+                char line[192];
+                std::snprintf(line, sizeof(line), "DEADLOCK: %s %zu (thread %lu) made no progress for %llu ms after "
+                              "%llu operations\n", workers[i].role, workers[i].index,
+                              static_cast<unsigned long>(workers[i].threadId),
+                              static_cast<unsigned long long>(now - lastAdvance[i]),
+                              static_cast<unsigned long long>(operations));
+                WriteDiagnostic(line);
+                stalled = true;
+            }
+        }
+        if (stalled) {
+            char line[192];
+            std::snprintf(line, sizeof(line), "Logger queue depth %zu, crash records dropped %llu\n",
+                          Logger::GetQueueDepth(),
+                          static_cast<unsigned long long>(CrashInterceptor::GetDroppedCrashRecordCount()));
+            WriteDiagnostic(line);
+            // Exiting normally would run destructors and DLL detach, which can wait on the stalled thread
+            TerminateProcess(GetCurrentProcess(), EXIT_DEADLOCK);
+        }
+    }
+}
+
+static void ReportLatency(const char* name, const Histogram& histogram) {
+    // Static: HistogramSnapshot holds 4 KiB of buckets
+    static HistogramSnapshot snapshot;
+    histogram.Read(&snapshot);
+    std::printf("%-22s  %9llu ops  mean %5llu ns  p50 %5llu ns  p99 %6llu ns  p99.9 %7llu ns  max %llu ns\n", name,
+                static_cast<unsigned long long>(snapshot.count), static_cast<unsigned long long>(snapshot.Mean()),
+                static_cast<unsigned long long>(snapshot.ValueAtQuantile(0.5)),
+                static_cast<unsigned long long>(snapshot.ValueAtQuantile(0.99)),
+                static_cast<unsigned long long>(snapshot.ValueAtQuantile(0.999)),
+                static_cast<unsigned long long>(snapshot.max));
+}
+
+static bool ParseArguments(int argc, wchar_t* argv[], StressConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::wcscmp(argv[i], L"--fault-threads") == 0 && hasValue) {
+            config.faultThreads = static_cast<size_t>(_wtoi64(argv[++i]));
+        } else if (std::wcscmp(argv[i], L"--log-threads") == 0 && hasValue) {
+            config.logThreads = static_cast<size_t>(_wtoi64(argv[++i]));
+        } else if (std::wcscmp(argv[i], L"--faults") == 0 && hasValue) {
+            config.faults = static_cast<size_t>(_wtoi64(argv[++i]));
+        } else if (std::wcscmp(argv[i], L"--stall-ms") == 0 && hasValue) {
+            config.stallMs = static_cast<DWORD>(_wtoi(argv[++i]));
+        } else if (std::wcscmp(argv[i], L"--no-rate-limit") == 0) {
+            config.noRateLimit = true;
+        } else if (std::wcscmp(argv[i], L"--block") == 0) {
+            config.block = true;
+        } else if (std::wcscmp(argv[i], L"--console") == 0) {
+            config.console = true;
+        } else {
+            std::printf("Unknown or incomplete argument: %ls\n", argv[i]);
+            return false;
+        }
+    }
+    return config.faultThreads != 0 && config.stallMs != 0;
+}
+
+// A file sink keeps the console from throttling the loggers
+static bool RedirectLogToFile() {
+    wchar_t temp[MAX_PATH];
+    const DWORD length = GetTempPathW(MAX_PATH, temp);
+    if (length == 0 || length >= MAX_PATH) {
+        return false;
+    }
+    MappedFileSinkConfig config;
+    config.directory = std::wstring(temp) + L"SentinelStress";
+    config.baseName = L"stress";
+    config.maxSegments = 4;
+    CreateDirectoryW(config.directory.c_str(), nullptr);
+    return Logger::EnableFileSink(config, false);
+}
+
+int wmain(int argc, wchar_t* argv[]) {
+    StressConfig config;
+    if (!ParseArguments(argc, argv, config)) {
+        std::printf("Usage: SentinelStress [--fault-threads N] [--log-threads N] [--faults N] [--stall-ms N] "
+                    "[--no-rate-limit] [--block] [--console]\n");
+        return EXIT_SETUP_FAILED;
+    }
+    std::printf("SentinelStress: %zu faulting threads, %zu logging threads, %zu faults, stall limit %lu ms\n",
+                config.faultThreads, config.logThreads, config.faults, static_cast<unsigned long>(config.stallMs));
+
+    EtwTrace::Register();
+    if (!config.console && !RedirectLogToFile()) {
+        std::printf("Log file sink unavailable; log output goes to the console\n");
+    }
+    AsyncLoggerConfig loggerConfig;
+    loggerConfig.overflowPolicy = config.block ? OverflowPolicy::Block : OverflowPolicy::DropNewest;
+    if (!Logger::EnableAsync(loggerConfig)) {
+        std::printf("Asynchronous logging unavailable\n");
+        return EXIT_SETUP_FAILED;
+    }
+    if (config.noRateLimit) {
+        CrashRateLimitConfig rateLimit;
+        rateLimit.reportsPerSecond = 0;
+        CrashInterceptor::ConfigureRateLimit(rateLimit);
+    }
+    CrashInterceptor interceptor;
+    if (!interceptor.Initialize()) {
+        std::printf("Crash Interceptor unavailable\n");
+        return EXIT_SETUP_FAILED;
+    }
+
+    const uint64_t guardPagesBefore = CrashInterceptor::GetExceptionCount(STATUS_GUARD_PAGE_VIOLATION);
+    const uint64_t accessViolationsBefore = CrashInterceptor::GetExceptionCount(STATUS_ACCESS_VIOLATION);
+
+    // The last worker is the main thread's shutdown, so a Flush that never returns is caught too
+    std::vector<WorkerProgress> workers(config.faultThreads + config.logThreads + 1);
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].role = i < config.faultThreads ? "faulting thread"
+                          : i < workers.size() - 1 ? "logging thread" : "shutdown";
+        workers[i].index = i < config.faultThreads ? i : i - config.faultThreads;
+    }
+    WorkerProgress& shutdown = workers.back();
+    shutdown.threadId = GetCurrentThreadId();
+    shutdown.finished.store(true, std::memory_order_relaxed);
+    std::thread watchdog(WatchdogThread, std::ref(workers), config.stallMs);
+
+    const LONGLONG start = Now();
+    std::vector<std::thread> threads;
+    threads.reserve(config.faultThreads + config.logThreads);
+    for (size_t i = 0; i < config.faultThreads; ++i) {
+        const size_t share = config.faults / config.faultThreads + (i < config.faults % config.faultThreads ? 1 : 0);
+        threads.emplace_back(FaultingThread, std::ref(workers[i]), share);
+    }
+    for (size_t i = 0; i < config.logThreads; ++i) {
+        threads.emplace_back(LoggingThread, std::ref(workers[config.faultThreads + i]));
+    }
+    for (size_t i = 0; i < config.faultThreads; ++i) {
+        threads[i].join();
+    }
+    const double faultSeconds = static_cast<double>(TicksToNanoseconds(Now() - start)) / 1e9;
+    faultingDone.store(true, std::memory_order_release);
+    for (size_t i = config.faultThreads; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+
+    // Draining is watched as well: each step counts as progress
+    shutdown.finished.store(false, std::memory_order_release);
+    CrashInterceptor::FlushCrashRecords();
+    shutdown.operations.fetch_add(1, std::memory_order_relaxed);
+    Logger::Flush();
+    shutdown.operations.fetch_add(1, std::memory_order_relaxed);
+    shutdown.finished.store(true, std::memory_order_release);
+    watchdogStop.store(true, std::memory_order_release);
+    watchdog.join();
+
+    const uint64_t guardPages = CrashInterceptor::GetExceptionCount(STATUS_GUARD_PAGE_VIOLATION) - guardPagesBefore;
+    const uint64_t accessViolations =
+        CrashInterceptor::GetExceptionCount(STATUS_ACCESS_VIOLATION) - accessViolationsBefore;
+    const uint64_t dropped = Logger::GetDroppedCount();
+    const uint64_t crashDropped = CrashInterceptor::GetDroppedCrashRecordCount();
+    Logger::Shutdown();
+    if (!config.console) {
+        Logger::DisableFileSink();
+    }
+    EtwTrace::Unregister();
+
+    ReportLatency("fault/guard-page", guardPageLatency);
+    ReportLatency("fault/access-violation", accessViolationLatency);
+    ReportLatency("log", logLatency);
+
+    uint64_t logged = 0;
+    for (size_t i = config.faultThreads; i < workers.size() - 1; ++i) {
+        logged += workers[i].operations.load(std::memory_order_relaxed);
+    }
+    std::printf("%.2f s: %.0f faults/s, %.0f log records/s\n", faultSeconds,
+                static_cast<double>(guardPageFaults.load() + accessViolationFaults.load()) / faultSeconds,
+                static_cast<double>(logged) / faultSeconds);
+    std::printf("Dropped: %llu log records, %llu crash records\n", static_cast<unsigned long long>(dropped),
+                static_cast<unsigned long long>(crashDropped));
+
+    // Every fault taken must have reached HandlerRoutine; other code in the process may add to the counts
+    const uint64_t guardPagesTaken = guardPageFaults.load(std::memory_order_relaxed);
+    const uint64_t accessViolationsTaken = accessViolationFaults.load(std::memory_order_relaxed);
+    const uint64_t missed = missedFaults.load(std::memory_order_relaxed);
+    const bool counted = missed == 0 && guardPages >= guardPagesTaken && accessViolations >= accessViolationsTaken;
+    std::printf("HandlerRoutine saw %llu of %llu guard page and %llu of %llu access violation faults "
+                "(%llu accesses missed): %s\n",
+                static_cast<unsigned long long>(guardPages), static_cast<unsigned long long>(guardPagesTaken),
+                static_cast<unsigned long long>(accessViolations),
+                static_cast<unsigned long long>(accessViolationsTaken), static_cast<unsigned long long>(missed),
+                counted ? "ok" : "MISMATCH");
+    return counted ? 0 : EXIT_COUNT_MISMATCH;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file CrashDedupTable.cpp
+ * @brief Implementation of the lock-free crash site table.
+ */
+
+#include "Sentinel/Bedrock/CrashDedupTable.hpp"
+#include <algorithm>
+
+namespace Sentinel {
+namespace Bedrock {
+
+// Table size must be a power of two so probing can wrap with a mask
+static_assert((CrashDedupTable::TABLE_SIZE & (CrashDedupTable::TABLE_SIZE - 1)) == 0,
+              "CrashDedupTable::TABLE_SIZE must be a power of two");
+static_assert(CrashDedupTable::MAX_PROBES <= CrashDedupTable::TABLE_SIZE,
+              "CrashDedupTable::MAX_PROBES cannot exceed the table size");
+
+// splitmix64 finalizer: cheap, and spreads nearby page and instruction addresses apart
+static constexpr uint64_t MixHash(uint64_t value) noexcept {
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ULL;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBULL;
+    value ^= value >> 31;
+    return value;
+}
+
+static constexpr uint64_t HashKey(const CrashSiteKey& key) noexcept {
+    uint64_t hash = MixHash(static_cast<uint64_t>(key.exceptionCode));
+    hash = MixHash(hash ^ static_cast<uint64_t>(key.sanitizedAddress));
+    hash = MixHash(hash ^ static_cast<uint64_t>(key.instructionAddress));
+    // Zero marks a free slot
+    return hash != 0 ? hash : 1;
+}
+
+void CrashDedupTable::Configure(const CrashRateLimitConfig& config, int64_t qpcFrequency) noexcept {
+    if (config.reportsPerSecond == 0 || qpcFrequency <= 0) {
+        ticksPerReport_.store(0, std::memory_order_relaxed);
+        return;
+    }
+
+    const int64_t interval = (std::max)(qpcFrequency / static_cast<int64_t>(config.reportsPerSecond),
+                                        static_cast<int64_t>(1));
+    const int64_t burst = static_cast<int64_t>((std::max)(config.burst, 1u));
+
+    // A full bucket admits burst occurrences at once: the first is free, the rest may run
+    // up to (burst - 1) intervals ahead of schedule
+    burstTolerance_.store(interval * (burst - 1), std::memory_order_relaxed);
+    ticksPerReport_.store(interval, std::memory_order_relaxed);
+}
+
+CrashDedupTable::Slot* CrashDedupTable::FindOrClaim(const CrashSiteKey& key, uint64_t hash) noexcept {
+    for (size_t probe = 0; probe < MAX_PROBES; ++probe) {
+        Slot& slot = slots_[(hash + probe) & (TABLE_SIZE - 1)];
+
+        uint64_t current = slot.keyHash.load(std::memory_order_acquire);
+        if (current == hash) {
+            return &slot;
+        }
+        if (current != 0) {
+            continue;
+        }
+
+        // Free slot: claim it, or discover that a racing occurrence claimed it first
+        if (slot.keyHash.compare_exchange_strong(current, hash, std::memory_order_acq_rel)) {
+            slot.exceptionCode.store(key.exceptionCode, std::memory_order_relaxed);
+            slot.sanitizedAddress.store(key.sanitizedAddress, std::memory_order_relaxed);
+            slot.instructionAddress.store(key.instructionAddress, std::memory_order_relaxed);
+            slot.ready.store(true, std::memory_order_release);
+            return &slot;
+        }
+        if (current == hash) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+bool CrashDedupTable::Admit(Slot& slot, int64_t timestamp) noexcept {
+    const int64_t interval = ticksPerReport_.load(std::memory_order_relaxed);
+    if (interval == 0) {
+        return true;
+    }
+    const int64_t tolerance = burstTolerance_.load(std::memory_order_relaxed);
+
+    int64_t arrival = slot.theoreticalArrival.load(std::memory_order_relaxed);
+    for (;;) {
+        // An idle site's schedule restarts at "now", which refills its bucket
+        const int64_t scheduled = (std::max)(arrival, timestamp);
+        if (scheduled - timestamp > tolerance) {
+            return false;
+        }
+        if (slot.theoreticalArrival.compare_exchange_weak(arrival, scheduled + interval,
+                                                          std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+bool CrashDedupTable::ShouldReport(const CrashSiteKey& key, int64_t timestamp) noexcept {
+    const uint64_t hash = HashKey(key);
+    Slot* slot = FindOrClaim(key, hash);
+    if (slot == nullptr) {
+        slot = &overflow_;
+    }
+
+    slot->totalCount.fetch_add(1, std::memory_order_relaxed);
+    if (Admit(*slot, timestamp)) {
+        return true;
+    }
+    slot->suppressedCount.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool CrashDedupTable::TakeRepeats(size_t index, CrashRepeatSummary& out) noexcept {
+    Slot& slot = (index < TABLE_SIZE) ? slots_[index] : overflow_;
+    if (&slot != &overflow_ && !slot.ready.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    const uint64_t suppressed = slot.suppressedCount.exchange(0, std::memory_order_relaxed);
+    if (suppressed == 0) {
+        return false;
+    }
+
+    out.key.exceptionCode = slot.exceptionCode.load(std::memory_order_relaxed);
+    out.key.sanitizedAddress = slot.sanitizedAddress.load(std::memory_order_relaxed);
+    out.key.instructionAddress = slot.instructionAddress.load(std::memory_order_relaxed);
+    out.suppressedCount = suppressed;
+    out.totalCount = slot.totalCount.load(std::memory_order_relaxed);
+    return true;
+}
+
+} // namespace Bedrock
+} // namespace Sentinel
@@ -0,0 +1,223 @@
+/**
+ * @file CrashDedupTable.hpp
+ * @brief Lock-free duplicate suppression and per-site rate limiting for crash records.
+ *
+ * @details This module exists because a buggy module that faults inside a retry loop turns
+ * every iteration into a crash record, a formatted line and a console write. The channel
+ * keeps the handler itself cheap, but the watchdog and the Logger still pay per
+ * occurrence, and the log fills with thousands of identical lines that hide everything
+ * else.
+ *
+ * The table identifies a crash site by (exception code, sanitized page address, faulting
+ * instruction address) and gives each site a token bucket. Occurrences within the bucket's
+ * burst are reported normally; the rest are only counted, and the watchdog periodically
+ * emits one "repeated N times" summary per site instead.
+ *
+ * The design prioritizes:
+ * - Async-signal safety: fixed static storage, atomic operations only, no allocation
+ * - Bounded cost: a hash, at most MAX_PROBES slot compares and one CAS for the bucket
+ * - Bounded logging: each site costs at most burst lines plus one summary per interval
+ *
+ * The token bucket is kept in its virtual-scheduling form (GCRA): a single "theoretical
+ * arrival time" per site replaces the token count and refill timestamp pair, so admitting
+ * an occurrence is one compare-and-swap.
+ *
+ * Sites are never evicted. When the table is full (or a probe sequence is exhausted),
+ * occurrences share one overflow bucket, so logging stays bounded even then.
+ *
+ * @security The faulting instruction address is used only as a key and is never reported
+ * unmasked.
+ *
+ * @performance ShouldReport is lock-free: a 64-bit hash compare per probe in the common
+ * case where the site is already known. CollectRepeats is O(TABLE_SIZE) and runs on the
+ * watchdog thread only.
+ *
+ * @see CrashInterceptor
+ */
+
+#pragma once
+
+#include <Windows.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Sentinel {
+namespace Bedrock {
+
+/**
+ * @brief Identity of a crash site.
+ */
+struct CrashSiteKey {
+    /** @brief Exception code from the EXCEPTION_RECORD. */
+    DWORD exceptionCode;
+
+    /** @brief Faulting data address masked to its page boundary. */
+    uintptr_t sanitizedAddress;
+
+    /** @brief Address of the faulting instruction (ExceptionAddress). */
+    uintptr_t instructionAddress;
+};
+
+/**
+ * @brief Occurrences of one crash site that were suppressed since the previous summary.
+ */
+struct CrashRepeatSummary {
+    /** @brief Site identity. All zero for the shared overflow bucket. */
+    CrashSiteKey key;
+
+    /** @brief Occurrences suppressed since the previous summary. */
+    uint64_t suppressedCount;
+
+    /** @brief Occurrences since process start, reported or not. */
+    uint64_t totalCount;
+};
+
+/**
+ * @brief Token-bucket parameters for CrashDedupTable::Configure.
+ */
+struct CrashRateLimitConfig {
+    /** @brief Occurrences of one site that are reported back to back. */
+    uint32_t burst = 5;
+
+    /** @brief Sustained reports per second per site once the burst is spent. */
+    uint32_t reportsPerSecond = 1;
+
+    /** @brief Interval between "repeated N times" summaries. */
+    DWORD summaryIntervalMs = 5000;
+};
+
+/**
+ * @class CrashDedupTable
+ * @brief Fixed-size open-addressed table of crash sites with per-site token buckets.
+ *
+ * @details Slots are claimed by a CAS of the key hash from zero; the key fields are
+ * written afterwards and published with a release store so the watchdog can report the
+ * site. Two occurrences of a site that race to claim a slot resolve to the same slot,
+ * because the loser observes the winner's hash on its next compare.
+ *
+ * The class is constexpr-constructible so a static instance is constant-initialized and
+ * usable from an exception handler before any dynamic initializer has run.
+ *
+ * Usage example:
+ * @code
+ * static CrashDedupTable table;
+ * table.Configure(CrashRateLimitConfig{}, frequency);
+ * // In the VEH:
+ * if (table.ShouldReport(key, timestamp)) { channel.Publish(record); }
+ * // On the watchdog thread, every summaryIntervalMs:
+ * table.CollectRepeats([](const CrashRepeatSummary& s) { Report(s); });
+ * @endcode
+ *
+ * @threadsafe ShouldReport may be called concurrently from any thread, including from
+ * inside an exception handler. CollectRepeats must only be called from one thread at a
+ * time. Configure may be called at any time; occurrences racing with it use either the
+ * old or the new parameters.
+ */
+class CrashDedupTable {
+public:
+    /** @brief Number of distinct sites tracked. Power of two for cheap wrapping. */
+    static constexpr size_t TABLE_SIZE = 256;
+
+    /** @brief Slots inspected before an occurrence falls back to the overflow bucket. */
+    static constexpr size_t MAX_PROBES = 16;
+
+    constexpr CrashDedupTable() = default;
+
+    CrashDedupTable(const CrashDedupTable&) = delete;
+    CrashDedupTable& operator=(const CrashDedupTable&) = delete;
+
+    /**
+     * @brief Sets the token-bucket parameters.
+     *
+     * @param config Burst and sustained rate. A zero rate disables rate limiting.
+     * @param qpcFrequency QueryPerformanceFrequency value; timestamps passed to
+     *        ShouldReport are QueryPerformanceCounter ticks.
+     */
+    void Configure(const CrashRateLimitConfig& config, int64_t qpcFrequency) noexcept;
+
+    /**
+     * @brief Records one occurrence of @p key and decides whether to report it.
+     *
+     * @param key Crash site identity.
+     * @param timestamp QueryPerformanceCounter value of the occurrence.
+     * @return true if the occurrence fits in the site's bucket and should be published;
+     *         false if it was counted for the next summary instead.
+     *
+     * @note Async-signal safe: uses only atomic operations on static storage.
+     */
+    bool ShouldReport(const CrashSiteKey& key, int64_t timestamp) noexcept;
+
+    /**
+     * @brief Invokes @p sink for every site with suppressed occurrences and resets their
+     * suppressed counts.
+     *
+     * @param sink Callable invoked as sink(const CrashRepeatSummary&).
+     * @return Number of summaries delivered.
+     */
+    template <typename Sink>
+    size_t CollectRepeats(Sink&& sink) {
+        size_t delivered = 0;
+        for (size_t index = 0; index <= TABLE_SIZE; ++index) {
+            CrashRepeatSummary summary{};
+            if (TakeRepeats(index, summary)) {
+                sink(summary);
+                ++delivered;
+            }
+        }
+        return delivered;
+    }
+
+private:
+// Slots are padded to a cache line each (C4324 is expected)
+#pragma warning(push)
+#pragma warning(disable : 4324)
+    /**
+     * @brief One crash site: identity, token-bucket state and counters.
+     */
+    struct alignas(64) Slot {
+        // 0 while the slot is free; never reset once claimed
+        std::atomic<uint64_t> keyHash{0};
+
+        // Written once by the claiming thread, then published through ready
+        std::atomic<DWORD> exceptionCode{0};
+        std::atomic<uintptr_t> sanitizedAddress{0};
+        std::atomic<uintptr_t> instructionAddress{0};
+        std::atomic<bool> ready{false};
+
+        // GCRA theoretical arrival time, in QPC ticks
+        std::atomic<int64_t> theoreticalArrival{0};
+
+        std::atomic<uint64_t> totalCount{0};
+        std::atomic<uint64_t> suppressedCount{0};
+    };
+#pragma warning(pop)
+
+    /**
+     * @brief Returns the slot for @p key, or nullptr when no slot could be found or claimed.
+     */
+    Slot* FindOrClaim(const CrashSiteKey& key, uint64_t hash) noexcept;
+
+    /**
+     * @brief Applies the token bucket to one occurrence at @p timestamp.
+     */
+    bool Admit(Slot& slot, int64_t timestamp) noexcept;
+
+    /**
+     * @brief Reads and resets the suppressed count of slot @p index (TABLE_SIZE is the
+     * overflow bucket).
+     *
+     * @return true if @p out was filled with a non-empty summary.
+     */
+    bool TakeRepeats(size_t index, CrashRepeatSummary& out) noexcept;
+
+    Slot slots_[TABLE_SIZE]{};
+    Slot overflow_{};
+
+    // Token-bucket parameters in QPC ticks; emission interval 0 disables limiting
+    std::atomic<int64_t> ticksPerReport_{0};
+    std::atomic<int64_t> burstTolerance_{0};
+};
+
+} // namespace Bedrock
+} // namespace Sentinel
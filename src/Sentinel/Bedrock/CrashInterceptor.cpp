@@ -4,7 +4,11 @@
  */
 
 #include "Sentinel/Bedrock/CrashInterceptor.hpp"
+#include "Sentinel/Bedrock/StackTrace.hpp"
+#include "Sentinel/Utils/EtwTrace.hpp"
 #include "Sentinel/Utils/Logger.hpp"
+#include "Sentinel/Utils/Metrics.hpp"
+#include <mutex>
 #include <stdio.h>
 
 namespace Sentinel {
@@ -23,7 +27,269 @@ namespace Bedrock {
 // Masking lower 12 bits aligns addresses to page boundaries to prevent ASLR bypass
 static constexpr uintptr_t PAGE_OFFSET_MASK = 0xFFFULL;
 
+// Upper bound on how long a published crash record waits before the watchdog drains it
+// when the handler's wake-up signal is lost (e.g. the event could not be created)
+static constexpr DWORD WATCHDOG_INTERVAL_MS = 100;
+
+// Time spent in HandlerRoutine per interesting exception; filtered codes are not timed. Recording
+// touches only atomics in static storage, so it is safe inside the handler.
+static Utils::Histogram handlerLatency;
+static const Utils::MetricRegistration handlerLatencyMetric("crash.handler_ns", handlerLatency);
+
+// Static member initialization
+CrashRecordChannel CrashInterceptor::crashChannel_;
+CrashDedupTable CrashInterceptor::crashSites_;
+std::atomic<DWORD> CrashInterceptor::summaryIntervalMs_{CrashRateLimitConfig{}.summaryIntervalMs};
+std::atomic<bool> CrashInterceptor::rateLimitConfigured_{false};
+HANDLE CrashInterceptor::crashEvent_ = nullptr;
+HANDLE CrashInterceptor::watchdogThread_ = nullptr;
+std::mutex CrashInterceptor::drainMutex_;
+CrashInterceptor::PaddedCounter CrashInterceptor::exceptionCounters_[EXCEPTION_COUNTER_COUNT];
+
+bool CrashInterceptor::StartWatchdog() {
+    // Start the watchdog once, before the handler is registered, so the handler never
+    // observes a half-initialized event handle
+    static std::once_flag watchdogFlag;
+    std::call_once(watchdogFlag, []() {
+        if (!rateLimitConfigured_.load(std::memory_order_acquire)) {
+            ConfigureRateLimit(CrashRateLimitConfig{});
+        }
+        crashEvent_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        watchdogThread_ = CreateThread(nullptr, 0, WatchdogThreadProc, nullptr, 0, nullptr);
+    });
+    return watchdogThread_ != nullptr;
+}
+
+DWORD WINAPI CrashInterceptor::WatchdogThreadProc(LPVOID) {
+    ULONGLONG lastSummary = GetTickCount64();
+    for (;;) {
+        if (crashEvent_ != nullptr) {
+            WaitForSingleObject(crashEvent_, WATCHDOG_INTERVAL_MS);
+        } else {
+            Sleep(WATCHDOG_INTERVAL_MS);
+        }
+        DrainCrashRecords();
+        
+        // Suppressed repeats are reported on a schedule, not per occurrence
+        const ULONGLONG now = GetTickCount64();
+        if (now - lastSummary >= summaryIntervalMs_.load(std::memory_order_relaxed)) {
+            DrainCrashRepeats();
+            lastSummary = now;
+        }
+    }
+}
+
+size_t CrashInterceptor::FlushCrashRecords() {
+    // Records first, so a summary never precedes the occurrences it follows up on
+    size_t written = DrainCrashRecords();
+    written += DrainCrashRepeats();
+    return written;
+}
+
+size_t CrashInterceptor::DrainCrashRecords() {
+    std::lock_guard<std::mutex> lock(drainMutex_);
+    return crashChannel_.Drain(ReportCrashRecord);
+}
+
+size_t CrashInterceptor::DrainCrashRepeats() {
+    std::lock_guard<std::mutex> lock(drainMutex_);
+    return crashSites_.CollectRepeats(ReportCrashRepeat);
+}
+
+void CrashInterceptor::ConfigureRateLimit(const CrashRateLimitConfig& config) {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    crashSites_.Configure(config, frequency.QuadPart);
+    summaryIntervalMs_.store(config.summaryIntervalMs, std::memory_order_relaxed);
+    rateLimitConfigured_.store(true, std::memory_order_release);
+}
+
+bool CrashInterceptor::EnableMinidumps(const MinidumpConfig& config) {
+    return MinidumpWriter::Start(config);
+}
+
+uint64_t CrashInterceptor::GetDroppedCrashRecordCount() {
+    return crashChannel_.GetDroppedCount();
+}
+
+void CrashInterceptor::ReportCrashRecord(const CrashRecord& record) {
+    // Runs on the watchdog (or flushing) thread, where formatting and locking are safe
+    char logBuffer[256];
+    int result = -1;
+    
+    if (record.exceptionCode == STATUS_GUARD_PAGE_VIOLATION) {
+        result = sprintf_s(logBuffer, sizeof(logBuffer),
+                           "[CRITICAL] Guard Page Violation Detected at 0x%016llX (page-aligned)! (thread %lu)",
+                           static_cast<unsigned long long>(record.sanitizedAddress),
+                           static_cast<unsigned long>(record.threadId));
+    } else if (record.exceptionCode == STATUS_ACCESS_VIOLATION) {
+        // Decode access type string
+        // ExceptionInformation[0]: 0 = read, 1 = write, 8 = DEP violation
+        const char* accessTypeStr = "Access to";
+        switch (record.accessType) {
+            case 0:
+                accessTypeStr = "Read from";
+                break;
+            case 1:
+                accessTypeStr = "Write to";
+                break;
+            case 8:
+                accessTypeStr = "DEP violation at";
+                break;
+            default:
+                accessTypeStr = "Access to";
+                break;
+        }
+        
+        result = sprintf_s(logBuffer, sizeof(logBuffer),
+                           "[CRITICAL] Access Violation! %s address 0x%016llX (page-aligned) (thread %lu)",
+                           accessTypeStr,
+                           static_cast<unsigned long long>(record.sanitizedAddress),
+                           static_cast<unsigned long>(record.threadId));
+    }
+    
+    // Only log if formatting succeeded
+    if (result > 0) {
+        Utils::Logger::LogError(logBuffer);
+    } else {
+        // Fallback message if formatting fails (should never happen with static format)
+        Utils::Logger::LogError("[CRITICAL] Exception intercepted (formatting error)!");
+    }
+    
+    // Frames are symbolized here, off the faulting thread; repeated sites hit the cache
+    const bool traceEnabled = Utils::EtwTrace::IsEnabled(Utils::LogLevel::Error, Utils::EtwTrace::KEYWORD_CRASH);
+    std::string stack;
+    for (uint32_t frame = 0; frame < record.frameCount && frame < CRASH_STACK_CAPACITY; ++frame) {
+        const std::string symbol = SymbolResolver::Resolve(record.frames[frame], frame > 0);
+        Utils::Logger::Error("    #{} {}", frame, symbol);
+        if (traceEnabled) {
+            stack.append(stack.empty() ? "" : "\n").append(symbol);
+        }
+    }
+    
+    // Structured copy for ETW collectors; the text lines above reach them as Log events too
+    if (traceEnabled) {
+        TraceLoggingWrite(Utils::sentinelTraceProvider, "Crash", TraceLoggingLevel(WINEVENT_LEVEL_ERROR),
+                          TraceLoggingKeyword(Utils::EtwTrace::KEYWORD_CRASH),
+                          TraceLoggingHexUInt32(static_cast<UINT32>(record.exceptionCode), "ExceptionCode"),
+                          TraceLoggingHexUInt64(static_cast<UINT64>(record.sanitizedAddress), "PageAddress"),
+                          TraceLoggingUInt32(static_cast<UINT32>(record.accessType), "AccessType"),
+                          TraceLoggingUInt32(static_cast<UINT32>(record.threadId), "ThreadId"),
+                          TraceLoggingUtf8String(stack.c_str(), "Stack"));
+    }
+}
+
+void CrashInterceptor::ReportCrashRepeat(const CrashRepeatSummary& summary) {
+    char logBuffer[256];
+    int result = -1;
+    
+    if (summary.key.exceptionCode == 0) {
+        // Shared overflow bucket: sites that did not fit in the dedup table
+        result = sprintf_s(logBuffer, sizeof(logBuffer),
+                           "[CRITICAL] Untracked crash sites: %llu occurrences suppressed (%llu total)",
+                           static_cast<unsigned long long>(summary.suppressedCount),
+                           static_cast<unsigned long long>(summary.totalCount));
+    } else {
+        ExceptionClassification classification = ClassifyException(summary.key.exceptionCode);
+        const char* name = (classification.counterIndex != UNTRACKED_COUNTER_INDEX)
+            ? TRACKED_EXCEPTIONS[classification.counterIndex - 1].name
+            : "EXCEPTION";
+        
+        // The instruction address is a dedup key only; report its page like any address
+        result = sprintf_s(logBuffer, sizeof(logBuffer),
+                           "[CRITICAL] %s at 0x%016llX (page-aligned), code page 0x%016llX: "
+                           "repeated %llu more times (%llu total)",
+                           name,
+                           static_cast<unsigned long long>(summary.key.sanitizedAddress),
+                           static_cast<unsigned long long>(summary.key.instructionAddress & ~PAGE_OFFSET_MASK),
+                           static_cast<unsigned long long>(summary.suppressedCount),
+                           static_cast<unsigned long long>(summary.totalCount));
+    }
+    
+    if (result > 0) {
+        Utils::Logger::LogError(logBuffer);
+    }
+    
+    if (Utils::EtwTrace::IsEnabled(Utils::LogLevel::Error, Utils::EtwTrace::KEYWORD_CRASH)) {
+        TraceLoggingWrite(Utils::sentinelTraceProvider, "CrashRepeat", TraceLoggingLevel(WINEVENT_LEVEL_ERROR),
+                          TraceLoggingKeyword(Utils::EtwTrace::KEYWORD_CRASH),
+                          TraceLoggingHexUInt32(static_cast<UINT32>(summary.key.exceptionCode), "ExceptionCode"),
+                          TraceLoggingHexUInt64(static_cast<UINT64>(summary.key.sanitizedAddress), "PageAddress"),
+                          TraceLoggingUInt64(summary.suppressedCount, "Suppressed"),
+                          TraceLoggingUInt64(summary.totalCount, "Total"));
+    }
+}
+
+bool CrashInterceptor::PublishCrashRecord(CrashRecord& record, uintptr_t instructionAddress,
+                                          const CONTEXT* context) {
+    // Everything here must be async-signal safe: no heap, no CRT, no locks
+    LARGE_INTEGER timestamp;
+    QueryPerformanceCounter(&timestamp);
+    record.timestamp = timestamp.QuadPart;
+    
+    // Over-limit repeats of a known site are only counted; the watchdog summarizes them
+    const CrashSiteKey key{record.exceptionCode, record.sanitizedAddress, instructionAddress};
+    if (!crashSites_.ShouldReport(key, record.timestamp)) {
+        return false;
+    }
+    
+    record.threadId = GetCurrentThreadId();
+    
+    // Only admitted occurrences pay for the unwind
+    if (context != nullptr) {
+        record.frameCount = static_cast<uint32_t>(
+            StackWalker::CaptureFromContext(*context, record.frames, CRASH_STACK_CAPACITY));
+    }
+    
+    crashChannel_.Publish(record);
+    
+    // Wake the watchdog; SetEvent is a plain system call and takes no user-mode locks
+    if (crashEvent_ != nullptr) {
+        SetEvent(crashEvent_);
+    }
+    return true;
+}
+
+uint64_t CrashInterceptor::GetExceptionCount(DWORD code) {
+    ExceptionClassification classification = ClassifyException(code);
+    if (classification.counterIndex == UNTRACKED_COUNTER_INDEX) {
+        return 0;
+    }
+    return exceptionCounters_[classification.counterIndex].value.load(std::memory_order_relaxed);
+}
+
+uint64_t CrashInterceptor::GetUntrackedExceptionCount() {
+    return exceptionCounters_[UNTRACKED_COUNTER_INDEX].value.load(std::memory_order_relaxed);
+}
+
+size_t CrashInterceptor::GetExceptionCounters(ExceptionCounterSnapshot* out, size_t capacity) {
+    if (out == nullptr) {
+        return 0;
+    }
+    
+    size_t written = 0;
+    for (size_t index = 0; index < EXCEPTION_COUNTER_COUNT && written < capacity; ++index) {
+        ExceptionCounterSnapshot& entry = out[written++];
+        if (index == UNTRACKED_COUNTER_INDEX) {
+            entry.code = 0;
+            entry.name = "OTHER";
+        } else {
+            // Counter index i corresponds to TRACKED_EXCEPTIONS[i - 1]
+            entry.code = TRACKED_EXCEPTIONS[index - 1].code;
+            entry.name = TRACKED_EXCEPTIONS[index - 1].name;
+        }
+        entry.count = exceptionCounters_[index].value.load(std::memory_order_relaxed);
+    }
+    return written;
+}
+
 bool CrashInterceptor::Initialize() {
+    // Start the watchdog that drains crash records into the Logger.
+    // Without it records are still captured and can be drained with FlushCrashRecords().
+    if (!StartWatchdog()) {
+        Utils::Logger::LogError("Failed to start crash record watchdog thread");
+    }
+    
     // Register the Vectored Exception Handler with priority 1
     // Priority 1 ensures we execute before most handlers but after critical system handlers
     PVOID handler = AddVectoredExceptionHandler(1, HandlerRoutine);
@@ -47,6 +313,17 @@ LONG WINAPI CrashInterceptor::HandlerRoutine(PEXCEPTION_POINTERS ExceptionInfo)
     // Extract exception code for analysis
     DWORD exceptionCode = ExceptionInfo->ExceptionRecord->ExceptionCode;
     
+    // Fast path: one constexpr table lookup classifies the code; every exception is
+    // counted, but only interesting codes are processed further
+    ExceptionClassification classification = ClassifyException(exceptionCode);
+    exceptionCounters_[classification.counterIndex].value.fetch_add(1, std::memory_order_relaxed);
+    if (!classification.interesting) {
+        return EXCEPTION_CONTINUE_SEARCH;
+    }
+
+    // Only the interesting path is timed, so filtered codes stay a lookup and one counter
+    Utils::ScopedTimer latencyTimer(handlerLatency);
+    
     // Handle STATUS_GUARD_PAGE_VIOLATION (0x80000001)
     // This exception occurs when code accesses a guard page protected memory region
     // In the Sentinel architecture, this is used by the Integrity Engine for JIT decryption
@@ -64,29 +341,23 @@ LONG WINAPI CrashInterceptor::HandlerRoutine(PEXCEPTION_POINTERS ExceptionInfo)
         // This provides forensic information while protecting address space layout
         uintptr_t sanitizedAddress = reinterpret_cast<uintptr_t>(faultingAddress) & ~PAGE_OFFSET_MASK;
         
-        // Format log message using stack-based buffer to avoid heap allocation in exception handler
-        char logBuffer[256];
-        int result = sprintf_s(logBuffer, sizeof(logBuffer),
-                               "[CRITICAL] Guard Page Violation Detected at 0x%016llX (page-aligned)!",
-                               static_cast<unsigned long long>(sanitizedAddress));
-        
-        // Only log if formatting succeeded
-        if (result > 0) {
-            Utils::Logger::LogError(logBuffer);
-        } else {
-            // Fallback message if formatting fails (should never happen with static format)
-            Utils::Logger::LogError("[CRITICAL] Guard Page Violation Detected (formatting error)!");
+        // Hand the record to the watchdog instead of logging here: the faulting thread may
+        // hold the heap lock or the logger mutex, and re-acquiring either would deadlock
+        CrashRecord record{};
+        record.exceptionCode = exceptionCode;
+        record.sanitizedAddress = sanitizedAddress;
+        if (PublishCrashRecord(record, reinterpret_cast<uintptr_t>(ExceptionInfo->ExceptionRecord->ExceptionAddress),
+                               ExceptionInfo->ContextRecord)) {
+            // Hands the exception state to the dump worker (no-op unless enabled for guard pages)
+            MinidumpWriter::RequestDump(ExceptionInfo, true);
         }
         
-        // NOTE: This is where JIT decryption logic will be implemented in the future.
-        // The JIT decryption process will:
-        // 1. Validate that the faulting address is within the VM bytecode region
-        // 2. Temporarily remove PAGE_GUARD protection from the faulting page
-        // 3. Decrypt a single VM instruction into a secure execution buffer
-        // 4. Allow execution to continue (return EXCEPTION_CONTINUE_EXECUTION)
-        // 5. After instruction execution, restore PAGE_GUARD protection
+        // The integrity VM does not decrypt from this handler: a guard page round trip per
+        // VM instruction costs microseconds. Virtualization::SecureProgram decrypts whole
+        // windows (instruction, cache line or basic block) explicitly into a locked scratch
+        // arena instead, so no legitimate VM execution ever faults here.
         //
-        // For now, we simply log the violation and continue the search chain.
+        // The violation is recorded and the search chain continues.
         
         return EXCEPTION_CONTINUE_SEARCH;
     }
@@ -111,36 +382,15 @@ LONG WINAPI CrashInterceptor::HandlerRoutine(PEXCEPTION_POINTERS ExceptionInfo)
         // This provides forensic information while protecting address space layout
         uintptr_t sanitizedAddress = reinterpret_cast<uintptr_t>(faultingAddress) & ~PAGE_OFFSET_MASK;
         
-        // Decode access type string
-        const char* accessTypeStr = "Access to";
-        switch (accessType) {
-            case 0:
-                accessTypeStr = "Read from";
-                break;
-            case 1:
-                accessTypeStr = "Write to";
-                break;
-            case 8:
-                accessTypeStr = "DEP violation at";
-                break;
-            default:
-                accessTypeStr = "Access to";
-                break;
-        }
-        
-        // Format log message using stack-based buffer to avoid heap allocation in exception handler
-        char logBuffer[256];
-        int result = sprintf_s(logBuffer, sizeof(logBuffer),
-                               "[CRITICAL] Access Violation! %s address 0x%016llX (page-aligned)",
-                               accessTypeStr,
-                               static_cast<unsigned long long>(sanitizedAddress));
-        
-        // Only log if formatting succeeded
-        if (result > 0) {
-            Utils::Logger::LogError(logBuffer);
-        } else {
-            // Fallback message if formatting fails (should never happen with static format)
-            Utils::Logger::LogError("[CRITICAL] Access Violation (formatting error)!");
+        // Defer formatting and logging to the watchdog thread
+        CrashRecord record{};
+        record.exceptionCode = exceptionCode;
+        record.accessType = accessType;
+        record.sanitizedAddress = sanitizedAddress;
+        if (PublishCrashRecord(record, reinterpret_cast<uintptr_t>(ExceptionInfo->ExceptionRecord->ExceptionAddress),
+                               ExceptionInfo->ContextRecord)) {
+            // Capture a minidump on the pre-spawned worker while this thread waits
+            MinidumpWriter::RequestDump(ExceptionInfo);
         }
         
         // Continue the exception search chain
@@ -148,8 +398,7 @@ LONG WINAPI CrashInterceptor::HandlerRoutine(PEXCEPTION_POINTERS ExceptionInfo)
         return EXCEPTION_CONTINUE_SEARCH;
     }
     
-    // For all other exception types, immediately continue the search
-    // This ensures minimal overhead for expected exceptions
+    // Interesting codes without dedicated handling above continue the search
     return EXCEPTION_CONTINUE_SEARCH;
 }
 
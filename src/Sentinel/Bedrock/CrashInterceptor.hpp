@@ -38,9 +38,18 @@
  * @performance The exception handler is invoked on every exception in the process, including
  * expected exceptions from the CLR, system libraries, and application code. The handler must
  * execute with minimal latency to avoid impacting process performance. Current implementation:
- * - O(1) exception code comparison
+ * - O(1) exception code classification through a constexpr perfect-hash table
+ *   (see ExceptionFilter.hpp), with a relaxed per-code counter increment
  * - Direct API calls with no dynamic allocation
  * - Fast path for non-critical exceptions (EXCEPTION_CONTINUE_SEARCH)
+ * - No formatting or logging on the faulting thread: raw records are published to a
+ *   lock-free CrashRecordChannel and formatted later by a watchdog thread
+ * - Stack traces: admitted faults unwind the faulting stack from the CONTEXT into the
+ *   record; frames are symbolized later on the watchdog through a cached SymbolResolver
+ * - Optional minidumps: reported faults can hand their EXCEPTION_RECORD and CONTEXT to a
+ *   pre-spawned MinidumpWriter worker; MiniDumpWriteDump never runs on the faulting thread
+ * - Bounded cost during fault storms: repeated faults at one site are rate limited by a
+ *   lock-free CrashDedupTable and reported as periodic "repeated N times" summaries
  * 
  * @see https://docs.microsoft.com/en-us/windows/win32/debug/vectored-exception-handling
  * @see ARCHITECTURE.md Section 2: Module A - The Crash Interceptor
@@ -48,11 +57,33 @@
 
 #pragma once
 
+#include "Sentinel/Bedrock/CrashDedupTable.hpp"
+#include "Sentinel/Bedrock/CrashRecordChannel.hpp"
+#include "Sentinel/Bedrock/ExceptionFilter.hpp"
+#include "Sentinel/Bedrock/MinidumpWriter.hpp"
+#include <atomic>
 #include <Windows.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
 
 namespace Sentinel {
 namespace Bedrock {
 
+/**
+ * @brief Point-in-time value of one per-code exception counter.
+ */
+struct ExceptionCounterSnapshot {
+    /** @brief Exception code, or 0 for the bucket of untracked codes. */
+    DWORD code;
+
+    /** @brief Name from TRACKED_EXCEPTIONS, or "OTHER" for untracked codes. */
+    const char* name;
+
+    /** @brief Number of first-chance exceptions observed since process start. */
+    uint64_t count;
+};
+
 /**
  * @class CrashInterceptor
  * @brief Manages Vectored Exception Handling for system stability monitoring.
@@ -64,7 +95,8 @@ namespace Bedrock {
  * The class handles:
  * - VEH registration through the Windows API
  * - Exception filtering based on exception codes
- * - Logging of critical exceptions for forensic analysis
+ * - Logging of critical exceptions for forensic analysis (via a watchdog thread that
+ *   drains the lock-free crash record channel into the Logger)
  * - Preparation for future JIT decryption logic (guard page handling)
  * 
  * Usage example:
@@ -113,6 +145,85 @@ public:
      */
     bool Initialize();
 
+    /**
+     * @brief Drains pending crash records into the Logger on the calling thread.
+     * 
+     * @details The watchdog thread drains records periodically and whenever the handler
+     * signals it. Applications should also call this before shutting down the Logger so
+     * that records published just before exit are not lost. Unlike the watchdog, this also
+     * writes pending "repeated N times" summaries without waiting for the summary interval.
+     * 
+     * @return Number of crash records and summaries written.
+     * 
+     * @threadsafe This method is thread-safe. It must not be called from inside an
+     * exception handler.
+     */
+    static size_t FlushCrashRecords();
+
+    /**
+     * @brief Returns how many crash records were dropped because the channel was full.
+     * 
+     * @threadsafe This method is thread-safe.
+     */
+    static uint64_t GetDroppedCrashRecordCount();
+
+    /**
+     * @brief Sets the per-site token bucket and the summary interval for repeated faults.
+     * 
+     * @details Each crash site (exception code, data page, faulting instruction) reports
+     * up to config.burst occurrences back to back, then config.reportsPerSecond; the rest
+     * are counted and summarized by the watchdog every config.summaryIntervalMs. May be
+     * called before or after Initialize.
+     * 
+     * @threadsafe This method is thread-safe.
+     */
+    static void ConfigureRateLimit(const CrashRateLimitConfig& config);
+
+    /**
+     * @brief Enables minidump capture for reported access violations.
+     * 
+     * @details Starts the MinidumpWriter worker. From then on, every access violation
+     * that passes the per-site rate limit (and guard page violations, if
+     * config.dumpOnGuardPage is set) requests a dump, subject to the writer's own
+     * per-minute throttle.
+     * 
+     * @return true if the dump worker is running.
+     * 
+     * @threadsafe This method is thread-safe.
+     */
+    static bool EnableMinidumps(const MinidumpConfig& config);
+
+    /**
+     * @brief Returns how many times an exception code has passed through the handler.
+     * 
+     * @param code Exception code to query.
+     * @return Count for a tracked code, or 0 if the code is not in TRACKED_EXCEPTIONS
+     *         (untracked codes are aggregated; see GetUntrackedExceptionCount).
+     * 
+     * @threadsafe This method is thread-safe. Counters are relaxed, so values observed
+     * concurrently with exceptions are approximate.
+     */
+    static uint64_t GetExceptionCount(DWORD code);
+
+    /**
+     * @brief Returns the number of exceptions whose code is not individually tracked.
+     * 
+     * @threadsafe This method is thread-safe.
+     */
+    static uint64_t GetUntrackedExceptionCount();
+
+    /**
+     * @brief Copies every exception counter (untracked bucket first) into @p out.
+     * 
+     * @param out Destination array.
+     * @param capacity Number of entries available in @p out; EXCEPTION_COUNTER_COUNT
+     *        entries are needed for a complete snapshot.
+     * @return Number of entries written.
+     * 
+     * @threadsafe This method is thread-safe.
+     */
+    static size_t GetExceptionCounters(ExceptionCounterSnapshot* out, size_t capacity);
+
 private:
     /**
      * @brief Vectored Exception Handler routine for crash interception.
@@ -127,8 +238,8 @@ private:
      *    - Occurs when code attempts to access a memory page protected with PAGE_GUARD
      *    - In Sentinel, this is used by the Integrity Engine for JIT decryption
      *    - Currently logs the violation and returns EXCEPTION_CONTINUE_SEARCH
-     *    - Future: Will implement JIT decryption logic to temporarily remove guard protection,
-     *      decrypt a single VM instruction, execute it, and restore protection
+     *    - VM decryption itself does not fault: SecureProgram decrypts instruction, cache
+     *      line or basic block windows explicitly, avoiding one exception per instruction
      * 
      * 2. STATUS_ACCESS_VIOLATION:
      *    - Indicates illegal memory access (null pointer, buffer overflow, etc.)
@@ -136,7 +247,8 @@ private:
      *    - Returns EXCEPTION_CONTINUE_SEARCH to allow normal exception handling
      * 
      * 3. All other exceptions:
-     *    - Returns EXCEPTION_CONTINUE_SEARCH immediately to minimize overhead
+     *    - Counted in their per-code counter (or the untracked bucket) after a single
+     *      constexpr table lookup, then EXCEPTION_CONTINUE_SEARCH is returned immediately
      * 
      * Address Sanitization:
      * - All logged addresses are masked to 4KB page boundaries (lower 12 bits cleared)
@@ -155,18 +267,19 @@ private:
      *       - Execute quickly to avoid performance degradation
      *       - Avoid operations that could themselves trigger exceptions
      *       - Not perform dynamic memory allocation (heap may be corrupted)
-     *       - Use thread-safe logging mechanisms
+     *       - Not take locks the faulting thread may already hold (heap, CRT, logger)
      * 
-     * @implementation Uses sprintf_s with stack-based buffers to avoid heap allocation.
-     *                 All string formatting is done on the stack for maximum performance
-     *                 and safety in the exception handling context.
+     * @implementation Captures raw fields into a CrashRecord and publishes it to the
+     *                 preallocated CrashRecordChannel with atomic operations only. The
+     *                 watchdog thread formats records with sprintf_s and forwards them to
+     *                 the Logger outside the exception context.
      * 
      * @security This handler has access to the complete process state. All addresses
-     *           are sanitized to page boundaries before logging to prevent ASLR bypass.
-     *           Uses sprintf_s to prevent buffer overflows.
+     *           are sanitized to page boundaries before they are recorded to prevent
+     *           ASLR bypass.
      * 
      * @performance This function is called on every exception. Current implementation
-     *              uses fast-path logic with O(1) comparisons, stack-based formatting,
+     *              uses fast-path logic with O(1) comparisons, a lock-free slot claim,
      *              and immediate return for non-critical exceptions.
      * 
      * @threadsafe This function may be called concurrently from multiple threads if
@@ -175,6 +288,114 @@ private:
      * @see https://docs.microsoft.com/en-us/windows/win32/api/errhandlingapi/nf-errhandlingapi-addvectoredexceptionhandler
      */
     static LONG WINAPI HandlerRoutine(PEXCEPTION_POINTERS ExceptionInfo);
+
+    /**
+     * @brief Stamps a record with thread id and timestamp, publishes it and wakes the watchdog.
+     * 
+     * @details Occurrences over their site's rate limit are only counted in crashSites_.
+     * Admitted occurrences also capture the faulting stack from @p context.
+     * 
+     * @return true if the record was published (not rate limited).
+     * 
+     * @note Async-signal safe; called from HandlerRoutine.
+     */
+    static bool PublishCrashRecord(CrashRecord& record, uintptr_t instructionAddress, const CONTEXT* context);
+
+    /**
+     * @brief Formats a crash record and writes it through the Logger.
+     * 
+     * @note Runs on the watchdog or flushing thread, never inside the handler.
+     */
+    static void ReportCrashRecord(const CrashRecord& record);
+
+    /**
+     * @brief Formats a "repeated N times" summary and writes it through the Logger.
+     */
+    static void ReportCrashRepeat(const CrashRepeatSummary& summary);
+
+    /**
+     * @brief Drains the crash record channel under drainMutex_.
+     */
+    static size_t DrainCrashRecords();
+
+    /**
+     * @brief Writes summaries for every site with suppressed occurrences under drainMutex_.
+     */
+    static size_t DrainCrashRepeats();
+
+    /**
+     * @brief Creates the wake-up event and watchdog thread (once per process).
+     * 
+     * @return true if the watchdog thread is running.
+     */
+    static bool StartWatchdog();
+
+    /**
+     * @brief Watchdog thread body: waits for the handler's signal and drains the channel.
+     */
+    static DWORD WINAPI WatchdogThreadProc(LPVOID parameter);
+
+    /**
+     * @brief Preallocated crash record slots shared by all handler invocations.
+     * 
+     * @details Constant-initialized static storage, so it is usable from the handler
+     * regardless of dynamic initialization order.
+     */
+    static CrashRecordChannel crashChannel_;
+
+    /**
+     * @brief Per-site rate limiter consulted before publishing.
+     * 
+     * @details Constant-initialized for the same reason as crashChannel_. Until it is
+     * configured (StartWatchdog or ConfigureRateLimit) every occurrence is reported.
+     */
+    static CrashDedupTable crashSites_;
+
+    /**
+     * @brief Milliseconds between repeat summaries written by the watchdog.
+     */
+    static std::atomic<DWORD> summaryIntervalMs_;
+
+    /**
+     * @brief Set once ConfigureRateLimit ran, so StartWatchdog keeps the caller's settings.
+     */
+    static std::atomic<bool> rateLimitConfigured_;
+
+    /**
+     * @brief Auto-reset event signalled by the handler after publishing a record.
+     */
+    static HANDLE crashEvent_;
+
+    /**
+     * @brief Watchdog thread handle. The thread lives for the process lifetime.
+     */
+    static HANDLE watchdogThread_;
+
+    /**
+     * @brief Serializes drains between the watchdog and explicit FlushCrashRecords calls.
+     * 
+     * @details Never taken on the handler path.
+     */
+    static std::mutex drainMutex_;
+
+// Counters are deliberately padded to a cache line each (C4324 is expected)
+#pragma warning(push)
+#pragma warning(disable : 4324)
+    /**
+     * @brief A relaxed counter on its own cache line.
+     * 
+     * @details Padding prevents a storm of one exception class (e.g. C++ throws on many
+     * threads) from slowing down counting of every other class through false sharing.
+     */
+    struct alignas(64) PaddedCounter {
+        std::atomic<uint64_t> value{0};
+    };
+#pragma warning(pop)
+
+    /**
+     * @brief Per-code exception counters indexed by ExceptionClassification::counterIndex.
+     */
+    static PaddedCounter exceptionCounters_[EXCEPTION_COUNTER_COUNT];
 };
 
 } // namespace Bedrock
@@ -0,0 +1,56 @@
+/**
+ * @file CrashRecordChannel.cpp
+ * @brief Implementation of the lock-free crash record channel.
+ */
+
+#include "Sentinel/Bedrock/CrashRecordChannel.hpp"
+#include <algorithm>
+
+namespace Sentinel {
+namespace Bedrock {
+
+// Slot count must be a power of two so ticket wrapping is a mask
+static_assert((CrashRecordChannel::SLOT_COUNT & (CrashRecordChannel::SLOT_COUNT - 1)) == 0,
+              "CrashRecordChannel::SLOT_COUNT must be a power of two");
+
+bool CrashRecordChannel::Publish(const CrashRecord& record) noexcept {
+    // The ticket picks the starting slot and doubles as the ordering key for Drain
+    const uint64_t ticket = writeCursor_.fetch_add(1, std::memory_order_relaxed);
+
+    // Probe forward from the ticket slot; a busy slot means the reader (or another
+    // writer) has not finished with it yet, so try the next one instead of waiting
+    for (size_t probe = 0; probe < SLOT_COUNT; ++probe) {
+        Slot& slot = slots_[(ticket + probe) & (SLOT_COUNT - 1)];
+        uint32_t expected = SLOT_FREE;
+        if (slot.state.compare_exchange_strong(expected, SLOT_WRITING, std::memory_order_acquire)) {
+            slot.record = record;
+            slot.record.sequence = ticket;
+            slot.state.store(SLOT_READY, std::memory_order_release);
+            return true;
+        }
+    }
+
+    // Every slot is occupied: drop rather than block the faulting thread
+    droppedCount_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+size_t CrashRecordChannel::Collect(CrashRecord (&out)[SLOT_COUNT]) noexcept {
+    size_t count = 0;
+    for (Slot& slot : slots_) {
+        uint32_t expected = SLOT_READY;
+        if (slot.state.compare_exchange_strong(expected, SLOT_READING, std::memory_order_acquire)) {
+            out[count++] = slot.record;
+            slot.state.store(SLOT_FREE, std::memory_order_release);
+        }
+    }
+
+    // Slots are scanned in array order; restore the order in which records were published
+    std::sort(out, out + count, [](const CrashRecord& a, const CrashRecord& b) {
+        return a.sequence < b.sequence;
+    });
+    return count;
+}
+
+} // namespace Bedrock
+} // namespace Sentinel
@@ -0,0 +1,179 @@
+/**
+ * @file CrashRecordChannel.hpp
+ * @brief Preallocated, lock-free channel for handing crash records out of the VEH.
+ *
+ * @details This module exists because the Vectored Exception Handler cannot safely call
+ * into the Logger. A fault can be raised while the faulting thread already holds the
+ * process heap lock, a CRT lock, or the Logger's console mutex; any of those being
+ * re-acquired from inside the handler deadlocks the process. Even when no lock is held,
+ * formatting and console I/O make the handler slow exactly when a fault storm is going on.
+ *
+ * The channel replaces that direct call with a fixed array of record slots living in
+ * static storage. The handler claims a slot with atomic operations only, fills in raw
+ * fields (no string formatting), and signals a watchdog thread, which later formats the
+ * records and forwards them to the normal Logger from an ordinary thread context.
+ *
+ * The design prioritizes:
+ * - Async-signal safety: no heap, no CRT, no locks on the publishing side
+ * - Bounded cost: slot claiming is a fetch_add plus at most SLOT_COUNT CAS probes
+ * - Graceful overload: when every slot is occupied, records are counted and dropped
+ *   rather than blocking the faulting thread
+ *
+ * @security Records carry page-aligned data addresses (see CrashInterceptor). The captured
+ * stack frames are precise code addresses; they are rendered only as module+offset by
+ * SymbolResolver, so nothing written to the log can be used to bypass ASLR.
+ *
+ * @performance Publish is wait-free in the common case (one fetch_add and one CAS). Drain
+ * is O(SLOT_COUNT) and runs on the watchdog thread only.
+ *
+ * @see CrashInterceptor
+ */
+
+#pragma once
+
+#include <Windows.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Sentinel {
+namespace Bedrock {
+
+/** @brief Maximum stack frames captured per crash record. */
+inline constexpr size_t CRASH_STACK_CAPACITY = 16;
+
+/**
+ * @brief Raw, unformatted description of an intercepted exception.
+ *
+ * @details Plain data only, so that filling it in from the handler cannot allocate or
+ * fault. Formatting happens on the watchdog thread.
+ */
+struct CrashRecord {
+    /** @brief Monotonic publish ticket used to restore publication order on drain. */
+    uint64_t sequence;
+
+    /** @brief QueryPerformanceCounter value captured in the handler. */
+    LONGLONG timestamp;
+
+    /** @brief Exception code from the EXCEPTION_RECORD. */
+    DWORD exceptionCode;
+
+    /** @brief Id of the faulting thread. */
+    DWORD threadId;
+
+    /** @brief ExceptionInformation[0] (access type for access violations). */
+    ULONG_PTR accessType;
+
+    /** @brief Faulting data address masked to its page boundary. */
+    uintptr_t sanitizedAddress;
+
+    /** @brief Number of valid entries in frames. */
+    uint32_t frameCount;
+
+    /**
+     * @brief Code addresses of the faulting stack, innermost first.
+     *
+     * @details Precise addresses: they are only symbolized (as module-relative offsets)
+     * and are never logged directly.
+     */
+    uintptr_t frames[CRASH_STACK_CAPACITY];
+};
+
+/**
+ * @class CrashRecordChannel
+ * @brief Fixed-size slot array with lock-free claiming, drained by a single reader.
+ *
+ * @details Each slot carries a state word (Free, Writing, Ready, Reading). Writers claim a
+ * slot by moving it from Free to Writing with a CAS, starting at a ticket obtained from a
+ * shared cursor so concurrent writers usually land on different slots. The reader moves
+ * Ready slots to Reading, copies them out and releases them back to Free.
+ *
+ * The class is constexpr-constructible so a static instance is constant-initialized and
+ * usable from an exception handler before any dynamic initializer has run.
+ *
+ * Usage example:
+ * @code
+ * static CrashRecordChannel channel;
+ * // In the VEH:
+ * channel.Publish(record);
+ * // On the watchdog thread:
+ * channel.Drain([](const CrashRecord& r) { Report(r); });
+ * @endcode
+ *
+ * @threadsafe Publish may be called concurrently from any thread, including from inside an
+ * exception handler. Drain must only be called from one thread at a time.
+ */
+class CrashRecordChannel {
+public:
+    /** @brief Number of preallocated slots. Power of two for cheap wrapping. */
+    static constexpr size_t SLOT_COUNT = 64;
+
+    constexpr CrashRecordChannel() = default;
+
+    CrashRecordChannel(const CrashRecordChannel&) = delete;
+    CrashRecordChannel& operator=(const CrashRecordChannel&) = delete;
+
+    /**
+     * @brief Copies a record into a free slot.
+     *
+     * @param record Record to publish. The sequence field is assigned by the channel.
+     * @return true if a slot was claimed, false if every slot was occupied (the record is
+     *         counted as dropped).
+     *
+     * @note Async-signal safe: uses only atomic operations on static storage.
+     */
+    bool Publish(const CrashRecord& record) noexcept;
+
+    /**
+     * @brief Removes every ready record and invokes @p sink for each, in publish order.
+     *
+     * @details Ready slots are copied to a stack array and released before @p sink runs,
+     * so a slow sink never holds slots that the handler needs.
+     *
+     * @param sink Callable invoked as sink(const CrashRecord&).
+     * @return Number of records delivered.
+     */
+    template <typename Sink>
+    size_t Drain(Sink&& sink) {
+        CrashRecord batch[SLOT_COUNT];
+        size_t count = Collect(batch);
+        for (size_t i = 0; i < count; ++i) {
+            sink(batch[i]);
+        }
+        return count;
+    }
+
+    /**
+     * @brief Returns the number of records dropped because the channel was full.
+     */
+    uint64_t GetDroppedCount() const noexcept {
+        return droppedCount_.load(std::memory_order_relaxed);
+    }
+
+private:
+    enum SlotState : uint32_t {
+        SLOT_FREE = 0,
+        SLOT_WRITING = 1,
+        SLOT_READY = 2,
+        SLOT_READING = 3
+    };
+
+    struct Slot {
+        std::atomic<uint32_t> state{SLOT_FREE};
+        CrashRecord record{};
+    };
+
+    /**
+     * @brief Copies and releases all ready slots into @p out, sorted by sequence.
+     *
+     * @return Number of records copied.
+     */
+    size_t Collect(CrashRecord (&out)[SLOT_COUNT]) noexcept;
+
+    Slot slots_[SLOT_COUNT]{};
+    std::atomic<uint64_t> writeCursor_{0};
+    std::atomic<uint64_t> droppedCount_{0};
+};
+
+} // namespace Bedrock
+} // namespace Sentinel
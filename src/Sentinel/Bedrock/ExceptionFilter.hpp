@@ -0,0 +1,217 @@
+/**
+ * @file ExceptionFilter.hpp
+ * @brief Compile-time exception code table used by the VEH fast path.
+ *
+ * @details This module exists because every first-chance exception in the process passes
+ * through CrashInterceptor::HandlerRoutine - including the very frequent ones Sentinel does
+ * not act on, such as C++ throws (0xE06D7363), debugger breakpoints and
+ * DBG_PRINTEXCEPTION_C from OutputDebugString. For those codes the handler should cost a
+ * single table lookup and a counter increment before returning EXCEPTION_CONTINUE_SEARCH.
+ *
+ * The table maps a known set of exception codes to a dense counter index and a
+ * classification flag through a perfect hash computed at compile time:
+ * - index = (code * EXCEPTION_HASH_MULTIPLIER) >> (32 - EXCEPTION_TABLE_BITS)
+ * - a static_assert proves the hash is collision-free for the tracked codes, so a lookup
+ *   is always exactly one load and one compare; untracked codes fall into an "other" bucket
+ *
+ * Counting every exception, not only the interesting ones, answers "how often do
+ * exceptions fire in production?" without logging each occurrence.
+ *
+ * @security The table is constexpr data in a read-only section; it cannot be patched at
+ * runtime to hide an exception class from the interceptor without first changing page
+ * protection.
+ *
+ * @performance Classify() is branch-light O(1): a multiply, a shift, one 8-byte load and a
+ * compare. The whole table is 512 bytes (eight cache lines).
+ *
+ * @see CrashInterceptor
+ */
+
+#pragma once
+
+#include <Windows.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace Sentinel {
+namespace Bedrock {
+
+/**
+ * @brief Exception codes referenced by the filter.
+ *
+ * @details Defined explicitly because several are not exposed by <Windows.h> in every
+ * build configuration (e.g. the MSVC C++ and CLR exception codes are not public macros).
+ */
+namespace ExceptionCodes {
+inline constexpr DWORD ACCESS_VIOLATION = 0xC0000005UL;
+inline constexpr DWORD GUARD_PAGE_VIOLATION = 0x80000001UL;
+inline constexpr DWORD BREAKPOINT = 0x80000003UL;
+inline constexpr DWORD SINGLE_STEP = 0x80000004UL;
+inline constexpr DWORD DBG_CONTROL_C_EVENT = 0x40010005UL;
+inline constexpr DWORD DBG_PRINT = 0x40010006UL;
+inline constexpr DWORD DBG_PRINT_WIDE = 0x4001000AUL;
+inline constexpr DWORD MSVC_THREAD_NAME = 0x406D1388UL;
+inline constexpr DWORD MSVC_CPP_EXCEPTION = 0xE06D7363UL;
+inline constexpr DWORD CLR_EXCEPTION = 0xE0434352UL;
+inline constexpr DWORD RPC_SERVER_UNAVAILABLE = 0x000006BAUL;
+inline constexpr DWORD IN_PAGE_ERROR = 0xC0000006UL;
+inline constexpr DWORD ILLEGAL_INSTRUCTION = 0xC000001DUL;
+inline constexpr DWORD ARRAY_BOUNDS_EXCEEDED = 0xC000008CUL;
+inline constexpr DWORD INTEGER_DIVIDE_BY_ZERO = 0xC0000094UL;
+inline constexpr DWORD INTEGER_OVERFLOW = 0xC0000095UL;
+inline constexpr DWORD PRIVILEGED_INSTRUCTION = 0xC0000096UL;
+inline constexpr DWORD STACK_OVERFLOW = 0xC00000FDUL;
+inline constexpr DWORD HEAP_CORRUPTION = 0xC0000374UL;
+inline constexpr DWORD STACK_BUFFER_OVERRUN = 0xC0000409UL;
+} // namespace ExceptionCodes
+
+/**
+ * @brief Static description of one tracked exception code.
+ */
+struct TrackedException {
+    /** @brief Exception code as reported in EXCEPTION_RECORD::ExceptionCode. */
+    DWORD code;
+
+    /** @brief Short human-readable name used in counter reports. */
+    const char* name;
+
+    /** @brief true if HandlerRoutine must inspect the exception beyond counting it. */
+    bool interesting;
+};
+
+/**
+ * @brief Every exception code the interceptor counts individually.
+ *
+ * @details The order defines counter indices (index 0 is reserved for untracked codes).
+ * Only access violations and guard page violations are currently "interesting"; the
+ * remainder are counted so production exception rates are observable.
+ */
+inline constexpr TrackedException TRACKED_EXCEPTIONS[] = {
+    {ExceptionCodes::ACCESS_VIOLATION, "ACCESS_VIOLATION", true},
+    {ExceptionCodes::GUARD_PAGE_VIOLATION, "GUARD_PAGE_VIOLATION", true},
+    {ExceptionCodes::BREAKPOINT, "BREAKPOINT", false},
+    {ExceptionCodes::SINGLE_STEP, "SINGLE_STEP", false},
+    {ExceptionCodes::DBG_CONTROL_C_EVENT, "DBG_CONTROL_C", false},
+    {ExceptionCodes::DBG_PRINT, "DBG_PRINTEXCEPTION_C", false},
+    {ExceptionCodes::DBG_PRINT_WIDE, "DBG_PRINTEXCEPTION_WIDE_C", false},
+    {ExceptionCodes::MSVC_THREAD_NAME, "MSVC_SET_THREAD_NAME", false},
+    {ExceptionCodes::MSVC_CPP_EXCEPTION, "MSVC_CPP_EXCEPTION", false},
+    {ExceptionCodes::CLR_EXCEPTION, "CLR_EXCEPTION", false},
+    {ExceptionCodes::RPC_SERVER_UNAVAILABLE, "RPC_S_SERVER_UNAVAILABLE", false},
+    {ExceptionCodes::IN_PAGE_ERROR, "IN_PAGE_ERROR", false},
+    {ExceptionCodes::ILLEGAL_INSTRUCTION, "ILLEGAL_INSTRUCTION", false},
+    {ExceptionCodes::ARRAY_BOUNDS_EXCEEDED, "ARRAY_BOUNDS_EXCEEDED", false},
+    {ExceptionCodes::INTEGER_DIVIDE_BY_ZERO, "INTEGER_DIVIDE_BY_ZERO", false},
+    {ExceptionCodes::INTEGER_OVERFLOW, "INTEGER_OVERFLOW", false},
+    {ExceptionCodes::PRIVILEGED_INSTRUCTION, "PRIVILEGED_INSTRUCTION", false},
+    {ExceptionCodes::STACK_OVERFLOW, "STACK_OVERFLOW", false},
+    {ExceptionCodes::HEAP_CORRUPTION, "HEAP_CORRUPTION", false},
+    {ExceptionCodes::STACK_BUFFER_OVERRUN, "STACK_BUFFER_OVERRUN", false},
+};
+
+/** @brief Number of individually tracked codes. */
+inline constexpr size_t TRACKED_EXCEPTION_COUNT = sizeof(TRACKED_EXCEPTIONS) / sizeof(TRACKED_EXCEPTIONS[0]);
+
+/** @brief Counter slots: one per tracked code plus the "other" bucket at index 0. */
+inline constexpr size_t EXCEPTION_COUNTER_COUNT = TRACKED_EXCEPTION_COUNT + 1;
+
+/** @brief Counter index used for codes not present in TRACKED_EXCEPTIONS. */
+inline constexpr uint8_t UNTRACKED_COUNTER_INDEX = 0;
+
+/** @brief log2 of the hash table size. */
+inline constexpr unsigned EXCEPTION_TABLE_BITS = 6;
+
+/** @brief Number of hash table slots. */
+inline constexpr size_t EXCEPTION_TABLE_SIZE = size_t{1} << EXCEPTION_TABLE_BITS;
+
+/**
+ * @brief Multiplier for the perfect hash.
+ *
+ * @details Chosen so the tracked codes map to distinct slots (enforced below). If a new
+ * code introduces a collision, the static_assert fires; pick another odd multiplier.
+ */
+inline constexpr uint32_t EXCEPTION_HASH_MULTIPLIER = 0x27D4EB2FU;
+
+/**
+ * @brief Result of classifying an exception code.
+ */
+struct ExceptionClassification {
+    /** @brief Index into the interceptor's counter array. */
+    uint8_t counterIndex;
+
+    /** @brief true if the handler must process the exception further. */
+    bool interesting;
+};
+
+/**
+ * @brief Perfect-hash slot index for an exception code.
+ */
+constexpr size_t ExceptionTableIndex(DWORD code) noexcept {
+    return static_cast<size_t>((static_cast<uint32_t>(code) * EXCEPTION_HASH_MULTIPLIER) >> (32 - EXCEPTION_TABLE_BITS));
+}
+
+namespace Detail {
+
+/**
+ * @brief One hash table slot: the code it holds and the classification to return.
+ */
+struct ExceptionTableSlot {
+    DWORD code;
+    ExceptionClassification classification;
+};
+
+struct ExceptionTable {
+    ExceptionTableSlot slots[EXCEPTION_TABLE_SIZE];
+    bool collisionFree;
+};
+
+consteval ExceptionTable BuildExceptionTable() {
+    ExceptionTable table{};
+    table.collisionFree = true;
+    for (size_t i = 0; i < EXCEPTION_TABLE_SIZE; ++i) {
+        // Empty slots hold a code that never hashes to them, so lookups miss cleanly.
+        // Code 0 (STATUS_SUCCESS) is never raised as an exception.
+        table.slots[i] = {0, {UNTRACKED_COUNTER_INDEX, false}};
+    }
+    for (size_t i = 0; i < TRACKED_EXCEPTION_COUNT; ++i) {
+        ExceptionTableSlot& slot = table.slots[ExceptionTableIndex(TRACKED_EXCEPTIONS[i].code)];
+        if (slot.code != 0) {
+            table.collisionFree = false;
+        }
+        slot = {TRACKED_EXCEPTIONS[i].code,
+                {static_cast<uint8_t>(i + 1), TRACKED_EXCEPTIONS[i].interesting}};
+    }
+    return table;
+}
+
+inline constexpr ExceptionTable EXCEPTION_TABLE = BuildExceptionTable();
+
+static_assert(EXCEPTION_TABLE.collisionFree,
+              "EXCEPTION_HASH_MULTIPLIER produces a collision for TRACKED_EXCEPTIONS; choose another multiplier");
+static_assert(EXCEPTION_COUNTER_COUNT <= 255, "Counter indices must fit in uint8_t");
+
+} // namespace Detail
+
+/**
+ * @brief Classifies an exception code with a single table lookup.
+ *
+ * @param code Exception code from EXCEPTION_RECORD::ExceptionCode.
+ * @return Counter index and whether the code needs further handling.
+ *
+ * @note Async-signal safe: reads constexpr data only.
+ */
+constexpr ExceptionClassification ClassifyException(DWORD code) noexcept {
+    const Detail::ExceptionTableSlot& slot = Detail::EXCEPTION_TABLE.slots[ExceptionTableIndex(code)];
+    if (slot.code == code && code != 0) {
+        return slot.classification;
+    }
+    return {UNTRACKED_COUNTER_INDEX, false};
+}
+
+static_assert(ClassifyException(ExceptionCodes::ACCESS_VIOLATION).interesting);
+static_assert(ClassifyException(ExceptionCodes::GUARD_PAGE_VIOLATION).interesting);
+static_assert(!ClassifyException(ExceptionCodes::MSVC_CPP_EXCEPTION).interesting);
+static_assert(ClassifyException(0x12345678UL).counterIndex == UNTRACKED_COUNTER_INDEX);
+
+} // namespace Bedrock
+} // namespace Sentinel
@@ -0,0 +1,229 @@
+/**
+ * @file MinidumpWriter.cpp
+ * @brief Implementation of the asynchronous minidump pipeline.
+ */
+
+#include "Sentinel/Bedrock/MinidumpWriter.hpp"
+#include "Sentinel/Bedrock/StackTrace.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+#include <cwchar>
+
+namespace Sentinel {
+namespace Bedrock {
+
+// Length of the throttle window
+static constexpr ULONGLONG THROTTLE_WINDOW_MS = 60 * 1000;
+
+// Static member initialization
+MinidumpWriter::CaptureArea MinidumpWriter::capture_{};
+std::atomic<uint32_t> MinidumpWriter::captureState_{CAPTURE_IDLE};
+HANDLE MinidumpWriter::requestEvent_ = nullptr;
+HANDLE MinidumpWriter::completionEvent_ = nullptr;
+std::atomic<uint64_t> MinidumpWriter::requestGeneration_{0};
+std::atomic<uint64_t> MinidumpWriter::completedGeneration_{0};
+HANDLE MinidumpWriter::workerThread_ = nullptr;
+DWORD MinidumpWriter::workerThreadId_ = 0;
+std::atomic<bool> MinidumpWriter::active_{false};
+std::atomic<uint32_t> MinidumpWriter::maxDumpsPerMinute_{0};
+std::atomic<DWORD> MinidumpWriter::waitForDumpMs_{0};
+std::atomic<bool> MinidumpWriter::dumpOnGuardPage_{false};
+std::mutex MinidumpWriter::configMutex_;
+wchar_t MinidumpWriter::directory_[MAX_PATH] = L".";
+MINIDUMP_TYPE MinidumpWriter::dumpType_ = MiniDumpNormal;
+std::atomic<ULONGLONG> MinidumpWriter::windowStart_{0};
+std::atomic<uint32_t> MinidumpWriter::windowCount_{0};
+std::atomic<uint64_t> MinidumpWriter::sequence_{0};
+std::atomic<uint64_t> MinidumpWriter::writtenCount_{0};
+std::atomic<uint64_t> MinidumpWriter::throttledCount_{0};
+
+bool MinidumpWriter::Start(const MinidumpConfig& config) {
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        if (config.directory.size() >= MAX_PATH) {
+            Utils::Logger::LogError("Minidump directory path is too long");
+            return false;
+        }
+        wcscpy_s(directory_, config.directory.c_str());
+        dumpType_ = config.dumpType;
+    }
+    maxDumpsPerMinute_.store(config.maxDumpsPerMinute, std::memory_order_relaxed);
+    waitForDumpMs_.store(config.waitForDumpMs, std::memory_order_relaxed);
+    dumpOnGuardPage_.store(config.dumpOnGuardPage, std::memory_order_relaxed);
+
+    // Events and worker are created once; the handler only ever sees them fully initialized
+    // because active_ is published last
+    static std::once_flag workerFlag;
+    std::call_once(workerFlag, []() {
+        requestEvent_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        completionEvent_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        if (requestEvent_ == nullptr || completionEvent_ == nullptr) {
+            return;
+        }
+        workerThread_ = CreateThread(nullptr, 0, WorkerThreadProc, nullptr, 0, &workerThreadId_);
+        if (workerThread_ != nullptr) {
+            active_.store(true, std::memory_order_release);
+        }
+    });
+
+    if (!IsActive()) {
+        Utils::Logger::LogError("Failed to start minidump worker thread");
+        return false;
+    }
+    return true;
+}
+
+bool MinidumpWriter::TryAcquireBudget() noexcept {
+    const uint32_t limit = maxDumpsPerMinute_.load(std::memory_order_relaxed);
+    if (limit == 0) {
+        return false;
+    }
+
+    // Whoever first observes an expired window opens the next one; racing requests may
+    // still count against the old window, which only errs on the side of fewer dumps
+    const ULONGLONG now = GetTickCount64();
+    ULONGLONG start = windowStart_.load(std::memory_order_acquire);
+    if (now - start >= THROTTLE_WINDOW_MS &&
+        windowStart_.compare_exchange_strong(start, now, std::memory_order_acq_rel)) {
+        windowCount_.store(0, std::memory_order_release);
+    }
+    return windowCount_.fetch_add(1, std::memory_order_acq_rel) < limit;
+}
+
+bool MinidumpWriter::RequestDump(PEXCEPTION_POINTERS exceptionInfo, bool guardPage) noexcept {
+    // Everything here must be async-signal safe: no heap, no CRT, no locks
+    if (!IsActive() || exceptionInfo == nullptr ||
+        exceptionInfo->ExceptionRecord == nullptr || exceptionInfo->ContextRecord == nullptr) {
+        return false;
+    }
+    if (guardPage && !dumpOnGuardPage_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    // Faults raised while the worker reads process memory must not request another dump
+    if (GetCurrentThreadId() == workerThreadId_) {
+        return false;
+    }
+
+    // One capture area: a second crash while a dump is in flight is counted, not queued
+    uint32_t expected = CAPTURE_IDLE;
+    if (!captureState_.compare_exchange_strong(expected, CAPTURE_FILLING, std::memory_order_acquire)) {
+        throttledCount_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (!TryAcquireBudget()) {
+        captureState_.store(CAPTURE_IDLE, std::memory_order_release);
+        throttledCount_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    capture_.exceptionRecord = *exceptionInfo->ExceptionRecord;
+    // Nested records live on the faulting stack; the outermost record is enough
+    capture_.exceptionRecord.ExceptionRecord = nullptr;
+    capture_.context = *exceptionInfo->ContextRecord;
+    capture_.pointers.ExceptionRecord = &capture_.exceptionRecord;
+    capture_.pointers.ContextRecord = &capture_.context;
+    capture_.threadId = GetCurrentThreadId();
+
+    const uint64_t generation = requestGeneration_.fetch_add(1, std::memory_order_relaxed) + 1;
+    captureState_.store(CAPTURE_PENDING, std::memory_order_release);
+    SetEvent(requestEvent_);
+
+    // Keep this thread's stack intact until the dump has been taken. A signal left over from
+    // a request whose waiter timed out carries an older generation and is waited past.
+    const DWORD waitMs = waitForDumpMs_.load(std::memory_order_relaxed);
+    const ULONGLONG deadline = GetTickCount64() + waitMs;
+    while (completedGeneration_.load(std::memory_order_acquire) < generation) {
+        DWORD remaining = INFINITE;
+        if (waitMs != INFINITE) {
+            const ULONGLONG now = GetTickCount64();
+            if (now >= deadline) {
+                break;
+            }
+            remaining = static_cast<DWORD>(deadline - now);
+        }
+        if (WaitForSingleObject(completionEvent_, remaining) != WAIT_OBJECT_0) {
+            break;
+        }
+    }
+    return true;
+}
+
+DWORD WINAPI MinidumpWriter::WorkerThreadProc(LPVOID) {
+    for (;;) {
+        WaitForSingleObject(requestEvent_, INFINITE);
+        if (captureState_.load(std::memory_order_acquire) != CAPTURE_PENDING) {
+            continue;
+        }
+
+        const DWORD threadId = capture_.threadId;
+        const uint64_t generation = requestGeneration_.load(std::memory_order_relaxed);
+        DWORD error = 0;
+        const bool written = WriteDump(error);
+
+        // Release the faulting thread before logging: it may hold the Logger's mutex
+        completedGeneration_.store(generation, std::memory_order_release);
+        captureState_.store(CAPTURE_IDLE, std::memory_order_release);
+        SetEvent(completionEvent_);
+
+        if (written) {
+            writtenCount_.fetch_add(1, std::memory_order_relaxed);
+            Utils::Logger::Info("Minidump written for faulting thread {}", threadId);
+        } else {
+            Utils::Logger::Error("Failed to write minidump for thread {} (error {})", threadId, error);
+        }
+    }
+}
+
+bool MinidumpWriter::WriteDump(DWORD& error) {
+    // Build the path on the stack: the faulting thread may be holding the heap lock
+    wchar_t path[MAX_PATH];
+    MINIDUMP_TYPE dumpType;
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        SYSTEMTIME now;
+        GetSystemTime(&now);
+        int length = swprintf(path, MAX_PATH, L"%ls\\sentinel-%lu-%04u%02u%02uT%02u%02u%02uZ-%llu.dmp",
+                              directory_, static_cast<unsigned long>(GetCurrentProcessId()),
+                              now.wYear, now.wMonth, now.wDay, now.wHour, now.wMinute, now.wSecond,
+                              static_cast<unsigned long long>(sequence_.fetch_add(1, std::memory_order_relaxed)));
+        if (length <= 0) {
+            error = ERROR_BUFFER_OVERFLOW;
+            return false;
+        }
+        dumpType = dumpType_;
+    }
+
+    HANDLE file = CreateFileW(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error = GetLastError();
+        return false;
+    }
+
+    // ClientPointers is FALSE: the exception pointers refer to this process's own memory
+    MINIDUMP_EXCEPTION_INFORMATION exceptionInformation;
+    exceptionInformation.ThreadId = capture_.threadId;
+    exceptionInformation.ExceptionPointers = &capture_.pointers;
+    exceptionInformation.ClientPointers = FALSE;
+
+    BOOL result = FALSE;
+    {
+        // DbgHelp is single-threaded; the watchdog may be symbolizing at the same time
+        std::lock_guard<std::mutex> lock(SymbolResolver::DbgHelpMutex());
+        result = MiniDumpWriteDump(GetCurrentProcess(), GetCurrentProcessId(), file, dumpType,
+                                   &exceptionInformation, nullptr, nullptr);
+    }
+    if (!result) {
+        error = GetLastError();
+    }
+    CloseHandle(file);
+
+    if (!result) {
+        // A partial dump is useless to a debugger; do not leave it behind
+        DeleteFileW(path);
+        return false;
+    }
+    return true;
+}
+
+} // namespace Bedrock
+} // namespace Sentinel
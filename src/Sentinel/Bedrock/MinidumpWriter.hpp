@@ -0,0 +1,196 @@
+/**
+ * @file MinidumpWriter.hpp
+ * @brief Asynchronous minidump capture for exceptions intercepted by CrashInterceptor.
+ *
+ * @details This module exists because a page-aligned address in a log line is rarely enough
+ * to diagnose a crash, while MiniDumpWriteDump cannot be called from the faulting thread:
+ * it allocates, takes the loader lock and performs file I/O, any of which may deadlock or
+ * fault again when the process is already in a bad state.
+ *
+ * The writer therefore splits capture in two:
+ * - On the faulting thread (inside the VEH), RequestDump copies the EXCEPTION_RECORD and
+ *   CONTEXT into a preallocated static area and signals a pre-spawned worker thread. It
+ *   then waits, bounded by a timeout, so the faulting thread's stack is still intact when
+ *   the dump is taken.
+ * - On the worker thread, the dump is written with MiniDumpWriteDump using the copied
+ *   exception information, and the faulting thread is released.
+ *
+ * The design prioritizes:
+ * - Async-signal safety on the handler side: atomics, memcpy and two kernel calls only
+ * - Bounded disk I/O: at most maxDumpsPerMinute dumps are written per one-minute window
+ *   and only one dump is in flight at a time; other requests are counted and dropped
+ * - Configurability: the MINIDUMP_TYPE flags and output directory are set by the caller
+ *
+ * The worker builds the dump path without touching the heap, but MiniDumpWriteDump itself
+ * allocates. If the faulting thread holds the heap lock, the dump completes only after
+ * waitForDumpMs expires and the faulting thread moves on; the timeout is what keeps this
+ * from becoming a deadlock.
+ *
+ * @security Minidumps contain raw process memory and precise addresses - everything the
+ * log sanitization avoids exposing. Write them to a directory that only administrators
+ * and the service account can read, and treat them as sensitive incident data.
+ *
+ * @performance RequestDump costs a handful of atomic operations when throttled. When a
+ * dump is taken, the faulting thread is blocked for the duration of MiniDumpWriteDump
+ * (up to waitForDumpMs).
+ *
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/minidumpapiset/nf-minidumpapiset-minidumpwritedump
+ * @see CrashInterceptor::EnableMinidumps
+ */
+
+#pragma once
+
+#include <Windows.h>
+#include <DbgHelp.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace Sentinel {
+namespace Bedrock {
+
+/**
+ * @brief Configuration for MinidumpWriter::Start.
+ */
+struct MinidumpConfig {
+    /** @brief Directory that receives dump files. Must exist. */
+    std::wstring directory = L".";
+
+    /** @brief MINIDUMP_TYPE flags passed to MiniDumpWriteDump. */
+    MINIDUMP_TYPE dumpType = static_cast<MINIDUMP_TYPE>(
+        MiniDumpWithThreadInfo | MiniDumpWithIndirectlyReferencedMemory | MiniDumpWithUnloadedModules);
+
+    /** @brief Maximum dumps written per one-minute window (0 disables dumps). */
+    uint32_t maxDumpsPerMinute = 2;
+
+    /** @brief How long the faulting thread waits for its dump before continuing. */
+    DWORD waitForDumpMs = 10000;
+
+    /** @brief Also dump on guard page violations (normally expected, so off by default). */
+    bool dumpOnGuardPage = false;
+};
+
+/**
+ * @class MinidumpWriter
+ * @brief Pre-spawned worker that writes minidumps requested from the exception handler.
+ *
+ * Usage example:
+ * @code
+ * MinidumpConfig config;
+ * config.directory = L"C:\\ProgramData\\Sentinel\\dumps";
+ * MinidumpWriter::Start(config);
+ * // In the VEH:
+ * MinidumpWriter::RequestDump(ExceptionInfo);
+ * @endcode
+ *
+ * @threadsafe RequestDump may be called concurrently from any thread, including from
+ * inside an exception handler. Start may be called more than once; later calls replace
+ * the configuration.
+ */
+class MinidumpWriter {
+public:
+    /**
+     * @brief Applies @p config and starts the worker thread (once per process).
+     *
+     * @return true if the worker thread is running.
+     */
+    static bool Start(const MinidumpConfig& config);
+
+    /** @brief true once the worker thread is running. */
+    static bool IsActive() noexcept { return active_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Requests a dump for the exception described by @p exceptionInfo.
+     *
+     * @details Returns false without doing anything if dumps are disabled, throttled, or
+     * another dump is already in progress. Otherwise copies the exception state, signals
+     * the worker and waits up to waitForDumpMs for the dump to complete.
+     *
+     * @param exceptionInfo Pointers received by the exception handler.
+     * @param guardPage true when the exception is a guard page violation.
+     * @return true if a dump was requested.
+     *
+     * @note Async-signal safe: no heap, no CRT, no user-mode locks.
+     */
+    static bool RequestDump(PEXCEPTION_POINTERS exceptionInfo, bool guardPage = false) noexcept;
+
+    /** @brief Number of dump files written successfully. */
+    static uint64_t GetWrittenCount() noexcept { return writtenCount_.load(std::memory_order_relaxed); }
+
+    /** @brief Number of requests dropped by the throttle or because a dump was in flight. */
+    static uint64_t GetThrottledCount() noexcept { return throttledCount_.load(std::memory_order_relaxed); }
+
+private:
+    /**
+     * @brief Claims one unit of the per-minute budget.
+     */
+    static bool TryAcquireBudget() noexcept;
+
+    /**
+     * @brief Worker thread body: waits for requests and writes dumps.
+     */
+    static DWORD WINAPI WorkerThreadProc(LPVOID parameter);
+
+    /**
+     * @brief Writes the dump for the exception currently held in capture_.
+     * 
+     * @param error Receives the Win32 error code on failure.
+     * @return true if the dump file was written.
+     */
+    static bool WriteDump(DWORD& error);
+
+    enum CaptureState : uint32_t {
+        CAPTURE_IDLE = 0,
+        CAPTURE_FILLING = 1,
+        CAPTURE_PENDING = 2
+    };
+
+    /**
+     * @brief Preallocated copy of the faulting thread's exception state.
+     *
+     * @details MiniDumpWriteDump reads these copies instead of the handler's own
+     * EXCEPTION_POINTERS, whose lifetime ends when the handler returns.
+     */
+    struct CaptureArea {
+        EXCEPTION_RECORD exceptionRecord;
+        CONTEXT context;
+        EXCEPTION_POINTERS pointers;
+        DWORD threadId;
+    };
+
+    static CaptureArea capture_;
+    static std::atomic<uint32_t> captureState_;
+
+    static HANDLE requestEvent_;
+    static HANDLE completionEvent_;
+
+    // Numbers each request; the worker publishes the one it finished before signaling, so a
+    // late completion of a timed-out request cannot release the next request's waiter
+    static std::atomic<uint64_t> requestGeneration_;
+    static std::atomic<uint64_t> completedGeneration_;
+    static HANDLE workerThread_;
+    static DWORD workerThreadId_;
+    static std::atomic<bool> active_;
+
+    // Handler-visible configuration
+    static std::atomic<uint32_t> maxDumpsPerMinute_;
+    static std::atomic<DWORD> waitForDumpMs_;
+    static std::atomic<bool> dumpOnGuardPage_;
+
+    // Worker-only configuration, guarded by configMutex_
+    static std::mutex configMutex_;
+    static wchar_t directory_[MAX_PATH];
+    static MINIDUMP_TYPE dumpType_;
+
+    // Fixed one-minute throttle window
+    static std::atomic<ULONGLONG> windowStart_;
+    static std::atomic<uint32_t> windowCount_;
+
+    static std::atomic<uint64_t> sequence_;
+    static std::atomic<uint64_t> writtenCount_;
+    static std::atomic<uint64_t> throttledCount_;
+};
+
+} // namespace Bedrock
+} // namespace Sentinel
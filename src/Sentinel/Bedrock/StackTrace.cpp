@@ -0,0 +1,219 @@
+/**
+ * @file StackTrace.cpp
+ * @brief Implementation of stack capture and cached symbolization.
+ */
+
+#include "Sentinel/Bedrock/StackTrace.hpp"
+#include <DbgHelp.h>
+#include <stdio.h>
+
+namespace Sentinel {
+namespace Bedrock {
+
+// Static member initialization
+std::mutex SymbolResolver::cacheMutex_;
+std::list<SymbolResolver::CacheEntry> SymbolResolver::lru_;
+std::unordered_map<uint64_t, std::list<SymbolResolver::CacheEntry>::iterator> SymbolResolver::index_;
+std::unordered_map<std::wstring, uint32_t> SymbolResolver::moduleIds_;
+uint64_t SymbolResolver::cacheHits_ = 0;
+uint64_t SymbolResolver::cacheMisses_ = 0;
+bool SymbolResolver::symbolsInitialized_ = false;
+
+size_t StackWalker::CaptureFromContext(const CONTEXT& context, uintptr_t* frames, size_t capacity) noexcept {
+    if (frames == nullptr || capacity == 0) {
+        return 0;
+    }
+
+#if defined(_M_X64)
+    // Unwind a private copy; the handler's CONTEXT is what execution resumes with
+    CONTEXT cursor = context;
+
+    ULONG_PTR stackLow = 0;
+    ULONG_PTR stackHigh = 0;
+    GetCurrentThreadStackLimits(&stackLow, &stackHigh);
+
+    size_t count = 0;
+    while (count < capacity && cursor.Rip != 0) {
+        if (cursor.Rsp < stackLow || cursor.Rsp >= stackHigh) {
+            break;
+        }
+        frames[count++] = static_cast<uintptr_t>(cursor.Rip);
+
+        DWORD64 imageBase = 0;
+        PRUNTIME_FUNCTION function = RtlLookupFunctionEntry(cursor.Rip, &imageBase, nullptr);
+        if (function == nullptr) {
+            // Leaf function without unwind data: the return address is on top of the stack
+            if (cursor.Rsp + sizeof(DWORD64) > stackHigh) {
+                break;
+            }
+            cursor.Rip = *reinterpret_cast<const DWORD64*>(cursor.Rsp);
+            cursor.Rsp += sizeof(DWORD64);
+            continue;
+        }
+
+        PVOID handlerData = nullptr;
+        DWORD64 establisherFrame = 0;
+        RtlVirtualUnwind(UNW_FLAG_NHANDLER, imageBase, cursor.Rip, function, &cursor,
+                         &handlerData, &establisherFrame, nullptr);
+    }
+    return count;
+#else
+    // No CONTEXT-based unwinder here; capture the handler's own stack instead
+    static_cast<void>(context);
+    const DWORD maxFrames = capacity > 62 ? 62 : static_cast<DWORD>(capacity);
+    return RtlCaptureStackBackTrace(0, maxFrames, reinterpret_cast<PVOID*>(frames), nullptr);
+#endif
+}
+
+std::mutex& SymbolResolver::DbgHelpMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+uint64_t SymbolResolver::GetCacheHits() {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    return cacheHits_;
+}
+
+uint64_t SymbolResolver::GetCacheMisses() {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    return cacheMisses_;
+}
+
+bool SymbolResolver::IdentifyModule(uintptr_t address, uint32_t& moduleId, uintptr_t& moduleBase,
+                                    std::string& moduleName) {
+    HMODULE module = nullptr;
+    if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                            reinterpret_cast<LPCWSTR>(address), &module)) {
+        return false;
+    }
+
+    wchar_t path[MAX_PATH];
+    DWORD length = GetModuleFileNameW(module, path, MAX_PATH);
+    if (length == 0 || length >= MAX_PATH) {
+        return false;
+    }
+
+    // Keyed by path rather than base address, so a different module later loaded at the
+    // same base never inherits stale cache entries
+    std::wstring fullPath(path, length);
+    auto found = moduleIds_.find(fullPath);
+    if (found == moduleIds_.end()) {
+        found = moduleIds_.emplace(fullPath, static_cast<uint32_t>(moduleIds_.size())).first;
+    }
+    moduleId = found->second;
+    moduleBase = reinterpret_cast<uintptr_t>(module);
+
+    const wchar_t* fileName = path;
+    for (const wchar_t* cursor = path; *cursor != L'\0'; ++cursor) {
+        if (*cursor == L'\\' || *cursor == L'/') {
+            fileName = cursor + 1;
+        }
+    }
+    char narrow[MAX_PATH * 3];
+    int converted = WideCharToMultiByte(CP_UTF8, 0, fileName, -1, narrow, sizeof(narrow), nullptr, nullptr);
+    moduleName = converted > 0 ? narrow : "?";
+    return true;
+}
+
+bool SymbolResolver::EnsureSymbolsInitialized() {
+    if (!symbolsInitialized_) {
+        SymSetOptions(SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS | SYMOPT_LOAD_LINES | SYMOPT_FAIL_CRITICAL_ERRORS);
+        symbolsInitialized_ = SymInitializeW(GetCurrentProcess(), nullptr, TRUE) != FALSE;
+    }
+    return symbolsInitialized_;
+}
+
+bool SymbolResolver::Preload() {
+    std::lock_guard<std::mutex> lock(DbgHelpMutex());
+    return EnsureSymbolsInitialized();
+}
+
+std::string SymbolResolver::Symbolize(uintptr_t lookupAddress, uintptr_t moduleBase, const std::string& moduleName) {
+    char text[512];
+    const unsigned long long rva = static_cast<unsigned long long>(lookupAddress - moduleBase);
+    sprintf_s(text, sizeof(text), "%s+0x%llX", moduleName.c_str(), rva);
+
+    std::lock_guard<std::mutex> lock(DbgHelpMutex());
+    if (!EnsureSymbolsInitialized()) {
+        return text;
+    }
+
+    HANDLE process = GetCurrentProcess();
+    alignas(SYMBOL_INFO) char symbolBuffer[sizeof(SYMBOL_INFO) + MAX_SYM_NAME];
+    SYMBOL_INFO* symbol = reinterpret_cast<SYMBOL_INFO*>(symbolBuffer);
+    symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+    symbol->MaxNameLen = MAX_SYM_NAME;
+
+    DWORD64 displacement = 0;
+    BOOL found = SymFromAddr(process, lookupAddress, &displacement, symbol);
+    if (!found) {
+        // The module may have been loaded after SymInitialize enumerated the process
+        SymRefreshModuleList(process);
+        found = SymFromAddr(process, lookupAddress, &displacement, symbol);
+    }
+    if (!found) {
+        return text;
+    }
+
+    int length = sprintf_s(text, sizeof(text), "%s!%s+0x%llX", moduleName.c_str(), symbol->Name,
+                           static_cast<unsigned long long>(displacement));
+
+    IMAGEHLP_LINE64 line{};
+    line.SizeOfStruct = sizeof(line);
+    DWORD lineDisplacement = 0;
+    if (length > 0 && SymGetLineFromAddr64(process, lookupAddress, &lineDisplacement, &line) && line.FileName) {
+        // Build-machine paths add nothing to a report; keep the file name only
+        const char* fileName = line.FileName;
+        for (const char* cursor = line.FileName; *cursor != '\0'; ++cursor) {
+            if (*cursor == '\\' || *cursor == '/') {
+                fileName = cursor + 1;
+            }
+        }
+        sprintf_s(text + length, sizeof(text) - static_cast<size_t>(length), " (%s:%lu)",
+                  fileName, static_cast<unsigned long>(line.LineNumber));
+    }
+    return text;
+}
+
+std::string SymbolResolver::Resolve(uintptr_t address, bool returnAddress) {
+    // A return address points after the call; resolve the call instruction itself
+    const uintptr_t lookupAddress = (returnAddress && address > 0) ? address - 1 : address;
+
+    uint32_t moduleId = 0;
+    uintptr_t moduleBase = 0;
+    std::string moduleName;
+    uint64_t key = 0;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex_);
+        if (!IdentifyModule(lookupAddress, moduleId, moduleBase, moduleName)) {
+            return "<unknown module>";
+        }
+
+        key = (static_cast<uint64_t>(moduleId) << 32) | static_cast<uint32_t>(lookupAddress - moduleBase);
+        auto found = index_.find(key);
+        if (found != index_.end()) {
+            ++cacheHits_;
+            lru_.splice(lru_.begin(), lru_, found->second);
+            return found->second->text;
+        }
+        ++cacheMisses_;
+    }
+
+    // DbgHelp runs outside cacheMutex_ so cached lookups never wait behind it
+    std::string text = Symbolize(lookupAddress, moduleBase, moduleName);
+
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    if (index_.find(key) == index_.end()) {
+        lru_.push_front(CacheEntry{key, text});
+        index_[key] = lru_.begin();
+        if (lru_.size() > CACHE_CAPACITY) {
+            index_.erase(lru_.back().key);
+            lru_.pop_back();
+        }
+    }
+    return text;
+}
+
+} // namespace Bedrock
+} // namespace Sentinel
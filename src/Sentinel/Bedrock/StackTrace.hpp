@@ -0,0 +1,163 @@
+/**
+ * @file StackTrace.hpp
+ * @brief Handler-safe stack capture and cached, deferred symbolization.
+ *
+ * @details This module exists because a crash report without a call stack names only the
+ * faulting page, and because the obvious way to get one - StackWalk64 plus SymFromAddr on
+ * the faulting thread - is both unsafe inside a Vectored Exception Handler and slow: every
+ * DbgHelp call takes DbgHelp's global lock, and resolving each frame from scratch costs
+ * far more than the fault itself.
+ *
+ * The work is split in two:
+ * - StackWalker runs inside the handler. On x64 it unwinds the faulting thread's stack
+ *   from the exception CONTEXT with RtlLookupFunctionEntry/RtlVirtualUnwind into a fixed
+ *   array of return addresses; no heap, no DbgHelp.
+ * - SymbolResolver runs on the watchdog thread. It turns each address into
+ *   "module!symbol+0xoffset (file:line)" with DbgHelp, and remembers the result in an LRU
+ *   cache keyed by (module, RVA). Crash sites repeat, so frames are usually resolved
+ *   without touching DbgHelp at all.
+ *
+ * @security Captured frames are precise addresses and must never be logged as such.
+ * SymbolResolver only ever renders module names, symbol names and module-relative
+ * offsets, which do not reveal the ASLR layout.
+ *
+ * @performance StackWalker costs one function-table lookup and one virtual unwind per
+ * frame. A SymbolResolver cache hit costs a module lookup and a hash probe; a miss costs
+ * SymFromAddr and SymGetLineFromAddr64 under the DbgHelp lock.
+ *
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/winnt/nf-winnt-rtlvirtualunwind
+ * @see CrashInterceptor
+ */
+
+#pragma once
+
+#include <Windows.h>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Sentinel {
+namespace Bedrock {
+
+/**
+ * @class StackWalker
+ * @brief Captures return addresses from an exception CONTEXT.
+ *
+ * @threadsafe All methods are thread-safe and async-signal safe.
+ */
+class StackWalker {
+public:
+    /**
+     * @brief Unwinds the current thread's stack starting at @p context.
+     *
+     * @details On x64, unwinds from the exception CONTEXT, so the first frame is the
+     * faulting instruction. Every frame's stack pointer is checked against the current
+     * thread's stack limits before it is dereferenced, so a corrupted stack ends the walk
+     * instead of faulting inside the handler. On other architectures the handler's own
+     * stack is captured with RtlCaptureStackBackTrace (it includes the exception
+     * dispatcher frames).
+     *
+     * @param context CPU state of the faulting thread; must belong to the calling thread.
+     * @param frames Destination array.
+     * @param capacity Number of entries in @p frames.
+     * @return Number of frames written.
+     *
+     * @note Must be called on the faulting thread (the stack limits used for validation
+     * are those of the calling thread).
+     */
+    static size_t CaptureFromContext(const CONTEXT& context, uintptr_t* frames, size_t capacity) noexcept;
+};
+
+/**
+ * @class SymbolResolver
+ * @brief Renders code addresses as module!symbol+offset with an LRU result cache.
+ *
+ * Usage example:
+ * @code
+ * for (size_t i = 0; i < record.frameCount; ++i) {
+ *     std::string frame = SymbolResolver::Resolve(record.frames[i], i > 0);
+ * }
+ * @endcode
+ *
+ * @threadsafe All methods are thread-safe. DbgHelp itself is single-threaded; every
+ * DbgHelp call in Sentinel must hold DbgHelpMutex().
+ */
+class SymbolResolver {
+public:
+    /** @brief Maximum number of cached frame descriptions. */
+    static constexpr size_t CACHE_CAPACITY = 4096;
+
+    /**
+     * @brief Describes the code at @p address.
+     *
+     * @param address Code address captured by StackWalker.
+     * @param returnAddress true for every frame but the first: the address is then a
+     *        return address, and the call instruction before it is what gets resolved.
+     * @return "module!symbol+0xoffset (file:line)", or "module+0xrva" when no symbol is
+     *         available, or "<unknown module>" if the address is not inside a module.
+     */
+    static std::string Resolve(uintptr_t address, bool returnAddress);
+
+    /**
+     * @brief Lock serializing all DbgHelp calls in the process (symbols and minidumps).
+     */
+    static std::mutex& DbgHelpMutex();
+
+    /**
+     * @brief Initializes DbgHelp now, so the first crash report does not pay for
+     * SymInitialize (which enumerates every loaded module).
+     *
+     * @return false if DbgHelp could not be initialized; Resolve then falls back to
+     *         module+offset.
+     */
+    static bool Preload();
+
+    /** @brief Number of Resolve calls answered from the cache. */
+    static uint64_t GetCacheHits();
+
+    /** @brief Number of Resolve calls that needed DbgHelp. */
+    static uint64_t GetCacheMisses();
+
+private:
+    struct CacheEntry {
+        uint64_t key;
+        std::string text;
+    };
+
+    /**
+     * @brief Finds the module containing @p address.
+     *
+     * @param moduleId Receives the interned id of the module's path.
+     * @param moduleBase Receives the module's load address.
+     * @param moduleName Receives the module's file name (UTF-8, no directory).
+     * @return false if @p address is not inside a loaded module.
+     */
+    static bool IdentifyModule(uintptr_t address, uint32_t& moduleId, uintptr_t& moduleBase,
+                               std::string& moduleName);
+
+    /**
+     * @brief Resolves through DbgHelp. Called without cacheMutex_ held.
+     */
+    static std::string Symbolize(uintptr_t lookupAddress, uintptr_t moduleBase, const std::string& moduleName);
+
+    /**
+     * @brief Initializes DbgHelp for the current process once. Requires DbgHelpMutex().
+     */
+    static bool EnsureSymbolsInitialized();
+
+    // Guards the cache and the module table, never held across DbgHelp calls
+    static std::mutex cacheMutex_;
+    static std::list<CacheEntry> lru_;
+    static std::unordered_map<uint64_t, std::list<CacheEntry>::iterator> index_;
+    static std::unordered_map<std::wstring, uint32_t> moduleIds_;
+
+    static uint64_t cacheHits_;
+    static uint64_t cacheMisses_;
+    static bool symbolsInitialized_;
+};
+
+} // namespace Bedrock
+} // namespace Sentinel
@@ -0,0 +1,330 @@
+/**
+ * @file BatchCodec.cpp
+ * @brief Implementation of the batch encoder and decoder.
+ */
+
+#include "Sentinel/Comms/BatchCodec.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+#include <cstring>
+
+namespace Sentinel {
+namespace Comms {
+
+static constexpr size_t GCM_NONCE_SIZE = 12;
+
+// Frame sizes are stored as uint32; batches are far smaller in practice
+static constexpr size_t MAX_BATCH_BYTES = 16 * 1024 * 1024;
+
+/**
+ * @brief Opens an AES-GCM provider and imports @p key (16 or 32 bytes).
+ */
+static bool ImportGcmKey(const uint8_t* key, size_t keySize, BCRYPT_ALG_HANDLE* algorithm,
+                         BCRYPT_KEY_HANDLE* handle) {
+    if (key == nullptr || (keySize != 16 && keySize != 32)) {
+        Utils::Logger::LogError("BatchCodec: session key must be 16 or 32 bytes");
+        return false;
+    }
+    NTSTATUS status = BCryptOpenAlgorithmProvider(algorithm, BCRYPT_AES_ALGORITHM, nullptr, 0);
+    if (BCRYPT_SUCCESS(status)) {
+        status = BCryptSetProperty(*algorithm, BCRYPT_CHAINING_MODE,
+                                   reinterpret_cast<PUCHAR>(const_cast<wchar_t*>(BCRYPT_CHAIN_MODE_GCM)),
+                                   sizeof(BCRYPT_CHAIN_MODE_GCM), 0);
+    }
+    if (BCRYPT_SUCCESS(status)) {
+        status = BCryptGenerateSymmetricKey(*algorithm, handle, nullptr, 0, const_cast<PUCHAR>(key),
+                                            static_cast<ULONG>(keySize), 0);
+    }
+    if (!BCRYPT_SUCCESS(status)) {
+        Utils::Logger::Error("BatchCodec: AES-GCM key setup failed (0x{:08X})", static_cast<uint32_t>(status));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Builds the 96-bit GCM nonce salt || sequence.
+ */
+static void BuildNonce(const BatchFrameHeader& header, uint8_t (&nonce)[GCM_NONCE_SIZE]) noexcept {
+    std::memcpy(nonce, &header.salt, sizeof(header.salt));
+    std::memcpy(nonce + sizeof(header.salt), &header.sequence, sizeof(header.sequence));
+}
+
+BatchEncoder::~BatchEncoder() {
+    Release();
+}
+
+void BatchEncoder::Release() noexcept {
+    if (key_ != nullptr) {
+        BCryptDestroyKey(key_);
+        key_ = nullptr;
+    }
+    if (algorithm_ != nullptr) {
+        BCryptCloseAlgorithmProvider(algorithm_, 0);
+        algorithm_ = nullptr;
+    }
+    if (compressor_ != nullptr) {
+        CloseCompressor(compressor_);
+        compressor_ = nullptr;
+    }
+    plainSize_ = 0;
+    recordCount_ = 0;
+}
+
+bool BatchEncoder::Initialize(const uint8_t* key, size_t keySize, const BatchEncoderConfig& config,
+                              FrameSink sink) {
+    Release();
+    if (config.maxBatchBytes == 0 || config.maxBatchBytes > MAX_BATCH_BYTES || !sink) {
+        Utils::Logger::LogError("BatchEncoder: invalid configuration");
+        return false;
+    }
+    if (!ImportGcmKey(key, keySize, &algorithm_, &key_)) {
+        Release();
+        return false;
+    }
+    if (!BCRYPT_SUCCESS(BCryptGenRandom(nullptr, reinterpret_cast<PUCHAR>(&salt_), sizeof(salt_),
+                                        BCRYPT_USE_SYSTEM_PREFERRED_RNG))) {
+        Utils::Logger::LogError("BatchEncoder: cannot generate nonce salt");
+        Release();
+        return false;
+    }
+    // Raw XPRESS: the frame header already carries the uncompressed size
+    if (config.compress && CreateCompressor(COMPRESS_ALGORITHM_XPRESS | COMPRESS_RAW, nullptr, &compressor_) == 0) {
+        Utils::Logger::Error("BatchEncoder: cannot create XPRESS compressor ({})", GetLastError());
+        compressor_ = nullptr;
+        Release();
+        return false;
+    }
+
+    config_ = config;
+    sink_ = std::move(sink);
+    plain_.resize(config_.maxBatchBytes);
+    compressed_.resize(compressor_ != nullptr ? config_.maxBatchBytes : 0);
+    frame_.resize(BATCH_FRAME_OVERHEAD + config_.maxBatchBytes);
+    sequence_ = 0;
+    stats_ = BatchStats{};
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    ticksPerMs_ = frequency.QuadPart / 1000 > 0 ? frequency.QuadPart / 1000 : 1;
+    return true;
+}
+
+bool BatchEncoder::Append(uint32_t schemaId, const void* payload, size_t size) {
+    const size_t recordSize = VarintSize(schemaId) + VarintSize(size) + size;
+    if (key_ == nullptr || recordSize > config_.maxBatchBytes) {
+        Utils::Logger::Error("BatchEncoder: cannot append a {} byte record", size);
+        return false;
+    }
+    // A lost batch is reported to the caller, who still holds the record and may append it
+    // again - the open batch is empty now either way
+    if (plainSize_ + recordSize > config_.maxBatchBytes && !Flush()) {
+        return false;
+    }
+    if (plainSize_ == 0) {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        batchStart_ = now.QuadPart;
+    }
+
+    WireWriter writer(plain_.data() + plainSize_, recordSize);
+    writer.PutUnsigned(schemaId);
+    writer.PutBytes(payload, size);
+    plainSize_ += recordSize;
+    ++recordCount_;
+    return true;
+}
+
+bool BatchEncoder::Flush() {
+    if (plainSize_ == 0) {
+        return true;
+    }
+
+    BatchFrameHeader header{};
+    header.magic = BATCH_FRAME_MAGIC;
+    header.version = BATCH_FRAME_VERSION;
+    header.salt = salt_;
+    header.recordCount = recordCount_;
+    header.plainSize = static_cast<uint32_t>(plainSize_);
+    header.sequence = ++sequence_;
+
+    // Compression is kept only when it actually shrinks the batch; incompressible data
+    // overflows the buffer and is sent as is
+    const uint8_t* body = plain_.data();
+    size_t bodySize = plainSize_;
+    SIZE_T compressedSize = 0;
+    if (compressor_ != nullptr && plainSize_ >= config_.compressMinBytes &&
+        Compress(compressor_, plain_.data(), plainSize_, compressed_.data(), compressed_.size(), &compressedSize) !=
+            0 &&
+        compressedSize < plainSize_) {
+        body = compressed_.data();
+        bodySize = compressedSize;
+        header.flags |= BATCH_FLAG_COMPRESSED;
+    }
+    header.bodySize = static_cast<uint32_t>(bodySize);
+    std::memcpy(frame_.data(), &header, sizeof(header));
+
+    uint8_t nonce[GCM_NONCE_SIZE];
+    BuildNonce(header, nonce);
+    BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO info;
+    BCRYPT_INIT_AUTH_MODE_INFO(info);
+    info.pbNonce = nonce;
+    info.cbNonce = GCM_NONCE_SIZE;
+    info.pbAuthData = frame_.data();
+    info.cbAuthData = sizeof(header);
+    info.pbTag = frame_.data() + sizeof(header) + bodySize;
+    info.cbTag = BATCH_TAG_SIZE;
+
+    ULONG written = 0;
+    const NTSTATUS status =
+        BCryptEncrypt(key_, const_cast<PUCHAR>(body), static_cast<ULONG>(bodySize), &info, nullptr, 0,
+                      frame_.data() + sizeof(header), static_cast<ULONG>(bodySize), &written, 0);
+
+    const size_t records = recordCount_;
+    const size_t plainBytes = plainSize_;
+    plainSize_ = 0;
+    recordCount_ = 0;
+    if (!BCRYPT_SUCCESS(status)) {
+        Utils::Logger::Error("BatchEncoder: encryption failed (0x{:08X})", static_cast<uint32_t>(status));
+        ++stats_.failures;
+        return false;
+    }
+
+    const size_t frameSize = BATCH_FRAME_OVERHEAD + bodySize;
+    if (!sink_(frame_.data(), frameSize)) {
+        ++stats_.failures;
+        return false;
+    }
+    ++stats_.batches;
+    stats_.records += records;
+    stats_.plainBytes += plainBytes;
+    stats_.frameBytes += frameSize;
+    return true;
+}
+
+DWORD BatchEncoder::Poll() {
+    if (plainSize_ == 0) {
+        return INFINITE;
+    }
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    const LONGLONG elapsedMs = (now.QuadPart - batchStart_) / ticksPerMs_;
+    if (elapsedMs >= static_cast<LONGLONG>(config_.flushDeadlineMs)) {
+        Flush();
+        return INFINITE;
+    }
+    return config_.flushDeadlineMs - static_cast<DWORD>(elapsedMs);
+}
+
+BatchDecoder::~BatchDecoder() {
+    Release();
+}
+
+void BatchDecoder::Release() noexcept {
+    if (key_ != nullptr) {
+        BCryptDestroyKey(key_);
+        key_ = nullptr;
+    }
+    if (algorithm_ != nullptr) {
+        BCryptCloseAlgorithmProvider(algorithm_, 0);
+        algorithm_ = nullptr;
+    }
+    if (decompressor_ != nullptr) {
+        CloseDecompressor(decompressor_);
+        decompressor_ = nullptr;
+    }
+}
+
+bool BatchDecoder::Initialize(const uint8_t* key, size_t keySize, size_t maxBatchBytes) {
+    Release();
+    if (maxBatchBytes == 0 || maxBatchBytes > MAX_BATCH_BYTES) {
+        Utils::Logger::LogError("BatchDecoder: invalid batch size");
+        return false;
+    }
+    if (!ImportGcmKey(key, keySize, &algorithm_, &key_)) {
+        Release();
+        return false;
+    }
+    if (CreateDecompressor(COMPRESS_ALGORITHM_XPRESS | COMPRESS_RAW, nullptr, &decompressor_) == 0) {
+        Utils::Logger::Error("BatchDecoder: cannot create XPRESS decompressor ({})", GetLastError());
+        decompressor_ = nullptr;
+        Release();
+        return false;
+    }
+    maxBatchBytes_ = maxBatchBytes;
+    decrypted_.resize(maxBatchBytes);
+    plain_.resize(maxBatchBytes);
+    lastSequence_ = 0;
+    stats_ = BatchStats{};
+    return true;
+}
+
+const uint8_t* BatchDecoder::Open(const uint8_t* frame, size_t size, size_t* plainSize, uint32_t* recordCount) {
+    if (key_ == nullptr || frame == nullptr || size < BATCH_FRAME_OVERHEAD) {
+        Reject("frame too short");
+        return nullptr;
+    }
+    BatchFrameHeader header;
+    std::memcpy(&header, frame, sizeof(header));
+    const bool compressed = (header.flags & BATCH_FLAG_COMPRESSED) != 0;
+    if (header.magic != BATCH_FRAME_MAGIC || header.version != BATCH_FRAME_VERSION ||
+        (header.flags & ~BATCH_FLAG_COMPRESSED) != 0 || header.reserved != 0 ||
+        header.bodySize != size - BATCH_FRAME_OVERHEAD || header.plainSize > maxBatchBytes_ ||
+        (compressed ? header.bodySize >= header.plainSize : header.bodySize != header.plainSize)) {
+        Reject("invalid header");
+        return nullptr;
+    }
+    if (header.sequence <= lastSequence_) {
+        Reject("sequence did not increase (replayed or reordered frame)");
+        return nullptr;
+    }
+
+    uint8_t nonce[GCM_NONCE_SIZE];
+    BuildNonce(header, nonce);
+    BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO info;
+    BCRYPT_INIT_AUTH_MODE_INFO(info);
+    info.pbNonce = nonce;
+    info.cbNonce = GCM_NONCE_SIZE;
+    info.pbAuthData = const_cast<PUCHAR>(frame);
+    info.cbAuthData = sizeof(header);
+    info.pbTag = const_cast<PUCHAR>(frame + sizeof(header) + header.bodySize);
+    info.cbTag = BATCH_TAG_SIZE;
+
+    ULONG written = 0;
+    const NTSTATUS status =
+        BCryptDecrypt(key_, const_cast<PUCHAR>(frame + sizeof(header)), header.bodySize, &info, nullptr, 0,
+                      decrypted_.data(), header.bodySize, &written, 0);
+    if (!BCRYPT_SUCCESS(status)) {
+        Reject("authentication failed");
+        return nullptr;
+    }
+    // Only an authenticated frame may advance the replay window
+    lastSequence_ = header.sequence;
+
+    const uint8_t* plain = decrypted_.data();
+    if (compressed) {
+        SIZE_T decompressedSize = 0;
+        if (Decompress(decompressor_, decrypted_.data(), header.bodySize, plain_.data(), header.plainSize,
+                       &decompressedSize) == 0 ||
+            decompressedSize != header.plainSize) {
+            Reject("decompression failed");
+            return nullptr;
+        }
+        plain = plain_.data();
+    }
+
+    ++stats_.batches;
+    stats_.plainBytes += header.plainSize;
+    stats_.frameBytes += size;
+    *plainSize = header.plainSize;
+    *recordCount = header.recordCount;
+    return plain;
+}
+
+bool BatchDecoder::Reject(const char* reason) noexcept {
+    ++stats_.failures;
+    Utils::Logger::Warning("BatchDecoder: frame rejected, {}", reason);
+    return false;
+}
+
+} // namespace Comms
+} // namespace Sentinel
@@ -0,0 +1,268 @@
+/**
+ * @file BatchCodec.hpp
+ * @brief Batching, compression and authenticated encryption of telemetry records.
+ *
+ * @details The Module D protocol encrypts and authenticates every message. For a
+ * 10-byte telemetry record that means a 16-byte tag, a nonce, a frame header and one
+ * BCrypt call per record - more bytes and more CPU than the record itself. BatchEncoder
+ * moves all of that to the batch:
+ * - Records are appended to an open batch in the compact WireFormat encoding (schema id,
+ *   length, varint payload).
+ * - The batch is sealed when the next record would not fit in maxBatchBytes, or when
+ *   Poll finds that its oldest record has waited flushDeadlineMs, so latency stays bounded
+ *   at low rates and frames are large at high rates.
+ * - Sealing compresses the batch (when the session enables it and it pays off) and
+ *   encrypts it with a single AES-GCM operation, which BCrypt runs on AES-NI.
+ *
+ * BatchDecoder reverses this on the Service side: it checks the header, authenticates and
+ * decrypts, decompresses, and hands each record to a visitor.
+ *
+ * The frame layout is described in WireFormat.hpp. A sealed frame is at most
+ * maxBatchBytes + BATCH_FRAME_OVERHEAD bytes, which must not exceed the pipe's message
+ * size (PipeServerConfig::messageSize).
+ *
+ * @security Both sides must be initialized with the same session key, negotiated during
+ * the handshake (Module D step 3) and never reused across sessions: GCM nonces are unique
+ * only per key. Frames whose tag does not verify, whose sequence does not increase, or
+ * whose header or record stream is malformed are rejected and counted.
+ *
+ * @performance One BCryptEncrypt and at most one Compress call per batch; appending a
+ * record is a bounds check and a memcpy into a preallocated buffer.
+ *
+ * @see WireFormat.hpp
+ * @see PipeServer
+ */
+
+#pragma once
+
+#include "Sentinel/Comms/WireFormat.hpp"
+#include <Windows.h>
+#include <bcrypt.h>
+#include <compressapi.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Sentinel {
+namespace Comms {
+
+/**
+ * @brief Configuration for BatchEncoder::Initialize.
+ */
+struct BatchEncoderConfig {
+    /** @brief Upper bound on the plain record stream of one batch. */
+    size_t maxBatchBytes = 32 * 1024;
+
+    /** @brief Longest time a record waits in an open batch (enforced by Poll). */
+    DWORD flushDeadlineMs = 5;
+
+    /** @brief Compress batches with XPRESS (negotiated per session). */
+    bool compress = true;
+
+    /** @brief Batches smaller than this are sent uncompressed. */
+    size_t compressMinBytes = 512;
+};
+
+/**
+ * @brief Counters of one encoder or decoder.
+ */
+struct BatchStats {
+    uint64_t batches = 0;
+    uint64_t records = 0;
+
+    /** @brief Bytes of plain record streams. */
+    uint64_t plainBytes = 0;
+
+    /** @brief Bytes of frames, headers and tags included. */
+    uint64_t frameBytes = 0;
+
+    /** @brief Encoder: batches lost to a failed seal or sink. Decoder: rejected frames. */
+    uint64_t failures = 0;
+};
+
+/**
+ * @class BatchEncoder
+ * @brief Collects records into batches and emits sealed frames to a sink.
+ *
+ * Usage example:
+ * @code
+ * BatchEncoder encoder;
+ * encoder.Initialize(sessionKey, 32, BatchEncoderConfig{},
+ *                    [&](const uint8_t* frame, size_t size) { return SendToService(frame, size); });
+ * encoder.Append(SCHEMA_HANDLE_DIFF, payload, payloadSize);
+ * // in the sending loop
+ * WaitForSingleObject(wakeEvent, encoder.Poll());
+ * @endcode
+ *
+ * @threadsafe Not thread-safe; one thread appends, polls and flushes.
+ */
+class BatchEncoder {
+public:
+    /**
+     * @brief Receives each sealed frame; returns false if it could not be sent.
+     */
+    using FrameSink = std::function<bool(const uint8_t* frame, size_t size)>;
+
+    BatchEncoder() = default;
+
+    /**
+     * @brief Releases the key and compressor. An open batch is discarded, not flushed.
+     */
+    ~BatchEncoder();
+
+    BatchEncoder(const BatchEncoder&) = delete;
+    BatchEncoder& operator=(const BatchEncoder&) = delete;
+
+    /**
+     * @brief Imports the AES key (16 or 32 bytes) and preallocates the batch buffers.
+     *
+     * @return false (and logs) on an invalid key or configuration, or if BCrypt or the
+     *         compressor cannot be set up.
+     */
+    bool Initialize(const uint8_t* key, size_t keySize, const BatchEncoderConfig& config, FrameSink sink);
+
+    /**
+     * @brief Appends one record, sealing the open batch first if the record does not fit.
+     *
+     * @return false if the record can never fit in a batch, the encoder is not initialized,
+     *         or sealing the previous batch failed. In the last case that batch is dropped
+     *         (and counted, as by Flush) and the record is not appended; appending it again
+     *         starts a new batch.
+     */
+    bool Append(uint32_t schemaId, const void* payload, size_t size);
+
+    /**
+     * @brief Seals and emits the open batch, if any.
+     *
+     * @return false if sealing or the sink failed; the batch is dropped either way.
+     */
+    bool Flush();
+
+    /**
+     * @brief Flushes the open batch if its deadline has passed.
+     *
+     * @return Milliseconds until the open batch's deadline, or INFINITE if no batch is open.
+     */
+    DWORD Poll();
+
+    const BatchStats& GetStats() const noexcept { return stats_; }
+
+private:
+    void Release() noexcept;
+
+    BCRYPT_ALG_HANDLE algorithm_ = nullptr;
+    BCRYPT_KEY_HANDLE key_ = nullptr;
+    COMPRESSOR_HANDLE compressor_ = nullptr;
+    FrameSink sink_;
+    BatchEncoderConfig config_;
+
+    std::vector<uint8_t> plain_;
+    std::vector<uint8_t> compressed_;
+    std::vector<uint8_t> frame_;
+    size_t plainSize_ = 0;
+    uint32_t recordCount_ = 0;
+    LONGLONG batchStart_ = 0;
+    LONGLONG ticksPerMs_ = 1;
+
+    uint32_t salt_ = 0;
+    uint64_t sequence_ = 0;
+    BatchStats stats_;
+};
+
+/**
+ * @class BatchDecoder
+ * @brief Authenticates, decrypts and unpacks frames produced by a BatchEncoder.
+ *
+ * Usage example:
+ * @code
+ * BatchDecoder decoder;
+ * decoder.Initialize(sessionKey, 32, 32 * 1024);
+ * decoder.Decode(message.GetData(), message.GetSize(),
+ *                [&](uint32_t schemaId, const uint8_t* payload, size_t size) {
+ *                    Dispatch(schemaId, WireReader(payload, size));
+ *                });
+ * @endcode
+ *
+ * @threadsafe Not thread-safe; frames of one session are decoded in order by one thread.
+ */
+class BatchDecoder {
+public:
+    BatchDecoder() = default;
+
+    /**
+     * @brief Releases the key and decompressor.
+     */
+    ~BatchDecoder();
+
+    BatchDecoder(const BatchDecoder&) = delete;
+    BatchDecoder& operator=(const BatchDecoder&) = delete;
+
+    /**
+     * @brief Imports the AES key and preallocates buffers for batches up to
+     * @p maxBatchBytes (the encoder's maxBatchBytes).
+     */
+    bool Initialize(const uint8_t* key, size_t keySize, size_t maxBatchBytes);
+
+    /**
+     * @brief Decodes one frame and invokes @p visitor for each record.
+     *
+     * @param visitor Callable invoked as visitor(uint32_t schemaId, const uint8_t* payload,
+     *        size_t size). The payload is valid until the next Decode call.
+     * @return false (the frame is counted as rejected) if the frame fails validation or
+     *         authentication. Records before a malformed one have already been visited.
+     */
+    template <typename Visitor>
+    bool Decode(const uint8_t* frame, size_t size, Visitor&& visitor) {
+        size_t plainSize = 0;
+        uint32_t recordCount = 0;
+        const uint8_t* plain = Open(frame, size, &plainSize, &recordCount);
+        if (plain == nullptr) {
+            return false;
+        }
+        WireReader reader(plain, plainSize);
+        for (uint32_t i = 0; i < recordCount; ++i) {
+            const uint64_t schemaId = reader.GetUnsigned();
+            const std::string_view payload = reader.GetBytes();
+            if (!reader.IsValid() || schemaId > UINT32_MAX) {
+                return Reject("malformed record");
+            }
+            visitor(static_cast<uint32_t>(schemaId), reinterpret_cast<const uint8_t*>(payload.data()),
+                    payload.size());
+        }
+        if (!reader.IsAtEnd()) {
+            return Reject("trailing bytes after the last record");
+        }
+        stats_.records += recordCount;
+        return true;
+    }
+
+    const BatchStats& GetStats() const noexcept { return stats_; }
+
+private:
+    /**
+     * @brief Validates, authenticates, decrypts and decompresses @p frame.
+     *
+     * @return The plain record stream, or nullptr if the frame was rejected.
+     */
+    const uint8_t* Open(const uint8_t* frame, size_t size, size_t* plainSize, uint32_t* recordCount);
+
+    /**
+     * @brief Logs and counts a rejected frame; always returns false.
+     */
+    bool Reject(const char* reason) noexcept;
+
+    void Release() noexcept;
+
+    BCRYPT_ALG_HANDLE algorithm_ = nullptr;
+    BCRYPT_KEY_HANDLE key_ = nullptr;
+    DECOMPRESSOR_HANDLE decompressor_ = nullptr;
+    size_t maxBatchBytes_ = 0;
+    std::vector<uint8_t> decrypted_;
+    std::vector<uint8_t> plain_;
+    uint64_t lastSequence_ = 0;
+    BatchStats stats_;
+};
+
+} // namespace Comms
+} // namespace Sentinel
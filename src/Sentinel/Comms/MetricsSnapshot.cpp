@@ -0,0 +1,85 @@
+/**
+ * @file MetricsSnapshot.cpp
+ * @brief Encoding of the metrics registry into a snapshot record, and its responder.
+ */
+
+#include "Sentinel/Comms/MetricsSnapshot.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+
+namespace Sentinel {
+namespace Comms {
+
+size_t EncodeMetricsSnapshot(uint8_t* buffer, size_t capacity) noexcept {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+
+    // Metrics registered while encoding are left for the next snapshot
+    const size_t metricCount = Utils::MetricsRegistry::GetCount();
+    WireWriter writer(buffer, capacity);
+    writer.PutUnsigned(Utils::TicksToNanoseconds(now.QuadPart));
+    writer.PutUnsigned(Utils::HISTOGRAM_SUB_BUCKET_BITS);
+    writer.PutUnsigned(metricCount);
+
+    Utils::MetricSample sample;
+    for (size_t index = 0; index < metricCount && writer.IsValid(); ++index) {
+        Utils::MetricsRegistry::Read(index, &sample);
+        writer.PutString(sample.name);
+        writer.PutUnsigned(static_cast<uint64_t>(sample.kind));
+        if (sample.kind == Utils::MetricKind::Counter) {
+            writer.PutUnsigned(static_cast<uint64_t>(sample.value));
+        } else if (sample.kind == Utils::MetricKind::Gauge) {
+            writer.PutSigned(sample.value);
+        } else {
+            const Utils::HistogramSnapshot& histogram = sample.histogram;
+            writer.PutUnsigned(histogram.count);
+            writer.PutUnsigned(histogram.sum);
+            writer.PutUnsigned(histogram.max);
+            uint64_t bucketCount = 0;
+            for (const uint64_t bucket : histogram.buckets) {
+                bucketCount += bucket != 0 ? 1 : 0;
+            }
+            writer.PutUnsigned(bucketCount);
+            size_t previous = 0;
+            for (size_t bucket = 0; bucket < Utils::HISTOGRAM_BUCKET_COUNT; ++bucket) {
+                if (histogram.buckets[bucket] != 0) {
+                    writer.PutUnsigned(bucket - previous);
+                    writer.PutUnsigned(histogram.buckets[bucket]);
+                    previous = bucket;
+                }
+            }
+        }
+    }
+    return writer.IsValid() ? writer.GetSize() : 0;
+}
+
+MetricsResponder::MetricsResponder(BatchEncoder& encoder, size_t capacity) : encoder_(encoder), scratch_(capacity) {}
+
+bool MetricsResponder::OnRecord(uint32_t schemaId, const uint8_t*, size_t size) {
+    if (schemaId != SCHEMA_METRICS_REQUEST) {
+        return false;
+    }
+    if (size != 0) {
+        ++failed_;
+        Utils::Logger::Error("MetricsResponder: ignored a metrics request with a {} byte payload", size);
+        return true;
+    }
+
+    const size_t snapshotSize = EncodeMetricsSnapshot(scratch_.data(), scratch_.size());
+    if (snapshotSize == 0) {
+        ++failed_;
+        Utils::Logger::Error("MetricsResponder: snapshot does not fit in {} bytes", scratch_.size());
+        return true;
+    }
+
+    // Flushed at once: the peer is waiting for the reply, not for more telemetry
+    if (!encoder_.Append(SCHEMA_METRICS_SNAPSHOT, scratch_.data(), snapshotSize) || !encoder_.Flush()) {
+        ++failed_;
+        Utils::Logger::LogError("MetricsResponder: failed to send the metrics snapshot");
+        return true;
+    }
+    ++answered_;
+    return true;
+}
+
+} // namespace Comms
+} // namespace Sentinel
@@ -0,0 +1,178 @@
+/**
+ * @file MetricsSnapshot.hpp
+ * @brief Wire encoding of the metrics registry for requests over the Communication Pipe.
+ *
+ * @details The Service asks a Monitor for its metrics by sending a SCHEMA_METRICS_REQUEST
+ * record (empty payload); the Monitor answers with one SCHEMA_METRICS_SNAPSHOT record
+ * holding every registered metric. Both travel as ordinary records through BatchEncoder,
+ * so they are encrypted and authenticated like all other pipe traffic.
+ * @code
+ * snapshot  := varint timestampNs | varint subBucketBits | varint metricCount | metric*
+ * metric    := bytes name | varint kind | counter | gauge | histogram
+ * counter   := varint value
+ * gauge     := zigzag value
+ * histogram := varint count | varint sum | varint max | varint bucketCount
+ *              { varint indexDelta | varint bucketValue }*
+ * @endcode
+ * Only non-empty histogram buckets are sent, as deltas from the previous bucket index,
+ * which keeps a typical latency histogram to a few dozen bytes. timestampNs is the
+ * QueryPerformanceCounter time of the snapshot: rates such as VM instructions per second
+ * are the difference of two snapshots divided by the difference of their timestamps.
+ *
+ * MetricsResponder serves the requests: a session hands it every record its BatchDecoder
+ * yields, and it answers each request through the session's BatchEncoder.
+ *
+ * @security The decoder validates every field; a snapshot comes from another process.
+ *
+ * @see Utils::MetricsRegistry
+ * @see BatchEncoder
+ */
+
+#pragma once
+
+#include "Sentinel/Comms/BatchCodec.hpp"
+#include "Sentinel/Comms/WireFormat.hpp"
+#include "Sentinel/Utils/Metrics.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Sentinel {
+namespace Comms {
+
+/** @brief Record asking the peer for a metrics snapshot; the payload is empty. */
+inline constexpr uint32_t SCHEMA_METRICS_REQUEST = 0x0101;
+
+/** @brief Record carrying a metrics snapshot. */
+inline constexpr uint32_t SCHEMA_METRICS_SNAPSHOT = 0x0102;
+
+/**
+ * @brief Encodes every registered metric into @p buffer.
+ *
+ * @details Sessions normally answer requests through MetricsResponder, which calls this.
+ *
+ * @return Size of the payload, or 0 if it does not fit in @p capacity bytes.
+ *
+ * @threadsafe Thread-safe.
+ */
+size_t EncodeMetricsSnapshot(uint8_t* buffer, size_t capacity) noexcept;
+
+/**
+ * @class MetricsResponder
+ * @brief Answers the SCHEMA_METRICS_REQUEST records of one session.
+ *
+ * @details Each request is answered with one SCHEMA_METRICS_SNAPSHOT record appended to the
+ * session's encoder, which is then flushed so the reply does not wait for the batch
+ * deadline. Records of other schemas are left to the caller.
+ *
+ * Usage example:
+ * @code
+ * MetricsResponder responder(encoder);
+ * decoder.Decode(frame, size, [&](uint32_t schemaId, const uint8_t* payload, size_t size) {
+ *     if (!responder.OnRecord(schemaId, payload, size)) {
+ *         Dispatch(schemaId, WireReader(payload, size));
+ *     }
+ * });
+ * @endcode
+ *
+ * @threadsafe Not thread-safe; use it on the thread that owns the encoder.
+ */
+class MetricsResponder {
+public:
+    /** @brief Default snapshot buffer; must not exceed the encoder's maxBatchBytes. */
+    static constexpr size_t DEFAULT_CAPACITY = 16 * 1024;
+
+    /**
+     * @param encoder Encoder of the session; must outlive the responder.
+     * @param capacity Largest snapshot payload the responder can send.
+     */
+    explicit MetricsResponder(BatchEncoder& encoder, size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief Answers @p schemaId if it is a metrics request.
+     *
+     * @return true if the record was a metrics request, answered or not: a request with a
+     *         payload, a snapshot that does not fit, or a failed send is counted and
+     *         logged. false for records of other schemas.
+     */
+    bool OnRecord(uint32_t schemaId, const uint8_t* payload, size_t size);
+
+    /** @brief Requests answered with a snapshot. */
+    uint64_t GetAnsweredCount() const noexcept { return answered_; }
+
+    /** @brief Requests that could not be answered. */
+    uint64_t GetFailedCount() const noexcept { return failed_; }
+
+private:
+    BatchEncoder& encoder_;
+    std::vector<uint8_t> scratch_;
+    uint64_t answered_ = 0;
+    uint64_t failed_ = 0;
+};
+
+/**
+ * @brief Decodes a SCHEMA_METRICS_SNAPSHOT payload and invokes @p visitor for each metric.
+ *
+ * @param visitor Callable invoked as visitor(const Utils::MetricSample&). The sample's name
+ *        points into @p payload.
+ * @param timestampNs Receives the snapshot time; may be nullptr.
+ * @return false if the payload is malformed or uses another histogram layout. Metrics
+ *         before a malformed one have already been visited.
+ */
+template <typename Visitor>
+bool DecodeMetricsSnapshot(const uint8_t* payload, size_t size, Visitor&& visitor, uint64_t* timestampNs = nullptr) {
+    WireReader reader(payload, size);
+    const uint64_t timestamp = reader.GetUnsigned();
+    const uint64_t subBucketBits = reader.GetUnsigned();
+    const uint64_t metricCount = reader.GetUnsigned();
+    if (!reader.IsValid() || subBucketBits != Utils::HISTOGRAM_SUB_BUCKET_BITS ||
+        metricCount > Utils::MetricsRegistry::MAX_METRICS) {
+        return false;
+    }
+    if (timestampNs != nullptr) {
+        *timestampNs = timestamp;
+    }
+
+    Utils::MetricSample sample;
+    for (uint64_t i = 0; i < metricCount; ++i) {
+        sample.name = reader.GetBytes();
+        const uint64_t kind = reader.GetUnsigned();
+        sample.value = 0;
+        if (kind == static_cast<uint64_t>(Utils::MetricKind::Counter)) {
+            sample.kind = Utils::MetricKind::Counter;
+            sample.value = static_cast<int64_t>(reader.GetUnsigned());
+        } else if (kind == static_cast<uint64_t>(Utils::MetricKind::Gauge)) {
+            sample.kind = Utils::MetricKind::Gauge;
+            sample.value = reader.GetSigned();
+        } else if (kind == static_cast<uint64_t>(Utils::MetricKind::Histogram)) {
+            sample.kind = Utils::MetricKind::Histogram;
+            sample.histogram = Utils::HistogramSnapshot{};
+            sample.histogram.count = reader.GetUnsigned();
+            sample.histogram.sum = reader.GetUnsigned();
+            sample.histogram.max = reader.GetUnsigned();
+            const uint64_t bucketCount = reader.GetUnsigned();
+            if (bucketCount > Utils::HISTOGRAM_BUCKET_COUNT) {
+                return false;
+            }
+            uint64_t index = 0;
+            for (uint64_t bucket = 0; bucket < bucketCount; ++bucket) {
+                const uint64_t delta = reader.GetUnsigned();
+                if (delta >= Utils::HISTOGRAM_BUCKET_COUNT - index) {
+                    return false;
+                }
+                index += delta;
+                sample.histogram.buckets[index] = reader.GetUnsigned();
+            }
+        } else {
+            return false;
+        }
+        if (!reader.IsValid()) {
+            return false;
+        }
+        visitor(static_cast<const Utils::MetricSample&>(sample));
+    }
+    return reader.IsAtEnd();
+}
+
+} // namespace Comms
+} // namespace Sentinel
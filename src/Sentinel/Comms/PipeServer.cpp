@@ -0,0 +1,459 @@
+/**
+ * @file PipeServer.cpp
+ * @brief Implementation of the completion-port pipe server.
+ */
+
+#include "Sentinel/Comms/PipeServer.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+#include <sddl.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+
+namespace Sentinel {
+namespace Comms {
+
+// Completion keys; pipe instances are associated with key 0
+static constexpr ULONG_PTR STOP_KEY = 1;
+static constexpr ULONG_PTR CONNECTED_KEY = 2;
+
+// Message buffers of every server in the process
+static Utils::AllocatorStats pipeBufferStats("alloc.pipe_buffers.reserved_bytes", "alloc.pipe_buffers.in_use_bytes",
+                                             "alloc.pipe_buffers.overflows");
+
+/**
+ * @brief One pipe instance, from listening to the release of its last reference.
+ *
+ * @details Every outstanding I/O holds a reference, as does the PipeClient of a connected
+ * instance, so the handle is closed only when no completion can still refer to it.
+ * Everything below lock is protected by it.
+ */
+struct PipeConnection {
+    PipeServer* server = nullptr;
+    HANDLE pipe = INVALID_HANDLE_VALUE;
+    DWORD processId = 0;
+    bool connected = false;
+    std::atomic<long> refs{1};
+
+    PipeIoOperation connectOp{};
+    PipeIoOperation readOp{};
+
+    std::mutex lock;
+    bool closed = false;
+    bool readPending = false;
+    uint8_t* readBuffer = nullptr;
+    std::deque<PipeMessage> inbox;
+    PipeReadAwaiter* reader = nullptr;
+};
+
+static_assert(offsetof(PipeIoOperation, overlapped) == 0, "completions are mapped back through the OVERLAPPED");
+
+bool PipeReadAwaiter::await_suspend(std::coroutine_handle<> waiter) {
+    if (connection_ == nullptr) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(connection_->lock);
+    if (!connection_->inbox.empty()) {
+        message_ = std::move(connection_->inbox.front());
+        connection_->inbox.pop_front();
+        // Reading pauses while the inbox is full, so a slot freed here may restart it
+        connection_->server->PostRead(connection_);
+        return false;
+    }
+    if (connection_->closed) {
+        return false;
+    }
+    waiter_ = waiter;
+    connection_->reader = this;
+    return true;
+}
+
+bool PipeWriteAwaiter::await_suspend(std::coroutine_handle<> waiter) {
+    operation_.error = ERROR_INVALID_HANDLE;
+    if (connection_ == nullptr) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(connection_->lock);
+    if (connection_->closed) {
+        return false;
+    }
+    if (size_ > connection_->server->config_.messageSize) {
+        operation_.error = ERROR_INVALID_PARAMETER;
+        return false;
+    }
+
+    operation_.kind = PipeIoKind::Write;
+    operation_.connection = connection_;
+    operation_.waiter = waiter;
+    PipeServer::AddRef(connection_);
+    if (WriteFile(connection_->pipe, data_, static_cast<DWORD>(size_), nullptr, &operation_.overlapped) != 0 ||
+        GetLastError() == ERROR_IO_PENDING) {
+        // The completion may resume the session on a worker before this returns, so the
+        // awaiter is not touched again
+        return true;
+    }
+    operation_.error = GetLastError();
+    // The I/O reference never reaches zero here: the client holds another one
+    connection_->refs.fetch_sub(1, std::memory_order_acq_rel);
+    return false;
+}
+
+PipeClient::~PipeClient() {
+    if (connection_ != nullptr) {
+        Close();
+        connection_->server->Release(connection_);
+    }
+}
+
+DWORD PipeClient::GetProcessId() const noexcept {
+    return connection_ != nullptr ? connection_->processId : 0;
+}
+
+void PipeClient::Close() noexcept {
+    if (connection_ != nullptr) {
+        std::lock_guard<std::mutex> guard(connection_->lock);
+        PipeServer::CloseConnection(connection_);
+    }
+}
+
+PipeServer::~PipeServer() {
+    Stop();
+}
+
+bool PipeServer::Start(const PipeServerConfig& config, SessionHandler handler) {
+    if (port_ != nullptr) {
+        Utils::Logger::LogError("PipeServer: already running");
+        return false;
+    }
+    if (config.pipeName.empty() || config.messageSize == 0 || config.listenerCount == 0 ||
+        config.maxInstances < config.listenerCount || !handler) {
+        Utils::Logger::LogError("PipeServer: invalid configuration");
+        return false;
+    }
+    config_ = config;
+    handler_ = std::move(handler);
+
+    if (ConvertStringSecurityDescriptorToSecurityDescriptorW(config_.sddl.c_str(), SDDL_REVISION_1,
+                                                             &securityDescriptor_, nullptr) == 0) {
+        Utils::Logger::Error("PipeServer: invalid SDDL ({})", GetLastError());
+        securityDescriptor_ = nullptr;
+        return false;
+    }
+
+    pool_ = std::make_unique<Utils::SlabPool>();
+    const uint32_t workerCount = config_.workerCount != 0 ? config_.workerCount : 2;
+    port_ = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, workerCount);
+    if (!pool_->Initialize(config_.messageSize, config_.bufferCount, &pipeBufferStats) || port_ == nullptr) {
+        Utils::Logger::Error("PipeServer: cannot create completion port or buffer pool ({})", GetLastError());
+        Stop();
+        return false;
+    }
+
+    stopping_.store(false, std::memory_order_relaxed);
+    firstInstance_ = true;
+    listening_ = 0;
+    if (!CreateListener()) {
+        // Typically another process already owns the name
+        Stop();
+        return false;
+    }
+
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        workers_.emplace_back(&PipeServer::WorkerLoop, this);
+    }
+    ReplenishListeners();
+
+    Utils::Logger::Info("PipeServer: listening with {} workers, {} byte messages", workerCount, config_.messageSize);
+    return true;
+}
+
+void PipeServer::Stop(DWORD timeoutMs) {
+    if (port_ == nullptr) {
+        if (securityDescriptor_ != nullptr) {
+            LocalFree(securityDescriptor_);
+            securityDescriptor_ = nullptr;
+        }
+        return;
+    }
+
+    stopping_.store(true, std::memory_order_relaxed);
+    {
+        std::unique_lock<std::mutex> guard(connectionsMutex_);
+        for (PipeConnection* connection : connections_) {
+            std::lock_guard<std::mutex> connectionGuard(connection->lock);
+            CloseConnection(connection);
+        }
+        // Cancelled I/O completes on the workers, which wakes every waiting session
+        if (!connectionsDrained_.wait_for(guard, std::chrono::milliseconds(timeoutMs),
+                                          [this] { return connections_.empty(); })) {
+            Utils::Logger::Warning("PipeServer: {} connections still open after {} ms", connections_.size(),
+                                   timeoutMs);
+        }
+    }
+
+    // Each worker forwards the packet to the next before exiting
+    if (!workers_.empty()) {
+        PostQueuedCompletionStatus(port_, 0, STOP_KEY, nullptr);
+    }
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+
+    CloseHandle(port_);
+    port_ = nullptr;
+    LocalFree(securityDescriptor_);
+    securityDescriptor_ = nullptr;
+    handler_ = nullptr;
+}
+
+void PipeServer::WorkerLoop() {
+    OVERLAPPED_ENTRY entries[COMPLETION_BATCH];
+    for (;;) {
+        ULONG removed = 0;
+        if (GetQueuedCompletionStatusEx(port_, entries, COMPLETION_BATCH, &removed, INFINITE, FALSE) == 0) {
+            Utils::Logger::Error("PipeServer: GetQueuedCompletionStatusEx failed ({})", GetLastError());
+            return;
+        }
+
+        bool stop = false;
+        for (ULONG i = 0; i < removed; ++i) {
+            if (entries[i].lpCompletionKey == STOP_KEY) {
+                stop = true;
+                continue;
+            }
+            PipeIoOperation* operation = reinterpret_cast<PipeIoOperation*>(entries[i].lpOverlapped);
+            DWORD error = ERROR_SUCCESS;
+            if (entries[i].lpCompletionKey != CONNECTED_KEY) {
+                DWORD bytes = 0;
+                if (GetOverlappedResult(operation->connection->pipe, &operation->overlapped, &bytes, FALSE) == 0) {
+                    error = GetLastError();
+                }
+            }
+            OnCompletion(operation, entries[i].dwNumberOfBytesTransferred, error);
+        }
+        if (stop) {
+            PostQueuedCompletionStatus(port_, 0, STOP_KEY, nullptr);
+            return;
+        }
+    }
+}
+
+void PipeServer::OnCompletion(PipeIoOperation* operation, DWORD bytes, DWORD error) {
+    PipeConnection* connection = operation->connection;
+    switch (operation->kind) {
+    case PipeIoKind::Connect:
+        {
+            std::lock_guard<std::mutex> guard(connectionsMutex_);
+            --listening_;
+        }
+        // ERROR_OPERATION_ABORTED on Stop; ERROR_NO_DATA if the client is already gone
+        if (error == ERROR_SUCCESS && !stopping_.load(std::memory_order_relaxed)) {
+            OnConnected(connection);
+        }
+        Release(connection);
+        ReplenishListeners();
+        break;
+
+    case PipeIoKind::Read:
+        OnReadCompleted(connection, bytes, error);
+        break;
+
+    case PipeIoKind::Write:
+        {
+            // The awaiter lives in the session frame, which may be gone after the resume
+            const std::coroutine_handle<> waiter = operation->waiter;
+            operation->error = error;
+            waiter.resume();
+            Release(connection);
+        }
+        break;
+    }
+}
+
+void PipeServer::OnConnected(PipeConnection* connection) {
+    ULONG processId = 0;
+    GetNamedPipeClientProcessId(connection->pipe, &processId);
+    connection->processId = processId;
+    connection->connected = true;
+    connectedCount_.fetch_add(1, std::memory_order_relaxed);
+
+    AddRef(connection);
+    PipeClient client(connection);
+    bool closed;
+    {
+        std::lock_guard<std::mutex> guard(connection->lock);
+        PostRead(connection);
+        closed = connection->closed;
+    }
+    if (!closed) {
+        handler_(std::move(client));
+    }
+}
+
+void PipeServer::OnReadCompleted(PipeConnection* connection, DWORD bytes, DWORD error) {
+    std::coroutine_handle<> waiter;
+    {
+        std::lock_guard<std::mutex> guard(connection->lock);
+        connection->readPending = false;
+        uint8_t* buffer = connection->readBuffer;
+        connection->readBuffer = nullptr;
+
+        if (error == ERROR_SUCCESS && !connection->closed) {
+            PipeMessage message(pool_.get(), buffer, bytes);
+            if (connection->reader != nullptr) {
+                connection->reader->message_ = std::move(message);
+                waiter = connection->reader->waiter_;
+                connection->reader = nullptr;
+            } else {
+                connection->inbox.push_back(std::move(message));
+            }
+            PostRead(connection);
+        } else {
+            pool_->Release(buffer);
+            if (error == ERROR_MORE_DATA) {
+                Utils::Logger::Warning("PipeServer: message from process {} exceeds {} bytes, disconnecting",
+                                       connection->processId, config_.messageSize);
+            }
+            CloseConnection(connection);
+            // An empty message tells the session the client is gone
+            if (connection->reader != nullptr) {
+                waiter = connection->reader->waiter_;
+                connection->reader = nullptr;
+            }
+        }
+    }
+    // Resumed outside the lock: the session may read, write or close right away
+    if (waiter) {
+        waiter.resume();
+    }
+    Release(connection);
+}
+
+void PipeServer::ReplenishListeners() {
+    while (CreateListener()) {
+    }
+}
+
+bool PipeServer::CreateListener() {
+    PipeConnection* connection = new PipeConnection();
+    connection->server = this;
+    {
+        std::lock_guard<std::mutex> guard(connectionsMutex_);
+        if (stopping_.load(std::memory_order_relaxed) || listening_ >= config_.listenerCount ||
+            connections_.size() >= config_.maxInstances) {
+            delete connection;
+            return false;
+        }
+
+        SECURITY_ATTRIBUTES attributes{sizeof(attributes), securityDescriptor_, FALSE};
+        const DWORD openMode =
+            PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (firstInstance_ ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0);
+        const DWORD instances = std::min<DWORD>(config_.maxInstances, PIPE_UNLIMITED_INSTANCES);
+        connection->pipe = CreateNamedPipeW(
+            config_.pipeName.c_str(), openMode,
+            PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS, instances,
+            config_.messageSize, config_.messageSize, 0, &attributes);
+        if (connection->pipe == INVALID_HANDLE_VALUE) {
+            Utils::Logger::Error("PipeServer: CreateNamedPipeW failed ({})", GetLastError());
+            delete connection;
+            return false;
+        }
+        firstInstance_ = false;
+        connections_.insert(connection);
+        ++listening_;
+    }
+
+    // From here on the connect reference (refs = 1) owns the instance
+    connection->connectOp.kind = PipeIoKind::Connect;
+    connection->connectOp.connection = connection;
+    if (CreateIoCompletionPort(connection->pipe, port_, 0, 0) == nullptr) {
+        Utils::Logger::Error("PipeServer: cannot associate pipe with completion port ({})", GetLastError());
+        {
+            std::lock_guard<std::mutex> guard(connectionsMutex_);
+            --listening_;
+        }
+        Release(connection);
+        return false;
+    }
+
+    if (ConnectNamedPipe(connection->pipe, &connection->connectOp.overlapped) == 0) {
+        const DWORD error = GetLastError();
+        if (error == ERROR_PIPE_CONNECTED) {
+            // A client connected between CreateNamedPipeW and ConnectNamedPipe; no packet
+            // is queued for that, so one is posted
+            PostQueuedCompletionStatus(port_, 0, CONNECTED_KEY, &connection->connectOp.overlapped);
+        } else if (error != ERROR_IO_PENDING) {
+            Utils::Logger::Error("PipeServer: ConnectNamedPipe failed ({})", error);
+            {
+                std::lock_guard<std::mutex> guard(connectionsMutex_);
+                --listening_;
+            }
+            Release(connection);
+            return false;
+        }
+    }
+    return true;
+}
+
+void PipeServer::PostRead(PipeConnection* connection) {
+    if (connection->readPending || connection->closed || connection->inbox.size() >= config_.maxQueuedMessages) {
+        return;
+    }
+    uint8_t* buffer = pool_->Acquire();
+    if (buffer == nullptr) {
+        Utils::Logger::LogError("PipeServer: out of message buffers, disconnecting");
+        CloseConnection(connection);
+        return;
+    }
+
+    connection->readOp = PipeIoOperation{};
+    connection->readOp.kind = PipeIoKind::Read;
+    connection->readOp.connection = connection;
+    AddRef(connection);
+    if (ReadFile(connection->pipe, buffer, config_.messageSize, nullptr, &connection->readOp.overlapped) != 0 ||
+        GetLastError() == ERROR_IO_PENDING) {
+        connection->readPending = true;
+        connection->readBuffer = buffer;
+        return;
+    }
+
+    // ERROR_BROKEN_PIPE once the client has gone. Callers always hold another reference,
+    // so this one cannot be the last
+    connection->refs.fetch_sub(1, std::memory_order_acq_rel);
+    pool_->Release(buffer);
+    CloseConnection(connection);
+}
+
+void PipeServer::AddRef(PipeConnection* connection) noexcept {
+    connection->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PipeServer::Release(PipeConnection* connection) noexcept {
+    if (connection->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    CloseHandle(connection->pipe);
+    if (connection->connected) {
+        connectedCount_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Notified under the lock: Stop may destroy the server as soon as the set is empty
+    std::lock_guard<std::mutex> guard(connectionsMutex_);
+    connections_.erase(connection);
+    delete connection;
+    if (connections_.empty()) {
+        connectionsDrained_.notify_all();
+    }
+}
+
+void PipeServer::CloseConnection(PipeConnection* connection) noexcept {
+    if (!connection->closed) {
+        connection->closed = true;
+        // Pending reads, writes and connects complete with ERROR_OPERATION_ABORTED
+        CancelIoEx(connection->pipe, nullptr);
+    }
+}
+
+} // namespace Comms
+} // namespace Sentinel
@@ -0,0 +1,373 @@
+/**
+ * @file PipeServer.hpp
+ * @brief Service side of the Communication Pipe on overlapped I/O and a completion port.
+ *
+ * @details A host runs hundreds of monitored processes, each holding a pipe connection
+ * to the Service. A thread per client would park hundreds of threads - and their stacks -
+ * in blocking ReadFile calls. PipeServer instead serves every connection from a small
+ * fixed pool of workers:
+ * - All pipe instances are opened with FILE_FLAG_OVERLAPPED and associated with one I/O
+ *   completion port. Workers dequeue up to COMPLETION_BATCH completions per
+ *   GetQueuedCompletionStatusEx call.
+ * - listenerCount instances always have a ConnectNamedPipe posted, so a connecting
+ *   client never waits for the server to create an instance.
+ * - Every connection keeps a read preposted: as soon as one message arrives, the next
+ *   read is issued into a fresh SlabPool buffer, and messages the session has not asked
+ *   for yet queue on the connection (up to maxQueuedMessages, after which reading pauses
+ *   until the session catches up).
+ *
+ * Sessions are C++20 coroutines. For every accepted client the server calls the session
+ * handler, which co_awaits PipeClient::Read and PipeClient::Write; each co_await
+ * suspends the session while its I/O is in flight, and the worker that dequeues the
+ * completion resumes it. Session code therefore reads like a blocking loop but holds no
+ * thread while waiting.
+ *
+ * The pipe follows Module D: PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT (the
+ * wait mode only affects non-overlapped handles), the documented SDDL, and additionally
+ * PIPE_REJECT_REMOTE_CLIENTS and FILE_FLAG_FIRST_PIPE_INSTANCE on the first instance, so
+ * the server fails to start instead of sharing a name another process already created.
+ *
+ * @security The SDDL decides who may connect. Sessions should still validate the
+ * client (PipeClient::GetProcessId, then its token or image) before trusting it. Messages
+ * longer than messageSize close the connection rather than being reassembled, which
+ * bounds per-connection memory.
+ *
+ * @performance No thread blocks per connection, buffers come from a lock-free pool, and
+ * completion processing takes a per-connection lock only. Session code runs on the I/O
+ * workers and must not block.
+ *
+ * @see Utils::SlabPool
+ */
+
+#pragma once
+
+#include "Sentinel/Utils/SlabPool.hpp"
+#include <Windows.h>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace Sentinel {
+namespace Comms {
+
+struct PipeConnection;
+
+/**
+ * @brief One received message; returns its buffer to the pool when destroyed.
+ *
+ * @details An empty message (IsValid() false) signals that the connection is closed;
+ * messages that arrived before the disconnect are delivered first.
+ */
+class PipeMessage {
+public:
+    PipeMessage() = default;
+    PipeMessage(Utils::SlabPool* pool, uint8_t* data, size_t size) noexcept : pool_(pool), data_(data), size_(size) {}
+    ~PipeMessage() { Reset(); }
+
+    PipeMessage(PipeMessage&& other) noexcept : pool_(other.pool_), data_(other.data_), size_(other.size_) {
+        other.data_ = nullptr;
+    }
+
+    PipeMessage& operator=(PipeMessage&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            pool_ = other.pool_;
+            data_ = other.data_;
+            size_ = other.size_;
+            other.data_ = nullptr;
+        }
+        return *this;
+    }
+
+    PipeMessage(const PipeMessage&) = delete;
+    PipeMessage& operator=(const PipeMessage&) = delete;
+
+    bool IsValid() const noexcept { return data_ != nullptr; }
+    const uint8_t* GetData() const noexcept { return data_; }
+    size_t GetSize() const noexcept { return size_; }
+
+private:
+    void Reset() noexcept {
+        if (data_ != nullptr) {
+            pool_->Release(data_);
+            data_ = nullptr;
+        }
+    }
+
+    Utils::SlabPool* pool_ = nullptr;
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/**
+ * @brief What a completion packet completed.
+ */
+enum class PipeIoKind : uint8_t {
+    Connect = 0,
+    Read = 1,
+    Write = 2
+};
+
+/**
+ * @brief OVERLAPPED plus the context needed to route its completion.
+ *
+ * @details overlapped must remain the first member: completions are mapped back to the
+ * operation from the OVERLAPPED pointer.
+ */
+struct PipeIoOperation {
+    OVERLAPPED overlapped;
+    PipeIoKind kind;
+    PipeConnection* connection;
+
+    /** @brief Coroutine to resume on completion (writes only). */
+    std::coroutine_handle<> waiter;
+
+    /** @brief Win32 error of the completed operation. */
+    DWORD error;
+};
+
+/**
+ * @brief Awaitable returned by PipeClient::Read; yields the next PipeMessage.
+ */
+class PipeReadAwaiter {
+public:
+    explicit PipeReadAwaiter(PipeConnection* connection) noexcept : connection_(connection) {}
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> waiter);
+    PipeMessage await_resume() noexcept { return std::move(message_); }
+
+private:
+    friend class PipeServer;
+
+    PipeConnection* connection_;
+    PipeMessage message_;
+    std::coroutine_handle<> waiter_;
+};
+
+/**
+ * @brief Awaitable returned by PipeClient::Write; yields true if the write completed.
+ */
+class PipeWriteAwaiter {
+public:
+    PipeWriteAwaiter(PipeConnection* connection, const void* data, size_t size) noexcept
+        : connection_(connection), data_(data), size_(size) {}
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> waiter);
+    bool await_resume() const noexcept { return operation_.error == ERROR_SUCCESS; }
+
+private:
+    PipeConnection* connection_;
+    const void* data_;
+    size_t size_;
+    PipeIoOperation operation_{};
+};
+
+/**
+ * @class PipeClient
+ * @brief A session's handle to its connection.
+ *
+ * @details Owns a reference to the connection; destroying the last PipeClient (normally
+ * when the session coroutine finishes) closes the pipe instance. At most one Read and one
+ * Write may be outstanding at a time.
+ */
+class PipeClient {
+public:
+    PipeClient(PipeClient&& other) noexcept : connection_(other.connection_) { other.connection_ = nullptr; }
+    PipeClient& operator=(PipeClient&&) = delete;
+    PipeClient(const PipeClient&) = delete;
+    PipeClient& operator=(const PipeClient&) = delete;
+
+    /**
+     * @brief Closes the connection and releases it.
+     */
+    ~PipeClient();
+
+    /** @brief Next message; empty once the client disconnects or the server stops. */
+    PipeReadAwaiter Read() noexcept { return PipeReadAwaiter(connection_); }
+
+    /** @brief Writes one message; @p data must stay valid until the co_await returns. */
+    PipeWriteAwaiter Write(const void* data, size_t size) noexcept { return PipeWriteAwaiter(connection_, data, size); }
+
+    /** @brief Process id of the connected client, from GetNamedPipeClientProcessId. */
+    DWORD GetProcessId() const noexcept;
+
+    /**
+     * @brief Disconnects the client; outstanding awaits complete with failure.
+     */
+    void Close() noexcept;
+
+private:
+    friend class PipeServer;
+
+    explicit PipeClient(PipeConnection* connection) noexcept : connection_(connection) {}
+
+    PipeConnection* connection_;
+};
+
+/**
+ * @brief Coroutine type of a session: starts eagerly and destroys itself on completion.
+ */
+struct PipeSession {
+    struct promise_type {
+        PipeSession get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+/**
+ * @brief Configuration for PipeServer::Start.
+ */
+struct PipeServerConfig {
+    /** @brief Full pipe name, e.g. \\.\pipe\SentinelMonitor-{GUID}. */
+    std::wstring pipeName;
+
+    /** @brief Security descriptor of every pipe instance (see Module D). */
+    std::wstring sddl = L"D:(A;;GA;;;SY)(A;;GA;;;BA)(A;;GRGW;;;S-1-5-32-544)";
+
+    /** @brief Upper bound on simultaneous instances (connections plus listeners). */
+    uint32_t maxInstances = 256;
+
+    /** @brief Instances kept waiting in ConnectNamedPipe. */
+    uint32_t listenerCount = 4;
+
+    /** @brief Completion port workers (0 = two). */
+    uint32_t workerCount = 2;
+
+    /** @brief Largest accepted message, also the pipe buffer and pool buffer size. */
+    uint32_t messageSize = 64 * 1024;
+
+    /** @brief Buffers preallocated in the pool. */
+    uint32_t bufferCount = 1024;
+
+    /** @brief Received messages a session may leave unread before reading pauses. */
+    uint32_t maxQueuedMessages = 16;
+};
+
+/**
+ * @class PipeServer
+ * @brief Completion-port named pipe server running one coroutine session per client.
+ *
+ * Usage example:
+ * @code
+ * PipeSession Echo(PipeClient client) {
+ *     for (;;) {
+ *         PipeMessage message = co_await client.Read();
+ *         if (!message.IsValid() || !co_await client.Write(message.GetData(), message.GetSize())) {
+ *             co_return;
+ *         }
+ *     }
+ * }
+ *
+ * PipeServer server;
+ * PipeServerConfig config;
+ * config.pipeName = L"\\\\.\\pipe\\SentinelMonitor-{...}";
+ * server.Start(config, &Echo);
+ * @endcode
+ *
+ * @threadsafe Start and Stop must not be called concurrently. The handler is invoked on
+ * worker threads, concurrently for different clients.
+ */
+class PipeServer {
+public:
+    using SessionHandler = std::function<PipeSession(PipeClient)>;
+
+    /** @brief Completions dequeued per GetQueuedCompletionStatusEx call. */
+    static constexpr ULONG COMPLETION_BATCH = 64;
+
+    PipeServer() = default;
+
+    /**
+     * @brief Stops the server if it is running.
+     */
+    ~PipeServer();
+
+    PipeServer(const PipeServer&) = delete;
+    PipeServer& operator=(const PipeServer&) = delete;
+
+    /**
+     * @brief Creates the completion port, the workers and the listening instances.
+     *
+     * @return false (and logs) if the server is running, the SDDL does not parse, or the
+     *         first pipe instance cannot be created (for example, because the name is taken).
+     */
+    bool Start(const PipeServerConfig& config, SessionHandler handler);
+
+    /**
+     * @brief Disconnects every client, waits up to @p timeoutMs for sessions to finish,
+     * and joins the workers.
+     */
+    void Stop(DWORD timeoutMs = 5000);
+
+    bool IsRunning() const noexcept { return port_ != nullptr; }
+
+    /** @brief Clients currently connected. */
+    size_t GetConnectionCount() const noexcept { return connectedCount_.load(std::memory_order_relaxed); }
+
+    /** @brief Buffers taken from the heap because the pool was empty. */
+    uint64_t GetBufferOverflowCount() const noexcept { return pool_ ? pool_->GetOverflowCount() : 0; }
+
+private:
+    friend class PipeReadAwaiter;
+    friend class PipeWriteAwaiter;
+    friend class PipeClient;
+
+    void WorkerLoop();
+    void OnCompletion(PipeIoOperation* operation, DWORD bytes, DWORD error);
+    void OnConnected(PipeConnection* connection);
+    void OnReadCompleted(PipeConnection* connection, DWORD bytes, DWORD error);
+
+    /**
+     * @brief Creates listening instances until listenerCount are waiting.
+     */
+    void ReplenishListeners();
+
+    /**
+     * @brief Creates one instance and posts its ConnectNamedPipe.
+     */
+    bool CreateListener();
+
+    /**
+     * @brief Issues the connection's next read unless one is pending, the inbox is full
+     * or the connection is closed. Caller holds the connection lock.
+     */
+    void PostRead(PipeConnection* connection);
+
+    static void AddRef(PipeConnection* connection) noexcept;
+    void Release(PipeConnection* connection) noexcept;
+    static void CloseConnection(PipeConnection* connection) noexcept;
+
+    PipeServerConfig config_;
+    SessionHandler handler_;
+    PSECURITY_DESCRIPTOR securityDescriptor_ = nullptr;
+    HANDLE port_ = nullptr;
+    std::unique_ptr<Utils::SlabPool> pool_;
+    std::vector<std::thread> workers_;
+
+    // Live connections (listening or connected) and the listeners among them
+    std::mutex connectionsMutex_;
+    std::condition_variable connectionsDrained_;
+    std::unordered_set<PipeConnection*> connections_;
+    uint32_t listening_ = 0;
+    bool firstInstance_ = true;
+    std::atomic<bool> stopping_{false};
+    std::atomic<size_t> connectedCount_{0};
+};
+
+} // namespace Comms
+} // namespace Sentinel
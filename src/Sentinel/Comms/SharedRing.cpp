@@ -0,0 +1,363 @@
+/**
+ * @file SharedRing.cpp
+ * @brief Implementation of the shared-memory telemetry ring.
+ */
+
+#include "Sentinel/Comms/SharedRing.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+#include <sddl.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <new>
+
+namespace Sentinel {
+namespace Comms {
+
+static constexpr uint32_t RING_MAGIC = 0x474E5253; // "SRNG"
+static constexpr uint32_t RING_VERSION = 1;
+static constexpr size_t MIN_CAPACITY = 4096;
+static constexpr size_t MAX_CAPACITY = size_t{1} << 30;
+
+// Record length value marking the unused tail of the ring before a wrap
+static constexpr uint32_t PADDING_MARKER = 0xFFFFFFFF;
+
+#pragma warning(push)
+#pragma warning(disable : 4324) // structure was padded due to alignment specifier
+
+/**
+ * @brief Start of the section; the data area follows it.
+ *
+ * @details magic, version and capacity are written once by the creator. head and
+ * producerWaiting are written by the producer, tail and consumerWaiting by the consumer
+ * (each side clears its own flag, the other side may clear it when signalling).
+ */
+struct SharedRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+
+    alignas(64) std::atomic<uint64_t> head;
+    std::atomic<uint32_t> producerWaiting;
+
+    alignas(64) std::atomic<uint64_t> tail;
+    std::atomic<uint32_t> consumerWaiting;
+};
+
+#pragma warning(pop)
+
+// The atomics are shared between processes, which is only valid for lock-free types
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "shared ring cursors must be lock-free");
+
+/**
+ * @brief Milliseconds left of @p timeoutMs since @p start.
+ *
+ * @details The events are auto-reset and may still be signalled from an earlier wake, so a
+ * wait can return before there is anything to do; the waits loop until the deadline.
+ */
+static DWORD RemainingMs(ULONGLONG start, DWORD timeoutMs) noexcept {
+    if (timeoutMs == INFINITE) {
+        return INFINITE;
+    }
+    const ULONGLONG elapsed = GetTickCount64() - start;
+    return elapsed >= timeoutMs ? 0 : static_cast<DWORD>(timeoutMs - elapsed);
+}
+
+SharedRing::~SharedRing() {
+    Close();
+}
+
+bool SharedRing::Create(const SharedRingConfig& config) {
+    Close();
+    if (config.name.empty() || config.capacity > MAX_CAPACITY) {
+        Utils::Logger::LogError("SharedRing: invalid name or capacity");
+        return false;
+    }
+
+    PSECURITY_DESCRIPTOR descriptor = nullptr;
+    if (ConvertStringSecurityDescriptorToSecurityDescriptorW(config.sddl.c_str(), SDDL_REVISION_1, &descriptor,
+                                                             nullptr) == 0) {
+        Utils::Logger::Error("SharedRing: invalid SDDL ({})", GetLastError());
+        return false;
+    }
+    SECURITY_ATTRIBUTES attributes{sizeof(attributes), descriptor, FALSE};
+
+    // Any object that exists already was created by someone else and is not trusted
+    bool squatted = false;
+    const size_t capacity = std::max(MIN_CAPACITY, std::bit_ceil(config.capacity));
+    const uint64_t sectionSize = sizeof(SharedRingHeader) + capacity;
+    HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, &attributes, PAGE_READWRITE,
+                                        static_cast<DWORD>(sectionSize >> 32), static_cast<DWORD>(sectionSize),
+                                        config.name.c_str());
+    squatted |= mapping != nullptr && GetLastError() == ERROR_ALREADY_EXISTS;
+    dataEvent_ = CreateEventW(&attributes, FALSE, FALSE, (config.name + L".Data").c_str());
+    squatted |= dataEvent_ != nullptr && GetLastError() == ERROR_ALREADY_EXISTS;
+    spaceEvent_ = CreateEventW(&attributes, FALSE, FALSE, (config.name + L".Space").c_str());
+    squatted |= spaceEvent_ != nullptr && GetLastError() == ERROR_ALREADY_EXISTS;
+    LocalFree(descriptor);
+
+    if (mapping == nullptr || dataEvent_ == nullptr || spaceEvent_ == nullptr || squatted) {
+        Utils::Logger::Error("SharedRing: cannot create section and events ({})",
+                             squatted ? "name already in use" : "creation failed");
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        Close();
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+    if (view == nullptr) {
+        Utils::Logger::Error("SharedRing: cannot map section ({})", GetLastError());
+        CloseHandle(mapping);
+        Close();
+        return false;
+    }
+    header_ = new (view) SharedRingHeader{RING_MAGIC, RING_VERSION, capacity, {0}, {0}, {0}, {0}};
+    mapping_ = mapping;
+    data_ = static_cast<uint8_t*>(view) + sizeof(SharedRingHeader);
+    capacity_ = capacity;
+    producer_ = false;
+    return true;
+}
+
+bool SharedRing::Open(const std::wstring& name) {
+    Close();
+    HANDLE mapping = OpenFileMappingW(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, name.c_str());
+    dataEvent_ = OpenEventW(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, (name + L".Data").c_str());
+    spaceEvent_ = OpenEventW(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, (name + L".Space").c_str());
+    if (mapping == nullptr || dataEvent_ == nullptr || spaceEvent_ == nullptr) {
+        Utils::Logger::Error("SharedRing: cannot open section and events ({})", GetLastError());
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        Close();
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info{};
+    if (view == nullptr || VirtualQuery(view, &info, sizeof(info)) == 0) {
+        Utils::Logger::Error("SharedRing: cannot map section ({})", GetLastError());
+        if (view != nullptr) {
+            UnmapViewOfFile(view);
+        }
+        CloseHandle(mapping);
+        Close();
+        return false;
+    }
+
+    // The header is validated against the size actually mapped before it is used
+    SharedRingHeader* header = static_cast<SharedRingHeader*>(view);
+    const uint64_t capacity = info.RegionSize >= sizeof(SharedRingHeader) ? header->capacity : 0;
+    if (header->magic != RING_MAGIC || header->version != RING_VERSION || capacity < MIN_CAPACITY ||
+        capacity > MAX_CAPACITY || !std::has_single_bit(capacity) ||
+        sizeof(SharedRingHeader) + capacity > info.RegionSize) {
+        Utils::Logger::LogError("SharedRing: section header is invalid");
+        UnmapViewOfFile(view);
+        CloseHandle(mapping);
+        Close();
+        return false;
+    }
+
+    header_ = header;
+    mapping_ = mapping;
+    data_ = static_cast<uint8_t*>(view) + sizeof(SharedRingHeader);
+    capacity_ = static_cast<size_t>(capacity);
+    producer_ = true;
+    // A reopening producer continues after the records it already committed
+    head_ = header_->head.load(std::memory_order_acquire);
+    tailCache_ = header_->tail.load(std::memory_order_acquire);
+    return true;
+}
+
+void SharedRing::Close() noexcept {
+    if (header_ != nullptr) {
+        UnmapViewOfFile(header_);
+    }
+    for (HANDLE* handle : {&mapping_, &dataEvent_, &spaceEvent_}) {
+        if (*handle != nullptr) {
+            CloseHandle(*handle);
+            *handle = nullptr;
+        }
+    }
+    header_ = nullptr;
+    data_ = nullptr;
+    capacity_ = 0;
+    producer_ = false;
+    broken_ = false;
+    head_ = tailCache_ = reserved_ = 0;
+    reservedSize_ = 0;
+    reserving_ = false;
+    fullCount_ = 0;
+    tail_ = peekEnd_ = 0;
+}
+
+size_t SharedRing::SpaceNeeded(size_t size) const noexcept {
+    const size_t offset = static_cast<size_t>(head_) & (capacity_ - 1);
+    const size_t span = RecordSpan(size);
+    return capacity_ - offset < span ? capacity_ - offset + span : span;
+}
+
+bool SharedRing::HasSpace(size_t size) noexcept {
+    const uint64_t needed = SpaceNeeded(size);
+    if (head_ + needed - tailCache_ <= capacity_) {
+        return true;
+    }
+    tailCache_ = header_->tail.load(std::memory_order_seq_cst);
+    return head_ + needed - tailCache_ <= capacity_;
+}
+
+void* SharedRing::Reserve(size_t size) noexcept {
+    if (!producer_ || header_ == nullptr || size > GetMaxRecordSize()) {
+        return nullptr;
+    }
+    if (!HasSpace(size)) {
+        ++fullCount_;
+        return nullptr;
+    }
+
+    uint64_t position = head_;
+    size_t offset = static_cast<size_t>(position) & (capacity_ - 1);
+    if (capacity_ - offset < RecordSpan(size)) {
+        // Published together with the record by Commit
+        std::memcpy(data_ + offset, &PADDING_MARKER, sizeof(PADDING_MARKER));
+        position += capacity_ - offset;
+        offset = 0;
+    }
+    reserved_ = position;
+    reservedSize_ = size;
+    reserving_ = true;
+    return data_ + offset + RECORD_HEADER_SIZE;
+}
+
+void SharedRing::Commit(size_t size) noexcept {
+    if (!reserving_) {
+        return;
+    }
+    reserving_ = false;
+    const uint32_t length = static_cast<uint32_t>(std::min(size, reservedSize_));
+    uint8_t* record = data_ + (static_cast<size_t>(reserved_) & (capacity_ - 1));
+    std::memcpy(record, &length, sizeof(length));
+    std::memset(record + sizeof(length), 0, RECORD_HEADER_SIZE - sizeof(length));
+    head_ = reserved_ + RecordSpan(length);
+
+    // Store-then-load on both sides (Dekker): either the consumer sees the new head when
+    // it re-checks, or this load sees its waiting flag
+    header_->head.store(head_, std::memory_order_seq_cst);
+    if (header_->consumerWaiting.load(std::memory_order_seq_cst) != 0 &&
+        header_->consumerWaiting.exchange(0, std::memory_order_seq_cst) != 0) {
+        SetEvent(dataEvent_);
+    }
+}
+
+bool SharedRing::WaitForSpace(size_t size, DWORD timeoutMs) noexcept {
+    if (!producer_ || header_ == nullptr || size > GetMaxRecordSize()) {
+        return false;
+    }
+    if (HasSpace(size)) {
+        return true;
+    }
+    const ULONGLONG start = GetTickCount64();
+    for (;;) {
+        // Set again on every pass: the consumer clears the flag when it signals
+        header_->producerWaiting.store(1, std::memory_order_seq_cst);
+        if (HasSpace(size)) {
+            break;
+        }
+        const DWORD remaining = RemainingMs(start, timeoutMs);
+        if (remaining == 0 || WaitForSingleObject(spaceEvent_, remaining) != WAIT_OBJECT_0) {
+            break;
+        }
+    }
+    header_->producerWaiting.store(0, std::memory_order_relaxed);
+    return HasSpace(size);
+}
+
+bool SharedRing::HasData() const noexcept {
+    return header_->head.load(std::memory_order_seq_cst) != tail_;
+}
+
+bool SharedRing::Peek(const void** data, size_t* size) noexcept {
+    if (producer_ || header_ == nullptr || broken_) {
+        return false;
+    }
+    for (;;) {
+        const uint64_t head = header_->head.load(std::memory_order_acquire);
+        const uint64_t available = head - tail_;
+        if (available == 0) {
+            return false;
+        }
+        if (available > capacity_ || available % 8 != 0) {
+            MarkBroken("head cursor out of range");
+            return false;
+        }
+
+        // The length is read once: the producer can rewrite the section at any time
+        const size_t offset = static_cast<size_t>(tail_) & (capacity_ - 1);
+        uint32_t length;
+        std::memcpy(&length, data_ + offset, sizeof(length));
+        if (length == PADDING_MARKER) {
+            if (capacity_ - offset > available) {
+                MarkBroken("padding beyond head");
+                return false;
+            }
+            tail_ += capacity_ - offset;
+            continue;
+        }
+
+        const size_t span = RecordSpan(length);
+        if (length > GetMaxRecordSize() || span > capacity_ - offset || span > available) {
+            MarkBroken("record length out of range");
+            return false;
+        }
+        *data = data_ + offset + RECORD_HEADER_SIZE;
+        *size = length;
+        peekEnd_ = tail_ + span;
+        return true;
+    }
+}
+
+void SharedRing::Release() noexcept {
+    if (producer_ || header_ == nullptr || peekEnd_ <= tail_) {
+        return;
+    }
+    tail_ = peekEnd_;
+    header_->tail.store(tail_, std::memory_order_seq_cst);
+    if (header_->producerWaiting.load(std::memory_order_seq_cst) != 0 &&
+        header_->producerWaiting.exchange(0, std::memory_order_seq_cst) != 0) {
+        SetEvent(spaceEvent_);
+    }
+}
+
+bool SharedRing::WaitForData(DWORD timeoutMs) noexcept {
+    if (producer_ || header_ == nullptr || broken_) {
+        return false;
+    }
+    if (HasData()) {
+        return true;
+    }
+    const ULONGLONG start = GetTickCount64();
+    for (;;) {
+        header_->consumerWaiting.store(1, std::memory_order_seq_cst);
+        if (HasData()) {
+            break;
+        }
+        const DWORD remaining = RemainingMs(start, timeoutMs);
+        if (remaining == 0 || WaitForSingleObject(dataEvent_, remaining) != WAIT_OBJECT_0) {
+            break;
+        }
+    }
+    header_->consumerWaiting.store(0, std::memory_order_relaxed);
+    return HasData();
+}
+
+void SharedRing::MarkBroken(const char* reason) noexcept {
+    broken_ = true;
+    Utils::Logger::Error("SharedRing: {}, ring disabled", reason);
+}
+
+} // namespace Comms
+} // namespace Sentinel
@@ -0,0 +1,229 @@
+/**
+ * @file SharedRing.hpp
+ * @brief Shared-memory SPSC ring for bulk telemetry from the Monitor to the Service.
+ *
+ * @details Every message sent through the Communication Pipe costs a kernel transition
+ * and two copies (into and out of the pipe buffer). That is the right trade for commands,
+ * but not for high-rate metrics such as handle-diff events and exception counters.
+ * SharedRing is a second transport for those: a section shared by exactly one producer
+ * (the monitored process) and one consumer (the Service), holding a ring of
+ * variable-length records.
+ * - The producer reserves space directly in the section, encodes the record in place and
+ *   commits it; the consumer reads it in place and releases it. No copy is made by the
+ *   transport and, while the ring neither runs empty nor full, no system call either.
+ * - Each cursor is written by one side only and lives on its own cache line.
+ * - Wakeups follow the futex pattern: a side that finds the ring empty (or full) sets a
+ *   "waiting" flag, re-checks, and only then sleeps; the other side signals only when
+ *   that flag is set. WaitOnAddress would be the natural primitive, but it only wakes
+ *   threads of the same process, so the sleep is on a named auto-reset event instead.
+ *
+ * The pipe remains the control channel: the Service creates the ring, sends its name to
+ * the Monitor over the pipe, and tears the ring down when the pipe session ends.
+ *
+ * Records are 8-byte aligned and never wrap: a record that does not fit before the end
+ * of the ring is preceded by a padding marker and starts at offset 0.
+ *
+ * @security The section and both events are created with the configured SDDL, and
+ * creation fails if any of them already exists, so a squatter cannot pre-create the
+ * objects. The consumer treats the producer as untrusted: cursors and record lengths read
+ * from the section are validated, and a ring that fails validation is marked broken. A
+ * record's payload stays writable by the producer while the consumer reads it, so the
+ * consumer must copy any field before validating and using it.
+ *
+ * @performance Reserve/Commit and Peek/Release are a few loads and stores; SetEvent is
+ * called only when the other side is actually asleep.
+ *
+ * @see PipeServer
+ */
+
+#pragma once
+
+#include <Windows.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Sentinel {
+namespace Comms {
+
+struct SharedRingHeader;
+
+/**
+ * @brief Configuration for SharedRing::Create.
+ */
+struct SharedRingConfig {
+    /**
+     * @brief Base name of the section; the events are named <name>.Data and <name>.Space.
+     *
+     * @details Use the Global\ prefix when the Monitor runs in another session than the
+     * Service.
+     */
+    std::wstring name;
+
+    /** @brief Data bytes; rounded up to a power of two of at least 4 KiB. */
+    size_t capacity = 1024 * 1024;
+
+    /**
+     * @brief Security descriptor of the section and events.
+     *
+     * @details The producer opens the section for read/write and the events for
+     * EVENT_MODIFY_STATE | SYNCHRONIZE, which on events requires generic write and execute.
+     * The default matches the Communication Pipe (see Module D).
+     */
+    std::wstring sddl = L"D:(A;;GA;;;SY)(A;;GA;;;BA)(A;;GRGW;;;S-1-5-32-544)";
+};
+
+/**
+ * @class SharedRing
+ * @brief One side of a cross-process single-producer, single-consumer record ring.
+ *
+ * @details The Service side calls Create and consumes; the Monitor side calls Open and
+ * produces. Producer calls on a consumer (and vice versa) fail.
+ *
+ * Usage example:
+ * @code
+ * // Monitor
+ * SharedRing ring;
+ * ring.Open(nameFromPipe);
+ * if (void* record = ring.Reserve(sizeof(HandleDiffEvent))) {
+ *     new (record) HandleDiffEvent{...};
+ *     ring.Commit(sizeof(HandleDiffEvent));
+ * }
+ *
+ * // Service
+ * const void* data;
+ * size_t size;
+ * while (ring.WaitForData(100)) {
+ *     while (ring.Peek(&data, &size)) {
+ *         Process(data, size);
+ *         ring.Release();
+ *     }
+ * }
+ * @endcode
+ *
+ * @threadsafe One thread per side. Only the producer thread may call Reserve, Commit and
+ * WaitForSpace, and only the consumer thread Peek, Release and WaitForData.
+ */
+class SharedRing {
+public:
+    SharedRing() = default;
+
+    /**
+     * @brief Unmaps the section and closes the events.
+     */
+    ~SharedRing();
+
+    SharedRing(const SharedRing&) = delete;
+    SharedRing& operator=(const SharedRing&) = delete;
+
+    /**
+     * @brief Creates the section and events and becomes the consumer.
+     *
+     * @return false (and logs) if any object exists already or cannot be created.
+     */
+    bool Create(const SharedRingConfig& config);
+
+    /**
+     * @brief Opens a ring created by the peer and becomes the producer.
+     *
+     * @return false (and logs) if the objects cannot be opened or the header is invalid.
+     */
+    bool Open(const std::wstring& name);
+
+    /**
+     * @brief Unmaps and closes everything; the ring can be created or opened again.
+     */
+    void Close() noexcept;
+
+    /**
+     * @brief Reserves space for a record of up to @p size bytes.
+     *
+     * @return Pointer into the section where the record is to be written, or nullptr if
+     *         the ring is full or @p size exceeds GetMaxRecordSize.
+     */
+    void* Reserve(size_t size) noexcept;
+
+    /**
+     * @brief Publishes the reserved record with its final @p size (at most the reserved
+     * size) and wakes the consumer if it sleeps.
+     */
+    void Commit(size_t size) noexcept;
+
+    /**
+     * @brief Waits until @p size bytes can be reserved or @p timeoutMs elapses.
+     */
+    bool WaitForSpace(size_t size, DWORD timeoutMs) noexcept;
+
+    /**
+     * @brief Returns the oldest record without removing it.
+     *
+     * @return false if the ring is empty or broken.
+     */
+    bool Peek(const void** data, size_t* size) noexcept;
+
+    /**
+     * @brief Removes the record returned by the last Peek and wakes the producer if it
+     * sleeps for space.
+     */
+    void Release() noexcept;
+
+    /**
+     * @brief Waits until a record is available or @p timeoutMs elapses.
+     */
+    bool WaitForData(DWORD timeoutMs) noexcept;
+
+    bool IsOpen() const noexcept { return header_ != nullptr; }
+
+    /** @brief True once the consumer found an invalid cursor or record length. */
+    bool IsBroken() const noexcept { return broken_; }
+
+    /** @brief Largest record Reserve accepts: a quarter of the capacity minus framing. */
+    size_t GetMaxRecordSize() const noexcept { return capacity_ / 4 - RECORD_HEADER_SIZE; }
+
+    size_t GetCapacity() const noexcept { return capacity_; }
+
+    /** @brief Producer only: Reserve calls that failed because the ring was full. */
+    uint64_t GetFullCount() const noexcept { return fullCount_; }
+
+private:
+    static constexpr size_t RECORD_HEADER_SIZE = 8;
+
+    /**
+     * @brief Bytes a record of @p size occupies, framing and alignment included.
+     */
+    static size_t RecordSpan(size_t size) noexcept { return RECORD_HEADER_SIZE + ((size + 7) & ~size_t{7}); }
+
+    /**
+     * @brief Ring bytes needed at the current head for a record of @p size, counting the
+     * padding up to the end of the ring when the record does not fit before it.
+     */
+    size_t SpaceNeeded(size_t size) const noexcept;
+
+    bool HasSpace(size_t size) noexcept;
+    bool HasData() const noexcept;
+    void MarkBroken(const char* reason) noexcept;
+
+    HANDLE mapping_ = nullptr;
+    HANDLE dataEvent_ = nullptr;
+    HANDLE spaceEvent_ = nullptr;
+    SharedRingHeader* header_ = nullptr;
+    uint8_t* data_ = nullptr;
+    size_t capacity_ = 0;
+    bool producer_ = false;
+    bool broken_ = false;
+
+    // Producer: published head, cached tail and the record being written
+    uint64_t head_ = 0;
+    uint64_t tailCache_ = 0;
+    uint64_t reserved_ = 0;
+    size_t reservedSize_ = 0;
+    bool reserving_ = false;
+    uint64_t fullCount_ = 0;
+
+    // Consumer: local tail and the end of the record returned by Peek
+    uint64_t tail_ = 0;
+    uint64_t peekEnd_ = 0;
+};
+
+} // namespace Comms
+} // namespace Sentinel
@@ -0,0 +1,209 @@
+/**
+ * @file WireFormat.hpp
+ * @brief Compact record encoding and batch frame layout of the telemetry wire protocol.
+ *
+ * @details Telemetry records are small (a handle-diff event is a few integers), so any
+ * fixed per-record framing quickly outweighs the data. Records are therefore encoded as
+ * varints, identified by a schema id, and sent in batches that are compressed and
+ * encrypted as a whole (see BatchEncoder):
+ * @code
+ * frame  := BatchFrameHeader | body[bodySize] | tag[16]
+ * body   := AES-GCM(plain, optionally XPRESS-compressed); header is the associated data
+ * plain  := { record }*
+ * record := varint schemaId | varint length | payload[length]
+ * @endcode
+ * Unsigned integers in payloads are LEB128 varints and signed integers zigzag varints, as
+ * in the binary log, so small values take one or two bytes. What a payload contains is
+ * defined by its schema id; decoders skip records with unknown ids.
+ *
+ * @security WireReader is bounds-checked throughout: it is used on data that arrived
+ * from another process and has only been authenticated, not validated.
+ *
+ * @see BatchEncoder
+ * @see BatchDecoder
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace Sentinel {
+namespace Comms {
+
+/** @brief "SBAT" in little-endian byte order. */
+inline constexpr uint32_t BATCH_FRAME_MAGIC = 0x54414253;
+
+/** @brief Current frame layout version. */
+inline constexpr uint8_t BATCH_FRAME_VERSION = 1;
+
+/** @brief BatchFrameHeader::flags: the body is XPRESS-compressed. */
+inline constexpr uint8_t BATCH_FLAG_COMPRESSED = 0x01;
+
+/** @brief Size of the AES-GCM authentication tag after the body. */
+inline constexpr size_t BATCH_TAG_SIZE = 16;
+
+/** @brief Largest encoding of a 64-bit varint. */
+inline constexpr size_t MAX_VARINT_SIZE = 10;
+
+#pragma pack(push, 1)
+/**
+ * @brief Plaintext header of one batch frame, authenticated as AES-GCM associated data.
+ *
+ * @details The 96-bit GCM nonce is salt followed by sequence. The sender picks a random
+ * salt per session and increments sequence per batch; the receiver rejects a sequence
+ * that does not increase, which also rejects replayed frames.
+ */
+struct BatchFrameHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t flags;
+    uint16_t reserved;
+    uint32_t salt;
+    uint32_t recordCount;
+
+    /** @brief Size of the plain record stream (after decompression). */
+    uint32_t plainSize;
+
+    /** @brief Size of the encrypted body. */
+    uint32_t bodySize;
+    uint64_t sequence;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(BatchFrameHeader) == 32, "BatchFrameHeader is part of the wire format");
+
+/** @brief Bytes a frame adds around its body. */
+inline constexpr size_t BATCH_FRAME_OVERHEAD = sizeof(BatchFrameHeader) + BATCH_TAG_SIZE;
+
+/**
+ * @brief Number of bytes @p value takes as a varint.
+ */
+constexpr size_t VarintSize(uint64_t value) noexcept {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+/**
+ * @class WireWriter
+ * @brief Appends varint-encoded fields to a caller-provided buffer.
+ *
+ * @details A field that does not fit sets the overflow flag and is not written; check
+ * IsValid() once after the last field.
+ *
+ * Usage example:
+ * @code
+ * uint8_t payload[64];
+ * WireWriter writer(payload, sizeof(payload));
+ * writer.PutUnsigned(handleValue);
+ * writer.PutSigned(countDelta);
+ * if (writer.IsValid()) {
+ *     encoder.Append(SCHEMA_HANDLE_DIFF, payload, writer.GetSize());
+ * }
+ * @endcode
+ */
+class WireWriter {
+public:
+    WireWriter(uint8_t* buffer, size_t capacity) noexcept : buffer_(buffer), capacity_(capacity) {}
+
+    void PutUnsigned(uint64_t value) noexcept {
+        if (capacity_ - size_ < VarintSize(value)) {
+            overflow_ = true;
+            return;
+        }
+        while (value >= 0x80) {
+            buffer_[size_++] = static_cast<uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+        buffer_[size_++] = static_cast<uint8_t>(value);
+    }
+
+    void PutSigned(int64_t value) noexcept {
+        PutUnsigned((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    /** @brief Length-prefixed byte string. */
+    void PutBytes(const void* data, size_t size) noexcept {
+        if (capacity_ - size_ < VarintSize(size) + size) {
+            overflow_ = true;
+            return;
+        }
+        PutUnsigned(size);
+        std::memcpy(buffer_ + size_, data, size);
+        size_ += size;
+    }
+
+    void PutString(std::string_view value) noexcept { PutBytes(value.data(), value.size()); }
+
+    bool IsValid() const noexcept { return !overflow_; }
+    size_t GetSize() const noexcept { return size_; }
+
+private:
+    uint8_t* buffer_;
+    size_t capacity_;
+    size_t size_ = 0;
+    bool overflow_ = false;
+};
+
+/**
+ * @class WireReader
+ * @brief Bounds-checked reader for fields written by WireWriter.
+ *
+ * @details Reading past the end, or a varint longer than ten bytes, sets the failure flag
+ * and returns zero / empty; check IsValid() once after the last field.
+ */
+class WireReader {
+public:
+    WireReader(const uint8_t* data, size_t size) noexcept : data_(data), size_(size) {}
+
+    uint64_t GetUnsigned() noexcept {
+        uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64 && offset_ < size_; shift += 7) {
+            const uint8_t byte = data_[offset_++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        failed_ = true;
+        return 0;
+    }
+
+    int64_t GetSigned() noexcept {
+        const uint64_t value = GetUnsigned();
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    /**
+     * @brief Reads a length-prefixed byte string; the view points into the input.
+     */
+    std::string_view GetBytes() noexcept {
+        const uint64_t length = GetUnsigned();
+        if (failed_ || length > size_ - offset_) {
+            failed_ = true;
+            return {};
+        }
+        const std::string_view bytes(reinterpret_cast<const char*>(data_ + offset_), static_cast<size_t>(length));
+        offset_ += static_cast<size_t>(length);
+        return bytes;
+    }
+
+    bool IsValid() const noexcept { return !failed_; }
+    bool IsAtEnd() const noexcept { return offset_ == size_; }
+    size_t GetOffset() const noexcept { return offset_; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t offset_ = 0;
+    bool failed_ = false;
+};
+
+} // namespace Comms
+} // namespace Sentinel
@@ -0,0 +1,181 @@
+/**
+ * @file HandleFilter.cpp
+ * @brief Implementation of the scalar and AVX2 handle filter kernels.
+ */
+
+#include "Sentinel/Internals/HandleFilter.hpp"
+#include <bit>
+#include <cstddef>
+
+#if defined(_M_X64)
+#include <intrin.h>
+#include <immintrin.h>
+#define SENTINEL_HANDLE_FILTER_AVX2 1
+#endif
+
+// MSVC emits AVX2 intrinsics in any function; clang and GCC need the target enabled per function
+#if defined(SENTINEL_HANDLE_FILTER_AVX2) && (defined(__clang__) || defined(__GNUC__))
+#define SENTINEL_TARGET_AVX2 __attribute__((target("avx2")))
+#define SENTINEL_TARGET_XSAVE __attribute__((target("xsave")))
+#else
+#define SENTINEL_TARGET_AVX2
+#define SENTINEL_TARGET_XSAVE
+#endif
+
+namespace Sentinel {
+namespace Internals {
+
+// Appends a match, counting the ones that do not fit
+static inline void RecordMatch(size_t index, uint32_t* matches, size_t capacity, size_t& found) noexcept {
+    if (found < capacity) {
+        matches[found] = static_cast<uint32_t>(index);
+    }
+    ++found;
+}
+
+static inline bool IsExcluded(const HandleTableEntry& entry, const HandleFilterQuery& query) noexcept {
+    return query.excludedProcessId != 0 && entry.uniqueProcessId == query.excludedProcessId;
+}
+
+// Scalar loop over [begin, count); shared by FindScalar and the AVX2 tail
+static size_t ScanScalar(const HandleTableEntry* entries, size_t begin, size_t count, const HandleFilterQuery& query,
+                         uint32_t* matches, size_t capacity, size_t found) noexcept {
+    const void* target = query.object;
+    const ULONG accessMask = query.accessMask;
+    for (size_t i = begin; i < count; ++i) {
+        const HandleTableEntry& entry = entries[i];
+        if (entry.object != target) {
+            continue;
+        }
+        if (accessMask != 0 && (entry.grantedAccess & accessMask) == 0) {
+            continue;
+        }
+        if (IsExcluded(entry, query)) {
+            continue;
+        }
+        RecordMatch(i, matches, capacity, found);
+    }
+    return found;
+}
+
+size_t HandleFilter::FindScalar(const HandleTableEntry* entries, size_t count, const HandleFilterQuery& query,
+                                uint32_t* matches, size_t capacity) noexcept {
+    if (entries == nullptr) {
+        return 0;
+    }
+    return ScanScalar(entries, 0, count, query, matches, capacity, 0);
+}
+
+#if defined(SENTINEL_HANDLE_FILTER_AVX2)
+
+// The gather indices below encode the entry layout: 40-byte stride, object at offset 0,
+// grantedAccess at offset 24
+static_assert(sizeof(HandleTableEntry) == 5 * sizeof(long long), "AVX2 kernel assumes a 40-byte entry");
+static_assert(offsetof(HandleTableEntry, object) == 0, "AVX2 kernel assumes object at offset 0");
+static_assert(offsetof(HandleTableEntry, grantedAccess) == 6 * sizeof(int), "AVX2 kernel assumes grantedAccess at offset 24");
+
+static constexpr size_t QWORDS_PER_ENTRY = sizeof(HandleTableEntry) / sizeof(long long);
+
+SENTINEL_TARGET_AVX2
+static size_t ScanAvx2(const HandleTableEntry* entries, size_t count, const HandleFilterQuery& query,
+                       uint32_t* matches, size_t capacity) noexcept {
+    const long long* base = reinterpret_cast<const long long*>(entries);
+    const __m256i objectIndex = _mm256_setr_epi64x(0, 5, 10, 15);
+    const __m256i accessIndex = _mm256_setr_epi32(6, 16, 26, 36, 46, 56, 66, 76);
+    const __m256i target = _mm256_set1_epi64x(static_cast<long long>(reinterpret_cast<uintptr_t>(query.object)));
+    const __m256i accessMask = _mm256_set1_epi32(static_cast<int>(query.accessMask));
+    const __m256i zero = _mm256_setzero_si256();
+
+    size_t found = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const long long* group = base + i * QWORDS_PER_ENTRY;
+        const __m256i low = _mm256_i64gather_epi64(group, objectIndex, 8);
+        const __m256i high = _mm256_i64gather_epi64(group + 4 * QWORDS_PER_ENTRY, objectIndex, 8);
+        unsigned hits = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(low, target)))) |
+                        (static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(high, target)))) << 4);
+        if (hits == 0) {
+            continue;
+        }
+
+        // Matches are rare; only groups containing one pay for the access mask gather
+        if (query.accessMask != 0) {
+            const __m256i access = _mm256_i32gather_epi32(reinterpret_cast<const int*>(group), accessIndex, 4);
+            const __m256i denied = _mm256_cmpeq_epi32(_mm256_and_si256(access, accessMask), zero);
+            hits &= ~static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(denied))) & 0xFFu;
+        }
+        while (hits != 0) {
+            const size_t index = i + static_cast<size_t>(std::countr_zero(hits));
+            hits &= hits - 1;
+            if (!IsExcluded(entries[index], query)) {
+                RecordMatch(index, matches, capacity, found);
+            }
+        }
+    }
+    return ScanScalar(entries, i, count, query, matches, capacity, found);
+}
+
+SENTINEL_TARGET_XSAVE
+static bool DetectAvx2() noexcept {
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    // AVX must be present and the OS must have enabled XSAVE of XMM and YMM state
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+}
+
+#endif // SENTINEL_HANDLE_FILTER_AVX2
+
+size_t HandleFilter::FindAvx2(const HandleTableEntry* entries, size_t count, const HandleFilterQuery& query,
+                              uint32_t* matches, size_t capacity) noexcept {
+    if (entries == nullptr) {
+        return 0;
+    }
+#if defined(SENTINEL_HANDLE_FILTER_AVX2)
+    return ScanAvx2(entries, count, query, matches, capacity);
+#else
+    return ScanScalar(entries, 0, count, query, matches, capacity, 0);
+#endif
+}
+
+bool HandleFilter::IsAvx2Supported() noexcept {
+#if defined(SENTINEL_HANDLE_FILTER_AVX2)
+    static const bool supported = DetectAvx2();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+size_t HandleFilter::Find(const HandleTableEntry* entries, size_t count, const HandleFilterQuery& query,
+                          uint32_t* matches, size_t capacity) noexcept {
+    return IsAvx2Supported() ? FindAvx2(entries, count, query, matches, capacity)
+                             : FindScalar(entries, count, query, matches, capacity);
+}
+
+const HandleTableEntry* HandleFilter::FindHandle(const HandleTableEntry* entries, size_t count,
+                                                 ULONG_PTR processId, ULONG_PTR handleValue) noexcept {
+    if (entries == nullptr) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (entries[i].uniqueProcessId == processId && entries[i].handleValue == handleValue) {
+            return &entries[i];
+        }
+    }
+    return nullptr;
+}
+
+} // namespace Internals
+} // namespace Sentinel
@@ -0,0 +1,133 @@
+/**
+ * @file HandleIndex.cpp
+ * @brief Implementation of the incremental handle table index.
+ */
+
+#include "Sentinel/Internals/HandleIndex.hpp"
+#include <algorithm>
+
+namespace Sentinel {
+namespace Internals {
+
+// SplitMix64 finalizer: spreads handle values (multiples of 4) and object addresses
+// (16-byte aligned) over the whole slot range
+static constexpr uint64_t MixHash(uint64_t value) noexcept {
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ull;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBull;
+    value ^= value >> 31;
+    return value;
+}
+
+static uint64_t HashKey(uint64_t object, uint32_t ownerProcessId, uint32_t handleValue) noexcept {
+    return MixHash(object ^ MixHash((static_cast<uint64_t>(ownerProcessId) << 32) | handleValue));
+}
+
+void HandleIndex::Clear() {
+    std::fill(slots_.begin(), slots_.end(), Slot{});
+    liveCount_ = 0;
+    tombstoneCount_ = 0;
+}
+
+void HandleIndex::Prepare(size_t count) {
+    // Generations only have to differ between consecutive passes: after a pass, every live
+    // slot carries the current one
+    if (++generation_ == GENERATION_TOMBSTONE) {
+        generation_ = 1;
+    }
+
+    size_t slotCount = slots_.empty() ? INITIAL_SLOT_COUNT : slots_.size();
+    while (slotCount < count * 2) {
+        slotCount *= 2;
+    }
+    if (slotCount != slots_.size() || tombstoneCount_ * 8 > slotCount) {
+        Rehash(slotCount);
+    }
+}
+
+HandleIndex::Slot& HandleIndex::FindOrInsert(const HandleTableEntry& entry, bool& inserted) {
+    if ((liveCount_ + tombstoneCount_ + 1) * 4 > slots_.size() * 3) {
+        Rehash(slots_.size() * 2);
+    }
+
+    // PIDs are DWORDs and handle values stay far below 2^32; the truncation is lossless
+    const uint64_t object = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(entry.object));
+    const uint32_t ownerProcessId = static_cast<uint32_t>(entry.uniqueProcessId);
+    const uint32_t handleValue = static_cast<uint32_t>(entry.handleValue);
+
+    const size_t mask = slots_.size() - 1;
+    size_t index = static_cast<size_t>(HashKey(object, ownerProcessId, handleValue)) & mask;
+    Slot* reusable = nullptr;
+    for (;;) {
+        Slot& slot = slots_[index];
+        if (slot.generation == GENERATION_EMPTY) {
+            break;
+        }
+        if (slot.generation == GENERATION_TOMBSTONE) {
+            if (reusable == nullptr) {
+                reusable = &slot;
+            }
+        } else if (slot.object == object && slot.ownerProcessId == ownerProcessId &&
+                   slot.handleValue == handleValue) {
+            slot.generation = generation_;
+            inserted = false;
+            return slot;
+        }
+        index = (index + 1) & mask;
+    }
+
+    Slot& slot = reusable != nullptr ? *reusable : slots_[index];
+    if (reusable != nullptr) {
+        --tombstoneCount_;
+    }
+    slot.object = object;
+    slot.ownerProcessId = ownerProcessId;
+    slot.handleValue = handleValue;
+    slot.generation = generation_;
+    ++liveCount_;
+    inserted = true;
+    return slot;
+}
+
+HandleIndex::Slot* HandleIndex::Find(const HandleTableEntry& entry) noexcept {
+    const uint64_t object = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(entry.object));
+    const uint32_t ownerProcessId = static_cast<uint32_t>(entry.uniqueProcessId);
+    const uint32_t handleValue = static_cast<uint32_t>(entry.handleValue);
+
+    const size_t mask = slots_.size() - 1;
+    size_t index = static_cast<size_t>(HashKey(object, ownerProcessId, handleValue)) & mask;
+    for (;;) {
+        Slot& slot = slots_[index];
+        if (slot.generation == GENERATION_EMPTY) {
+            return nullptr;
+        }
+        if (slot.generation != GENERATION_TOMBSTONE && slot.object == object &&
+            slot.ownerProcessId == ownerProcessId && slot.handleValue == handleValue) {
+            return &slot;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+void HandleIndex::Rehash(size_t slotCount) {
+    // assign() keeps the spare's storage when the size is unchanged, so tombstone cleanup
+    // never allocates; only growth does
+    spare_.assign(slotCount, Slot{});
+    const size_t mask = slotCount - 1;
+    for (const Slot& slot : slots_) {
+        if (slot.generation == GENERATION_EMPTY || slot.generation == GENERATION_TOMBSTONE) {
+            continue;
+        }
+        size_t index = static_cast<size_t>(HashKey(slot.object, slot.ownerProcessId, slot.handleValue)) & mask;
+        while (spare_[index].generation != GENERATION_EMPTY) {
+            index = (index + 1) & mask;
+        }
+        spare_[index] = slot;
+    }
+    slots_.swap(spare_);
+    tombstoneCount_ = 0;
+}
+
+} // namespace Internals
+} // namespace Sentinel
@@ -0,0 +1,300 @@
+/**
+ * @file HandleIndex.hpp
+ * @brief Incremental diffing of handle table snapshots.
+ *
+ * @details This module exists because between two audit passes almost every handle in the
+ * system is unchanged, yet classifying a snapshot from scratch costs a classification per
+ * handle - half a million per pass on a busy host. That limits auditing to roughly once a
+ * minute.
+ *
+ * HandleIndex remembers the previous snapshot as a compact open-addressing hash table keyed
+ * by (owner process id, handle value, object address), with the granted access mask and
+ * the classification result stored alongside. Each new snapshot is compared against it:
+ * - A key that is not in the index is classified and reported as Opened.
+ * - A key whose granted access changed is reclassified and reported as RightsChanged.
+ * - An unchanged key costs one hash probe and no classification.
+ * - Keys not seen during the pass are reported as Closed and removed.
+ *
+ * A handle value reused for a different object has a different key, so it is reported as
+ * one Closed and one Opened event rather than being mistaken for the old handle.
+ *
+ * Classification of the changed keys can be spread over a Utils::ThreadPool; results are
+ * merged by position, so the events are identical to a sequential pass.
+ *
+ * Seen keys are marked with a per-pass generation number instead of a separate bitmap, so
+ * the Closed sweep is a single linear pass over the slot array. Removed keys leave
+ * tombstones; the table is rehashed into a retained spare array when tombstones build up,
+ * which keeps steady-state passes free of allocations.
+ *
+ * @security Object addresses are kernel addresses. They are kept to tell handles apart and
+ * to allow sanitization, and are never logged.
+ *
+ * @performance One hash probe per snapshot entry plus one O(slot count) sweep per pass.
+ * Slots are 32 bytes and the table is sized to stay at most half full, so 500,000 handles
+ * take 32 MB, plus a spare array of the same size that rehashing reuses.
+ *
+ * @see ResourceAuditor
+ */
+
+#pragma once
+
+#include "Sentinel/Internals/HandleTable.hpp"
+#include "Sentinel/Utils/ThreadPool.hpp"
+#include <Windows.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Sentinel {
+namespace Internals {
+
+/**
+ * @brief Outcome of classifying one handle.
+ */
+enum class HandleVerdict : uint8_t {
+    /** @brief Expected handle (own process, system process, allow-listed owner). */
+    Authorized = 0,
+
+    /** @brief Not explained by policy, but without dangerous rights. */
+    Suspicious = 1,
+
+    /** @brief Grants rights that enable injection or handle theft. */
+    Unauthorized = 2
+};
+
+/** @brief Risk flag: the handle grants PROCESS_VM_WRITE. */
+inline constexpr uint8_t HANDLE_RISK_VM_WRITE = 0x01;
+
+/** @brief Risk flag: the handle grants PROCESS_CREATE_THREAD. */
+inline constexpr uint8_t HANDLE_RISK_CREATE_THREAD = 0x02;
+
+/** @brief Risk flag: the handle grants PROCESS_DUP_HANDLE. */
+inline constexpr uint8_t HANDLE_RISK_DUP_HANDLE = 0x04;
+
+/**
+ * @brief Classification result cached per handle.
+ */
+struct HandleClassification {
+    HandleVerdict verdict;
+
+    /** @brief HANDLE_RISK_* flags explaining the verdict. */
+    uint8_t riskFlags;
+};
+
+/**
+ * @brief Kind of change reported by HandleIndex::Update.
+ */
+enum class HandleEventKind : uint8_t {
+    Opened = 0,
+    Closed = 1,
+    RightsChanged = 2
+};
+
+/**
+ * @brief One change between two consecutive snapshots.
+ */
+struct HandleEvent {
+    HandleEventKind kind;
+
+    /** @brief Id of the process that owns the handle. */
+    uint32_t ownerProcessId;
+
+    /** @brief Handle value inside the owning process. */
+    uint32_t handleValue;
+
+    /** @brief Current access mask (for Closed: the last known mask). */
+    uint32_t grantedAccess;
+
+    /** @brief Access mask before the change; equal to grantedAccess except for RightsChanged. */
+    uint32_t previousAccess;
+
+    /** @brief Object type index from the snapshot. */
+    uint16_t objectTypeIndex;
+
+    /** @brief Classification of the handle (for Closed: the cached one). */
+    HandleClassification classification;
+
+    /** @brief Kernel object address. Used for sanitization only; never log it. */
+    const void* object;
+};
+
+/**
+ * @class HandleIndex
+ * @brief Open-addressing index of the previous snapshot with per-pass generation marks.
+ *
+ * Usage example:
+ * @code
+ * HandleIndex index;
+ * index.Update(auditor.GetEntries(), auditor.GetEntryCount(),
+ *     [](const HandleTableEntry& entry) { return Classify(entry); },
+ *     [](const HandleEvent& event) { Report(event); });
+ * @endcode
+ *
+ * @threadsafe Not thread-safe.
+ */
+class HandleIndex {
+public:
+    /** @brief Slot count of the first table. Power of two. */
+    static constexpr size_t INITIAL_SLOT_COUNT = 1u << 16;
+
+    HandleIndex() = default;
+
+    HandleIndex(const HandleIndex&) = delete;
+    HandleIndex& operator=(const HandleIndex&) = delete;
+
+    /** @brief Changed handles per classification chunk when a thread pool is used. */
+    static constexpr size_t CLASSIFY_GRAIN = 256;
+
+    /**
+     * @brief Diffs @p entries against the index and brings the index up to date.
+     *
+     * @details Runs in three stages. The diff itself is sequential and only records which
+     * entries changed. Those entries are then classified, in chunks of CLASSIFY_GRAIN
+     * across @p pool when one is given. Finally the results are stored and the events
+     * emitted sequentially, so event order never depends on scheduling: Opened and
+     * RightsChanged in snapshot order, then Closed in index order. The first call reports
+     * every entry as Opened.
+     *
+     * @param entries Snapshot taken by ResourceAuditor.
+     * @param count Number of entries.
+     * @param classify Callable invoked as HandleClassification(const HandleTableEntry&),
+     *        only for opened and rights-changed handles. Must be thread-safe when @p pool
+     *        is not null.
+     * @param sink Callable invoked as sink(const HandleEvent&) for every change, always on
+     *        the calling thread.
+     * @param pool Pool for the classification stage, or nullptr to classify inline.
+     * @return Number of events reported.
+     */
+    template <typename Classifier, typename Sink>
+    size_t Update(const HandleTableEntry* entries, size_t count, Classifier&& classify, Sink&& sink,
+                  Utils::ThreadPool* pool = nullptr) {
+        Prepare(count);
+
+        changes_.clear();
+        for (size_t i = 0; i < count; ++i) {
+            const HandleTableEntry& entry = entries[i];
+            bool inserted = false;
+            Slot& slot = FindOrInsert(entry, inserted);
+            if (inserted) {
+                slot.grantedAccess = entry.grantedAccess;
+                slot.objectTypeIndex = entry.objectTypeIndex;
+                changes_.push_back(Change{i, HandleEventKind::Opened, entry.grantedAccess});
+            } else if (slot.grantedAccess != entry.grantedAccess) {
+                changes_.push_back(Change{i, HandleEventKind::RightsChanged, slot.grantedAccess});
+                slot.grantedAccess = entry.grantedAccess;
+            }
+        }
+
+        // Results are written by change index, so the merge below is order-independent
+        classifications_.resize(changes_.size());
+        auto classifyRange = [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                classifications_[k] = classify(entries[changes_[k].entryIndex]);
+            }
+        };
+        if (pool != nullptr && changes_.size() > CLASSIFY_GRAIN) {
+            pool->ParallelFor(changes_.size(), CLASSIFY_GRAIN, classifyRange);
+        } else {
+            classifyRange(0, changes_.size());
+        }
+
+        // The table no longer changes shape, so each changed key is found with one probe
+        size_t events = 0;
+        for (size_t k = 0; k < changes_.size(); ++k) {
+            Slot& slot = *Find(entries[changes_[k].entryIndex]);
+            slot.classification = classifications_[k];
+            sink(MakeEvent(slot, changes_[k].kind, changes_[k].previousAccess));
+            ++events;
+        }
+
+        // Everything not stamped with this pass's generation has been closed
+        for (Slot& slot : slots_) {
+            if (slot.generation != GENERATION_EMPTY && slot.generation != GENERATION_TOMBSTONE &&
+                slot.generation != generation_) {
+                sink(MakeEvent(slot, HandleEventKind::Closed, slot.grantedAccess));
+                ++events;
+                slot.generation = GENERATION_TOMBSTONE;
+                --liveCount_;
+                ++tombstoneCount_;
+            }
+        }
+        return events;
+    }
+
+    /** @brief Number of handles currently indexed. */
+    size_t GetSize() const noexcept { return liveCount_; }
+
+    /** @brief Number of slots in the table. */
+    size_t GetSlotCount() const noexcept { return slots_.size(); }
+
+    /** @brief Forgets every handle; the next Update reports all entries as Opened. */
+    void Clear();
+
+private:
+    static constexpr uint32_t GENERATION_EMPTY = 0;
+    static constexpr uint32_t GENERATION_TOMBSTONE = 0xFFFFFFFFu;
+
+    struct Slot {
+        uint64_t object;
+        uint32_t ownerProcessId;
+        uint32_t handleValue;
+        uint32_t grantedAccess;
+        uint32_t generation;
+        uint16_t objectTypeIndex;
+        HandleClassification classification;
+    };
+
+    /**
+     * @brief Starts a pass: advances the generation and sizes the table for @p count entries.
+     */
+    void Prepare(size_t count);
+
+    /**
+     * @brief Finds the slot for @p entry's key, claiming a free one if it is not indexed.
+     *
+     * @details Stamps the slot with the current generation. Grows the table first if an
+     * insertion would push the load factor above 3/4; generation marks survive the rehash.
+     *
+     * @param inserted Set to true if the key was not indexed.
+     */
+    Slot& FindOrInsert(const HandleTableEntry& entry, bool& inserted);
+
+    /**
+     * @brief Returns the slot holding @p entry's key, or nullptr if it is not indexed.
+     */
+    Slot* Find(const HandleTableEntry& entry) noexcept;
+
+    /**
+     * @brief Moves every live slot into a table of @p slotCount slots.
+     */
+    void Rehash(size_t slotCount);
+
+    static HandleEvent MakeEvent(const Slot& slot, HandleEventKind kind, uint32_t previousAccess) noexcept {
+        return HandleEvent{kind, slot.ownerProcessId, slot.handleValue, slot.grantedAccess, previousAccess,
+                           slot.objectTypeIndex, slot.classification,
+                           reinterpret_cast<const void*>(static_cast<uintptr_t>(slot.object))};
+    }
+
+    /**
+     * @brief Entry that needs classification in the current pass.
+     */
+    struct Change {
+        size_t entryIndex;
+        HandleEventKind kind;
+        uint32_t previousAccess;
+    };
+
+    std::vector<Slot> slots_;
+    std::vector<Slot> spare_;
+
+    // Per-pass scratch, kept to avoid reallocating on every pass
+    std::vector<Change> changes_;
+    std::vector<HandleClassification> classifications_;
+
+    size_t liveCount_ = 0;
+    size_t tombstoneCount_ = 0;
+    uint32_t generation_ = GENERATION_EMPTY;
+};
+
+} // namespace Internals
+} // namespace Sentinel
@@ -0,0 +1,64 @@
+/**
+ * @file HandleTable.hpp
+ * @brief Native layout of the SystemExtendedHandleInformation result.
+ *
+ * @details These structures mirror SYSTEM_HANDLE_INFORMATION_EX and
+ * SYSTEM_HANDLE_TABLE_ENTRY_INFO_EX, which the Windows SDK does not declare. They are shared
+ * by ResourceAuditor, which fills them, and HandleIndex, which diffs them.
+ *
+ * @see ResourceAuditor
+ */
+
+#pragma once
+
+#include <Windows.h>
+
+namespace Sentinel {
+namespace Internals {
+
+/**
+ * @brief One entry of the system handle table (SYSTEM_HANDLE_TABLE_ENTRY_INFO_EX).
+ *
+ * @details Layout is fixed by the kernel: 40 bytes on x64.
+ */
+struct HandleTableEntry {
+    /** @brief Kernel address of the object the handle refers to. */
+    PVOID object;
+
+    /** @brief Id of the process that owns the handle. */
+    ULONG_PTR uniqueProcessId;
+
+    /** @brief Handle value inside the owning process. */
+    ULONG_PTR handleValue;
+
+    /** @brief Access mask granted when the handle was opened or duplicated. */
+    ULONG grantedAccess;
+
+    /** @brief Creator stack trace index (only with object tracing enabled). */
+    USHORT creatorBackTraceIndex;
+
+    /** @brief Index of the object type (Process, Thread, File, ...). */
+    USHORT objectTypeIndex;
+
+    /** @brief OBJ_* handle attributes (inherit, protect from close). */
+    ULONG handleAttributes;
+
+    ULONG reserved;
+};
+
+#if defined(_M_X64)
+static_assert(sizeof(HandleTableEntry) == 40, "HandleTableEntry must match SYSTEM_HANDLE_TABLE_ENTRY_INFO_EX");
+#endif
+
+/**
+ * @brief Header of the block returned for SystemExtendedHandleInformation.
+ */
+struct HandleTableHeader {
+    /** @brief Number of entries that follow the header. */
+    ULONG_PTR numberOfHandles;
+
+    ULONG_PTR reserved;
+};
+
+} // namespace Internals
+} // namespace Sentinel
@@ -0,0 +1,355 @@
+/**
+ * @file MultiProcessCollector.cpp
+ * @brief Implementation of the shared-snapshot multi-target collector.
+ */
+
+#include "Sentinel/Internals/MultiProcessCollector.hpp"
+#include "Sentinel/Internals/HandleFilter.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+#include <algorithm>
+#include <system_error>
+
+namespace Sentinel {
+namespace Internals {
+
+Utils::Histogram MultiProcessCollector::tickTime_;
+const Utils::MetricRegistration MultiProcessCollector::tickTimeMetric_("collector.tick_ns", tickTime_);
+Utils::Gauge MultiProcessCollector::targetCount_;
+const Utils::MetricRegistration MultiProcessCollector::targetCountMetric_("collector.targets", targetCount_);
+
+static bool KeyLess(uint32_t owner, uint32_t handle, uint32_t otherOwner, uint32_t otherHandle) noexcept {
+    return owner != otherOwner ? owner < otherOwner : handle < otherHandle;
+}
+
+static size_t HashObject(const void* object, size_t mask) noexcept {
+    // Objects are pool allocations, so the low bits carry no information
+    const uint64_t key = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(object)) >> 4;
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+
+MultiProcessCollector::~MultiProcessCollector() {
+    Stop();
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!targets_.empty()) {
+        Remove(targets_.size() - 1);
+    }
+}
+
+bool MultiProcessCollector::Initialize() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return auditor_.Initialize();
+}
+
+size_t MultiProcessCollector::Find(DWORD processId) const noexcept {
+    for (size_t i = 0; i < targets_.size(); ++i) {
+        if (targets_[i]->processId == processId) {
+            return i;
+        }
+    }
+    return SIZE_MAX;
+}
+
+bool MultiProcessCollector::Watch(DWORD processId, const TargetPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (Find(processId) != SIZE_MAX || targets_.size() >= MAX_TARGETS) {
+        Utils::Logger::Error("MultiProcessCollector: cannot watch {} (already watched or {} targets)", processId,
+                             MAX_TARGETS);
+        return false;
+    }
+    HANDLE process = OpenProcess(policy.processAccess | SYNCHRONIZE, FALSE, processId);
+    if (process == nullptr) {
+        Utils::Logger::Error("MultiProcessCollector: cannot open process {} ({})", processId, GetLastError());
+        return false;
+    }
+    auto target = std::make_unique<Target>();
+    target->processId = processId;
+    target->process = process;
+    target->policy = policy;
+    targets_.push_back(std::move(target));
+    targetCount_.Set(static_cast<int64_t>(targets_.size()));
+    return true;
+}
+
+void MultiProcessCollector::Remove(size_t index) {
+    Target& target = *targets_[index];
+    for (const uint64_t job : target.jobs) {
+        scheduler_.Remove(job);
+    }
+    CloseHandle(target.process);
+    targets_.erase(targets_.begin() + static_cast<ptrdiff_t>(index));
+    objectsDirty_ = true;
+    targetCount_.Set(static_cast<int64_t>(targets_.size()));
+}
+
+bool MultiProcessCollector::Unwatch(DWORD processId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t index = Find(processId);
+    if (index == SIZE_MAX) {
+        return false;
+    }
+    Remove(index);
+    return true;
+}
+
+bool MultiProcessCollector::ScheduleWork(DWORD processId, uint32_t intervalTicks, TargetWork work, uint32_t cost) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t index = Find(processId);
+    if (index == SIZE_MAX || !work) {
+        Utils::Logger::Error("MultiProcessCollector: cannot schedule work for unwatched process {}", processId);
+        return false;
+    }
+    // Targets are heap-allocated, so the pointer stays valid until Remove cancels the job
+    Target* target = targets_[index].get();
+    const uint64_t job = scheduler_.Add(
+        intervalTicks, [target, work = std::move(work)]() { work(target->processId, target->process); }, cost);
+    if (job == Utils::TickScheduler::INVALID_JOB) {
+        return false;
+    }
+    target->jobs.push_back(job);
+    return true;
+}
+
+void MultiProcessCollector::DropExitedTargets(const EventSink& sink) {
+    for (size_t i = targets_.size(); i-- > 0;) {
+        Target& target = *targets_[i];
+        if (WaitForSingleObject(target.process, 0) != WAIT_OBJECT_0) {
+            continue;
+        }
+        for (const HeldHandle& handle : target.held) {
+            sink(TargetHandleEvent{target.processId,
+                                   HandleEvent{HandleEventKind::Closed, handle.ownerProcessId, handle.handleValue,
+                                               handle.grantedAccess, handle.grantedAccess, handle.objectTypeIndex,
+                                               handle.classification, target.object}});
+        }
+        Utils::Logger::Info("MultiProcessCollector: target {} exited", target.processId);
+        Remove(i);
+    }
+}
+
+void MultiProcessCollector::BuildObjectTable() {
+    size_t resolved = 0;
+    for (const auto& target : targets_) {
+        if (target->object != nullptr) {
+            ++resolved;
+        }
+    }
+    // At most half full, so probes stay short
+    size_t slotCount = 16;
+    while (slotCount < resolved * 2) {
+        slotCount *= 2;
+    }
+    objects_.assign(slotCount, ObjectSlot{nullptr, 0});
+    const size_t mask = slotCount - 1;
+    for (size_t i = 0; i < targets_.size(); ++i) {
+        const void* object = targets_[i]->object;
+        if (object == nullptr) {
+            continue;
+        }
+        size_t slot = HashObject(object, mask);
+        while (objects_[slot].object != nullptr) {
+            slot = (slot + 1) & mask;
+        }
+        objects_[slot] = ObjectSlot{object, static_cast<uint32_t>(i)};
+    }
+    objectsDirty_ = false;
+}
+
+bool MultiProcessCollector::IsHeld(const Target& target, uint32_t ownerProcessId, uint32_t handleValue) noexcept {
+    const auto found = std::lower_bound(target.held.begin(), target.held.end(), ownerProcessId,
+                                        [handleValue](const HeldHandle& held, uint32_t owner) {
+                                            return KeyLess(held.ownerProcessId, held.handleValue, owner, handleValue);
+                                        });
+    return found != target.held.end() && found->ownerProcessId == ownerProcessId && found->handleValue == handleValue;
+}
+
+HandleClassification MultiProcessCollector::Classify(const Target& target, uint32_t ownerProcessId,
+                                                     uint32_t grantedAccess) {
+    uint8_t riskFlags = 0;
+    if ((grantedAccess & PROCESS_VM_WRITE) != 0) {
+        riskFlags |= HANDLE_RISK_VM_WRITE;
+    }
+    if ((grantedAccess & PROCESS_CREATE_THREAD) != 0) {
+        riskFlags |= HANDLE_RISK_CREATE_THREAD;
+    }
+    if ((grantedAccess & PROCESS_DUP_HANDLE) != 0) {
+        riskFlags |= HANDLE_RISK_DUP_HANDLE;
+    }
+
+    // Kept only because it used to grant watched rights; nothing of interest remains
+    if ((grantedAccess & target.policy.watchedAccess) == 0) {
+        return HandleClassification{HandleVerdict::Authorized, riskFlags};
+    }
+
+    const std::vector<DWORD>& allowed = target.policy.allowedOwners;
+    if (std::find(allowed.begin(), allowed.end(), ownerProcessId) != allowed.end()) {
+        return HandleClassification{HandleVerdict::Authorized, riskFlags};
+    }
+    if (target.policy.trustSignedOwners &&
+        auditor_.GetProcessCache().Lookup(ownerProcessId)->trust == ProcessTrust::Trusted) {
+        return HandleClassification{HandleVerdict::Authorized, riskFlags};
+    }
+    return HandleClassification{riskFlags != 0 ? HandleVerdict::Unauthorized : HandleVerdict::Suspicious, riskFlags};
+}
+
+void MultiProcessCollector::Diff(Target& target, const EventSink& sink) {
+    std::vector<HeldHandle>& current = target.current;
+    std::sort(current.begin(), current.end(), [](const HeldHandle& a, const HeldHandle& b) {
+        return KeyLess(a.ownerProcessId, a.handleValue, b.ownerProcessId, b.handleValue);
+    });
+
+    auto report = [&](HandleEventKind kind, const HeldHandle& handle, uint32_t previousAccess) {
+        sink(TargetHandleEvent{target.processId,
+                               HandleEvent{kind, handle.ownerProcessId, handle.handleValue, handle.grantedAccess,
+                                           previousAccess, handle.objectTypeIndex, handle.classification,
+                                           target.object}});
+    };
+
+    // Both lists are sorted by key, so one merge finds every change
+    size_t previous = 0;
+    for (HeldHandle& handle : current) {
+        while (previous < target.held.size() &&
+               KeyLess(target.held[previous].ownerProcessId, target.held[previous].handleValue,
+                       handle.ownerProcessId, handle.handleValue)) {
+            report(HandleEventKind::Closed, target.held[previous], target.held[previous].grantedAccess);
+            ++previous;
+        }
+        const bool known = previous < target.held.size() &&
+                           target.held[previous].ownerProcessId == handle.ownerProcessId &&
+                           target.held[previous].handleValue == handle.handleValue;
+        if (!known) {
+            handle.classification = Classify(target, handle.ownerProcessId, handle.grantedAccess);
+            report(HandleEventKind::Opened, handle, handle.grantedAccess);
+            continue;
+        }
+        const HeldHandle& old = target.held[previous++];
+        if (old.grantedAccess != handle.grantedAccess) {
+            handle.classification = Classify(target, handle.ownerProcessId, handle.grantedAccess);
+            report(HandleEventKind::RightsChanged, handle, old.grantedAccess);
+        } else {
+            handle.classification = old.classification;
+        }
+    }
+    for (; previous < target.held.size(); ++previous) {
+        report(HandleEventKind::Closed, target.held[previous], target.held[previous].grantedAccess);
+    }
+    target.held.swap(current);
+    current.clear();
+}
+
+bool MultiProcessCollector::Tick(const EventSink& sink) {
+    Utils::ScopedTimer timer(tickTime_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    DropExitedTargets(sink);
+
+    const bool snapshotTaken = auditor_.Snapshot();
+    if (snapshotTaken) {
+        const HandleTableEntry* entries = auditor_.GetEntries();
+        const size_t count = auditor_.GetEntryCount();
+        const ULONG_PTR selfId = GetCurrentProcessId();
+
+        // New targets are found through the collector's own handle to them
+        for (const auto& target : targets_) {
+            if (target->object == nullptr) {
+                const HandleTableEntry* own = HandleFilter::FindHandle(
+                    entries, count, selfId, reinterpret_cast<ULONG_PTR>(target->process));
+                if (own != nullptr) {
+                    target->object = own->object;
+                    processTypeIndex_ = own->objectTypeIndex;
+                    objectsDirty_ = true;
+                }
+            }
+        }
+        if (objectsDirty_) {
+            BuildObjectTable();
+        }
+
+        const size_t mask = objects_.size() - 1;
+        for (size_t i = 0; i < count; ++i) {
+            const HandleTableEntry& entry = entries[i];
+            // Every target is a process object, so other object types are skipped with one compare
+            if (entry.objectTypeIndex != processTypeIndex_ || entry.uniqueProcessId == selfId) {
+                continue;
+            }
+            size_t slot = HashObject(entry.object, mask);
+            while (objects_[slot].object != nullptr && objects_[slot].object != entry.object) {
+                slot = (slot + 1) & mask;
+            }
+            if (objects_[slot].object == nullptr) {
+                continue;
+            }
+            Target& target = *targets_[objects_[slot].target];
+            if (entry.uniqueProcessId == target.processId) {
+                continue;
+            }
+            // A held handle that lost its watched rights is still open: keep it, so Diff
+            // reports RightsChanged rather than Closed
+            if ((entry.grantedAccess & target.policy.watchedAccess) == 0 &&
+                !IsHeld(target, static_cast<uint32_t>(entry.uniqueProcessId),
+                        static_cast<uint32_t>(entry.handleValue))) {
+                continue;
+            }
+            target.current.push_back(HeldHandle{static_cast<uint32_t>(entry.uniqueProcessId),
+                                                static_cast<uint32_t>(entry.handleValue), entry.grantedAccess,
+                                                entry.objectTypeIndex, HandleClassification{}});
+        }
+        for (const auto& target : targets_) {
+            if (target->object != nullptr) {
+                Diff(*target, sink);
+            }
+        }
+    }
+
+    scheduler_.RunTick();
+    return snapshotTaken;
+}
+
+void MultiProcessCollector::SamplerLoop(DWORD intervalMs, EventSink sink) {
+    while (WaitForSingleObject(stopEvent_, intervalMs) == WAIT_TIMEOUT) {
+        Tick(sink);
+    }
+}
+
+bool MultiProcessCollector::Start(DWORD intervalMs, EventSink sink) {
+    if (sampler_.joinable()) {
+        Utils::Logger::LogError("MultiProcessCollector: sampler already running");
+        return false;
+    }
+    stopEvent_ = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (stopEvent_ == nullptr) {
+        Utils::Logger::Error("MultiProcessCollector: cannot create stop event ({})", GetLastError());
+        return false;
+    }
+    try {
+        sampler_ = std::thread(&MultiProcessCollector::SamplerLoop, this, intervalMs, std::move(sink));
+    } catch (const std::system_error&) {
+        Utils::Logger::LogError("MultiProcessCollector: cannot start sampler thread");
+        CloseHandle(stopEvent_);
+        stopEvent_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void MultiProcessCollector::Stop() {
+    if (sampler_.joinable()) {
+        SetEvent(stopEvent_);
+        sampler_.join();
+    }
+    if (stopEvent_ != nullptr) {
+        CloseHandle(stopEvent_);
+        stopEvent_ = nullptr;
+    }
+}
+
+size_t MultiProcessCollector::GetTargetCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return targets_.size();
+}
+
+uint64_t MultiProcessCollector::GetTickIndex() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return scheduler_.GetTick();
+}
+
+} // namespace Internals
+} // namespace Sentinel
@@ -0,0 +1,282 @@
+/**
+ * @file MultiProcessCollector.hpp
+ * @brief Handle monitoring of many target processes from one sampler thread.
+ *
+ * @details A Service that protects dozens of processes could run one ResourceAuditor per
+ * target, but every auditor would then take its own system-wide handle snapshot - the
+ * largest system call Sentinel makes - and scan all of it for one object. The cost would
+ * grow with the number of targets while the handle table stays the same.
+ *
+ * MultiProcessCollector takes one snapshot per tick and fans it out:
+ * - Each watched process is opened once. The collector's own handle to it appears in the
+ *   snapshot, which yields the target's kernel object address, and keeps the PID from
+ *   being reused while the target is watched.
+ * - One pass over the snapshot looks every process-type entry's object up in a small
+ *   open-addressing table of target objects; entries of other object types cost one
+ *   compare.
+ * - Each target's matches are diffed against its previous tick, and only opened and
+ *   rights-changed handles are classified, against that target's TargetPolicy. A held
+ *   handle that loses its watched rights is reported as RightsChanged (and kept, so a
+ *   later re-escalation is RightsChanged too); only a handle that disappears is Closed.
+ * - Other per-target work, such as hashing a target's code, is scheduled on a
+ *   Utils::TickScheduler, which staggers it across ticks so that no tick carries every
+ *   target's work at once.
+ *
+ * Targets that exit are dropped at the start of the next tick, after Closed events for the
+ * handles still held to them.
+ *
+ * @security Object addresses are used for matching only and never logged.
+ *
+ * @performance Per tick: one NtQuerySystemInformation call, one pass over the snapshot
+ * independent of the number of targets, and classification only for changed handles.
+ *
+ * @see ResourceAuditor
+ * @see TickScheduler
+ */
+
+#pragma once
+
+#include "Sentinel/Internals/HandleIndex.hpp"
+#include "Sentinel/Internals/ResourceAuditor.hpp"
+#include "Sentinel/Utils/Metrics.hpp"
+#include "Sentinel/Utils/TickScheduler.hpp"
+#include <Windows.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Sentinel {
+namespace Internals {
+
+/**
+ * @brief What the collector watches for in one target, and who is allowed to hold it.
+ */
+struct TargetPolicy {
+    /** @brief Rights that make a new handle to the target reportable; others are ignored. */
+    ULONG watchedAccess = PROCESS_VM_WRITE | PROCESS_VM_OPERATION | PROCESS_CREATE_THREAD | PROCESS_DUP_HANDLE;
+
+    /** @brief Owners whose handles are Authorized regardless of rights. */
+    std::vector<DWORD> allowedOwners;
+
+    /** @brief Also authorize owners whose image signature verifies to a trusted root. */
+    bool trustSignedOwners = true;
+
+    /**
+     * @brief Access the collector opens the target with, for scheduled work (SYNCHRONIZE
+     * is always added).
+     */
+    DWORD processAccess = PROCESS_QUERY_LIMITED_INFORMATION | PROCESS_VM_READ;
+};
+
+/**
+ * @brief A change to the handles that other processes hold to one target.
+ */
+struct TargetHandleEvent {
+    DWORD targetProcessId;
+    HandleEvent event;
+};
+
+/**
+ * @class MultiProcessCollector
+ * @brief Shares one handle snapshot per tick among all watched processes.
+ *
+ * Usage example:
+ * @code
+ * MultiProcessCollector collector;
+ * collector.Initialize();
+ * TargetPolicy policy;
+ * policy.allowedOwners.push_back(servicePid);
+ * collector.Watch(gamePid, policy);
+ * collector.ScheduleWork(gamePid, 30, [](DWORD pid, HANDLE process) { HashCode(pid, process); });
+ * collector.Start(1000, [](const TargetHandleEvent& event) {
+ *     if (event.event.classification.verdict == HandleVerdict::Unauthorized) {
+ *         Report(event);
+ *     }
+ * });
+ * // ...
+ * collector.Stop();
+ * @endcode
+ *
+ * @threadsafe Watch, Unwatch, ScheduleWork and the accessors are thread-safe and wait for
+ * a running tick to finish. Tick must only be called while the sampler thread is stopped.
+ * Event sinks and scheduled work run on the ticking thread with the collector locked, so
+ * they must not call back into the collector.
+ */
+class MultiProcessCollector {
+public:
+    /** @brief Receives the events of one tick, grouped by target. */
+    using EventSink = std::function<void(const TargetHandleEvent&)>;
+
+    /** @brief Periodic per-target work; receives the target and the collector's handle to it. */
+    using TargetWork = std::function<void(DWORD processId, HANDLE process)>;
+
+    /** @brief Upper bound on watched processes. */
+    static constexpr size_t MAX_TARGETS = 1024;
+
+    MultiProcessCollector() = default;
+
+    /**
+     * @brief Stops the sampler thread and closes every target handle.
+     */
+    ~MultiProcessCollector();
+
+    MultiProcessCollector(const MultiProcessCollector&) = delete;
+    MultiProcessCollector& operator=(const MultiProcessCollector&) = delete;
+
+    /**
+     * @brief Initializes the shared auditor.
+     *
+     * @return false if the native API is unavailable.
+     */
+    bool Initialize();
+
+    /**
+     * @brief Starts watching @p processId with @p policy.
+     *
+     * @details Handles to the target appear from the next tick on, all reported as Opened
+     * the first time.
+     *
+     * @return false (and logs) if the process cannot be opened, is already watched, or
+     *         MAX_TARGETS is reached.
+     */
+    bool Watch(DWORD processId, const TargetPolicy& policy);
+
+    /**
+     * @brief Stops watching @p processId and cancels its scheduled work. No events are
+     * reported for it afterwards.
+     *
+     * @return false if the process is not watched.
+     */
+    bool Unwatch(DWORD processId);
+
+    /**
+     * @brief Runs @p work for @p processId every @p intervalTicks ticks, staggered against
+     * the work of other targets.
+     *
+     * @param cost Relative cost of one run, see TickScheduler::Add.
+     * @return false if the process is not watched or the interval is out of range.
+     */
+    bool ScheduleWork(DWORD processId, uint32_t intervalTicks, TargetWork work, uint32_t cost = 1);
+
+    /**
+     * @brief Takes one snapshot, reports what changed for every target, then runs the work
+     * due on this tick.
+     *
+     * @return false if the snapshot failed; scheduled work still runs.
+     */
+    bool Tick(const EventSink& sink);
+
+    /**
+     * @brief Starts the sampler thread, which calls Tick every @p intervalMs milliseconds.
+     *
+     * @return false if the thread is already running or cannot be created.
+     */
+    bool Start(DWORD intervalMs, EventSink sink);
+
+    /**
+     * @brief Stops the sampler thread, waiting for a running tick. No-op if not running.
+     */
+    void Stop();
+
+    /** @brief Number of watched processes. */
+    size_t GetTargetCount() const;
+
+    /** @brief Ticks run so far. */
+    uint64_t GetTickIndex() const;
+
+    /** @brief Shared auditor; use its process cache for owner lookups. */
+    ResourceAuditor& GetAuditor() noexcept { return auditor_; }
+
+private:
+    /**
+     * @brief Handle held to a target, keyed by (owner, handle value).
+     */
+    struct HeldHandle {
+        uint32_t ownerProcessId;
+        uint32_t handleValue;
+        uint32_t grantedAccess;
+        uint16_t objectTypeIndex;
+        HandleClassification classification;
+    };
+
+    struct Target {
+        DWORD processId = 0;
+        HANDLE process = nullptr;
+
+        /** @brief Kernel object of the target, learned from the first snapshot; never logged. */
+        const void* object = nullptr;
+
+        TargetPolicy policy;
+
+        /** @brief Handles seen on the previous tick, sorted by key. */
+        std::vector<HeldHandle> held;
+
+        /** @brief Matches of the current tick; retained to avoid reallocating. */
+        std::vector<HeldHandle> current;
+
+        std::vector<uint64_t> jobs;
+    };
+
+    /**
+     * @brief Slot of the object lookup table: a target object and the target's index.
+     */
+    struct ObjectSlot {
+        const void* object;
+        uint32_t target;
+    };
+
+    /** @brief Index of @p processId in targets_, or SIZE_MAX. Requires mutex_. */
+    size_t Find(DWORD processId) const noexcept;
+
+    /** @brief Cancels the work of targets_[index], closes it and removes it. Requires mutex_. */
+    void Remove(size_t index);
+
+    /** @brief Reports Closed for every handle held to targets that have exited and removes them. */
+    void DropExitedTargets(const EventSink& sink);
+
+    /** @brief Rebuilds objects_ from the resolved targets. */
+    void BuildObjectTable();
+
+    /** @brief true if (@p ownerProcessId, @p handleValue) was held to @p target last tick. */
+    static bool IsHeld(const Target& target, uint32_t ownerProcessId, uint32_t handleValue) noexcept;
+
+    /** @brief Classifies a handle held by @p ownerProcessId to @p target. */
+    HandleClassification Classify(const Target& target, uint32_t ownerProcessId, uint32_t grantedAccess);
+
+    /** @brief Diffs @p target's matches against the previous tick and reports the changes. */
+    void Diff(Target& target, const EventSink& sink);
+
+    /** @brief Body of the sampler thread. */
+    void SamplerLoop(DWORD intervalMs, EventSink sink);
+
+    /** @brief Tick durations ("collector.tick_ns"), shared by all instances. */
+    static Utils::Histogram tickTime_;
+    static const Utils::MetricRegistration tickTimeMetric_;
+
+    /** @brief Watched processes ("collector.targets"), shared by all instances. */
+    static Utils::Gauge targetCount_;
+    static const Utils::MetricRegistration targetCountMetric_;
+
+    mutable std::mutex mutex_;
+    ResourceAuditor auditor_;
+    Utils::TickScheduler scheduler_;
+    std::vector<std::unique_ptr<Target>> targets_;
+
+    // Open-addressing table over the resolved target objects, rebuilt when targets change
+    std::vector<ObjectSlot> objects_;
+    bool objectsDirty_ = true;
+
+    // Object type index of processes, learned with the first target object
+    uint16_t processTypeIndex_ = 0;
+
+    std::thread sampler_;
+    HANDLE stopEvent_ = nullptr;
+};
+
+} // namespace Internals
+} // namespace Sentinel
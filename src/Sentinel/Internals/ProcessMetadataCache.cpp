@@ -0,0 +1,329 @@
+/**
+ * @file ProcessMetadataCache.cpp
+ * @brief Implementation of the process metadata cache and signature verification.
+ */
+
+#include "Sentinel/Internals/ProcessMetadataCache.hpp"
+#include <wintrust.h>
+#include <Softpub.h>
+#include <mscat.h>
+#include <cwctype>
+#include <vector>
+
+namespace Sentinel {
+namespace Internals {
+
+// Long enough for any path QueryFullProcessImageNameW returns in practice
+static constexpr DWORD IMAGE_PATH_CAPACITY = 1024;
+
+// Image paths differ in case between processes; the file system does not care
+static std::wstring NormalizePath(const std::wstring& path) {
+    std::wstring key(path);
+    for (wchar_t& c : key) {
+        c = static_cast<wchar_t>(std::towlower(c));
+    }
+    return key;
+}
+
+// Reads the leaf certificate's display name out of a completed WinVerifyTrust state
+static std::wstring ExtractSigner(HANDLE stateData) {
+    CRYPT_PROVIDER_DATA* provider = WTHelperProvDataFromStateData(stateData);
+    if (provider == nullptr) {
+        return std::wstring();
+    }
+    CRYPT_PROVIDER_SGNR* signer = WTHelperGetProvSignerFromChain(provider, 0, FALSE, 0);
+    if (signer == nullptr || signer->csCertChain == 0 || signer->pasCertChain == nullptr ||
+        signer->pasCertChain[0].pCert == nullptr) {
+        return std::wstring();
+    }
+    wchar_t name[256];
+    DWORD length = CertGetNameStringW(signer->pasCertChain[0].pCert, CERT_NAME_SIMPLE_DISPLAY_TYPE, 0, nullptr,
+                                      name, static_cast<DWORD>(sizeof(name) / sizeof(name[0])));
+    return length > 1 ? std::wstring(name, length - 1) : std::wstring();
+}
+
+// Runs WinVerifyTrust on a prepared WINTRUST_DATA and releases its state again
+static LONG RunVerification(WINTRUST_DATA& data, std::wstring& signer) {
+    GUID action = WINTRUST_ACTION_GENERIC_VERIFY_V2;
+    data.dwStateAction = WTD_STATEACTION_VERIFY;
+    LONG status = WinVerifyTrust(static_cast<HWND>(INVALID_HANDLE_VALUE), &action, &data);
+    if (status == ERROR_SUCCESS) {
+        signer = ExtractSigner(data.hWVTStateData);
+    }
+    data.dwStateAction = WTD_STATEACTION_CLOSE;
+    WinVerifyTrust(static_cast<HWND>(INVALID_HANDLE_VALUE), &action, &data);
+    return status;
+}
+
+ProcessMetadataCache::~ProcessMetadataCache() {
+    std::unordered_map<DWORD, std::shared_ptr<Entry>> entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries.swap(processes_);
+    }
+    for (auto& [processId, entry] : entries) {
+        static_cast<void>(processId);
+        Discard(*entry);
+    }
+}
+
+std::shared_ptr<const ProcessMetadata> ProcessMetadataCache::Lookup(DWORD processId) {
+    const ULONGLONG now = GetTickCount64();
+    std::shared_ptr<Entry> cached;
+    std::shared_ptr<const ProcessMetadata> metadata;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (exitPending_.exchange(false, std::memory_order_acq_rel)) {
+            PurgeLocked(now);
+        }
+        auto found = processes_.find(processId);
+        if (found != processes_.end()) {
+            Entry& entry = *found->second;
+            const bool live = !entry.exited.load(std::memory_order_acquire) &&
+                              (entry.expiresAt == 0 || now < entry.expiresAt);
+            if (live) {
+                hitCount_.fetch_add(1, std::memory_order_relaxed);
+                if (entry.metadata->imagePath.empty() || now - entry.trustCheckedAt < config_.trustRefreshMs) {
+                    return entry.metadata;
+                }
+                cached = found->second;
+                metadata = entry.metadata;
+            }
+        }
+    }
+
+    if (cached != nullptr) {
+        // Stale trust: verify again outside the lock and publish a new copy
+        auto refreshed = std::make_shared<ProcessMetadata>(*metadata);
+        ResolveTrust(refreshed->imagePath, refreshed->trust, refreshed->signer);
+        std::lock_guard<std::mutex> lock(mutex_);
+        cached->metadata = refreshed;
+        cached->trustCheckedAt = now;
+        return refreshed;
+    }
+
+    missCount_.fetch_add(1, std::memory_order_relaxed);
+    std::shared_ptr<Entry> created = CreateEntry(processId);
+
+    std::shared_ptr<Entry> discarded;
+    std::shared_ptr<const ProcessMetadata> result = created->metadata;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = processes_.find(processId);
+        if (found != processes_.end()) {
+            Entry& existing = *found->second;
+            const bool live = !existing.exited.load(std::memory_order_acquire) &&
+                              (existing.expiresAt == 0 || now < existing.expiresAt);
+            if (live) {
+                // Another thread filled the same PID in the meantime; keep its entry
+                discarded = created;
+                result = existing.metadata;
+            } else {
+                discarded = found->second;
+                found->second = created;
+            }
+        } else if (processes_.size() < config_.maxEntries) {
+            processes_.emplace(processId, created);
+        } else {
+            discarded = created;
+        }
+    }
+    if (discarded != nullptr) {
+        Discard(*discarded);
+    }
+    return result;
+}
+
+std::shared_ptr<ProcessMetadataCache::Entry> ProcessMetadataCache::CreateEntry(DWORD processId) {
+    const ULONGLONG now = GetTickCount64();
+    auto entry = std::make_shared<Entry>();
+    entry->owner = this;
+    auto metadata = std::make_shared<ProcessMetadata>();
+    metadata->processId = processId;
+
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE, FALSE, processId);
+    if (process == nullptr) {
+        entry->expiresAt = now + config_.negativeTtlMs;
+        entry->metadata = std::move(metadata);
+        return entry;
+    }
+
+    FILETIME creation{};
+    FILETIME exitTime{};
+    FILETIME kernelTime{};
+    FILETIME userTime{};
+    if (GetProcessTimes(process, &creation, &exitTime, &kernelTime, &userTime)) {
+        metadata->creationTime = (static_cast<uint64_t>(creation.dwHighDateTime) << 32) | creation.dwLowDateTime;
+    }
+
+    wchar_t path[IMAGE_PATH_CAPACITY];
+    DWORD length = IMAGE_PATH_CAPACITY;
+    if (QueryFullProcessImageNameW(process, 0, path, &length)) {
+        metadata->imagePath.assign(path, length);
+        ResolveTrust(metadata->imagePath, metadata->trust, metadata->signer);
+    }
+    entry->trustCheckedAt = now;
+    entry->process = process;
+
+    // The wait context is the entry itself; Discard unregisters it before the entry dies
+    if (!RegisterWaitForSingleObject(&entry->wait, process, OnProcessExit, entry.get(), INFINITE,
+                                     WT_EXECUTEONLYONCE)) {
+        // Without an exit notification the entry can only be trusted for a while
+        entry->wait = nullptr;
+        entry->expiresAt = now + config_.negativeTtlMs;
+    }
+    entry->metadata = std::move(metadata);
+    return entry;
+}
+
+void ProcessMetadataCache::ResolveTrust(const std::wstring& imagePath, ProcessTrust& trust, std::wstring& signer) {
+    const std::wstring key = NormalizePath(imagePath);
+    const ULONGLONG now = GetTickCount64();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = images_.find(key);
+        if (found != images_.end() && now - found->second.verifiedAt < config_.trustRefreshMs) {
+            trust = found->second.trust;
+            signer = found->second.signer;
+            return;
+        }
+    }
+
+    // Concurrent misses on one image may both verify it; the results are identical
+    verificationCount_.fetch_add(1, std::memory_order_relaxed);
+    std::wstring verifiedSigner;
+    const ProcessTrust verified = VerifyImage(imagePath, verifiedSigner);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ImageTrust& image = images_[key];
+    image.trust = verified;
+    image.signer = verifiedSigner;
+    image.verifiedAt = now;
+    trust = verified;
+    signer = std::move(verifiedSigner);
+}
+
+ProcessTrust ProcessMetadataCache::VerifyImage(const std::wstring& path, std::wstring& signer) {
+    signer.clear();
+
+    // Embedded Authenticode signature first; no UI, no network
+    WINTRUST_FILE_INFO fileInfo{};
+    fileInfo.cbStruct = sizeof(fileInfo);
+    fileInfo.pcwszFilePath = path.c_str();
+
+    WINTRUST_DATA data{};
+    data.cbStruct = sizeof(data);
+    data.dwUIChoice = WTD_UI_NONE;
+    data.fdwRevocationChecks = WTD_REVOKE_NONE;
+    data.dwUnionChoice = WTD_CHOICE_FILE;
+    data.pFile = &fileInfo;
+    data.dwProvFlags = WTD_CACHE_ONLY_URL_RETRIEVAL;
+
+    LONG status = RunVerification(data, signer);
+    if (status == ERROR_SUCCESS) {
+        return ProcessTrust::Trusted;
+    }
+    if (status != TRUST_E_NOSIGNATURE) {
+        return ProcessTrust::Untrusted;
+    }
+
+    // Most Windows binaries carry no embedded signature; they are signed through catalogs
+    HCATADMIN catalogAdmin = nullptr;
+    if (!CryptCATAdminAcquireContext2(&catalogAdmin, nullptr, BCRYPT_SHA256_ALGORITHM, nullptr, 0)) {
+        return ProcessTrust::Unknown;
+    }
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        CryptCATAdminReleaseContext(catalogAdmin, 0);
+        return ProcessTrust::Unknown;
+    }
+
+    ProcessTrust trust = ProcessTrust::Unsigned;
+    DWORD hashSize = 0;
+    CryptCATAdminCalcHashFromFileHandle2(catalogAdmin, file, &hashSize, nullptr, 0);
+    std::vector<BYTE> hash(hashSize);
+    if (hashSize != 0 && CryptCATAdminCalcHashFromFileHandle2(catalogAdmin, file, &hashSize, hash.data(), 0)) {
+        HCATINFO catalog = CryptCATAdminEnumCatalogFromHash(catalogAdmin, hash.data(), hashSize, 0, nullptr);
+        if (catalog != nullptr) {
+            CATALOG_INFO catalogInfo{};
+            catalogInfo.cbStruct = sizeof(catalogInfo);
+            if (CryptCATCatalogInfoFromContext(catalog, &catalogInfo, 0)) {
+                // Catalog members are tagged with the uppercase hex hash of the file
+                static const wchar_t HEX[] = L"0123456789ABCDEF";
+                std::wstring memberTag;
+                memberTag.reserve(hash.size() * 2);
+                for (BYTE value : hash) {
+                    memberTag.push_back(HEX[value >> 4]);
+                    memberTag.push_back(HEX[value & 0x0F]);
+                }
+
+                WINTRUST_CATALOG_INFO catalogData{};
+                catalogData.cbStruct = sizeof(catalogData);
+                catalogData.pcwszCatalogFilePath = catalogInfo.wszCatalogFile;
+                catalogData.pcwszMemberFilePath = path.c_str();
+                catalogData.pcwszMemberTag = memberTag.c_str();
+                catalogData.hMemberFile = file;
+                catalogData.pbCalculatedFileHash = hash.data();
+                catalogData.cbCalculatedFileHash = hashSize;
+                catalogData.hCatAdmin = catalogAdmin;
+
+                data.dwUnionChoice = WTD_CHOICE_CATALOG;
+                data.pCatalog = &catalogData;
+                data.hWVTStateData = nullptr;
+                status = RunVerification(data, signer);
+                trust = status == ERROR_SUCCESS ? ProcessTrust::Trusted : ProcessTrust::Untrusted;
+            }
+            CryptCATAdminReleaseCatalogContext(catalogAdmin, catalog, 0);
+        }
+    }
+    CloseHandle(file);
+    CryptCATAdminReleaseContext(catalogAdmin, 0);
+    return trust;
+}
+
+void ProcessMetadataCache::Discard(Entry& entry) {
+    if (entry.wait != nullptr) {
+        // INVALID_HANDLE_VALUE waits for a callback in progress, which never takes mutex_
+        UnregisterWaitEx(entry.wait, INVALID_HANDLE_VALUE);
+        entry.wait = nullptr;
+    }
+    if (entry.process != nullptr) {
+        CloseHandle(entry.process);
+        entry.process = nullptr;
+    }
+}
+
+void ProcessMetadataCache::Purge() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exitPending_.store(false, std::memory_order_relaxed);
+    PurgeLocked(GetTickCount64());
+}
+
+void ProcessMetadataCache::PurgeLocked(ULONGLONG now) {
+    for (auto it = processes_.begin(); it != processes_.end();) {
+        Entry& entry = *it->second;
+        if (entry.exited.load(std::memory_order_acquire) || (entry.expiresAt != 0 && now >= entry.expiresAt)) {
+            Discard(entry);
+            it = processes_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t ProcessMetadataCache::GetSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return processes_.size();
+}
+
+VOID CALLBACK ProcessMetadataCache::OnProcessExit(PVOID context, BOOLEAN timedOut) {
+    static_cast<void>(timedOut);
+    // Runs on a thread pool thread: only flag the entry; removal happens under the lock
+    Entry* entry = static_cast<Entry*>(context);
+    entry->exited.store(true, std::memory_order_release);
+    entry->owner->exitPending_.store(true, std::memory_order_release);
+}
+
+} // namespace Internals
+} // namespace Sentinel
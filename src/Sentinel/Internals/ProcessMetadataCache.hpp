@@ -0,0 +1,226 @@
+/**
+ * @file ProcessMetadataCache.hpp
+ * @brief Cached image path, signer and signature trust of handle-owning processes.
+ *
+ * @details This module exists because classifying a handle means knowing who owns it, and
+ * finding out is expensive: OpenProcess and QueryFullProcessImageName cost two system
+ * calls, and WinVerifyTrust hashes the image file and walks its certificate chain, which
+ * takes milliseconds or longer. The set of processes holding handles barely changes between
+ * audit passes, so that work should be done once per process, not once per scan.
+ *
+ * Each process is identified by (PID, creation time). The cache keeps a
+ * PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE handle to every process it describes:
+ * - The open handle keeps the process object - and therefore its PID - from being reused
+ *   while the entry exists, so the PID alone finds the right entry.
+ * - The handle is registered with RegisterWaitForSingleObject; when the process exits, the
+ *   callback marks the entry, and the next lookup discards it. A later process reusing the
+ *   PID has a different creation time and gets a fresh entry.
+ *
+ * Trust results are additionally shared by image path, so the dozens of svchost.exe
+ * instances on a host cost one verification. They are refreshed lazily: a lookup that
+ * finds a result older than trustRefreshMs verifies the image again.
+ *
+ * Processes that cannot be opened (protected processes, the Idle process) are cached as
+ * negative entries for negativeTtlMs.
+ *
+ * @security Signature checks run with WTD_REVOKE_NONE and cache-only URL retrieval: the
+ * auditor never goes to the network, so a revoked certificate is only detected once the
+ * local revocation cache knows about it. Catalog-signed system binaries are verified
+ * against the system catalogs.
+ *
+ * @performance A hit costs one hash lookup under a mutex and a shared_ptr copy. Misses
+ * run outside the lock, so concurrent classification threads are never blocked behind a
+ * WinVerifyTrust call.
+ *
+ * @see ResourceAuditor
+ */
+
+#pragma once
+
+#include <Windows.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Sentinel {
+namespace Internals {
+
+/**
+ * @brief Result of verifying a process image's Authenticode signature.
+ */
+enum class ProcessTrust : uint8_t {
+    /** @brief The image could not be located or verified. */
+    Unknown = 0,
+
+    /** @brief Neither an embedded signature nor a catalog entry exists. */
+    Unsigned = 1,
+
+    /** @brief A signature exists but does not verify (tampered, untrusted root, expired). */
+    Untrusted = 2,
+
+    /** @brief The signature verifies to a trusted root. */
+    Trusted = 3
+};
+
+/**
+ * @brief What the cache knows about one process.
+ */
+struct ProcessMetadata {
+    DWORD processId = 0;
+
+    /** @brief Creation time as a FILETIME value; 0 if the process could not be opened. */
+    uint64_t creationTime = 0;
+
+    /** @brief Full Win32 path of the image; empty if unavailable. */
+    std::wstring imagePath;
+
+    /** @brief Display name of the signing certificate; empty if unsigned. */
+    std::wstring signer;
+
+    ProcessTrust trust = ProcessTrust::Unknown;
+};
+
+/**
+ * @brief Configuration for ProcessMetadataCache.
+ */
+struct ProcessMetadataCacheConfig {
+    /** @brief Age after which a trust result is verified again on the next lookup. */
+    ULONGLONG trustRefreshMs = 30 * 60 * 1000;
+
+    /** @brief Lifetime of entries for processes that could not be opened. */
+    ULONGLONG negativeTtlMs = 5000;
+
+    /** @brief Maximum number of cached processes; lookups beyond it are not cached. */
+    size_t maxEntries = 8192;
+};
+
+/**
+ * @class ProcessMetadataCache
+ * @brief Per-process metadata cache invalidated by process-exit notifications.
+ *
+ * Usage example:
+ * @code
+ * ProcessMetadataCache cache;
+ * std::shared_ptr<const ProcessMetadata> owner = cache.Lookup(pid);
+ * if (owner->trust != ProcessTrust::Trusted) {
+ *     Logger::Warning("Untrusted handle owner {}", pid);
+ * }
+ * @endcode
+ *
+ * @threadsafe All methods are thread-safe.
+ */
+class ProcessMetadataCache {
+public:
+    ProcessMetadataCache() = default;
+    explicit ProcessMetadataCache(const ProcessMetadataCacheConfig& config) : config_(config) {}
+
+    /**
+     * @brief Unregisters every exit notification and closes every process handle.
+     */
+    ~ProcessMetadataCache();
+
+    ProcessMetadataCache(const ProcessMetadataCache&) = delete;
+    ProcessMetadataCache& operator=(const ProcessMetadataCache&) = delete;
+
+    /**
+     * @brief Returns the metadata of process @p processId, computing it on a miss.
+     *
+     * @return Never null. For processes that cannot be opened, the result has an empty
+     *         image path and ProcessTrust::Unknown.
+     */
+    std::shared_ptr<const ProcessMetadata> Lookup(DWORD processId);
+
+    /**
+     * @brief Drops entries of processes that have exited. Lookup does this implicitly.
+     */
+    void Purge();
+
+    /** @brief Number of cached processes. */
+    size_t GetSize() const;
+
+    /** @brief Lookups answered from the cache. */
+    uint64_t GetHitCount() const noexcept { return hitCount_.load(std::memory_order_relaxed); }
+
+    /** @brief Lookups that opened the process. */
+    uint64_t GetMissCount() const noexcept { return missCount_.load(std::memory_order_relaxed); }
+
+    /** @brief WinVerifyTrust runs (one per image path and refresh interval). */
+    uint64_t GetVerificationCount() const noexcept { return verificationCount_.load(std::memory_order_relaxed); }
+
+private:
+    /**
+     * @brief One cached process.
+     *
+     * @details Owned by processes_ through a shared_ptr; the exit callback receives the raw
+     * pointer, which stays valid until the wait is unregistered in Discard.
+     */
+    struct Entry {
+        ProcessMetadataCache* owner = nullptr;
+        HANDLE process = nullptr;
+        HANDLE wait = nullptr;
+        std::atomic<bool> exited{false};
+
+        /** @brief GetTickCount64 deadline for entries without exit notification (0 = none). */
+        ULONGLONG expiresAt = 0;
+
+        ULONGLONG trustCheckedAt = 0;
+        std::shared_ptr<const ProcessMetadata> metadata;
+    };
+
+    /**
+     * @brief Trust result shared by every process running the same image.
+     */
+    struct ImageTrust {
+        ProcessTrust trust = ProcessTrust::Unknown;
+        std::wstring signer;
+        ULONGLONG verifiedAt = 0;
+    };
+
+    /**
+     * @brief Opens @p processId and fills in a new entry. Runs without mutex_ held.
+     */
+    std::shared_ptr<Entry> CreateEntry(DWORD processId);
+
+    /**
+     * @brief Returns the trust of @p imagePath, verifying it if unknown or stale.
+     */
+    void ResolveTrust(const std::wstring& imagePath, ProcessTrust& trust, std::wstring& signer);
+
+    /**
+     * @brief Verifies the embedded signature of @p path, falling back to system catalogs.
+     */
+    static ProcessTrust VerifyImage(const std::wstring& path, std::wstring& signer);
+
+    /**
+     * @brief Unregisters @p entry's wait (blocking until a running callback returns) and
+     * closes its process handle.
+     */
+    static void Discard(Entry& entry);
+
+    /**
+     * @brief Removes exited and expired entries. Requires mutex_.
+     */
+    void PurgeLocked(ULONGLONG now);
+
+    static VOID CALLBACK OnProcessExit(PVOID context, BOOLEAN timedOut);
+
+    ProcessMetadataCacheConfig config_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<DWORD, std::shared_ptr<Entry>> processes_;
+    std::unordered_map<std::wstring, ImageTrust> images_;
+
+    // Set by OnProcessExit; the next lookup sweeps exited entries
+    std::atomic<bool> exitPending_{false};
+
+    std::atomic<uint64_t> hitCount_{0};
+    std::atomic<uint64_t> missCount_{0};
+    std::atomic<uint64_t> verificationCount_{0};
+};
+
+} // namespace Internals
+} // namespace Sentinel
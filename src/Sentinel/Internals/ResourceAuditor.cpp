@@ -0,0 +1,162 @@
+/**
+ * @file ResourceAuditor.cpp
+ * @brief Implementation of handle table snapshots with a persistent buffer.
+ */
+
+#include "Sentinel/Internals/ResourceAuditor.hpp"
+#include "Sentinel/Utils/AllocatorStats.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+
+namespace Sentinel {
+namespace Internals {
+
+// NTSTATUS values used here; ntstatus.h conflicts with Windows.h
+static constexpr LONG STATUS_SUCCESS_CODE = 0;
+static constexpr LONG STATUS_INFO_LENGTH_MISMATCH_CODE = static_cast<LONG>(0xC0000004L);
+
+// VirtualAlloc reserves in 64 KB units; anything smaller is wasted address space
+static constexpr size_t ALLOCATION_GRANULARITY = 64 * 1024;
+
+// Pre-grow before the next scan once the table uses more than 7/8 of the buffer
+static constexpr size_t GROWTH_THRESHOLD_DIVISOR = 8;
+
+Utils::Histogram ResourceAuditor::auditTime_;
+const Utils::MetricRegistration ResourceAuditor::auditTimeMetric_("auditor.audit_ns", auditTime_);
+
+// Duration of the handle table query alone, failed snapshots included
+static Utils::Histogram snapshotTime;
+static const Utils::MetricRegistration snapshotTimeMetric("auditor.snapshot_ns", snapshotTime);
+
+// Snapshot buffers of every auditor: capacity reserved, and bytes filled by the last snapshot
+static Utils::AllocatorStats snapshotBufferStats("alloc.auditor_snapshots.reserved_bytes",
+                                                 "alloc.auditor_snapshots.in_use_bytes",
+                                                 "alloc.auditor_snapshots.overflows");
+
+ResourceAuditor::~ResourceAuditor() {
+    Release();
+    snapshotBufferStats.bytesInUse.Add(-static_cast<int64_t>(lastReturnedLength_));
+}
+
+bool ResourceAuditor::Initialize() {
+    if (query_ != nullptr) {
+        return true;
+    }
+
+    // ntdll is mapped into every process; no LoadLibrary reference is needed
+    HMODULE ntdll = GetModuleHandleW(L"ntdll.dll");
+    if (ntdll == nullptr) {
+        Utils::Logger::LogError("ntdll.dll is not loaded");
+        return false;
+    }
+    query_ = reinterpret_cast<NtQuerySystemInformationFn>(
+        reinterpret_cast<void*>(GetProcAddress(ntdll, "NtQuerySystemInformation")));
+    if (query_ == nullptr) {
+        Utils::Logger::LogError("NtQuerySystemInformation is not available");
+        return false;
+    }
+    return true;
+}
+
+bool ResourceAuditor::Snapshot() {
+    Utils::ScopedTimer timer(snapshotTime);
+    entries_ = nullptr;
+    entryCount_ = 0;
+    if (query_ == nullptr) {
+        Utils::Logger::LogError("ResourceAuditor::Snapshot called before Initialize");
+        return false;
+    }
+
+    // Grow ahead of time when the last scan nearly filled the buffer, so a slowly growing
+    // handle table costs one allocation instead of a failed query plus an allocation
+    if (buffer_ == nullptr || lastReturnedLength_ > capacity_ - capacity_ / GROWTH_THRESHOLD_DIVISOR) {
+        const size_t required = lastReturnedLength_ > INITIAL_CAPACITY ? lastReturnedLength_ : INITIAL_CAPACITY;
+        if (!Grow(required)) {
+            return false;
+        }
+    }
+
+    for (int attempt = 0; attempt < MAX_QUERY_ATTEMPTS; ++attempt) {
+        ULONG returnedLength = 0;
+        lastStatus_ = query_(SYSTEM_EXTENDED_HANDLE_INFORMATION, buffer_,
+                             static_cast<ULONG>(capacity_), &returnedLength);
+
+        if (lastStatus_ == STATUS_INFO_LENGTH_MISMATCH_CODE) {
+            // Some builds report 0 or the passed length; fall back to plain doubling then
+            const size_t required = returnedLength > capacity_ ? returnedLength : capacity_ + 1;
+            if (!Grow(required)) {
+                return false;
+            }
+            continue;
+        }
+
+        if (lastStatus_ != STATUS_SUCCESS_CODE) {
+            Utils::Logger::Error("NtQuerySystemInformation failed with status 0x{:08X}",
+                                 static_cast<unsigned long>(lastStatus_));
+            return false;
+        }
+
+        const HandleTableHeader* header = static_cast<const HandleTableHeader*>(buffer_);
+        const size_t maxEntries = (capacity_ - sizeof(HandleTableHeader)) / sizeof(HandleTableEntry);
+        if (header->numberOfHandles > maxEntries) {
+            Utils::Logger::Error("Handle table reports {} entries, buffer holds {}",
+                                 static_cast<unsigned long long>(header->numberOfHandles),
+                                 static_cast<unsigned long long>(maxEntries));
+            return false;
+        }
+
+        snapshotBufferStats.bytesInUse.Add(static_cast<int64_t>(returnedLength) -
+                                           static_cast<int64_t>(lastReturnedLength_));
+        lastReturnedLength_ = returnedLength;
+        entries_ = reinterpret_cast<const HandleTableEntry*>(header + 1);
+        entryCount_ = static_cast<size_t>(header->numberOfHandles);
+        return true;
+    }
+
+    Utils::Logger::Error("Handle table kept growing during {} query attempts", MAX_QUERY_ATTEMPTS);
+    return false;
+}
+
+bool ResourceAuditor::Grow(size_t required) {
+    size_t next = capacity_ * 2;
+    const size_t withHeadroom = required + required / 4;
+    if (withHeadroom > next) {
+        next = withHeadroom;
+    }
+    next = (next + ALLOCATION_GRANULARITY - 1) & ~(ALLOCATION_GRANULARITY - 1);
+    if (next > MAX_CAPACITY) {
+        if (required > MAX_CAPACITY) {
+            Utils::Logger::Error("Handle table needs {} bytes, above the {} byte limit",
+                                 static_cast<unsigned long long>(required),
+                                 static_cast<unsigned long long>(MAX_CAPACITY));
+            return false;
+        }
+        next = MAX_CAPACITY;
+    }
+
+    // Free first: old contents are never needed, and this halves the peak commit
+    Release();
+    buffer_ = VirtualAlloc(nullptr, next, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (buffer_ == nullptr) {
+        Utils::Logger::Error("Failed to allocate {} byte handle snapshot buffer (error {})",
+                             static_cast<unsigned long long>(next), GetLastError());
+        return false;
+    }
+    capacity_ = next;
+    ++allocationCount_;
+    snapshotBufferStats.bytesReserved.Add(static_cast<int64_t>(capacity_));
+    return true;
+}
+
+void ResourceAuditor::Release() noexcept {
+    if (buffer_ != nullptr) {
+        VirtualFree(buffer_, 0, MEM_RELEASE);
+        buffer_ = nullptr;
+        snapshotBufferStats.bytesReserved.Add(-static_cast<int64_t>(capacity_));
+    }
+    capacity_ = 0;
+    entries_ = nullptr;
+    entryCount_ = 0;
+}
+
+} // namespace Internals
+} // namespace Sentinel
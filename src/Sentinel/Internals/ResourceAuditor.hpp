@@ -0,0 +1,193 @@
+/**
+ * @file ResourceAuditor.hpp
+ * @brief System-wide handle table snapshots through NtQuerySystemInformation.
+ *
+ * @details This module implements the enumeration stage of the Resource Auditor (Module B).
+ * It queries SystemExtendedHandleInformation (class 0x40), which returns every open handle
+ * in the system as one SYSTEM_HANDLE_INFORMATION_EX block. On a busy host that block
+ * describes more than 500,000 handles, i.e. 20 MB or more.
+ *
+ * The native API has no way to ask for the size first: a caller passes a buffer, and on
+ * STATUS_INFO_LENGTH_MISMATCH learns the size that would have been needed at that instant.
+ * The usual pattern - allocate, query, free, reallocate bigger, retry - therefore pays for
+ * several multi-megabyte allocations on every audit pass. ResourceAuditor instead keeps one
+ * VirtualAlloc'd buffer for its whole lifetime:
+ * - The buffer only grows, geometrically: the next capacity is the larger of twice the
+ *   current capacity and the reported size plus headroom for handles opened meanwhile.
+ * - After each successful scan the returned length is compared with the capacity; when the
+ *   table has grown close to the limit, the buffer is enlarged before the next scan rather
+ *   than after a failed one.
+ * - Once the handle count stabilizes, Snapshot performs one system call and no allocation.
+ *
+ * Audit combines a snapshot with a HandleIndex pass, so callers receive opened, closed and
+ * rights-changed events and classification only runs for handles that changed.
+ *
+ * @security Reading the system handle table requires no privilege, but it discloses kernel
+ * object addresses. Snapshots must stay inside the auditor process; object addresses are
+ * never logged.
+ *
+ * @performance Steady state: one NtQuerySystemInformation call per scan. Growth: one
+ * VirtualFree/VirtualAlloc pair per doubling, so at most log2(final / initial) allocations
+ * over the process lifetime.
+ *
+ * @see https://learn.microsoft.com/en-us/windows/win32/api/winternl/nf-winternl-ntquerysysteminformation
+ * @see docs/ARCHITECTURE.md, Module B
+ */
+
+#pragma once
+
+#include "Sentinel/Internals/HandleIndex.hpp"
+#include "Sentinel/Internals/HandleTable.hpp"
+#include "Sentinel/Internals/ProcessMetadataCache.hpp"
+#include "Sentinel/Utils/Metrics.hpp"
+#include <Windows.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace Sentinel {
+namespace Internals {
+
+/**
+ * @class ResourceAuditor
+ * @brief Takes handle table snapshots into a persistent, geometrically growing buffer.
+ *
+ * Usage example:
+ * @code
+ * ResourceAuditor auditor;
+ * if (auditor.Initialize() && auditor.Snapshot()) {
+ *     for (size_t i = 0; i < auditor.GetEntryCount(); ++i) {
+ *         const HandleTableEntry& entry = auditor.GetEntries()[i];
+ *     }
+ * }
+ * // Or, incrementally:
+ * auditor.Audit([&auditor](const HandleTableEntry& entry) {
+ *                   auto owner = auditor.GetProcessCache().Lookup(static_cast<DWORD>(entry.uniqueProcessId));
+ *                   return Classify(entry, *owner);
+ *               },
+ *               [](const HandleEvent& event) { Report(event); });
+ * @endcode
+ *
+ * @threadsafe Not thread-safe. A snapshot is valid until the next call to Snapshot on the
+ * same instance; use one auditor per scanning thread.
+ */
+class ResourceAuditor {
+public:
+    /** @brief SystemExtendedHandleInformation information class. */
+    static constexpr ULONG SYSTEM_EXTENDED_HANDLE_INFORMATION = 0x40;
+
+    /** @brief Minimum size of the first buffer, enough for about 100,000 handles. */
+    static constexpr size_t INITIAL_CAPACITY = 4 * 1024 * 1024;
+
+    /** @brief Upper bound on the buffer; a larger reported size is treated as an error. */
+    static constexpr size_t MAX_CAPACITY = 1024ull * 1024 * 1024;
+
+    /** @brief Query attempts per snapshot while the handle table keeps growing. */
+    static constexpr int MAX_QUERY_ATTEMPTS = 4;
+
+    ResourceAuditor() = default;
+    ~ResourceAuditor();
+
+    ResourceAuditor(const ResourceAuditor&) = delete;
+    ResourceAuditor& operator=(const ResourceAuditor&) = delete;
+
+    /**
+     * @brief Resolves NtQuerySystemInformation from ntdll.dll.
+     *
+     * @return true if the native API is available.
+     */
+    bool Initialize();
+
+    /**
+     * @brief Replaces the current snapshot with the system's handle table.
+     *
+     * @details Grows the buffer only when the table does not fit; on failure the previous
+     * snapshot is discarded and GetEntryCount returns 0.
+     *
+     * @return true if a complete snapshot was taken.
+     */
+    bool Snapshot();
+
+    /**
+     * @brief Takes a snapshot and reports what changed since the previous Audit call.
+     *
+     * @details Only handles that were opened or whose access rights changed are passed to
+     * @p classify; unchanged handles reuse the classification cached in the index. The
+     * classification stage runs in chunks on @p pool; events are still delivered in a
+     * deterministic order on the calling thread. The first call reports every handle as
+     * Opened.
+     *
+     * @param classify Callable invoked as HandleClassification(const HandleTableEntry&),
+     *        concurrently from pool threads; must be thread-safe.
+     * @param sink Callable invoked as sink(const HandleEvent&).
+     * @param pool Pool for the classification stage (nullptr classifies inline).
+     * @return true if a snapshot was taken and diffed. On failure the index is kept, so
+     *         the next successful pass reports changes relative to the last good one.
+     */
+    template <typename Classifier, typename Sink>
+    bool Audit(Classifier&& classify, Sink&& sink, Utils::ThreadPool* pool = &Utils::ThreadPool::Shared()) {
+        Utils::ScopedTimer timer(auditTime_);
+        if (!Snapshot()) {
+            return false;
+        }
+        index_.Update(entries_, entryCount_, classify, sink, pool);
+        return true;
+    }
+
+    /** @brief Index of the handles seen by the last Audit pass. */
+    const HandleIndex& GetIndex() const noexcept { return index_; }
+
+    /**
+     * @brief Image path, signer and trust of handle owners, for use by classifiers.
+     *
+     * @details Thread-safe, so classifiers running on the pool during Audit may call it.
+     * Entries survive across passes and are dropped when their process exits.
+     */
+    ProcessMetadataCache& GetProcessCache() noexcept { return processCache_; }
+
+    /** @brief Entries of the last snapshot. */
+    const HandleTableEntry* GetEntries() const noexcept { return entries_; }
+
+    /** @brief Number of entries in the last snapshot. */
+    size_t GetEntryCount() const noexcept { return entryCount_; }
+
+    /** @brief Current buffer capacity in bytes. */
+    size_t GetCapacity() const noexcept { return capacity_; }
+
+    /** @brief Number of buffer allocations made so far. */
+    uint64_t GetAllocationCount() const noexcept { return allocationCount_; }
+
+    /** @brief NTSTATUS of the last query (0 on success). */
+    LONG GetLastStatus() const noexcept { return lastStatus_; }
+
+private:
+    using NtQuerySystemInformationFn = LONG (NTAPI*)(ULONG, PVOID, ULONG, PULONG);
+
+    /**
+     * @brief Replaces the buffer with one of at least @p required bytes.
+     *
+     * @details The new capacity is max(2 * capacity, required + required / 4), rounded up
+     * to the allocation granularity. The old contents are not preserved.
+     */
+    bool Grow(size_t required);
+
+    /** @brief Releases the buffer. */
+    void Release() noexcept;
+
+    /** @brief Duration of Audit passes ("auditor.audit_ns"), shared by all instances. */
+    static Utils::Histogram auditTime_;
+    static const Utils::MetricRegistration auditTimeMetric_;
+
+    NtQuerySystemInformationFn query_ = nullptr;
+    void* buffer_ = nullptr;
+    size_t capacity_ = 0;
+    const HandleTableEntry* entries_ = nullptr;
+    size_t entryCount_ = 0;
+    size_t lastReturnedLength_ = 0;
+    uint64_t allocationCount_ = 0;
+    LONG lastStatus_ = 0;
+    HandleIndex index_;
+    ProcessMetadataCache processCache_;
+};
+
+} // namespace Internals
+} // namespace Sentinel
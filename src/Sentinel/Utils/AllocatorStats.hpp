@@ -0,0 +1,68 @@
+/**
+ * @file AllocatorStats.hpp
+ * @brief Usage metrics shared by Sentinel's own allocators.
+ *
+ * @details Sentinel runs inside the monitored process, so every heap allocation it makes
+ * competes with the host for the process heap lock, and an allocation made while another
+ * thread faulted inside the heap can deadlock. Long-lived and high-churn memory therefore
+ * comes from Sentinel-owned VirtualAlloc reservations instead:
+ * - Arena: one bump-allocated reservation per subsystem for data built once and freed
+ *   together (decoded and sealed VM programs).
+ * - SlabPool: equal-sized blocks behind a lock-free list, for messages and records that
+ *   are acquired and released at high rates (pipe buffers).
+ * - Both are std::pmr::memory_resource implementations, so std::pmr containers can be
+ *   placed in them without custom allocator types.
+ *
+ * Each allocator can feed an AllocatorStats instance, whose gauges and counter appear in
+ * the metrics registry and therefore in every metrics snapshot.
+ *
+ * @see Arena
+ * @see SlabPool
+ * @see MetricsRegistry
+ */
+
+#pragma once
+
+#include "Sentinel/Utils/Metrics.hpp"
+
+namespace Sentinel {
+namespace Utils {
+
+/**
+ * @brief Registered usage metrics of one allocator or group of allocators.
+ *
+ * @details Several allocators of the same subsystem may share one instance; the gauges
+ * are then totals. Instances must have static storage duration, as the registry keeps
+ * pointers to their members and metric names.
+ *
+ * Usage example:
+ * @code
+ * static AllocatorStats pipeBufferStats("alloc.pipe_buffers.reserved_bytes", "alloc.pipe_buffers.in_use_bytes",
+ *                                       "alloc.pipe_buffers.overflows");
+ * pool.Initialize(64 * 1024, 256, &pipeBufferStats);
+ * @endcode
+ *
+ * @threadsafe All members are atomic metrics.
+ */
+struct AllocatorStats {
+    AllocatorStats(const char* reservedName, const char* inUseName, const char* overflowName) noexcept {
+        MetricsRegistry::Register(reservedName, bytesReserved);
+        MetricsRegistry::Register(inUseName, bytesInUse);
+        MetricsRegistry::Register(overflowName, overflows);
+    }
+
+    AllocatorStats(const AllocatorStats&) = delete;
+    AllocatorStats& operator=(const AllocatorStats&) = delete;
+
+    /** @brief Address space reserved from VirtualAlloc, committed or not. */
+    Gauge bytesReserved;
+
+    /** @brief Bytes handed out and not yet returned (whole blocks for slab pools). */
+    Gauge bytesInUse;
+
+    /** @brief Allocations served by the heap because the reservation could not. */
+    Counter overflows;
+};
+
+} // namespace Utils
+} // namespace Sentinel
@@ -0,0 +1,98 @@
+/**
+ * @file Arena.cpp
+ * @brief Implementation of the VirtualAlloc-backed bump allocator.
+ */
+
+#include "Sentinel/Utils/Arena.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+
+namespace Sentinel {
+namespace Utils {
+
+Arena::~Arena() {
+    if (base_ != nullptr) {
+        VirtualFree(base_, 0, MEM_RELEASE);
+        if (stats_ != nullptr) {
+            stats_->bytesReserved.Add(-static_cast<int64_t>(capacity_));
+            stats_->bytesInUse.Add(-static_cast<int64_t>(used_));
+        }
+    }
+}
+
+bool Arena::Initialize(size_t capacity, AllocatorStats* stats) {
+    if (base_ != nullptr || capacity == 0) {
+        Logger::LogError("Arena: already initialized or zero capacity");
+        return false;
+    }
+    stats_ = stats;
+    capacity = (capacity + COMMIT_GRANULE - 1) & ~(COMMIT_GRANULE - 1);
+    base_ = static_cast<uint8_t*>(VirtualAlloc(nullptr, capacity, MEM_RESERVE, PAGE_NOACCESS));
+    if (base_ == nullptr) {
+        Logger::Error("Arena: cannot reserve {} bytes ({})", capacity, GetLastError());
+        return false;
+    }
+    capacity_ = capacity;
+    if (stats_ != nullptr) {
+        stats_->bytesReserved.Add(static_cast<int64_t>(capacity_));
+    }
+    return true;
+}
+
+void Arena::Reset() noexcept {
+    if (stats_ != nullptr) {
+        stats_->bytesInUse.Add(-static_cast<int64_t>(used_));
+    }
+    used_ = 0;
+}
+
+bool Arena::Commit(size_t end) noexcept {
+    const size_t target = (end + COMMIT_GRANULE - 1) & ~(COMMIT_GRANULE - 1);
+    if (VirtualAlloc(base_ + committed_, target - committed_, MEM_COMMIT, PAGE_READWRITE) == nullptr) {
+        return false;
+    }
+    committed_ = target;
+    return true;
+}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment) {
+    // alignment is a power of two; the reservation itself is 64 KB aligned
+    const size_t begin = (used_ + alignment - 1) & ~(alignment - 1);
+    if (base_ != nullptr && begin <= capacity_ && bytes <= capacity_ - begin &&
+        (begin + bytes <= committed_ || Commit(begin + bytes))) {
+        if (stats_ != nullptr) {
+            stats_->bytesInUse.Add(static_cast<int64_t>(begin + bytes - used_));
+        }
+        used_ = begin + bytes;
+        return base_ + begin;
+    }
+
+    ++overflowCount_;
+    if (stats_ != nullptr) {
+        stats_->overflows.Add();
+    }
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void Arena::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    // The end of the reservation is in range: a zero-byte allocation on a full arena
+    // returns base_ + capacity_, and it must not be handed to the heap
+    uint8_t* block = static_cast<uint8_t*>(pointer);
+    if (base_ == nullptr || block < base_ || block > base_ + capacity_) {
+        std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+        return;
+    }
+    // Freed blocks stay mapped until Reset and beyond, so wipe them: decoded and sealed
+    // programs must not leave readable plaintext behind
+    SecureZeroMemory(block, bytes);
+
+    // Only the most recent allocation can be taken back; the rest waits for Reset
+    if (block + bytes == base_ + used_) {
+        if (stats_ != nullptr) {
+            stats_->bytesInUse.Add(-static_cast<int64_t>(bytes));
+        }
+        used_ -= bytes;
+    }
+}
+
+} // namespace Utils
+} // namespace Sentinel
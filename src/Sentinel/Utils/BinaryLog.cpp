@@ -0,0 +1,577 @@
+/**
+ * @file BinaryLog.cpp
+ * @brief Implementation of binary log encoding, decoding and file output.
+ */
+
+#include "Sentinel/Utils/BinaryLog.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+#include "Sentinel/Utils/Metrics.hpp"
+#include <format>
+#include <mutex>
+#include <unordered_map>
+
+namespace Sentinel {
+namespace Utils {
+
+// Byte offsets of Event record fields (see the layout in BinaryLog.hpp)
+static constexpr size_t OFFSET_SIZE = 0;
+static constexpr size_t OFFSET_TYPE = 2;
+static constexpr size_t OFFSET_LEVEL = 3;
+static constexpr size_t OFFSET_FORMAT_ID = 4;
+static constexpr size_t OFFSET_THREAD_ID = 8;
+static constexpr size_t OFFSET_TIMESTAMP = 12;
+static constexpr size_t OFFSET_ARG_COUNT = 20;
+static constexpr size_t EVENT_HEADER_SIZE = 21;
+
+// Size of the uint16 size + uint8 type prefix shared by all record types
+static constexpr size_t RECORD_PREFIX_SIZE = 3;
+
+// Longest LEB128 encoding of a 64-bit value
+static constexpr size_t MAX_VARINT_SIZE = 10;
+
+// Direct-mapped per-thread cache of format string address -> id
+static constexpr size_t FORMAT_CACHE_SIZE = 64;
+
+template <typename T>
+static void StoreLE(uint8_t* destination, T value) noexcept {
+    // x64 is little-endian; memcpy avoids unaligned-access undefined behaviour
+    std::memcpy(destination, &value, sizeof(T));
+}
+
+template <typename T>
+static T LoadLE(const uint8_t* source) noexcept {
+    T value;
+    std::memcpy(&value, source, sizeof(T));
+    return value;
+}
+
+// ============================================================================
+// LogFormatRegistry
+// ============================================================================
+
+namespace {
+
+struct FormatRegistryState {
+    std::mutex mutex;
+    std::unordered_map<const char*, uint32_t> idsByAddress;
+    std::vector<std::string> formats;
+};
+
+FormatRegistryState& GetRegistryState() {
+    // Function-local static: constructed on first use, safe during static initialization
+    static FormatRegistryState state;
+    return state;
+}
+
+struct FormatCacheEntry {
+    const char* format = nullptr;
+    uint32_t id = 0;
+};
+
+} // namespace
+
+uint32_t LogFormatRegistry::Intern(const char* format) {
+    thread_local FormatCacheEntry cache[FORMAT_CACHE_SIZE];
+
+    // Format strings are literals, so their addresses are at least 1-byte aligned but
+    // often share low bits; drop the low bits before indexing
+    const size_t slot = (reinterpret_cast<uintptr_t>(format) >> 3) & (FORMAT_CACHE_SIZE - 1);
+    if (cache[slot].format == format) {
+        return cache[slot].id;
+    }
+
+    FormatRegistryState& state = GetRegistryState();
+    uint32_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        auto found = state.idsByAddress.find(format);
+        if (found != state.idsByAddress.end()) {
+            id = found->second;
+        } else {
+            id = static_cast<uint32_t>(state.formats.size());
+            state.formats.emplace_back(format);
+            state.idsByAddress.emplace(format, id);
+        }
+    }
+
+    cache[slot].format = format;
+    cache[slot].id = id;
+    return id;
+}
+
+bool LogFormatRegistry::Lookup(uint32_t id, std::string& out) {
+    FormatRegistryState& state = GetRegistryState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (id >= state.formats.size()) {
+        return false;
+    }
+    out = state.formats[id];
+    return true;
+}
+
+// ============================================================================
+// BinaryRecordEncoder
+// ============================================================================
+
+BinaryRecordEncoder::BinaryRecordEncoder(LogLevel level, uint32_t formatId) noexcept {
+    LARGE_INTEGER timestamp;
+    QueryPerformanceCounter(&timestamp);
+
+    buffer_[OFFSET_TYPE] = static_cast<uint8_t>(BinaryRecordType::Event);
+    buffer_[OFFSET_LEVEL] = static_cast<uint8_t>(level);
+    StoreLE<uint32_t>(buffer_ + OFFSET_FORMAT_ID, formatId);
+    StoreLE<uint32_t>(buffer_ + OFFSET_THREAD_ID, GetCurrentThreadId());
+    StoreLE<int64_t>(buffer_ + OFFSET_TIMESTAMP, timestamp.QuadPart);
+    buffer_[OFFSET_ARG_COUNT] = 0;
+    size_ = EVENT_HEADER_SIZE;
+    StoreLE<uint16_t>(buffer_ + OFFSET_SIZE, static_cast<uint16_t>(size_));
+}
+
+bool BinaryRecordEncoder::Reserve(size_t bytes) noexcept {
+    return size_ + bytes <= BINARY_RECORD_MAX_SIZE;
+}
+
+void BinaryRecordEncoder::PutVarint(uint64_t value) noexcept {
+    // Callers reserve MAX_VARINT_SIZE bytes beforehand
+    while (value >= 0x80) {
+        buffer_[size_++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    buffer_[size_++] = static_cast<uint8_t>(value);
+}
+
+void BinaryRecordEncoder::FinishArgument() noexcept {
+    ++argCount_;
+    buffer_[OFFSET_ARG_COUNT] = argCount_;
+    StoreLE<uint16_t>(buffer_ + OFFSET_SIZE, static_cast<uint16_t>(size_));
+}
+
+void BinaryRecordEncoder::AppendSigned(int64_t value) noexcept {
+    if (!Reserve(1 + MAX_VARINT_SIZE)) {
+        return;
+    }
+    // Zigzag encoding keeps small negative numbers short
+    const uint64_t zigzag = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    buffer_[size_++] = static_cast<uint8_t>(BinaryArgTag::SignedInt);
+    PutVarint(zigzag);
+    FinishArgument();
+}
+
+void BinaryRecordEncoder::AppendUnsigned(uint64_t value) noexcept {
+    if (!Reserve(1 + MAX_VARINT_SIZE)) {
+        return;
+    }
+    buffer_[size_++] = static_cast<uint8_t>(BinaryArgTag::UnsignedInt);
+    PutVarint(value);
+    FinishArgument();
+}
+
+void BinaryRecordEncoder::AppendDouble(double value) noexcept {
+    if (!Reserve(1 + sizeof(double))) {
+        return;
+    }
+    buffer_[size_++] = static_cast<uint8_t>(BinaryArgTag::Double);
+    StoreLE<double>(buffer_ + size_, value);
+    size_ += sizeof(double);
+    FinishArgument();
+}
+
+void BinaryRecordEncoder::AppendBool(bool value) noexcept {
+    if (!Reserve(2)) {
+        return;
+    }
+    buffer_[size_++] = static_cast<uint8_t>(BinaryArgTag::Bool);
+    buffer_[size_++] = static_cast<uint8_t>(value ? 1 : 0);
+    FinishArgument();
+}
+
+void BinaryRecordEncoder::AppendChar(char value) noexcept {
+    if (!Reserve(2)) {
+        return;
+    }
+    buffer_[size_++] = static_cast<uint8_t>(BinaryArgTag::Char);
+    buffer_[size_++] = static_cast<uint8_t>(value);
+    FinishArgument();
+}
+
+void BinaryRecordEncoder::AppendString(std::string_view value) noexcept {
+    // Tag plus a two-byte length prefix is the minimum useful encoding
+    if (!Reserve(3)) {
+        return;
+    }
+    // Records are at most 252 bytes, so a string length never needs more than two
+    // varint bytes; truncate to the space that remains
+    size_t length = value.size();
+    const size_t lengthBytes = length < 0x80 ? 1 : 2;
+    const size_t available = BINARY_RECORD_MAX_SIZE - size_ - 1 - lengthBytes;
+    if (length > available) {
+        length = available;
+    }
+
+    buffer_[size_++] = static_cast<uint8_t>(BinaryArgTag::String);
+    PutVarint(length);
+    std::memcpy(buffer_ + size_, value.data(), length);
+    size_ += length;
+    FinishArgument();
+}
+
+void BinaryRecordEncoder::AppendPointer(const void* value) noexcept {
+    if (!Reserve(1 + MAX_VARINT_SIZE)) {
+        return;
+    }
+    buffer_[size_++] = static_cast<uint8_t>(BinaryArgTag::Pointer);
+    PutVarint(reinterpret_cast<uintptr_t>(value));
+    FinishArgument();
+}
+
+// ============================================================================
+// BinaryLogDecoder
+// ============================================================================
+
+static bool ReadVarint(const uint8_t*& cursor, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && cursor < end; shift += 7) {
+        uint8_t byte = *cursor++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BinaryLogDecoder::DecodeEvent(const uint8_t* record, size_t size, DecodedEvent& out) {
+    if (record == nullptr || size < EVENT_HEADER_SIZE ||
+        record[OFFSET_TYPE] != static_cast<uint8_t>(BinaryRecordType::Event)) {
+        return false;
+    }
+
+    const size_t recordSize = LoadLE<uint16_t>(record + OFFSET_SIZE);
+    if (recordSize < EVENT_HEADER_SIZE || recordSize > size) {
+        return false;
+    }
+
+    out.level = static_cast<LogLevel>(record[OFFSET_LEVEL]);
+    out.formatId = LoadLE<uint32_t>(record + OFFSET_FORMAT_ID);
+    out.threadId = LoadLE<uint32_t>(record + OFFSET_THREAD_ID);
+    out.timestamp = LoadLE<int64_t>(record + OFFSET_TIMESTAMP);
+    out.args.clear();
+
+    const uint8_t argCount = record[OFFSET_ARG_COUNT];
+    const uint8_t* cursor = record + EVENT_HEADER_SIZE;
+    const uint8_t* end = record + recordSize;
+
+    for (uint8_t i = 0; i < argCount; ++i) {
+        if (cursor >= end) {
+            return false;
+        }
+        DecodedArg arg{};
+        arg.tag = static_cast<BinaryArgTag>(*cursor++);
+        uint64_t raw = 0;
+
+        switch (arg.tag) {
+            case BinaryArgTag::SignedInt:
+                if (!ReadVarint(cursor, end, raw)) {
+                    return false;
+                }
+                arg.signedValue = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+                break;
+            case BinaryArgTag::UnsignedInt:
+            case BinaryArgTag::Pointer:
+                if (!ReadVarint(cursor, end, raw)) {
+                    return false;
+                }
+                arg.unsignedValue = raw;
+                break;
+            case BinaryArgTag::Double:
+                if (end - cursor < static_cast<ptrdiff_t>(sizeof(double))) {
+                    return false;
+                }
+                arg.doubleValue = LoadLE<double>(cursor);
+                cursor += sizeof(double);
+                break;
+            case BinaryArgTag::Bool:
+            case BinaryArgTag::Char:
+                if (cursor >= end) {
+                    return false;
+                }
+                arg.unsignedValue = *cursor++;
+                break;
+            case BinaryArgTag::String:
+                if (!ReadVarint(cursor, end, raw) || raw > static_cast<uint64_t>(end - cursor)) {
+                    return false;
+                }
+                arg.text = std::string_view(reinterpret_cast<const char*>(cursor), static_cast<size_t>(raw));
+                cursor += raw;
+                break;
+            default:
+                return false;
+        }
+        out.args.push_back(arg);
+    }
+    return true;
+}
+
+static std::string FormatArgument(const DecodedArg& arg, std::string_view spec) {
+    // Re-create a single replacement field so std::format applies the original spec
+    std::string field;
+    field.reserve(spec.size() + 3);
+    field += "{:";
+    field += spec;
+    field += '}';
+
+    try {
+        switch (arg.tag) {
+            case BinaryArgTag::SignedInt: {
+                long long value = arg.signedValue;
+                return std::vformat(field, std::make_format_args(value));
+            }
+            case BinaryArgTag::UnsignedInt: {
+                unsigned long long value = arg.unsignedValue;
+                return std::vformat(field, std::make_format_args(value));
+            }
+            case BinaryArgTag::Double: {
+                double value = arg.doubleValue;
+                return std::vformat(field, std::make_format_args(value));
+            }
+            case BinaryArgTag::Bool: {
+                bool value = arg.unsignedValue != 0;
+                return std::vformat(field, std::make_format_args(value));
+            }
+            case BinaryArgTag::Char: {
+                char value = static_cast<char>(arg.unsignedValue);
+                return std::vformat(field, std::make_format_args(value));
+            }
+            case BinaryArgTag::String: {
+                std::string_view value = arg.text;
+                return std::vformat(field, std::make_format_args(value));
+            }
+            case BinaryArgTag::Pointer: {
+                const void* value = reinterpret_cast<const void*>(static_cast<uintptr_t>(arg.unsignedValue));
+                return std::vformat(field, std::make_format_args(value));
+            }
+            default:
+                break;
+        }
+    } catch (const std::format_error&) {
+        // Spec does not apply to this argument type; fall through to the raw field
+    }
+
+    std::string raw = "{";
+    if (!spec.empty()) {
+        raw += ':';
+        raw += spec;
+    }
+    raw += '}';
+    return raw;
+}
+
+std::string BinaryLogDecoder::FormatEvent(std::string_view format, const std::vector<DecodedArg>& args) {
+    std::string result;
+    result.reserve(format.size() + args.size() * 8);
+    size_t nextArg = 0;
+
+    for (size_t i = 0; i < format.size(); ++i) {
+        const char c = format[i];
+        if (c == '{') {
+            if (i + 1 < format.size() && format[i + 1] == '{') {
+                result += '{';
+                ++i;
+                continue;
+            }
+            const size_t close = format.find('}', i + 1);
+            if (close == std::string_view::npos) {
+                result.append(format.substr(i));
+                break;
+            }
+
+            // Field content: [index][:spec]
+            std::string_view field = format.substr(i + 1, close - i - 1);
+            const size_t colon = field.find(':');
+            std::string_view indexText = field.substr(0, colon);
+            std::string_view spec = (colon == std::string_view::npos) ? std::string_view() : field.substr(colon + 1);
+
+            size_t argIndex = nextArg++;
+            if (!indexText.empty()) {
+                argIndex = 0;
+                for (char digit : indexText) {
+                    argIndex = argIndex * 10 + static_cast<size_t>(digit - '0');
+                }
+            }
+
+            if (argIndex < args.size()) {
+                result += FormatArgument(args[argIndex], spec);
+            } else {
+                result.append(format.substr(i, close - i + 1));
+            }
+            i = close;
+        } else if (c == '}' && i + 1 < format.size() && format[i + 1] == '}') {
+            result += '}';
+            ++i;
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+// ============================================================================
+// BinaryLogWriter
+// ============================================================================
+
+// Events lost to failed or short writes of the binary log file, shared by all writers
+static Counter lostEvents;
+static const MetricRegistration lostEventsMetric("logger.binary_lost", lostEvents);
+
+BinaryLogWriter::~BinaryLogWriter() {
+    Close();
+}
+
+bool BinaryLogWriter::Open(const std::wstring& path) {
+    Close();
+
+    // Every session appends behind previous ones; the decoder resets its format table
+    // whenever it encounters a new file header. Write access rather than FILE_APPEND_DATA
+    // alone, so that a failed flush can cut the file back to its last complete record.
+    file_ = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                        OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER end;
+    const LARGE_INTEGER zero{};
+    if (!SetFilePointerEx(file_, zero, &end, FILE_END)) {
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+        return false;
+    }
+    fileEnd_ = end.QuadPart;
+
+    buffer_.clear();
+    buffer_.reserve(BUFFER_CAPACITY);
+    bufferedEvents_ = 0;
+    definedFormats_.clear();
+
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+    FILETIME fileTime;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&now);
+    GetSystemTimeAsFileTime(&fileTime);
+
+    BinaryLogFileHeader header{};
+    std::memcpy(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic));
+    header.version = BINARY_LOG_VERSION;
+    header.processId = GetCurrentProcessId();
+    header.qpcFrequency = frequency.QuadPart;
+    header.qpcAtOpen = now.QuadPart;
+    header.fileTimeAtOpen = (static_cast<uint64_t>(fileTime.dwHighDateTime) << 32) | fileTime.dwLowDateTime;
+    AppendBytes(&header, sizeof(header));
+    if (!Flush()) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void BinaryLogWriter::Close() {
+    if (file_ == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    Flush();
+    CloseHandle(file_);
+    file_ = INVALID_HANDLE_VALUE;
+}
+
+void BinaryLogWriter::AppendEvent(const uint8_t* record, size_t size) {
+    if (file_ == INVALID_HANDLE_VALUE || size < EVENT_HEADER_SIZE) {
+        return;
+    }
+
+    // Emit the format definition the first time this file sees the id
+    const uint32_t formatId = LoadLE<uint32_t>(record + OFFSET_FORMAT_ID);
+    std::string format;
+    if ((formatId >= definedFormats_.size() || !definedFormats_[formatId]) &&
+        LogFormatRegistry::Lookup(formatId, format)) {
+        const size_t maxText = 0xFFFF - RECORD_PREFIX_SIZE - sizeof(uint32_t);
+        if (format.size() > maxText) {
+            format.resize(maxText);
+        }
+    }
+    const size_t definitionSize = format.empty() ? 0 : RECORD_PREFIX_SIZE + sizeof(uint32_t) + format.size();
+
+    // Flush before the definition and the event rather than between them, so the buffer
+    // only ever holds whole records
+    if (buffer_.size() + definitionSize + size > BUFFER_CAPACITY) {
+        Flush();
+    }
+    if (formatId >= definedFormats_.size() || !definedFormats_[formatId]) {
+        if (definitionSize != 0) {
+            uint8_t prefix[RECORD_PREFIX_SIZE + sizeof(uint32_t)];
+            StoreLE<uint16_t>(prefix, static_cast<uint16_t>(definitionSize));
+            prefix[OFFSET_TYPE] = static_cast<uint8_t>(BinaryRecordType::FormatDefinition);
+            StoreLE<uint32_t>(prefix + RECORD_PREFIX_SIZE, formatId);
+            AppendBytes(prefix, sizeof(prefix));
+            AppendBytes(format.data(), format.size());
+        }
+        if (formatId >= definedFormats_.size()) {
+            definedFormats_.resize(static_cast<size_t>(formatId) + 1, false);
+        }
+        definedFormats_[formatId] = true;
+    }
+
+    AppendBytes(record, size);
+    ++bufferedEvents_;
+}
+
+void BinaryLogWriter::AppendBytes(const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    buffer_.insert(buffer_.end(), bytes, bytes + size);
+}
+
+bool BinaryLogWriter::Flush() {
+    if (file_ == INVALID_HANDLE_VALUE || buffer_.empty()) {
+        return true;
+    }
+
+    // A short write is continued from where it stopped
+    const uint8_t* data = buffer_.data();
+    size_t remaining = buffer_.size();
+    while (remaining > 0) {
+        DWORD written = 0;
+        if (!WriteFile(file_, data, static_cast<DWORD>(remaining), &written, nullptr) || written == 0) {
+            break;
+        }
+        data += written;
+        remaining -= written;
+    }
+    if (remaining == 0) {
+        fileEnd_ += static_cast<LONGLONG>(buffer_.size());
+        buffer_.clear();
+        bufferedEvents_ = 0;
+        return true;
+    }
+
+    // Drop the whole buffer and cut off whatever part of it reached the file, so the file
+    // still ends on a record boundary. Definitions in the buffer are lost with it and are
+    // emitted again by the next event that needs them.
+    lostEvents.Add(bufferedEvents_);
+    buffer_.clear();
+    bufferedEvents_ = 0;
+    definedFormats_.clear();
+    LARGE_INTEGER end;
+    end.QuadPart = fileEnd_;
+    if (!SetFilePointerEx(file_, end, nullptr, FILE_BEGIN) || !SetEndOfFile(file_)) {
+        // A partial record is left behind; stop writing rather than append after it
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+    }
+    return false;
+}
+
+uint64_t BinaryLogWriter::GetLostEventCount() noexcept {
+    return lostEvents.Get();
+}
+
+} // namespace Utils
+} // namespace Sentinel
@@ -0,0 +1,317 @@
+/**
+ * @file BinaryLog.hpp
+ * @brief Compact binary log records with deferred (offline) formatting.
+ *
+ * @details This module exists because Sentinel's telemetry pipeline used to parse the
+ * Logger's text output back into structured data. That costs twice: hot threads pay for
+ * string formatting, and the pipeline pays again to undo it. In binary mode a log call
+ * stores only what is needed to reconstruct the line later:
+ * - QueryPerformanceCounter timestamp and thread id
+ * - Severity
+ * - A format-string id (the format text itself is written once per file)
+ * - The raw argument values, tagged by type
+ *
+ * Text is produced offline by the SentinelLogDecode tool (or on the consumer thread when
+ * errors are mirrored to the console), using the same "{}" replacement-field syntax as
+ * std::format so that call sites read identically in both modes.
+ *
+ * File layout (all integers little-endian):
+ * @code
+ * BinaryLogFileHeader
+ * { record }*
+ *   record := uint16 size | uint8 type | payload
+ *   FormatDefinition payload := uint32 id | bytes[size - 7]
+ *   Event payload := uint8 level | uint32 formatId | uint32 threadId | int64 qpc |
+ *                    uint8 argCount | { uint8 tag | value }*
+ * @endcode
+ * Integer arguments are zigzag/LEB128 varints, so small values take one or two bytes.
+ *
+ * @security Arguments are stored as raw values. Anything that would be sanitized in text
+ * (e.g. pointer values) must be sanitized by the caller before logging, exactly as in
+ * text mode. The format table in each file is plain text.
+ *
+ * @performance Encoding is a handful of stores into a stack buffer; the format id is
+ * resolved through a thread-local direct-mapped cache, falling back to a mutex-protected
+ * registry only the first time a thread uses a format string.
+ *
+ * @see Logger::EnableBinaryLog
+ */
+
+#pragma once
+
+#include <Windows.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace Sentinel {
+namespace Utils {
+
+enum class LogLevel : uint8_t;
+
+/** @brief Magic bytes at the start of every binary log file. */
+inline constexpr char BINARY_LOG_MAGIC[8] = {'S', 'N', 'T', 'L', 'B', 'L', 'O', 'G'};
+
+/** @brief Current binary log format version (2: Debug/Info/Warning/Error level values). */
+inline constexpr uint32_t BINARY_LOG_VERSION = 2;
+
+/** @brief Maximum encoded size of one record, including its size/type prefix. */
+inline constexpr size_t BINARY_RECORD_MAX_SIZE = 252;
+
+#pragma pack(push, 1)
+/**
+ * @brief Fixed header written once at the start of a binary log file.
+ *
+ * @details Carries what the decoder needs to turn raw QPC ticks into wall-clock time.
+ */
+struct BinaryLogFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t processId;
+    int64_t qpcFrequency;
+    int64_t qpcAtOpen;
+    uint64_t fileTimeAtOpen;
+};
+#pragma pack(pop)
+
+/**
+ * @brief Record type discriminator.
+ */
+enum class BinaryRecordType : uint8_t {
+    FormatDefinition = 1,
+    Event = 2
+};
+
+/**
+ * @brief Type tag stored before each argument value.
+ */
+enum class BinaryArgTag : uint8_t {
+    SignedInt = 1,
+    UnsignedInt = 2,
+    Double = 3,
+    Bool = 4,
+    Char = 5,
+    String = 6,
+    Pointer = 7
+};
+
+/**
+ * @class LogFormatRegistry
+ * @brief Assigns stable numeric ids to format strings.
+ *
+ * @details Ids are keyed by the format string's address, which is why format strings
+ * passed to the structured logging API must have static storage duration (string
+ * literals). The text is copied into the registry on first use so the consumer thread and
+ * decoder never dereference caller memory.
+ *
+ * @threadsafe All methods are thread-safe.
+ */
+class LogFormatRegistry {
+public:
+    /**
+     * @brief Returns the id for @p format, registering it on first use.
+     *
+     * @performance A thread-local cache hit costs one hash and one compare.
+     */
+    static uint32_t Intern(const char* format);
+
+    /**
+     * @brief Copies the text registered under @p id into @p out.
+     *
+     * @return false if @p id is unknown.
+     */
+    static bool Lookup(uint32_t id, std::string& out);
+};
+
+/**
+ * @class BinaryRecordEncoder
+ * @brief Builds one Event record in a fixed stack buffer.
+ *
+ * @details Arguments that do not fit are dropped (and the record marked as truncated by a
+ * lower argCount); strings are shortened to the remaining space. The encoder never
+ * allocates.
+ *
+ * Usage example:
+ * @code
+ * BinaryRecordEncoder encoder(LogLevel::Info, LogFormatRegistry::Intern("Thread {} - {}"));
+ * encoder.Append(threadId);
+ * encoder.Append(message);
+ * writer.Append(encoder.Data(), encoder.Size());
+ * @endcode
+ */
+class BinaryRecordEncoder {
+public:
+    BinaryRecordEncoder(LogLevel level, uint32_t formatId) noexcept;
+
+    void AppendSigned(int64_t value) noexcept;
+    void AppendUnsigned(uint64_t value) noexcept;
+    void AppendDouble(double value) noexcept;
+    void AppendBool(bool value) noexcept;
+    void AppendChar(char value) noexcept;
+    void AppendString(std::string_view value) noexcept;
+    void AppendPointer(const void* value) noexcept;
+
+    /**
+     * @brief Encodes any supported argument type by dispatching on its category.
+     */
+    template <typename T>
+    void Append(const T& value) noexcept {
+        using Decayed = std::remove_cvref_t<T>;
+        if constexpr (std::is_same_v<Decayed, bool>) {
+            AppendBool(value);
+        } else if constexpr (std::is_same_v<Decayed, char>) {
+            AppendChar(value);
+        } else if constexpr (std::is_integral_v<Decayed> && std::is_signed_v<Decayed>) {
+            AppendSigned(static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral_v<Decayed> || std::is_enum_v<Decayed>) {
+            AppendUnsigned(static_cast<uint64_t>(value));
+        } else if constexpr (std::is_floating_point_v<Decayed>) {
+            AppendDouble(static_cast<double>(value));
+        } else if constexpr (std::is_same_v<Decayed, const char*> || std::is_same_v<Decayed, char*>) {
+            AppendString(value != nullptr ? std::string_view(value) : std::string_view("(null)"));
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            AppendString(std::string_view(value));
+        } else if constexpr (std::is_pointer_v<Decayed>) {
+            AppendPointer(static_cast<const void*>(value));
+        } else {
+            static_assert(std::is_same_v<Decayed, void>, "Unsupported binary log argument type");
+        }
+    }
+
+    /** @brief Encoded record bytes (valid after the last Append). */
+    const uint8_t* Data() const noexcept { return buffer_; }
+
+    /** @brief Encoded record size in bytes. */
+    size_t Size() const noexcept { return size_; }
+
+private:
+    bool Reserve(size_t bytes) noexcept;
+    void PutVarint(uint64_t value) noexcept;
+    void FinishArgument() noexcept;
+
+    uint8_t buffer_[BINARY_RECORD_MAX_SIZE];
+    size_t size_ = 0;
+    uint8_t argCount_ = 0;
+};
+
+/**
+ * @brief One argument decoded from an Event record.
+ */
+struct DecodedArg {
+    BinaryArgTag tag;
+    int64_t signedValue;
+    uint64_t unsignedValue;
+    double doubleValue;
+    std::string_view text;
+};
+
+/**
+ * @brief A decoded Event record. String arguments point into the source buffer.
+ */
+struct DecodedEvent {
+    LogLevel level;
+    uint32_t formatId;
+    uint32_t threadId;
+    int64_t timestamp;
+    std::vector<DecodedArg> args;
+};
+
+/**
+ * @class BinaryLogDecoder
+ * @brief Parses records and renders events to text.
+ *
+ * @details Shared by the offline decoder tool and by the Logger's consumer thread (to
+ * mirror errors to the console), so both produce byte-identical text.
+ */
+class BinaryLogDecoder {
+public:
+    /**
+     * @brief Parses an Event record (including its size/type prefix).
+     *
+     * @return false if the record is malformed or not an Event.
+     */
+    static bool DecodeEvent(const uint8_t* record, size_t size, DecodedEvent& out);
+
+    /**
+     * @brief Substitutes decoded arguments into a "{}"-style format string.
+     *
+     * @details Supports automatic ("{}") and manual ("{0}") indexing and standard format
+     * specs ("{:08X}"). Fields without a matching argument are emitted verbatim.
+     */
+    static std::string FormatEvent(std::string_view format, const std::vector<DecodedArg>& args);
+};
+
+/**
+ * @class BinaryLogWriter
+ * @brief Appends binary records to a file through a write-behind buffer.
+ *
+ * @details Format definitions are emitted lazily: the first event that uses a format id
+ * in this file is preceded by that id's definition, so every file is self-describing.
+ * The buffer holds whole records only, so a failed write never leaves half a record in
+ * the file.
+ *
+ * @threadsafe Not thread-safe; the Logger serializes access with its console mutex.
+ */
+class BinaryLogWriter {
+public:
+    BinaryLogWriter() = default;
+    ~BinaryLogWriter();
+
+    BinaryLogWriter(const BinaryLogWriter&) = delete;
+    BinaryLogWriter& operator=(const BinaryLogWriter&) = delete;
+
+    /**
+     * @brief Opens (appending to) @p path and writes a file header.
+     */
+    bool Open(const std::wstring& path);
+
+    /**
+     * @brief Flushes buffered records and closes the file.
+     */
+    void Close();
+
+    /** @brief true while a file is open. */
+    bool IsOpen() const noexcept { return file_ != INVALID_HANDLE_VALUE; }
+
+    /**
+     * @brief Appends an encoded Event record, emitting its format definition if needed.
+     */
+    void AppendEvent(const uint8_t* record, size_t size);
+
+    /**
+     * @brief Writes buffered records to the file.
+     *
+     * @return false if the write failed or stayed short. The buffered events are then
+     *         dropped and counted (GetLostEventCount), and the file is cut back to its last
+     *         complete record; if even that fails, the file is closed.
+     */
+    bool Flush();
+
+    /**
+     * @brief Events lost to failed writes, by all writers ("logger.binary_lost").
+     *
+     * @threadsafe Thread-safe.
+     */
+    static uint64_t GetLostEventCount() noexcept;
+
+private:
+    void AppendBytes(const void* data, size_t size);
+
+    static constexpr size_t BUFFER_CAPACITY = 64 * 1024;
+
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+
+    // File size up to the last complete flush; a failed flush truncates back to it
+    LONGLONG fileEnd_ = 0;
+
+    std::vector<uint8_t> buffer_;
+    size_t bufferedEvents_ = 0;
+    std::vector<bool> definedFormats_;
+};
+
+} // namespace Utils
+} // namespace Sentinel
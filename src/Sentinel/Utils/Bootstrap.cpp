@@ -0,0 +1,285 @@
+/**
+ * @file Bootstrap.cpp
+ * @brief Implementation of the subsystem startup orchestrator.
+ */
+
+#include "Sentinel/Utils/Bootstrap.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+#include <cstring>
+
+namespace Sentinel {
+namespace Utils {
+
+// Attach time of the last Start, for metrics snapshots
+static Gauge attachTime;
+static const MetricRegistration attachTimeMetric("bootstrap.attach_ns", attachTime);
+
+static LONGLONG Now() noexcept {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+static const char* StateName(SubsystemState state) noexcept {
+    switch (state) {
+        case SubsystemState::Pending:
+            return "not run yet";
+        case SubsystemState::Running:
+            return "running";
+        case SubsystemState::Succeeded:
+            return "ok";
+        case SubsystemState::Failed:
+            return "FAILED";
+        case SubsystemState::Skipped:
+            return "skipped";
+        default:
+            return "unknown";
+    }
+}
+
+Bootstrap::~Bootstrap() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_.wait(lock, [this]() { return outstanding_ == 0 && backgroundTasks_ == 0; });
+}
+
+size_t Bootstrap::Find(const char* name) const noexcept {
+    for (size_t i = 0; i < subsystems_.size(); ++i) {
+        if (std::strcmp(subsystems_[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return SIZE_MAX;
+}
+
+bool Bootstrap::Add(const char* name, std::initializer_list<const char*> dependencies, InitFunction initialize,
+                    StartupMode mode) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (started_ || name == nullptr || Find(name) != SIZE_MAX) {
+        Logger::Error("Bootstrap: cannot add subsystem {} (duplicate, or startup already began)",
+                      name != nullptr ? name : "(null)");
+        return false;
+    }
+    Subsystem subsystem{name, {}, {}, std::move(initialize), SubsystemTiming{}};
+    subsystem.timing.name = name;
+    subsystem.timing.mode = mode;
+    for (const char* dependency : dependencies) {
+        const size_t index = Find(dependency);
+        if (index == SIZE_MAX) {
+            Logger::Error("Bootstrap: {} depends on {}, which is not declared before it", name, dependency);
+            return false;
+        }
+        subsystem.dependencies.push_back(index);
+    }
+    for (const size_t dependency : subsystem.dependencies) {
+        subsystems_[dependency].dependents.push_back(subsystems_.size());
+    }
+    subsystems_.push_back(std::move(subsystem));
+    return true;
+}
+
+bool Bootstrap::Run(size_t index) {
+    Subsystem& subsystem = subsystems_[index];
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_.wait(lock, [&subsystem]() { return subsystem.timing.state != SubsystemState::Running; });
+    if (subsystem.timing.state != SubsystemState::Pending) {
+        return subsystem.timing.state == SubsystemState::Succeeded;
+    }
+    for (const size_t dependency : subsystem.dependencies) {
+        if (subsystems_[dependency].timing.state != SubsystemState::Succeeded) {
+            subsystem.timing.state = SubsystemState::Skipped;
+            lock.unlock();
+            finished_.notify_all();
+            Logger::Error("Bootstrap: {} not started, {} did not succeed", subsystem.name,
+                          subsystems_[dependency].name);
+            return false;
+        }
+    }
+    subsystem.timing.state = SubsystemState::Running;
+    if (origin_ == 0) {
+        origin_ = Now();
+    }
+    const LONGLONG origin = origin_;
+    lock.unlock();
+
+    const LONGLONG start = Now();
+    const bool succeeded = subsystem.initialize();
+    const LONGLONG end = Now();
+
+    lock.lock();
+    subsystem.timing.state = succeeded ? SubsystemState::Succeeded : SubsystemState::Failed;
+    subsystem.timing.startNs = TicksToNanoseconds(start - origin);
+    subsystem.timing.durationNs = TicksToNanoseconds(end - start);
+    subsystem.timing.threadId = GetCurrentThreadId();
+    lock.unlock();
+    finished_.notify_all();
+    if (!succeeded) {
+        Logger::Error("Bootstrap: {} failed to initialize", subsystem.name);
+    }
+    return succeeded;
+}
+
+bool Bootstrap::RunWithDependencies(size_t index) {
+    // Declaration order is topological, so this recursion terminates
+    for (const size_t dependency : subsystems_[index].dependencies) {
+        RunWithDependencies(dependency);
+    }
+    return Run(index);
+}
+
+bool Bootstrap::Require(const char* name) {
+    const size_t index = Find(name);
+    if (index == SIZE_MAX) {
+        Logger::Error("Bootstrap: unknown subsystem {}", name);
+        return false;
+    }
+    return RunWithDependencies(index);
+}
+
+void Bootstrap::RunScheduled(size_t index, ThreadPool* pool) {
+    Run(index);
+
+    std::vector<size_t> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const size_t dependent : subsystems_[index].dependents) {
+            if (scheduled_[dependent] && --unfinishedDependencies_[dependent] == 0) {
+                ready.push_back(dependent);
+            }
+        }
+        // Notified under the lock: once it is released ~Bootstrap may return and destroy finished_
+        --outstanding_;
+        finished_.notify_all();
+    }
+    for (const size_t next : ready) {
+        pool->Submit([this, next, pool]() { RunScheduled(next, pool); });
+    }
+}
+
+bool Bootstrap::Start(ThreadPool* pool) {
+    const LONGLONG begin = Now();
+
+    // Eager subsystems and everything they depend on, found in reverse declaration order
+    std::vector<bool> needed(subsystems_.size(), false);
+    for (size_t i = subsystems_.size(); i-- > 0;) {
+        needed[i] = needed[i] || subsystems_[i].timing.mode == StartupMode::Eager;
+        if (needed[i]) {
+            for (const size_t dependency : subsystems_[i].dependencies) {
+                needed[dependency] = true;
+            }
+        }
+    }
+
+    std::vector<size_t> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (started_) {
+            Logger::LogError("Bootstrap: Start called twice");
+            return false;
+        }
+        started_ = true;
+        if (origin_ == 0) {
+            origin_ = begin;
+        }
+        if (pool != nullptr) {
+            scheduled_ = needed;
+            unfinishedDependencies_.assign(subsystems_.size(), 0);
+            for (size_t i = 0; i < subsystems_.size(); ++i) {
+                if (needed[i]) {
+                    unfinishedDependencies_[i] = subsystems_[i].dependencies.size();
+                    ++outstanding_;
+                    if (unfinishedDependencies_[i] == 0) {
+                        ready.push_back(i);
+                    }
+                }
+            }
+        }
+    }
+
+    if (pool == nullptr) {
+        for (size_t i = 0; i < subsystems_.size(); ++i) {
+            if (needed[i]) {
+                Run(i);
+            }
+        }
+    } else {
+        for (const size_t index : ready) {
+            pool->Submit([this, index, pool]() { RunScheduled(index, pool); });
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        finished_.wait(lock, [this]() { return outstanding_ == 0; });
+    }
+
+    attachNs_ = TicksToNanoseconds(Now() - begin);
+    attachTime.Set(static_cast<int64_t>(attachNs_));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Subsystem& subsystem : subsystems_) {
+        if (subsystem.timing.mode == StartupMode::Eager && subsystem.timing.state != SubsystemState::Succeeded) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Bootstrap::RunDeferred(ThreadPool* pool) {
+    std::vector<size_t> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < subsystems_.size(); ++i) {
+            if (subsystems_[i].timing.mode == StartupMode::Deferred &&
+                subsystems_[i].timing.state == SubsystemState::Pending) {
+                pending.push_back(i);
+            }
+        }
+        backgroundTasks_ += pending.size();
+    }
+    for (const size_t index : pending) {
+        pool->Submit([this, index]() {
+            RunWithDependencies(index);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --backgroundTasks_;
+                finished_.notify_all();
+            }
+        });
+    }
+}
+
+SubsystemState Bootstrap::GetState(const char* name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t index = Find(name);
+    return index != SIZE_MAX ? subsystems_[index].timing.state : SubsystemState::Pending;
+}
+
+std::vector<SubsystemTiming> Bootstrap::GetTimings() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<SubsystemTiming> timings;
+    timings.reserve(subsystems_.size());
+    for (const Subsystem& subsystem : subsystems_) {
+        timings.push_back(subsystem.timing);
+    }
+    return timings;
+}
+
+void Bootstrap::ReportTimings() const {
+    const std::vector<SubsystemTiming> timings = GetTimings();
+    uint64_t workNs = 0;
+    for (const SubsystemTiming& timing : timings) {
+        workNs += timing.durationNs;
+    }
+    Logger::Info("Startup: attached in {} us, {} us of initialization across {} subsystems", attachNs_ / 1000,
+                 workNs / 1000, timings.size());
+    for (const SubsystemTiming& timing : timings) {
+        if (timing.state == SubsystemState::Pending) {
+            Logger::Info("Startup:   {} ({}): {}", timing.name,
+                         timing.mode == StartupMode::Eager ? "eager" : "deferred", StateName(timing.state));
+            continue;
+        }
+        Logger::Info("Startup:   {} ({}): {} at +{} us, {} us on thread {}", timing.name,
+                     timing.mode == StartupMode::Eager ? "eager" : "deferred", StateName(timing.state),
+                     timing.startNs / 1000, timing.durationNs / 1000, timing.threadId);
+    }
+}
+
+} // namespace Utils
+} // namespace Sentinel
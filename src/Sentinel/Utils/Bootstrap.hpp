@@ -0,0 +1,211 @@
+/**
+ * @file Bootstrap.hpp
+ * @brief Dependency-ordered, parallel and lazy startup of Sentinel's subsystems.
+ *
+ * @details Attaching to a short-lived target has to be fast, but a full startup loads
+ * ntdll exports, takes a first handle snapshot, decrypts VM bytecode, loads symbols and
+ * creates pipes. Run one after the other, the slowest steps add up even though most of
+ * them do not depend on each other. Bootstrap takes a declaration of every subsystem and
+ * the subsystems it needs, then:
+ * - Start runs the eager subsystems on the thread pool, each as soon as its dependencies
+ *   have succeeded, so independent subsystems initialize concurrently and attach time is
+ *   the longest dependency chain rather than the sum.
+ * - Deferred subsystems (first full audit, symbol loading) do not delay attach. They run
+ *   when first Required, or in the background once RunDeferred is called.
+ * - A subsystem whose dependency failed is not started and is reported as skipped.
+ * - Every subsystem's start offset, duration and thread are kept, and ReportTimings logs
+ *   them along with the total attach time.
+ *
+ * Dependencies must be declared before their dependents, so the declaration order is a
+ * valid startup order and cycles cannot be expressed.
+ *
+ * @see ThreadPool
+ */
+
+#pragma once
+
+#include "Sentinel/Utils/Metrics.hpp"
+#include "Sentinel/Utils/ThreadPool.hpp"
+#include <Windows.h>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <vector>
+
+namespace Sentinel {
+namespace Utils {
+
+/**
+ * @brief When Bootstrap initializes a subsystem.
+ */
+enum class StartupMode : uint8_t {
+    /** @brief During Start; attach waits for it. */
+    Eager = 0,
+
+    /** @brief On first Require, or in the background after RunDeferred. */
+    Deferred = 1
+};
+
+/**
+ * @brief Progress of one subsystem.
+ */
+enum class SubsystemState : uint8_t {
+    Pending = 0,
+    Running = 1,
+    Succeeded = 2,
+    Failed = 3,
+
+    /** @brief Not started because a dependency failed or was skipped. */
+    Skipped = 4
+};
+
+/**
+ * @brief Startup timing of one subsystem, in nanoseconds since Start was called.
+ */
+struct SubsystemTiming {
+    const char* name = nullptr;
+    StartupMode mode = StartupMode::Eager;
+    SubsystemState state = SubsystemState::Pending;
+    uint64_t startNs = 0;
+    uint64_t durationNs = 0;
+    DWORD threadId = 0;
+};
+
+/**
+ * @class Bootstrap
+ * @brief Initializes declared subsystems in dependency order, concurrently where possible.
+ *
+ * Usage example:
+ * @code
+ * Bootstrap bootstrap;
+ * bootstrap.Add("etw", {}, []() { return EtwTrace::Register(); });
+ * bootstrap.Add("logger", {}, []() { return Logger::EnableAsync(); });
+ * bootstrap.Add("auditor", {"logger"}, [&]() { return auditor.Initialize(); });
+ * bootstrap.Add("first-audit", {"auditor"}, [&]() { return auditor.Snapshot(); }, StartupMode::Deferred);
+ * if (!bootstrap.Start()) {
+ *     Logger::LogError("Startup incomplete");
+ * }
+ * bootstrap.ReportTimings();
+ * bootstrap.RunDeferred();
+ * // Later, wherever the first snapshot is needed:
+ * bootstrap.Require("first-audit");
+ * @endcode
+ *
+ * @threadsafe Add must complete before Start. Start, Require, RunDeferred and the
+ * accessors are thread-safe. Initialization functions may run on pool workers and must
+ * not call Require for a subsystem that depends on their own.
+ */
+class Bootstrap {
+public:
+    /** @brief Initialization function of a subsystem; returns false on failure. */
+    using InitFunction = std::function<bool()>;
+
+    Bootstrap() = default;
+
+    /**
+     * @brief Waits for deferred subsystems still running in the background.
+     */
+    ~Bootstrap();
+
+    Bootstrap(const Bootstrap&) = delete;
+    Bootstrap& operator=(const Bootstrap&) = delete;
+
+    /**
+     * @brief Declares subsystem @p name.
+     *
+     * @param name Unique name; must outlive the Bootstrap (a string literal).
+     * @param dependencies Names of previously declared subsystems that must succeed first.
+     * @param initialize Called once, on a pool worker or on the thread that Requires it.
+     * @param mode Eager subsystems run during Start, deferred ones on demand.
+     * @return false (and logs) if the name is taken, a dependency is unknown or Start
+     *         has already been called.
+     */
+    bool Add(const char* name, std::initializer_list<const char*> dependencies, InitFunction initialize,
+             StartupMode mode = StartupMode::Eager);
+
+    /**
+     * @brief Initializes every eager subsystem (and anything it depends on) and waits.
+     *
+     * @param pool Pool to run independent subsystems on, or nullptr to run them on the
+     *        calling thread in declaration order. Must not be called from a worker of
+     *        @p pool.
+     * @return true if every eager subsystem succeeded.
+     */
+    bool Start(ThreadPool* pool = &ThreadPool::Shared());
+
+    /**
+     * @brief Initializes @p name and its dependencies on the calling thread unless they
+     * already ran, waiting for any that another thread is running.
+     *
+     * @details May be called before Start to run a subsystem ahead of all others (the
+     * crash handler, for one); Start then treats it as already done.
+     *
+     * @return true if @p name has succeeded; false if it or a dependency failed, or the
+     *         name is unknown.
+     */
+    bool Require(const char* name);
+
+    /**
+     * @brief Queues every deferred subsystem that has not run yet on @p pool and returns
+     * without waiting.
+     */
+    void RunDeferred(ThreadPool* pool = &ThreadPool::Shared());
+
+    /** @brief Current state of @p name (Pending for unknown names). */
+    SubsystemState GetState(const char* name) const;
+
+    /** @brief Timing of every declared subsystem, in declaration order. */
+    std::vector<SubsystemTiming> GetTimings() const;
+
+    /** @brief Wall time of Start, from call to return. */
+    uint64_t GetAttachNs() const noexcept { return attachNs_; }
+
+    /**
+     * @brief Logs the attach time and one line per subsystem that has run or failed.
+     */
+    void ReportTimings() const;
+
+private:
+    struct Subsystem {
+        const char* name;
+        std::vector<size_t> dependencies;
+        std::vector<size_t> dependents;
+        InitFunction initialize;
+        SubsystemTiming timing;
+    };
+
+    /** @brief Index of @p name, or SIZE_MAX. */
+    size_t Find(const char* name) const noexcept;
+
+    /**
+     * @brief Runs subsystem @p index once its dependencies have finished, or waits for
+     * the thread already running it.
+     */
+    bool Run(size_t index);
+
+    /** @brief Requires every dependency of @p index, then runs it. */
+    bool RunWithDependencies(size_t index);
+
+    /** @brief Pool task of Start: runs @p index, then queues dependents that became ready. */
+    void RunScheduled(size_t index, ThreadPool* pool);
+
+    std::vector<Subsystem> subsystems_;
+    mutable std::mutex mutex_;
+    std::condition_variable finished_;
+
+    // Start's scheduling state, guarded by mutex_
+    std::vector<size_t> unfinishedDependencies_;
+    std::vector<bool> scheduled_;
+    size_t outstanding_ = 0;
+    size_t backgroundTasks_ = 0;
+    bool started_ = false;
+
+    LONGLONG origin_ = 0;
+    uint64_t attachNs_ = 0;
+};
+
+} // namespace Utils
+} // namespace Sentinel
@@ -0,0 +1,68 @@
+/**
+ * @file EtwTrace.cpp
+ * @brief Definition and registration of the Sentinel TraceLogging provider.
+ */
+
+#include "Sentinel/Utils/EtwTrace.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+
+namespace Sentinel {
+namespace Utils {
+
+// GUID = EventSource name hash of "Sentinel" (see EtwTrace.hpp)
+TRACELOGGING_DEFINE_PROVIDER(sentinelTraceProvider, "Sentinel",
+                             (0xd60b7b0a, 0xb369, 0x5088, 0xc6, 0xdb, 0xcb, 0xdb, 0xc6, 0xb8, 0x60, 0x4a));
+
+static bool registered = false;
+
+// TraceLogging bounds counted strings to 16 bits
+static constexpr size_t MAX_EVENT_STRING_LENGTH = 0xFFFF;
+
+bool EtwTrace::Register() {
+    if (registered) {
+        return true;
+    }
+    const HRESULT result = TraceLoggingRegister(sentinelTraceProvider);
+    if (FAILED(result)) {
+        Logger::Error("EtwTrace: TraceLoggingRegister failed (0x{:08X})", static_cast<uint32_t>(result));
+        return false;
+    }
+    registered = true;
+    return true;
+}
+
+void EtwTrace::Unregister() {
+    if (registered) {
+        TraceLoggingUnregister(sentinelTraceProvider);
+        registered = false;
+    }
+}
+
+void EtwTrace::WriteLog(LogLevel level, std::string_view message) noexcept {
+    const char* text = message.data();
+    const UINT16 length = static_cast<UINT16>(message.size() < MAX_EVENT_STRING_LENGTH ? message.size()
+                                                                                        : MAX_EVENT_STRING_LENGTH);
+    // Level is part of the static event metadata, so each one needs its own write site
+#define WRITE_LOG_EVENT(eventLevel)                                                    \
+    TraceLoggingWrite(sentinelTraceProvider, "Log", TraceLoggingLevel(eventLevel), \
+                      TraceLoggingKeyword(KEYWORD_LOG),                            \
+                      TraceLoggingCountedUtf8String(text, length, "Message"))
+    switch (level) {
+        case LogLevel::Debug:
+            WRITE_LOG_EVENT(WINEVENT_LEVEL_VERBOSE);
+            break;
+        case LogLevel::Info:
+            WRITE_LOG_EVENT(WINEVENT_LEVEL_INFO);
+            break;
+        case LogLevel::Warning:
+            WRITE_LOG_EVENT(WINEVENT_LEVEL_WARNING);
+            break;
+        default:
+            WRITE_LOG_EVENT(WINEVENT_LEVEL_ERROR);
+            break;
+    }
+#undef WRITE_LOG_EVENT
+}
+
+} // namespace Utils
+} // namespace Sentinel
@@ -0,0 +1,117 @@
+/**
+ * @file EtwTrace.hpp
+ * @brief TraceLogging (ETW) provider for Sentinel's log and crash events.
+ *
+ * @details Where Sentinel is deployed, central collection is ETW-based: a collector starts
+ * an ETW session on each host and enables the providers it is interested in. The
+ * "Sentinel" provider makes the Logger's records and CrashInterceptor's crash reports
+ * visible to such sessions, in addition to the console, file and binary sinks.
+ * - TraceLogging events are self-describing, so no manifest has to be installed.
+ * - A session can enable it at any time, for any subset of keywords and up to any level,
+ *   and the running process starts emitting immediately; no restart or configuration
+ *   change is needed.
+ * - While no session listens, IsEnabled is an inline load and compare of two fields the
+ *   ETW runtime keeps in the provider object, so call sites pay one predictable branch.
+ *   That is what allows rich instrumentation to stay compiled into release builds.
+ *
+ * The provider GUID, {d60b7b0a-b369-5088-c6db-cbdbc6b8604a}, is derived from its name
+ * with the standard EventSource hashing scheme, so tools that hash names (PerfView, WPR
+ * profiles) can enable it as "*Sentinel":
+ * @code
+ * PerfView collect /onlyProviders=*Sentinel
+ * tracelog -start sentinel -guid #d60b7b0a-b369-5088-c6db-cbdbc6b8604a -level 5 -flag 0x3 -f sentinel.etl
+ * @endcode
+ *
+ * @security Events carry the same data as the log: messages and page-aligned addresses.
+ * A process running as the same user, or an administrator, can enable the provider and
+ * read them; do not log anything that must not leave the process.
+ *
+ * @performance Disabled: one inline branch per call site. Enabled: one EventWrite per
+ * event on the calling thread, without locks in user mode.
+ *
+ * @see https://learn.microsoft.com/en-us/windows/win32/tracelogging/trace-logging-portal
+ */
+
+#pragma once
+
+#include <Windows.h>
+#include <TraceLoggingProvider.h>
+#include <winmeta.h>
+#include <cstdint>
+#include <string_view>
+
+namespace Sentinel {
+namespace Utils {
+
+enum class LogLevel : uint8_t;
+
+/**
+ * @brief The "Sentinel" TraceLogging provider, defined in EtwTrace.cpp.
+ *
+ * @details Modules that write their own events (see CrashInterceptor) pass it to
+ * TraceLoggingWrite; everything else goes through EtwTrace.
+ */
+TRACELOGGING_DECLARE_PROVIDER(sentinelTraceProvider);
+
+/**
+ * @class EtwTrace
+ * @brief Registration, enablement checks and Logger events of the Sentinel provider.
+ *
+ * Usage example:
+ * @code
+ * EtwTrace::Register();  // once, at startup
+ * if (EtwTrace::IsEnabled(LogLevel::Info, EtwTrace::KEYWORD_LOG)) {
+ *     EtwTrace::WriteLog(LogLevel::Info, BuildExpensiveMessage());
+ * }
+ * EtwTrace::Unregister();  // before exit
+ * @endcode
+ *
+ * @threadsafe IsEnabled and the Write functions are thread-safe. Register and Unregister
+ * must not race with each other.
+ */
+class EtwTrace {
+public:
+    /** @brief Keyword of Logger records ("Log" events). */
+    static constexpr uint64_t KEYWORD_LOG = 0x1;
+
+    /** @brief Keyword of CrashInterceptor reports ("Crash" and "CrashRepeat" events). */
+    static constexpr uint64_t KEYWORD_CRASH = 0x2;
+
+    /**
+     * @brief Registers the provider with ETW; further calls do nothing.
+     *
+     * @return false (and logs) if registration failed; events are then never enabled.
+     */
+    static bool Register();
+
+    /**
+     * @brief Unregisters the provider. Must be called before the module that contains
+     * it is unloaded.
+     */
+    static void Unregister();
+
+    /**
+     * @brief Returns whether any session wants events of @p level and @p keyword.
+     *
+     * @details False while the provider is not registered.
+     */
+    static bool IsEnabled(LogLevel level, uint64_t keyword) noexcept {
+        return TraceLoggingProviderEnabled(sentinelTraceProvider, ToEventLevel(level), keyword);
+    }
+
+    /**
+     * @brief Writes a "Log" event. Callers check IsEnabled first.
+     */
+    static void WriteLog(LogLevel level, std::string_view message) noexcept;
+
+    /**
+     * @brief ETW level corresponding to @p level: Debug is WINEVENT_LEVEL_VERBOSE (5),
+     * Info 4, Warning 3 and Error WINEVENT_LEVEL_ERROR (2).
+     */
+    static constexpr UCHAR ToEventLevel(LogLevel level) noexcept {
+        return static_cast<UCHAR>(WINEVENT_LEVEL_VERBOSE - static_cast<uint8_t>(level));
+    }
+};
+
+} // namespace Utils
+} // namespace Sentinel
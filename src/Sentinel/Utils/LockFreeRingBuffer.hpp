@@ -0,0 +1,219 @@
+/**
+ * @file LockFreeRingBuffer.hpp
+ * @brief Bounded multi-producer lock-free ring buffer used by the asynchronous logger.
+ *
+ * @details This module exists so that hot threads can hand work to a background
+ * consumer without ever blocking on a mutex. The Logger's original design serialized
+ * every caller on a single console mutex; under telemetry load every logging thread
+ * queued up behind console I/O. A bounded ring lets producers publish a record with a
+ * single compare-and-swap and return immediately, while the consumer drains records in
+ * batches at its own pace.
+ *
+ * The implementation follows Dmitry Vyukov's bounded MPMC queue: every cell carries a
+ * sequence number that tells producers and consumers whether the cell is free, full,
+ * or still being written. This was chosen over a mutex-protected std::deque because:
+ * - Producers never sleep or enter the kernel on the fast path
+ * - Storage is preallocated once, so pushing never touches the heap
+ * - Multiple consumers are tolerated, which the drop-oldest overflow policy relies on
+ *   (a producer evicts the oldest record by consuming it)
+ *
+ * @security Records are copied into preallocated cells and remain in memory until they
+ * are overwritten. Callers must not push secrets they expect to be wiped on consumption.
+ *
+ * @performance Push and pop are O(1) with one CAS on the shared position counter and one
+ * release store on the cell sequence. The head and tail counters live on separate cache
+ * lines to avoid false sharing between producers and the consumer. Capacity is rounded up
+ * to a power of two so index wrapping is a mask instead of a division.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Sentinel {
+namespace Utils {
+
+// Cache-line alignment of cells and counters is intentional; silence the padding warning
+// (C4324) that /W4 /WX would otherwise turn into an error.
+#pragma warning(push)
+#pragma warning(disable : 4324)
+
+/**
+ * @brief Cache line size assumed for padding on x64.
+ *
+ * @details A fixed constant is used instead of std::hardware_destructive_interference_size
+ * so that the padded layout does not change with compiler version or tuning flags.
+ */
+inline constexpr size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * @class LockFreeRingBuffer
+ * @brief Fixed-capacity lock-free queue with in-place produce and consume callbacks.
+ *
+ * @details Elements are constructed once when the buffer is created and then filled in
+ * place by producers. This avoids a second copy of large records (such as log lines)
+ * and keeps the element type free of any move/copy requirements on the hot path.
+ *
+ * Usage example:
+ * @code
+ * LockFreeRingBuffer<Record> queue(4096);
+ * queue.TryPush([&](Record& slot) { slot.value = 42; });
+ * queue.TryPop([&](Record& slot) { Process(slot); });
+ * @endcode
+ *
+ * @tparam T Element type. Must be default constructible.
+ *
+ * @threadsafe All methods are safe to call concurrently from any number of producers and
+ * consumers.
+ */
+template <typename T>
+class LockFreeRingBuffer {
+public:
+    /**
+     * @brief Creates a ring buffer with at least @p capacity cells.
+     *
+     * @param capacity Requested number of cells. Rounded up to the next power of two
+     *        (minimum 2).
+     *
+     * @note This is the only allocation the buffer ever performs.
+     */
+    explicit LockFreeRingBuffer(size_t capacity)
+        : capacity_(RoundUpToPowerOfTwo(capacity))
+        , mask_(capacity_ - 1)
+        , cells_(new Cell[capacity_]) {
+        for (size_t i = 0; i < capacity_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enqueuePos_.store(0, std::memory_order_relaxed);
+        dequeuePos_.store(0, std::memory_order_relaxed);
+    }
+
+    LockFreeRingBuffer(const LockFreeRingBuffer&) = delete;
+    LockFreeRingBuffer& operator=(const LockFreeRingBuffer&) = delete;
+
+    /**
+     * @brief Claims a free cell and fills it in place.
+     *
+     * @param fill Callable invoked as fill(T&) on the claimed cell before it is published.
+     * @return true if a cell was claimed and published, false if the buffer was full.
+     *
+     * @performance One CAS on the enqueue position plus one release store. No allocation.
+     */
+    template <typename Fill>
+    bool TryPush(Fill&& fill) {
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+            if (difference == 0) {
+                // Cell is free for this lap; try to claim it
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    fill(cell.value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                // Consumer has not yet released this cell from the previous lap: buffer is full
+                return false;
+            } else {
+                // Another producer claimed this position; reload and retry
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Removes the oldest published element and hands it to @p consume.
+     *
+     * @param consume Callable invoked as consume(T&) before the cell is released.
+     * @return true if an element was consumed, false if the buffer was empty.
+     */
+    template <typename Consume>
+    bool TryPop(Consume&& consume) {
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+            if (difference == 0) {
+                if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    consume(cell.value);
+                    // Release the cell for the producer one lap ahead
+                    cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                // Cell not yet published: buffer is empty (or producer mid-write)
+                return false;
+            } else {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the number of cells in the buffer.
+     */
+    size_t Capacity() const noexcept {
+        return capacity_;
+    }
+
+    /**
+     * @brief Returns the total number of push claims made since construction.
+     *
+     * @details Used by flush logic to take a "high-water mark" that the consumer must
+     * reach before the flush is considered complete.
+     */
+    size_t EnqueuedCount() const noexcept {
+        return enqueuePos_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Returns an approximate number of elements currently queued.
+     *
+     * @note The value is a racy snapshot and is intended for metrics only.
+     */
+    size_t ApproximateSize() const noexcept {
+        size_t enqueued = enqueuePos_.load(std::memory_order_relaxed);
+        size_t dequeued = dequeuePos_.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+private:
+    /**
+     * @brief A single queue cell padded to a cache line boundary.
+     *
+     * @details Padding keeps neighbouring producers from invalidating each other's cells
+     * while they fill records concurrently.
+     */
+    struct alignas(CACHE_LINE_SIZE) Cell {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    static size_t RoundUpToPowerOfTwo(size_t value) noexcept {
+        size_t result = 2;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueuePos_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeuePos_{0};
+};
+
+#pragma warning(pop)
+
+} // namespace Utils
+} // namespace Sentinel
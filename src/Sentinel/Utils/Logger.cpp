@@ -4,7 +4,14 @@
  */
 
 #include "Sentinel/Utils/Logger.hpp"
-#include <iostream>
+#include "Sentinel/Utils/LockFreeRingBuffer.hpp"
+#include "Sentinel/Utils/Metrics.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <system_error>
+#include <thread>
 
 namespace Sentinel {
 namespace Utils {
@@ -16,10 +23,171 @@ HANDLE Logger::errorConsoleHandle_ = nullptr;
 WORD Logger::defaultAttributes_ = 0;
 WORD Logger::errorDefaultAttributes_ = 0;
 bool Logger::initialized_ = false;
+Logger::AsyncState* Logger::asyncState_ = nullptr;
+std::atomic<bool> Logger::asyncActive_{false};
+std::atomic<bool> Logger::binaryActive_{false};
+BinaryLogWriter Logger::binaryWriter_;
+bool Logger::mirrorErrorsToConsole_ = true;
+MappedFileSink Logger::fileSink_;
+bool Logger::consoleOutputEnabled_ = true;
+Logger::OutputKind Logger::outputKind_ = Logger::OutputKind::Unavailable;
+Logger::OutputKind Logger::errorOutputKind_ = Logger::OutputKind::Unavailable;
+
+// Format used to store plain LogInfo/LogError messages in binary mode
+static constexpr const char* PLAIN_MESSAGE_FORMAT = "{}";
+
+static_assert(BINARY_RECORD_MAX_SIZE <= Logger::LOG_RECORD_TEXT_CAPACITY,
+              "Encoded binary records must fit in a queued record");
 
 // Default console color attributes (white text on black background)
 static constexpr WORD DEFAULT_CONSOLE_ATTRIBUTES = FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE;
 
+/**
+ * @brief Output routing and decoration for one severity.
+ */
+struct LevelStyle {
+    const char* prefix;
+    WORD color;
+    const char* escape;
+    bool useStdErr;
+};
+
+// Warnings and errors go to stderr so they survive stdout redirection; info and debug
+// go to stdout. Colors: debug cyan, info bright green, warning bright yellow, error bright red.
+// The escape sequences are the SGR equivalents used on virtual-terminal consoles.
+static LevelStyle GetLevelStyle(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug:
+            return {"[DEBUG] ", FOREGROUND_GREEN | FOREGROUND_BLUE, "\x1b[36m", false};
+        case LogLevel::Warning:
+            return {"[WARN] ", FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY, "\x1b[93m", true};
+        case LogLevel::Error:
+            return {"[ERROR] ", FOREGROUND_RED | FOREGROUND_INTENSITY, "\x1b[91m", true};
+        case LogLevel::Info:
+        default:
+            return {"[INFO] ", FOREGROUND_GREEN | FOREGROUND_INTENSITY, "\x1b[92m", false};
+    }
+}
+
+// Capacity of a thread's console staging buffer. Lines are coalesced here and leave the
+// process in one WriteConsoleW/WriteFile call per run instead of one per line.
+static constexpr size_t OUTPUT_BUFFER_SIZE = 8192;
+
+// SGR sequence restoring default colors; room for it is always kept free in the buffer
+static constexpr char VT_RESET[] = "\x1b[0m";
+static constexpr size_t VT_RESET_LENGTH = sizeof(VT_RESET) - 1;
+
+/**
+ * @brief Pending console output (a "run" of lines for one stream). Used under consoleMutex_.
+ */
+struct Logger::OutputBatch {
+    char data[OUTPUT_BUFFER_SIZE];
+    size_t size = 0;
+    
+    // A run is open while its color is in effect: set on a legacy console, or emitted as an
+    // escape sequence on a VT console
+    bool open = false;
+    bool useStdErr = false;
+    LogLevel level = LogLevel::Info;
+};
+
+// Length of "YYYY-MM-DDTHH:MM:SS.mmmmmmZ " as written by FormatUtcTimestamp
+static constexpr size_t TIMESTAMP_LENGTH = 28;
+
+// Renders the current UTC time with microsecond precision for file sink lines
+static void FormatUtcTimestamp(char (&out)[TIMESTAMP_LENGTH + 1]) {
+    FILETIME fileTime;
+    GetSystemTimePreciseAsFileTime(&fileTime);
+    SYSTEMTIME systemTime;
+    FileTimeToSystemTime(&fileTime, &systemTime);
+    
+    // FILETIME counts 100 ns ticks; SYSTEMTIME drops everything below a millisecond
+    const ULARGE_INTEGER ticks{{fileTime.dwLowDateTime, fileTime.dwHighDateTime}};
+    const unsigned long micros = static_cast<unsigned long>((ticks.QuadPart / 10) % 1000000);
+    
+    sprintf_s(out, "%04u-%02u-%02uT%02u:%02u:%02u.%06luZ ",
+              systemTime.wYear, systemTime.wMonth, systemTime.wDay,
+              systemTime.wHour, systemTime.wMinute, systemTime.wSecond, micros);
+}
+
+// Size of the per-thread buffer that the format-string API renders into
+static constexpr size_t FORMAT_BUFFER_SIZE = 1024;
+
+/**
+ * @brief Output iterator writing into a fixed buffer and silently discarding overflow.
+ *
+ * @details Lets std::vformat_to render into the thread-local buffer without ever
+ * allocating; overlong messages are truncated like async records are.
+ */
+class TruncatingIterator {
+public:
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+
+    TruncatingIterator(char* cursor, char* end) noexcept
+        : cursor_(cursor), end_(end) {}
+
+    TruncatingIterator& operator=(char c) noexcept {
+        if (cursor_ < end_) {
+            *cursor_++ = c;
+        }
+        return *this;
+    }
+    TruncatingIterator& operator*() noexcept { return *this; }
+    TruncatingIterator& operator++() noexcept { return *this; }
+    TruncatingIterator operator++(int) noexcept { return *this; }
+
+    char* Position() const noexcept { return cursor_; }
+
+private:
+    char* cursor_;
+    char* end_;
+};
+
+// Number of queue-full retries before DropOldest gives up and drops the new record.
+// Bounds the producer's worst case when other producers keep refilling the evicted slot.
+static constexpr int DROP_OLDEST_MAX_ATTEMPTS = 4;
+
+/**
+ * @brief A queued log line or encoded binary record. Layout keeps the record at 256 bytes.
+ */
+struct QueuedLogRecord {
+    char text[Logger::LOG_RECORD_TEXT_CAPACITY];
+    uint16_t length;
+    LogLevel level;
+    bool binary;
+};
+
+struct Logger::AsyncState {
+    explicit AsyncState(size_t capacity)
+        : queue(capacity) {}
+
+    LockFreeRingBuffer<QueuedLogRecord> queue;
+    std::thread consumer;
+
+    // Serializes EnableAsync/Shutdown against each other (never taken by producers)
+    std::mutex controlMutex;
+
+    // Auto-reset event that wakes the consumer early (flush, shutdown, queue pressure)
+    HANDLE wakeEvent = nullptr;
+
+    std::atomic<OverflowPolicy> overflowPolicy{OverflowPolicy::DropNewest};
+    std::atomic<size_t> maxBatchSize{256};
+    std::atomic<DWORD> idleWaitMs{50};
+
+    std::atomic<bool> stopRequested{false};
+    std::atomic<bool> consumerIdle{false};
+
+    // Records retired by the consumer (written) and by producers (evicted under DropOldest).
+    // Together they tell Flush when a queue high-water mark has been fully processed.
+    std::atomic<uint64_t> writtenCount{0};
+    std::atomic<uint64_t> evictedCount{0};
+    std::atomic<uint64_t> droppedCount{0};
+};
+
 bool Logger::IsConsoleAvailable(HANDLE handle) {
     return (handle != INVALID_HANDLE_VALUE && handle != nullptr);
 }
@@ -60,54 +228,559 @@ void Logger::Initialize() {
             errorDefaultAttributes_ = DEFAULT_CONSOLE_ATTRIBUTES;
         }
         
+        outputKind_ = DetectOutputKind(consoleHandle_);
+        errorOutputKind_ = DetectOutputKind(errorConsoleHandle_);
+        
         initialized_ = true;
     }
 }
 
-void Logger::LogInfo(const std::string& message) {
-    std::lock_guard<std::mutex> lock(consoleMutex_);
+void Logger::WriteLineLocked(LogLevel level, const char* text, size_t length) {
+    WriteFileLineLocked(level, text, length);
+    if (!consoleOutputEnabled_) {
+        return;
+    }
     
     // Initialize console on first use
     if (!initialized_) {
         Initialize();
     }
     
-    // Set green color (bright green) if console is available
-    if (IsConsoleAvailable(consoleHandle_)) {
-        SetConsoleTextAttribute(consoleHandle_, FOREGROUND_GREEN | FOREGROUND_INTENSITY);
+    // Synchronous lines are not coalesced: each is assembled in one staging buffer (safe to
+    // share, consoleMutex_ is held) and written with a single call
+    static OutputBatch batch;
+    AppendLineLocked(batch, level, text, length);
+    FlushBatchLocked(batch);
+}
+
+Logger::OutputKind Logger::DetectOutputKind(HANDLE handle) {
+    if (!IsConsoleAvailable(handle)) {
+        return OutputKind::Unavailable;
     }
     
-    // Output message to stdout
-    std::cout << "[INFO] " << message << std::endl;
+    // GetConsoleMode fails for pipes and files: plain bytes, no colors
+    DWORD mode = 0;
+    if (!GetConsoleMode(handle, &mode)) {
+        return OutputKind::Redirected;
+    }
     
-    // Restore default color if console is available
-    if (IsConsoleAvailable(consoleHandle_)) {
-        SetConsoleTextAttribute(consoleHandle_, defaultAttributes_);
+    // Prefer escape sequences so color changes need no extra system calls
+    if ((mode & ENABLE_VIRTUAL_TERMINAL_PROCESSING) != 0 ||
+        SetConsoleMode(handle, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING)) {
+        return OutputKind::VirtualTerminal;
     }
+    return OutputKind::LegacyConsole;
 }
 
-void Logger::LogError(const std::string& message) {
+void Logger::AppendLineLocked(OutputBatch& batch, LogLevel level, const char* text, size_t length) {
+    const LevelStyle style = GetLevelStyle(level);
+    const OutputKind kind = style.useStdErr ? errorOutputKind_ : outputKind_;
+    if (kind == OutputKind::Unavailable) {
+        return;
+    }
+    
+    // A run ends when the stream changes, which keeps stdout/stderr ordering intact on a
+    // shared console, or on a legacy console when the color changes (attributes apply to
+    // whole write calls)
+    if (batch.open && (batch.useStdErr != style.useStdErr ||
+                       (kind == OutputKind::LegacyConsole && batch.level != level))) {
+        FlushBatchLocked(batch);
+    }
+    
+    if (!batch.open) {
+        batch.open = true;
+        batch.useStdErr = style.useStdErr;
+        batch.level = level;
+        if (kind == OutputKind::LegacyConsole) {
+            SetConsoleTextAttribute(style.useStdErr ? errorConsoleHandle_ : consoleHandle_, style.color);
+        } else if (kind == OutputKind::VirtualTerminal) {
+            AppendOutputLocked(batch, style.escape, std::strlen(style.escape));
+        }
+    } else if (kind == OutputKind::VirtualTerminal && batch.level != level) {
+        // Same stream, new color: an escape sequence in the buffer instead of a syscall
+        batch.level = level;
+        AppendOutputLocked(batch, style.escape, std::strlen(style.escape));
+    }
+    
+    AppendOutputLocked(batch, style.prefix, std::strlen(style.prefix));
+    AppendOutputLocked(batch, text, length);
+    AppendOutputLocked(batch, "\n", 1);
+}
+
+void Logger::AppendOutputLocked(OutputBatch& batch, const char* data, size_t length) {
+    while (length > 0) {
+        const size_t space = OUTPUT_BUFFER_SIZE - VT_RESET_LENGTH - batch.size;
+        size_t chunk = (std::min)(length, space);
+        
+        // Never split a UTF-8 sequence across two WriteConsoleW calls
+        if (chunk < length) {
+            while (chunk > 0 && (static_cast<unsigned char>(data[chunk]) & 0xC0) == 0x80) {
+                --chunk;
+            }
+        }
+        if (chunk == 0) {
+            if (batch.size == 0) {
+                // Not valid UTF-8 (no lead byte within a whole buffer): split where it is
+                chunk = (std::min)(length, space);
+            } else {
+                WritePendingLocked(batch);
+                continue;
+            }
+        }
+        
+        std::memcpy(batch.data + batch.size, data, chunk);
+        batch.size += chunk;
+        data += chunk;
+        length -= chunk;
+        
+        if (length > 0) {
+            WritePendingLocked(batch);
+        }
+    }
+}
+
+void Logger::WritePendingLocked(OutputBatch& batch) {
+    if (batch.size == 0) {
+        return;
+    }
+    
+    const OutputKind kind = batch.useStdErr ? errorOutputKind_ : outputKind_;
+    HANDLE handle = batch.useStdErr ? errorConsoleHandle_ : consoleHandle_;
+    
+    if (kind == OutputKind::LegacyConsole || kind == OutputKind::VirtualTerminal) {
+        // Consoles take UTF-16 so output is independent of the console code page. Only
+        // used under consoleMutex_, so one conversion buffer serves every thread.
+        static wchar_t wide[OUTPUT_BUFFER_SIZE];
+        const int count = MultiByteToWideChar(CP_UTF8, 0, batch.data, static_cast<int>(batch.size),
+                                              wide, static_cast<int>(OUTPUT_BUFFER_SIZE));
+        if (count > 0) {
+            DWORD written = 0;
+            WriteConsoleW(handle, wide, static_cast<DWORD>(count), &written, nullptr);
+            batch.size = 0;
+            return;
+        }
+    }
+    
+    // Pipes and files (and a failed conversion) receive the bytes unchanged
+    const char* cursor = batch.data;
+    size_t remaining = batch.size;
+    while (remaining > 0) {
+        DWORD written = 0;
+        if (!WriteFile(handle, cursor, static_cast<DWORD>(remaining), &written, nullptr) || written == 0) {
+            break;
+        }
+        cursor += written;
+        remaining -= written;
+    }
+    batch.size = 0;
+}
+
+void Logger::FlushBatchLocked(OutputBatch& batch) {
+    if (!batch.open) {
+        return;
+    }
+    
+    const OutputKind kind = batch.useStdErr ? errorOutputKind_ : outputKind_;
+    if (kind == OutputKind::VirtualTerminal) {
+        // Space is reserved by AppendOutputLocked, so this never forces an extra write
+        std::memcpy(batch.data + batch.size, VT_RESET, VT_RESET_LENGTH);
+        batch.size += VT_RESET_LENGTH;
+    }
+    WritePendingLocked(batch);
+    
+    if (kind == OutputKind::LegacyConsole) {
+        SetConsoleTextAttribute(batch.useStdErr ? errorConsoleHandle_ : consoleHandle_,
+                                batch.useStdErr ? errorDefaultAttributes_ : defaultAttributes_);
+    }
+    batch.open = false;
+}
+
+void Logger::WriteFileLineLocked(LogLevel level, const char* text, size_t length) {
+    if (!fileSink_.IsOpen()) {
+        return;
+    }
+    
+    char timestamp[TIMESTAMP_LENGTH + 1];
+    FormatUtcTimestamp(timestamp);
+    const char* prefix = GetLevelStyle(level).prefix;
+    
+    // Written as one unit so a line never straddles two segments
+    const char* parts[] = {timestamp, prefix, text, "\n"};
+    const size_t lengths[] = {TIMESTAMP_LENGTH, std::strlen(prefix), length, 1};
+    fileSink_.WriteParts(parts, lengths, 4);
+}
+
+void Logger::Dispatch(LogLevel level, std::string_view message) {
+    // ETW is an additional sink; with no session listening this is a single branch
+    if (EtwTrace::IsEnabled(level, EtwTrace::KEYWORD_LOG)) {
+        EtwTrace::WriteLog(level, message);
+    }
+    
+    // Binary mode stores plain messages as a single string argument
+    if (binaryActive_.load(std::memory_order_acquire)) {
+        BinaryRecordEncoder encoder(level, LogFormatRegistry::Intern(PLAIN_MESSAGE_FORMAT));
+        encoder.AppendString(message);
+        DispatchBinary(level, encoder);
+        return;
+    }
+    
+    // Async fast path: hand the record to the consumer and return
+    if (TryEnqueue(level, false, message.data(), message.size())) {
+        return;
+    }
+    
     std::lock_guard<std::mutex> lock(consoleMutex_);
+    WriteLineLocked(level, message.data(), message.size());
+}
+
+std::string_view Logger::FormatToThreadBuffer(std::string_view format, std::format_args args) {
+    // Reused for every message on this thread, so formatting never touches the heap
+    thread_local char buffer[FORMAT_BUFFER_SIZE];
     
-    // Initialize console on first use
+    TruncatingIterator begin(buffer, buffer + FORMAT_BUFFER_SIZE);
+    try {
+        TruncatingIterator end = std::vformat_to(begin, format, args);
+        return std::string_view(buffer, static_cast<size_t>(end.Position() - buffer));
+    } catch (const std::format_error&) {
+        // Only reachable from the runtime-checked overloads: log the format verbatim
+        return format;
+    }
+}
+
+void Logger::DispatchBinary(LogLevel level, const BinaryRecordEncoder& encoder) {
+    const char* bytes = reinterpret_cast<const char*>(encoder.Data());
+    if (TryEnqueue(level, true, bytes, encoder.Size())) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(consoleMutex_);
+    WriteBinaryLocked(level, encoder.Data(), encoder.Size());
+    
+    // Synchronous mode: make errors durable immediately, batch everything else
+    if (level == LogLevel::Error) {
+        binaryWriter_.Flush();
+    }
+}
+
+void Logger::WriteBinaryLocked(LogLevel level, const uint8_t* record, size_t size) {
+    binaryWriter_.AppendEvent(record, size);
+    
+    if (mirrorErrorsToConsole_ && level == LogLevel::Error) {
+        DecodedEvent event;
+        std::string format;
+        if (BinaryLogDecoder::DecodeEvent(record, size, event) &&
+            LogFormatRegistry::Lookup(event.formatId, format)) {
+            std::string text = BinaryLogDecoder::FormatEvent(format, event.args);
+            WriteLineLocked(level, text.data(), text.size());
+        }
+    }
+}
+
+bool Logger::EnableBinaryLog(const BinaryLogConfig& config) {
+    // Drain records queued in the previous mode so they are written in that mode
+    Flush();
+    
+    std::lock_guard<std::mutex> lock(consoleMutex_);
+    if (!binaryWriter_.Open(config.path)) {
+        return false;
+    }
+    mirrorErrorsToConsole_ = config.mirrorErrorsToConsole;
+    binaryActive_.store(true, std::memory_order_release);
+    return true;
+}
+
+void Logger::DisableBinaryLog() {
+    binaryActive_.store(false, std::memory_order_release);
+    
+    // Write out binary records that are still queued before closing the file
+    Flush();
+    
+    std::lock_guard<std::mutex> lock(consoleMutex_);
+    binaryWriter_.Close();
+}
+
+bool Logger::EnableFileSink(const MappedFileSinkConfig& config, bool keepConsoleOutput) {
+    // Records queued before the sink existed are written without it
+    Flush();
+    
+    std::lock_guard<std::mutex> lock(consoleMutex_);
+    if (!fileSink_.Open(config)) {
+        consoleOutputEnabled_ = true;
+        return false;
+    }
+    consoleOutputEnabled_ = keepConsoleOutput;
+    return true;
+}
+
+void Logger::DisableFileSink() {
+    Flush();
+    
+    std::lock_guard<std::mutex> lock(consoleMutex_);
+    fileSink_.Close();
+    consoleOutputEnabled_ = true;
+}
+
+void Logger::LogInfo(const std::string& message) {
+    if constexpr (IsLevelEnabled(LogLevel::Info)) {
+        Dispatch(LogLevel::Info, message);
+    } else {
+        static_cast<void>(message);
+    }
+}
+
+void Logger::LogError(const std::string& message) {
+    if constexpr (IsLevelEnabled(LogLevel::Error)) {
+        Dispatch(LogLevel::Error, message);
+    } else {
+        static_cast<void>(message);
+    }
+}
+
+bool Logger::TryEnqueue(LogLevel level, bool binary, const char* text, size_t length) {
+    if (!asyncActive_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    
+    AsyncState& state = *asyncState_;
+    size_t copyLength = (std::min)(length, LOG_RECORD_TEXT_CAPACITY);
+    if (!binary && copyLength < length) {
+        // Never split a multi-byte sequence: back up over continuation bytes to a lead byte
+        while (copyLength > 0 && (static_cast<uint8_t>(text[copyLength]) & 0xC0) == 0x80) {
+            --copyLength;
+        }
+    }
+    auto fill = [&](QueuedLogRecord& record) {
+        std::memcpy(record.text, text, copyLength);
+        record.length = static_cast<uint16_t>(copyLength);
+        record.level = level;
+        record.binary = binary;
+    };
+    
+    bool published = state.queue.TryPush(fill);
+    if (!published) {
+        switch (state.overflowPolicy.load(std::memory_order_relaxed)) {
+            case OverflowPolicy::DropOldest:
+                for (int attempt = 0; attempt < DROP_OLDEST_MAX_ATTEMPTS && !published; ++attempt) {
+                    // Evict the oldest record by consuming it ourselves, then retry
+                    if (state.queue.TryPop([](QueuedLogRecord&) {})) {
+                        state.evictedCount.fetch_add(1, std::memory_order_relaxed);
+                        state.droppedCount.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    published = state.queue.TryPush(fill);
+                }
+                break;
+            case OverflowPolicy::Block:
+                while (!published) {
+                    SetEvent(state.wakeEvent);
+                    std::this_thread::yield();
+                    if (!asyncActive_.load(std::memory_order_acquire)) {
+                        // Shutting down: fall back to a synchronous write
+                        return false;
+                    }
+                    published = state.queue.TryPush(fill);
+                }
+                break;
+            case OverflowPolicy::DropNewest:
+            default:
+                break;
+        }
+        
+        if (!published) {
+            state.droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    
+    // Pairs with the fence in Shutdown: either Shutdown's final drain sees our record,
+    // or we see the mode switch and drain it ourselves.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!asyncActive_.load(std::memory_order_relaxed)) {
+        DrainBatch();
+        return true;
+    }
+    
+    // Only pay for a wake-up syscall when the consumer is actually parked
+    if (state.consumerIdle.load(std::memory_order_relaxed)) {
+        SetEvent(state.wakeEvent);
+    }
+    return true;
+}
+
+size_t Logger::DrainBatch() {
+    AsyncState& state = *asyncState_;
+    const size_t maxBatch = state.maxBatchSize.load(std::memory_order_relaxed);
+    
+    std::lock_guard<std::mutex> lock(consoleMutex_);
     if (!initialized_) {
         Initialize();
     }
     
-    // Set red color (bright red) if console is available
-    // Use stderr handle for proper handling when streams are redirected separately
-    if (IsConsoleAvailable(errorConsoleHandle_)) {
-        SetConsoleTextAttribute(errorConsoleHandle_, FOREGROUND_RED | FOREGROUND_INTENSITY);
+    // Lines are coalesced in one staging buffer (shared by every draining thread, consoleMutex_
+    // is held): on a VT console a whole batch per stream is one write call; on a legacy
+    // console each same-color run is one call
+    static OutputBatch batch;
+    
+    size_t written = 0;
+    bool wroteBinary = false;
+    while (written < maxBatch) {
+        bool popped = state.queue.TryPop([&](QueuedLogRecord& record) {
+            if (record.binary) {
+                FlushBatchLocked(batch);
+                WriteBinaryLocked(record.level, reinterpret_cast<const uint8_t*>(record.text), record.length);
+                wroteBinary = true;
+                return;
+            }
+            
+            WriteFileLineLocked(record.level, record.text, record.length);
+            if (consoleOutputEnabled_) {
+                AppendLineLocked(batch, record.level, record.text, record.length);
+            }
+        });
+        if (!popped) {
+            break;
+        }
+        ++written;
+    }
+    FlushBatchLocked(batch);
+    
+    if (wroteBinary) {
+        binaryWriter_.Flush();
+    }
+    
+    if (written > 0) {
+        state.writtenCount.fetch_add(written, std::memory_order_release);
+    }
+    return written;
+}
+
+void Logger::ConsumerLoop() {
+    AsyncState& state = *asyncState_;
+    
+    for (;;) {
+        if (DrainBatch() > 0) {
+            continue;
+        }
+        
+        if (state.stopRequested.load(std::memory_order_acquire)) {
+            break;
+        }
+        
+        // Announce that we are about to park, then re-check the queue so a producer that
+        // published before seeing the flag is not left waiting for the idle timeout.
+        state.consumerIdle.store(true, std::memory_order_seq_cst);
+        if (state.queue.ApproximateSize() == 0 && !state.stopRequested.load(std::memory_order_acquire)) {
+            WaitForSingleObject(state.wakeEvent, state.idleWaitMs.load(std::memory_order_relaxed));
+        }
+        state.consumerIdle.store(false, std::memory_order_relaxed);
+    }
+}
+
+bool Logger::EnableAsync(const AsyncLoggerConfig& config) {
+    // Allocate the async state exactly once; it is never freed (see Shutdown)
+    static std::once_flag allocationFlag;
+    std::call_once(allocationFlag, [&config]() {
+        asyncState_ = new AsyncState((std::max)(config.queueCapacity, static_cast<size_t>(2)));
+        asyncState_->wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    });
+    
+    AsyncState& state = *asyncState_;
+    std::lock_guard<std::mutex> control(state.controlMutex);
+    
+    state.overflowPolicy.store(config.overflowPolicy, std::memory_order_relaxed);
+    state.maxBatchSize.store((std::max)(config.maxBatchSize, static_cast<size_t>(1)), std::memory_order_relaxed);
+    state.idleWaitMs.store(config.idleWaitMs, std::memory_order_relaxed);
+    
+    if (asyncActive_.load(std::memory_order_acquire)) {
+        return true;
+    }
+    if (state.wakeEvent == nullptr) {
+        return false;
+    }
+    
+    state.stopRequested.store(false, std::memory_order_relaxed);
+    try {
+        state.consumer = std::thread(&Logger::ConsumerLoop);
+    } catch (const std::system_error&) {
+        return false;
+    }
+    
+    asyncActive_.store(true, std::memory_order_release);
+    return true;
+}
+
+void Logger::InitializeConsole() {
+    std::lock_guard<std::mutex> lock(consoleMutex_);
+    Initialize();
+}
+
+void Logger::Flush() {
+    AsyncState* state = asyncState_;
+    if (state == nullptr || !asyncActive_.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(consoleMutex_);
+        binaryWriter_.Flush();
+        fileSink_.RequestFlush();
+        return;
+    }
+    
+    // Everything claimed up to now must be either written or evicted
+    const uint64_t target = state->queue.EnqueuedCount();
+    while (state->writtenCount.load(std::memory_order_acquire) +
+           state->evictedCount.load(std::memory_order_acquire) < target) {
+        if (!asyncActive_.load(std::memory_order_acquire)) {
+            // Shutdown raced with us and performs (or performed) the final drain
+            break;
+        }
+        SetEvent(state->wakeEvent);
+        Sleep(1);
+    }
+}
+
+void Logger::Shutdown() {
+    AsyncState* state = asyncState_;
+    if (state == nullptr) {
+        Flush();
+        return;
+    }
+    
+    std::lock_guard<std::mutex> control(state->controlMutex);
+    if (!asyncActive_.load(std::memory_order_acquire)) {
+        return;
     }
     
-    // Output message to stderr
-    std::cerr << "[ERROR] " << message << std::endl;
+    // Stop accepting new records; pairs with the fence in TryEnqueue
+    asyncActive_.store(false, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
     
-    // Restore default color if console is available
-    if (IsConsoleAvailable(errorConsoleHandle_)) {
-        SetConsoleTextAttribute(errorConsoleHandle_, errorDefaultAttributes_);
+    state->stopRequested.store(true, std::memory_order_release);
+    SetEvent(state->wakeEvent);
+    if (state->consumer.joinable()) {
+        state->consumer.join();
     }
+    
+    // Final drain for anything published between the consumer's last pass and the mode switch
+    while (DrainBatch() > 0) {
+    }
+    
+    std::lock_guard<std::mutex> lock(consoleMutex_);
+    binaryWriter_.Flush();
+    fileSink_.RequestFlush();
+}
+
+uint64_t Logger::GetDroppedCount() {
+    AsyncState* state = asyncState_;
+    return state ? state->droppedCount.load(std::memory_order_relaxed) : 0;
 }
 
+size_t Logger::GetQueueDepth() {
+    AsyncState* state = asyncState_;
+    return state ? state->queue.ApproximateSize() : 0;
+}
+
+// Both are already tracked by the async state; they are sampled when a snapshot is taken
+static const MetricRegistration queueDepthMetric("logger.queue_depth", MetricKind::Gauge,
+                                                 [] { return static_cast<int64_t>(Logger::GetQueueDepth()); });
+static const MetricRegistration droppedMetric("logger.dropped", MetricKind::Counter,
+                                              [] { return static_cast<int64_t>(Logger::GetDroppedCount()); });
+
 } // namespace Utils
 } // namespace Sentinel
@@ -14,6 +14,21 @@
  * - Visual clarity: Color coding enables rapid identification of log severity
  * - Performance: Minimal overhead with single mutex and direct console API usage
  * - Windows integration: Native use of Windows Console API for color support
+ * - Asynchronous mode: Callers can hand records to a lock-free ring buffer that a
+ *   single background consumer drains in batches, taking console I/O off hot threads
+ * - Binary mode: Records are stored as format id plus raw arguments in a compact file
+ *   and formatted offline (see BinaryLog.hpp), keeping formatting off hot threads
+ * - Format-string API: Logger::Info/Error(fmt, args...) checks format strings at compile
+ *   time, renders into a thread-local buffer (no heap allocation), and levels below
+ *   SENTINEL_LOG_MIN_LEVEL compile to nothing
+ * - Batched output: in async mode the consumer stages each drained batch and writes it
+ *   with one WriteConsoleW/WriteFile call per run of same-color lines (synchronous lines
+ *   are one call each); on virtual-terminal consoles colors are ANSI escape sequences, so
+ *   no attribute-switching system calls are made
+ * - File sink: text lines can additionally (or exclusively) be appended to rotating
+ *   memory-mapped segments (see MappedFileSink.hpp), which survive a process crash
+ * - ETW: every record is also written as a TraceLogging event while an ETW session has
+ *   the Sentinel provider enabled (see EtwTrace.hpp); otherwise this costs one branch
  * 
  * @security This logger writes to stdout/stderr and may expose sensitive
  * information. Care must be taken to sanitize log messages in production builds.
@@ -27,13 +42,112 @@
 
 #pragma once
 
+#include "Sentinel/Utils/BinaryLog.hpp"
+#include "Sentinel/Utils/EtwTrace.hpp"
+#include "Sentinel/Utils/MappedFileSink.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <format>
 #include <string>
+#include <string_view>
 #include <mutex>
+#include <utility>
 #include <Windows.h>
 
+/**
+ * @def SENTINEL_LOG_MIN_LEVEL
+ * @brief Compile-time minimum severity (0 = Debug, 1 = Info, 2 = Warning, 3 = Error).
+ * 
+ * @details Log calls below this level are discarded with `if constexpr`, so neither the
+ * formatting nor the dispatch code is emitted. Set by the build system (see the
+ * SENTINEL_LOG_MIN_LEVEL CMake cache variable); defaults to Debug when undefined.
+ */
+#ifndef SENTINEL_LOG_MIN_LEVEL
+#define SENTINEL_LOG_MIN_LEVEL 0
+#endif
+
 namespace Sentinel {
 namespace Utils {
 
+/**
+ * @brief Severity of a log record.
+ *
+ * @details Severity selects both the output stream (stdout for Debug/Info, stderr for
+ * Warning/Error) and the console color. It is stored in queued records so the
+ * asynchronous consumer can color and route lines without re-parsing message text.
+ * Values are ordered so they can be compared against SENTINEL_LOG_MIN_LEVEL.
+ */
+enum class LogLevel : uint8_t {
+    Debug = 0,
+    Info = 1,
+    Warning = 2,
+    Error = 3
+};
+
+/**
+ * @brief Severity threshold fixed at compile time from SENTINEL_LOG_MIN_LEVEL.
+ */
+inline constexpr LogLevel COMPILE_TIME_MIN_LEVEL = static_cast<LogLevel>(SENTINEL_LOG_MIN_LEVEL);
+
+/**
+ * @brief Returns true if records of @p level are compiled in.
+ */
+constexpr bool IsLevelEnabled(LogLevel level) noexcept {
+    return static_cast<uint8_t>(level) >= static_cast<uint8_t>(COMPILE_TIME_MIN_LEVEL);
+}
+
+/**
+ * @brief Behaviour of the asynchronous logger when its ring buffer is full.
+ *
+ * @details A bounded queue must decide what to sacrifice when producers outrun the
+ * console. The right answer differs per deployment, so the policy is configurable:
+ * - DropNewest: Discard the record being logged. Cheapest; preserves the history that
+ *   led up to an overload.
+ * - DropOldest: Evict the oldest queued record to make room. Preserves the most recent
+ *   state, which is usually what matters after a fault storm.
+ * - Block: Spin/yield until space is available. Lossless, but producers inherit the
+ *   console's latency when the queue saturates.
+ */
+enum class OverflowPolicy : uint8_t {
+    DropOldest,
+    DropNewest,
+    Block
+};
+
+/**
+ * @brief Configuration for Logger::EnableAsync.
+ */
+struct AsyncLoggerConfig {
+    /** @brief Number of queued records (rounded up to a power of two). */
+    size_t queueCapacity = 8192;
+
+    /** @brief What producers do when the queue is full. */
+    OverflowPolicy overflowPolicy = OverflowPolicy::DropNewest;
+
+    /** @brief Maximum records the consumer writes per batch before flushing the streams. */
+    size_t maxBatchSize = 256;
+
+    /** @brief Consumer wake-up interval when idle, bounding latency of a missed signal. */
+    DWORD idleWaitMs = 50;
+};
+
+/**
+ * @brief Configuration for Logger::EnableBinaryLog.
+ */
+struct BinaryLogConfig {
+    /** @brief File that binary records are appended to. */
+    std::wstring path;
+
+    /**
+     * @brief Also render error records as text on the console.
+     * 
+     * @details Rendering happens on the writing thread (the async consumer when async
+     * mode is active), never on the logging thread.
+     */
+    bool mirrorErrorsToConsole = true;
+};
+
 /**
  * @class Logger
  * @brief Thread-safe console logger with Windows console color support.
@@ -47,6 +161,23 @@ namespace Utils {
  * Logger::LogInfo("Sentinel monitor initialized successfully");
  * Logger::LogError("Failed to attach to target process");
  * @endcode
+ * 
+ * Asynchronous usage:
+ * @code
+ * Logger::EnableAsync();             // Start the background consumer
+ * Logger::LogInfo("Queued, not written on this thread");
+ * Logger::Flush();                   // Wait until everything queued so far is written
+ * Logger::Shutdown();                // Drain, stop the consumer, revert to synchronous mode
+ * @endcode
+ * 
+ * Format-string usage (checked at compile time, no heap allocation per line):
+ * @code
+ * Logger::Info("Thread {} - Message {}", id, i);
+ * Logger::Error("Failed to open process {}: error {}", pid, GetLastError());
+ * Logger::Debug("Compiled out when SENTINEL_LOG_MIN_LEVEL > 0");
+ * @endcode
+ * In binary mode (Logger::EnableBinaryLog) the same calls store the raw arguments and no
+ * formatting happens on the calling thread.
  */
 class Logger {
 public:
@@ -91,6 +222,259 @@ public:
      */
     static void LogError(const std::string& message);
 
+    /**
+     * @brief Logs a debug message using a compile-time checked format string.
+     * 
+     * @details The format string is validated against the argument types at compile
+     * time (std::format_string). In text mode the message is rendered into a reusable
+     * thread-local buffer, so the call performs no heap allocation; in binary mode only
+     * the raw arguments are recorded. When Debug is below SENTINEL_LOG_MIN_LEVEL the body
+     * is discarded at compile time.
+     * 
+     * @param format Format string literal using std::format replacement fields.
+     * @param args Arguments: integers, floating point, bool, char, strings and pointers.
+     * 
+     * @note Arguments are still evaluated at the call site when the level is compiled
+     * out; avoid expensive argument expressions in Debug calls.
+     * 
+     * @threadsafe This method is thread-safe.
+     */
+    template <typename... Args>
+    static void Debug(std::format_string<Args...> format, Args&&... args) {
+        if constexpr (IsLevelEnabled(LogLevel::Debug)) {
+            Emit(LogLevel::Debug, format.get(), args...);
+        } else {
+            // Compiled out: keep /W4 quiet about the unused parameters
+            static_cast<void>(format);
+            (static_cast<void>(args), ...);
+        }
+    }
+
+    /**
+     * @brief Logs an informational message using a compile-time checked format string.
+     * 
+     * @see Debug for details.
+     * @threadsafe This method is thread-safe.
+     */
+    template <typename... Args>
+    static void Info(std::format_string<Args...> format, Args&&... args) {
+        if constexpr (IsLevelEnabled(LogLevel::Info)) {
+            Emit(LogLevel::Info, format.get(), args...);
+        } else {
+            // Compiled out: keep /W4 quiet about the unused parameters
+            static_cast<void>(format);
+            (static_cast<void>(args), ...);
+        }
+    }
+
+    /**
+     * @brief Logs a warning using a compile-time checked format string.
+     * 
+     * @see Debug for details.
+     * @threadsafe This method is thread-safe.
+     */
+    template <typename... Args>
+    static void Warning(std::format_string<Args...> format, Args&&... args) {
+        if constexpr (IsLevelEnabled(LogLevel::Warning)) {
+            Emit(LogLevel::Warning, format.get(), args...);
+        } else {
+            // Compiled out: keep /W4 quiet about the unused parameters
+            static_cast<void>(format);
+            (static_cast<void>(args), ...);
+        }
+    }
+
+    /**
+     * @brief Logs an error using a compile-time checked format string.
+     * 
+     * @see Debug for details.
+     * @threadsafe This method is thread-safe.
+     */
+    template <typename... Args>
+    static void Error(std::format_string<Args...> format, Args&&... args) {
+        if constexpr (IsLevelEnabled(LogLevel::Error)) {
+            Emit(LogLevel::Error, format.get(), args...);
+        } else {
+            // Compiled out: keep /W4 quiet about the unused parameters
+            static_cast<void>(format);
+            (static_cast<void>(args), ...);
+        }
+    }
+
+    /**
+     * @brief Logs a structured informational message with a runtime format string.
+     * 
+     * @details Equivalent to Info() for format strings that are not compile-time
+     * constants. Invalid format strings are detected at runtime and logged verbatim.
+     * 
+     * @param format Format string. Must have static storage duration, because binary
+     *        mode identifies formats by address.
+     * @param args Arguments: integers, floating point, bool, char, strings and pointers.
+     * 
+     * @threadsafe This method is thread-safe.
+     */
+    template <typename... Args>
+        requires(sizeof...(Args) > 0)
+    static void LogInfo(const char* format, const Args&... args) {
+        if constexpr (IsLevelEnabled(LogLevel::Info)) {
+            Emit(LogLevel::Info, format, args...);
+        } else {
+            // Compiled out: keep /W4 quiet about the unused parameters
+            static_cast<void>(format);
+            (static_cast<void>(args), ...);
+        }
+    }
+
+    /**
+     * @brief Logs a structured error message. See the structured LogInfo overload.
+     * 
+     * @threadsafe This method is thread-safe.
+     */
+    template <typename... Args>
+        requires(sizeof...(Args) > 0)
+    static void LogError(const char* format, const Args&... args) {
+        if constexpr (IsLevelEnabled(LogLevel::Error)) {
+            Emit(LogLevel::Error, format, args...);
+        } else {
+            // Compiled out: keep /W4 quiet about the unused parameters
+            static_cast<void>(format);
+            (static_cast<void>(args), ...);
+        }
+    }
+
+    /**
+     * @brief Switches the logger into binary record mode.
+     * 
+     * @details After this call every record - including plain LogInfo/LogError calls,
+     * which are stored as a "{}" format with one string argument - is appended to
+     * config.path in the BinaryLog format instead of being written to the console.
+     * Works together with async mode: encoded records travel through the same queue and
+     * are written by the consumer thread.
+     * 
+     * @param config Output path and console mirroring options.
+     * @return true if the file was opened.
+     * 
+     * @threadsafe This method is thread-safe.
+     */
+    static bool EnableBinaryLog(const BinaryLogConfig& config);
+
+    /**
+     * @brief Flushes and closes the binary log and reverts to text output.
+     * 
+     * @threadsafe This method is thread-safe.
+     */
+    static void DisableBinaryLog();
+
+    /**
+     * @brief Starts appending timestamped text lines to rotating memory-mapped files.
+     * 
+     * @details Every text line written from then on is also copied into the current
+     * segment as "<UTC timestamp> <prefix><message>". Writing is a memcpy under the
+     * console mutex; flushing and rotation housekeeping run on the sink's own thread.
+     * Errors mirrored from binary mode are written to the file sink as well.
+     * 
+     * @param config Segment location, size and retention.
+     * @param keepConsoleOutput false to stop writing to the console while the sink is
+     *        active (the usual choice for a service without a console).
+     * @return true if the first segment was created.
+     * 
+     * @threadsafe This method is thread-safe.
+     */
+    static bool EnableFileSink(const MappedFileSinkConfig& config, bool keepConsoleOutput = true);
+
+    /**
+     * @brief Closes the file sink (segments are flushed and truncated) and restores
+     * console output.
+     * 
+     * @threadsafe This method is thread-safe.
+     */
+    static void DisableFileSink();
+
+    /**
+     * @brief Switches the logger into asynchronous mode.
+     * 
+     * @details Allocates the record ring buffer (once per process) and starts a single
+     * consumer thread. From then on, LogInfo and LogError copy the message into a queue
+     * slot and return; the consumer formats, colors and writes records in batches, so
+     * each run of same-severity lines costs a single color change and one flush per
+     * batch instead of two attribute syscalls and a flush per line.
+     * 
+     * Messages longer than LOG_RECORD_TEXT_CAPACITY bytes are truncated in async mode.
+     * 
+     * @param config Queue capacity, overflow policy and batching parameters. The queue
+     *        capacity is fixed by the first successful call; later calls only update the
+     *        overflow policy and batching parameters.
+     * @return true if async mode is active on return, false if the consumer thread could
+     *         not be created (the logger stays synchronous).
+     * 
+     * @performance The front-end cost in async mode is a CAS, a bounded memcpy and a
+     * fence - tens of nanoseconds, independent of console speed.
+     * 
+     * @threadsafe This method is thread-safe, but is intended to be called once during
+     * startup.
+     */
+    static bool EnableAsync(const AsyncLoggerConfig& config = AsyncLoggerConfig{});
+
+    /**
+     * @brief Blocks until every record queued before the call has been written.
+     * 
+     * @details In synchronous mode console lines are already written; this only flushes
+     * the binary log and requests a file sink flush.
+     * 
+     * @threadsafe This method is thread-safe. It must not be called from the consumer
+     * thread itself.
+     */
+    static void Flush();
+
+    /**
+     * @brief Drains the queue, stops the consumer thread and reverts to synchronous mode.
+     * 
+     * @details Intended to be called by main() before exit so no queued records are lost.
+     * Records that race with shutdown are still written: a producer that observes the
+     * transition after publishing drains the queue itself.
+     * 
+     * @note The queue storage is intentionally retained for the process lifetime so that
+     * late producers never touch freed memory.
+     * 
+     * @threadsafe This method is thread-safe. Calling it when async mode is not active is
+     * a no-op apart from flushing the streams.
+     */
+    static void Shutdown();
+
+    /**
+     * @brief Detects the console and stream kinds now instead of on the first log line.
+     * 
+     * @details Lets startup pay for console detection in a bootstrap task that runs
+     * alongside other subsystems. Calling it is optional and repeated calls are no-ops.
+     * 
+     * @threadsafe This method is thread-safe.
+     */
+    static void InitializeConsole();
+
+    /**
+     * @brief Returns the number of records discarded by the overflow policy.
+     * 
+     * @threadsafe This method is thread-safe.
+     */
+    static uint64_t GetDroppedCount();
+
+    /**
+     * @brief Returns the approximate number of queued records (0 in synchronous mode).
+     * 
+     * @threadsafe This method is thread-safe.
+     */
+    static size_t GetQueueDepth();
+
+    /**
+     * @brief Maximum message bytes stored per queued record.
+     * 
+     * @details Chosen so that a record (text, length, severity and kind) is exactly 256
+     * bytes; with its 8-byte sequence number, each cache-line-aligned ring cell then takes
+     * five cache lines (320 bytes). Also bounds the size of an encoded binary record.
+     * Longer text is cut back to a UTF-8 code point boundary.
+     */
+    static constexpr size_t LOG_RECORD_TEXT_CAPACITY = 252;
+
 private:
     /**
      * @brief Mutex for synchronizing console access across threads.
@@ -167,6 +551,198 @@ private:
      * the consoleMutex_ lock.
      */
     static void Initialize();
+
+    /**
+     * @brief Writes one line with the color and stream matching its severity.
+     * 
+     * @note Must be called with consoleMutex_ held.
+     */
+    static void WriteLineLocked(LogLevel level, const char* text, size_t length);
+
+    /**
+     * @brief How a standard handle is written, detected once in Initialize.
+     */
+    enum class OutputKind : uint8_t {
+        Unavailable,      ///< No handle; console output is discarded
+        LegacyConsole,    ///< Console without VT support; colors via SetConsoleTextAttribute
+        VirtualTerminal,  ///< Console with VT processing; colors via escape sequences
+        Redirected        ///< Pipe or file; raw bytes via WriteFile, no colors
+    };
+
+    /**
+     * @brief A thread's staging buffer for console output. Defined in Logger.cpp.
+     */
+    struct OutputBatch;
+
+    /**
+     * @brief Classifies @p handle and enables VT processing on consoles that support it.
+     */
+    static OutputKind DetectOutputKind(HANDLE handle);
+
+    /**
+     * @brief Stages one line, ending the current run first if the stream (or, on a legacy
+     * console, the color) changes.
+     * 
+     * @note Must be called with consoleMutex_ held.
+     */
+    static void AppendLineLocked(OutputBatch& batch, LogLevel level, const char* text, size_t length);
+
+    /**
+     * @brief Copies bytes into @p batch, writing out full buffers as needed.
+     * 
+     * @note Must be called with consoleMutex_ held.
+     */
+    static void AppendOutputLocked(OutputBatch& batch, const char* data, size_t length);
+
+    /**
+     * @brief Writes the staged bytes with a single WriteConsoleW or WriteFile call.
+     * 
+     * @note Must be called with consoleMutex_ held.
+     */
+    static void WritePendingLocked(OutputBatch& batch);
+
+    /**
+     * @brief Ends the current run: writes staged bytes and restores default colors.
+     * 
+     * @note Must be called with consoleMutex_ held.
+     */
+    static void FlushBatchLocked(OutputBatch& batch);
+
+    /**
+     * @brief Appends one timestamped line to the file sink if it is open.
+     * 
+     * @note Must be called with consoleMutex_ held.
+     */
+    static void WriteFileLineLocked(LogLevel level, const char* text, size_t length);
+
+    /**
+     * @brief Common front end for LogInfo and LogError.
+     * 
+     * @details Routes the message to the async queue when async mode is active, and falls
+     * back to a synchronous mutex-protected write otherwise.
+     */
+    static void Dispatch(LogLevel level, std::string_view message);
+
+    /**
+     * @brief Attempts to publish a record to the async queue.
+     * 
+     * @return true if the record was handled (queued or dropped by policy), false if async
+     *         mode is not active and the caller must write synchronously.
+     */
+    static bool TryEnqueue(LogLevel level, bool binary, const char* text, size_t length);
+
+    /**
+     * @brief Shared implementation of the format-string and structured overloads.
+     * 
+     * @param format Format text; its data() pointer identifies the format in binary mode.
+     */
+    template <typename... Args>
+    static void Emit(LogLevel level, std::string_view format, const Args&... args) {
+        if (binaryActive_.load(std::memory_order_acquire)) {
+            // ETW sessions want text; format here only while one is listening
+            if (EtwTrace::IsEnabled(level, EtwTrace::KEYWORD_LOG)) {
+                EtwTrace::WriteLog(level, FormatToThreadBuffer(format, std::make_format_args(args...)));
+            }
+            
+            // Binary mode: record the raw arguments, no formatting on this thread
+            BinaryRecordEncoder encoder(level, LogFormatRegistry::Intern(format.data()));
+            (encoder.Append(args), ...);
+            DispatchBinary(level, encoder);
+            return;
+        }
+        
+        Dispatch(level, FormatToThreadBuffer(format, std::make_format_args(args...)));
+    }
+
+    /**
+     * @brief Renders a message into the calling thread's reusable format buffer.
+     * 
+     * @details Output longer than the buffer is truncated. If the format string is
+     * invalid (runtime-checked overloads only), the format text itself is returned.
+     * 
+     * @return View of the rendered text, valid until the next call on this thread.
+     */
+    static std::string_view FormatToThreadBuffer(std::string_view format, std::format_args args);
+
+    /**
+     * @brief Routes an encoded binary record to the async queue or writes it directly.
+     */
+    static void DispatchBinary(LogLevel level, const BinaryRecordEncoder& encoder);
+
+    /**
+     * @brief Appends an encoded record to the binary log and mirrors errors if configured.
+     * 
+     * @note Must be called with consoleMutex_ held.
+     */
+    static void WriteBinaryLocked(LogLevel level, const uint8_t* record, size_t size);
+
+    /**
+     * @brief Pops and writes up to maxBatchSize records under consoleMutex_.
+     * 
+     * @return Number of records written.
+     */
+    static size_t DrainBatch();
+
+    /**
+     * @brief Body of the background consumer thread.
+     */
+    static void ConsumerLoop();
+
+    /**
+     * @brief State owned by asynchronous mode (queue, consumer thread, counters).
+     * 
+     * @details Defined in Logger.cpp to keep the ring buffer and threading headers out of
+     * every translation unit that logs.
+     */
+    struct AsyncState;
+
+    /**
+     * @brief Async-mode state, allocated on first EnableAsync and never freed.
+     */
+    static AsyncState* asyncState_;
+
+    /**
+     * @brief True while producers should enqueue instead of writing synchronously.
+     * 
+     * @details Checked on every log call, so it is kept as a standalone atomic rather than
+     * inside AsyncState to avoid an extra indirection on the synchronous path.
+     */
+    static std::atomic<bool> asyncActive_;
+
+    /**
+     * @brief True while records are encoded in binary form instead of formatted to text.
+     */
+    static std::atomic<bool> binaryActive_;
+
+    /**
+     * @brief Binary log file writer. Guarded by consoleMutex_.
+     */
+    static BinaryLogWriter binaryWriter_;
+
+    /**
+     * @brief Whether binary error records are also rendered to the console.
+     * 
+     * @details Guarded by consoleMutex_.
+     */
+    static bool mirrorErrorsToConsole_;
+
+    /**
+     * @brief Memory-mapped file sink. Guarded by consoleMutex_.
+     */
+    static MappedFileSink fileSink_;
+
+    /**
+     * @brief Whether text lines are written to the console.
+     * 
+     * @details Cleared by EnableFileSink(config, false). Guarded by consoleMutex_.
+     */
+    static bool consoleOutputEnabled_;
+
+    /**
+     * @brief Output kinds of stdout and stderr. Set by Initialize.
+     */
+    static OutputKind outputKind_;
+    static OutputKind errorOutputKind_;
 };
 
 } // namespace Utils
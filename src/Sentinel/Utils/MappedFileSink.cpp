@@ -0,0 +1,278 @@
+/**
+ * @file MappedFileSink.cpp
+ * @brief Implementation of the memory-mapped rotating log sink.
+ */
+
+#include "Sentinel/Utils/MappedFileSink.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cwchar>
+
+namespace Sentinel {
+namespace Utils {
+
+// Mapping views are allocated at allocation-granularity boundaries; rounding segment sizes
+// to the same unit avoids wasting the remainder of the last granule
+static constexpr size_t SEGMENT_SIZE_GRANULARITY = 64 * 1024;
+
+MappedFileSink::~MappedFileSink() {
+    Close();
+}
+
+bool MappedFileSink::Open(const MappedFileSinkConfig& config) {
+    Close();
+
+    config_ = config;
+    const size_t requested = (std::max)(config.segmentSize, SEGMENT_SIZE_GRANULARITY);
+    segmentSize_ = (requested + SEGMENT_SIZE_GRANULARITY - 1) & ~(SEGMENT_SIZE_GRANULARITY - 1);
+    nextSequence_ = 0;
+
+    if (!CreateSegment(current_, nextSequence_++)) {
+        return false;
+    }
+
+    // Without the event the flusher's wait would return at once and spin
+    flusherEvent_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (flusherEvent_ == nullptr) {
+        std::wstring path = current_.path;
+        RetireSegment(current_);
+        DeleteFileW(path.c_str());
+        current_ = Segment{};
+        return false;
+    }
+    createdPaths_.push_back(current_.path);
+    publishedUsed_.store(0, std::memory_order_relaxed);
+
+    stopRequested_.store(false, std::memory_order_relaxed);
+    try {
+        flusher_ = std::thread(&MappedFileSink::FlusherLoop, this);
+    } catch (const std::system_error&) {
+        // Without the flusher the sink still works: rotation creates segments inline and
+        // retirement happens on Close
+    }
+    return true;
+}
+
+void MappedFileSink::Close() {
+    if (flusher_.joinable()) {
+        stopRequested_.store(true, std::memory_order_release);
+        SetEvent(flusherEvent_);
+        flusher_.join();
+    }
+    if (flusherEvent_ != nullptr) {
+        CloseHandle(flusherEvent_);
+        flusherEvent_ = nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(viewMutex_);
+    if (current_.view != nullptr) {
+        RetireSegment(current_);
+    }
+    for (Segment& segment : retired_) {
+        RetireSegment(segment);
+    }
+    retired_.clear();
+
+    // The spare was never written to; delete it rather than leaving an empty file behind
+    if (spare_.view != nullptr) {
+        std::wstring sparePath = spare_.path;
+        RetireSegment(spare_);
+        DeleteFileW(sparePath.c_str());
+    }
+    spare_ = Segment{};
+    current_ = Segment{};
+    createdPaths_.clear();
+}
+
+bool MappedFileSink::CreateSegment(Segment& segment, uint64_t sequence) {
+    wchar_t name[MAX_PATH];
+    int length = swprintf(name, MAX_PATH, L"%ls\\%ls-%lu-%06llu.log",
+                          config_.directory.c_str(), config_.baseName.c_str(),
+                          static_cast<unsigned long>(GetCurrentProcessId()),
+                          static_cast<unsigned long long>(sequence));
+    if (length <= 0) {
+        return false;
+    }
+
+    HANDLE file = CreateFileW(name, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    // Creating the mapping with an explicit size extends the file: this is the preallocation
+    const ULARGE_INTEGER size{{static_cast<DWORD>(segmentSize_ & 0xFFFFFFFFULL),
+                               static_cast<DWORD>(static_cast<uint64_t>(segmentSize_) >> 32)}};
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, size.HighPart, size.LowPart, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        DeleteFileW(name);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, segmentSize_);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        DeleteFileW(name);
+        return false;
+    }
+
+    segment.file = file;
+    segment.mapping = mapping;
+    segment.view = static_cast<char*>(view);
+    segment.used = 0;
+    segment.path = name;
+    return true;
+}
+
+void MappedFileSink::RetireSegment(Segment& segment) {
+    if (segment.view != nullptr) {
+        FlushViewOfFile(segment.view, segment.used);
+        UnmapViewOfFile(segment.view);
+        segment.view = nullptr;
+    }
+    if (segment.mapping != nullptr) {
+        CloseHandle(segment.mapping);
+        segment.mapping = nullptr;
+    }
+    if (segment.file != INVALID_HANDLE_VALUE) {
+        // Drop the unused preallocated tail now that the segment is complete
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>(segment.used);
+        if (SetFilePointerEx(segment.file, end, nullptr, FILE_BEGIN)) {
+            SetEndOfFile(segment.file);
+        }
+        CloseHandle(segment.file);
+        segment.file = INVALID_HANDLE_VALUE;
+    }
+    segment.used = 0;
+}
+
+void MappedFileSink::Rotate() {
+    std::lock_guard<std::mutex> lock(viewMutex_);
+
+    // Hand the full segment to the flusher for retirement
+    retired_.push_back(current_);
+    current_ = Segment{};
+
+    if (spare_.view != nullptr) {
+        current_ = spare_;
+        spare_ = Segment{};
+    } else if (!CreateSegment(current_, nextSequence_++)) {
+        // Out of disk or handles: keep logging into nothing rather than failing the caller
+        current_ = Segment{};
+    }
+
+    if (current_.view != nullptr) {
+        createdPaths_.push_back(current_.path);
+    }
+    publishedUsed_.store(0, std::memory_order_release);
+
+    if (flusherEvent_ != nullptr) {
+        SetEvent(flusherEvent_);
+    }
+}
+
+void MappedFileSink::Write(const char* data, size_t length) {
+    WriteParts(&data, &length, 1);
+}
+
+void MappedFileSink::WriteParts(const char* const* parts, const size_t* lengths, size_t count) {
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        total += lengths[i];
+    }
+    if (total == 0 || current_.view == nullptr) {
+        return;
+    }
+
+    if (current_.used + total > segmentSize_) {
+        Rotate();
+        if (current_.view == nullptr) {
+            return;
+        }
+    }
+
+    // Plain memcpy into the mapping; the kernel owns persistence from here on
+    size_t remaining = segmentSize_ - current_.used;
+    for (size_t i = 0; i < count && remaining > 0; ++i) {
+        const size_t chunk = (std::min)(lengths[i], remaining);
+        std::memcpy(current_.view + current_.used, parts[i], chunk);
+        current_.used += chunk;
+        remaining -= chunk;
+    }
+    publishedUsed_.store(current_.used, std::memory_order_release);
+}
+
+void MappedFileSink::RequestFlush() {
+    if (flusherEvent_ != nullptr) {
+        SetEvent(flusherEvent_);
+    }
+}
+
+void MappedFileSink::EnforceRetention() {
+    // Called with viewMutex_ held. Only files created by this sink are ever deleted.
+    if (config_.maxSegments == 0) {
+        return;
+    }
+    while (createdPaths_.size() > config_.maxSegments) {
+        // A file that cannot be deleted yet (still being retired, or opened by a reader)
+        // stays at the front and is retried on the next pass
+        if (!DeleteFileW(createdPaths_.front().c_str()) && GetLastError() != ERROR_FILE_NOT_FOUND) {
+            return;
+        }
+        createdPaths_.pop_front();
+    }
+}
+
+void MappedFileSink::FlusherLoop() {
+    while (!stopRequested_.load(std::memory_order_acquire)) {
+        WaitForSingleObject(flusherEvent_, config_.flushIntervalMs);
+
+        std::vector<Segment> toRetire;
+        bool needSpare = false;
+        uint64_t spareSequence = 0;
+        {
+            std::lock_guard<std::mutex> lock(viewMutex_);
+            toRetire.swap(retired_);
+            needSpare = (spare_.view == nullptr);
+            if (needSpare) {
+                spareSequence = nextSequence_++;
+            }
+
+            // Asynchronous durability for the live segment
+            if (current_.view != nullptr) {
+                FlushViewOfFile(current_.view, publishedUsed_.load(std::memory_order_acquire));
+            }
+        }
+
+        // Retirement and preallocation involve file system calls; keep them outside the lock
+        for (Segment& segment : toRetire) {
+            RetireSegment(segment);
+        }
+
+        if (needSpare && !stopRequested_.load(std::memory_order_acquire)) {
+            Segment spare;
+            if (CreateSegment(spare, spareSequence)) {
+                std::unique_lock<std::mutex> lock(viewMutex_);
+                if (nextSequence_ == spareSequence + 1) {
+                    spare_ = spare;
+                } else {
+                    // Rotate created a newer segment inline meanwhile; using this one after
+                    // it would put the files out of order, so the next pass makes another
+                    lock.unlock();
+                    std::wstring sparePath = spare.path;
+                    RetireSegment(spare);
+                    DeleteFileW(sparePath.c_str());
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(viewMutex_);
+        EnforceRetention();
+    }
+}
+
+} // namespace Utils
+} // namespace Sentinel
@@ -0,0 +1,181 @@
+/**
+ * @file MappedFileSink.hpp
+ * @brief Memory-mapped, preallocated, size-rotated log file sink.
+ *
+ * @details This module exists because console output is the slowest sink available and the
+ * Sentinel service usually runs without a console at all. Writing log lines with WriteFile
+ * would still cost a system call per batch; writing into a memory-mapped view of a
+ * preallocated file turns each line into a plain memcpy.
+ *
+ * Mapped files also give a forensic property the console cannot: pages written to a file
+ * mapping belong to the system file cache, not to the process. If the monitored process
+ * crashes - the exact moment CrashInterceptor records are most valuable - the kernel still
+ * writes the dirty pages to disk, so the log tail survives the crash.
+ *
+ * The design prioritizes:
+ * - Hot-path cost: a bounds check and a memcpy; no system calls while a segment has room
+ * - Rotation without stalls: the flusher thread preallocates the next segment ahead of time,
+ *   so a rotation is a pointer swap; retiring the old segment (flush, unmap, truncate) also
+ *   happens on the flusher thread
+ * - Bounded disk usage: only the newest maxSegments files created by this sink are kept
+ * - Asynchronous durability: FlushViewOfFile runs periodically on the flusher thread
+ *
+ * Unused space at the end of a segment is zero-filled; after a crash the log ends at the
+ * first NUL byte. Segments closed normally are truncated to their used length.
+ *
+ * @security Log files are created with default security inherited from the target
+ * directory. Deploy them in a directory that only the service account can write.
+ *
+ * @performance Write is O(length). Rotation on the writing thread is O(1) when a spare
+ * segment is ready, otherwise it creates the segment synchronously (one CreateFile,
+ * CreateFileMapping and MapViewOfFile).
+ *
+ * @see Logger::EnableFileSink
+ */
+
+#pragma once
+
+#include <Windows.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Sentinel {
+namespace Utils {
+
+/**
+ * @brief Configuration for MappedFileSink::Open.
+ */
+struct MappedFileSinkConfig {
+    /** @brief Directory that receives the segment files. Must exist. */
+    std::wstring directory = L".";
+
+    /** @brief File name prefix; segments are named <baseName>-<pid>-<sequence>.log. */
+    std::wstring baseName = L"sentinel";
+
+    /** @brief Size of each preallocated segment in bytes (rounded up to 64 KB). */
+    size_t segmentSize = 16 * 1024 * 1024;
+
+    /** @brief Number of most recent segments to keep on disk (0 = keep all). */
+    size_t maxSegments = 8;
+
+    /** @brief Interval between asynchronous FlushViewOfFile calls. */
+    DWORD flushIntervalMs = 1000;
+};
+
+/**
+ * @class MappedFileSink
+ * @brief Appends bytes to a rotating set of memory-mapped log segments.
+ *
+ * Usage example:
+ * @code
+ * MappedFileSink sink;
+ * if (sink.Open(MappedFileSinkConfig{L"C:\\ProgramData\\Sentinel\\logs"})) {
+ *     sink.Write("service started\n", 16);
+ * }
+ * sink.Close();
+ * @endcode
+ *
+ * @threadsafe Write must be called by one thread at a time (the Logger serializes it with
+ * its console mutex). Open and Close must not race with Write. The internal flusher thread
+ * synchronizes with rotation through its own lock, which Write does not take unless it
+ * rotates.
+ */
+class MappedFileSink {
+public:
+    MappedFileSink() = default;
+    ~MappedFileSink();
+
+    MappedFileSink(const MappedFileSink&) = delete;
+    MappedFileSink& operator=(const MappedFileSink&) = delete;
+
+    /**
+     * @brief Creates the first segment and starts the flusher thread.
+     *
+     * @return true if the first segment was mapped.
+     */
+    bool Open(const MappedFileSinkConfig& config);
+
+    /**
+     * @brief Retires all segments (flushed and truncated) and stops the flusher thread.
+     */
+    void Close();
+
+    /** @brief true while a segment is mapped. */
+    bool IsOpen() const noexcept { return current_.view != nullptr; }
+
+    /**
+     * @brief Copies @p length bytes into the current segment, rotating first if needed.
+     *
+     * @details Data is never split across segments. Writes larger than a whole segment
+     * are truncated to the segment size.
+     */
+    void Write(const char* data, size_t length);
+
+    /**
+     * @brief Writes several pieces as one unit that never straddles a segment boundary.
+     *
+     * @details Used to emit a log line (timestamp, prefix, text, newline) without building
+     * it in an intermediate buffer first.
+     */
+    void WriteParts(const char* const* parts, const size_t* lengths, size_t count);
+
+    /**
+     * @brief Requests an asynchronous flush of the current segment.
+     */
+    void RequestFlush();
+
+private:
+    /**
+     * @brief One mapped segment file.
+     */
+    struct Segment {
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+        char* view = nullptr;
+        size_t used = 0;
+        std::wstring path;
+    };
+
+    /**
+     * @brief Creates and maps segment file number @p sequence.
+     *
+     * @details Sequence numbers are taken from nextSequence_ under viewMutex_ by the
+     * caller, so the writer and the flusher never build the same name.
+     */
+    bool CreateSegment(Segment& segment, uint64_t sequence);
+    static void RetireSegment(Segment& segment);
+    void Rotate();
+    void FlusherLoop();
+    void EnforceRetention();
+
+    MappedFileSinkConfig config_;
+    size_t segmentSize_ = 0;
+
+    // Next segment file number, guarded by viewMutex_ once the flusher runs
+    uint64_t nextSequence_ = 0;
+
+    // Written only by the writing thread; read by the flusher under viewMutex_
+    Segment current_;
+
+    // Protects current_ against the flusher, plus spare_, retired_ and createdPaths_
+    std::mutex viewMutex_;
+    Segment spare_;
+    std::vector<Segment> retired_;
+    std::deque<std::wstring> createdPaths_;
+
+    // Mirrors current_.used for the flusher, which must not read the writer's field
+    std::atomic<size_t> publishedUsed_{0};
+
+    std::thread flusher_;
+    HANDLE flusherEvent_ = nullptr;
+    std::atomic<bool> stopRequested_{false};
+};
+
+} // namespace Utils
+} // namespace Sentinel
@@ -0,0 +1,134 @@
+/**
+ * @file Metrics.cpp
+ * @brief Implementation of the metrics registry and histogram merging.
+ */
+
+#include "Sentinel/Utils/Metrics.hpp"
+#include <cstring>
+
+namespace Sentinel {
+namespace Utils {
+
+MetricsRegistry::Entry MetricsRegistry::entries_[MAX_METRICS];
+std::atomic<size_t> MetricsRegistry::count_{0};
+SRWLOCK MetricsRegistry::lock_ = SRWLOCK_INIT;
+
+// QueryPerformanceFrequency is fixed at boot; 0 means not queried yet
+static std::atomic<int64_t> performanceFrequency{0};
+
+uint64_t TicksToNanoseconds(LONGLONG ticks) noexcept {
+    if (ticks <= 0) {
+        return 0;
+    }
+    int64_t frequency = performanceFrequency.load(std::memory_order_relaxed);
+    if (frequency == 0) {
+        LARGE_INTEGER queried;
+        QueryPerformanceFrequency(&queried);
+        frequency = queried.QuadPart;
+        performanceFrequency.store(frequency, std::memory_order_relaxed);
+    }
+    // Split the conversion so that ticks * 1e9 cannot overflow
+    const uint64_t whole = static_cast<uint64_t>(ticks / frequency);
+    const uint64_t remainder = static_cast<uint64_t>(ticks % frequency);
+    return whole * 1000000000ull + remainder * 1000000000ull / static_cast<uint64_t>(frequency);
+}
+
+uint64_t HistogramSnapshot::ValueAtQuantile(double quantile) const noexcept {
+    if (count == 0) {
+        return 0;
+    }
+    quantile = quantile < 0.0 ? 0.0 : (quantile > 1.0 ? 1.0 : quantile);
+    uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(count));
+    rank = rank == 0 ? 1 : (rank > count ? count : rank);
+
+    uint64_t seen = 0;
+    for (size_t index = 0; index < HISTOGRAM_BUCKET_COUNT; ++index) {
+        seen += buckets[index];
+        if (seen >= rank) {
+            const uint64_t upper = HistogramBucketUpperBound(index);
+            return upper < max ? upper : max;
+        }
+    }
+    // Buckets lag count under concurrent recording
+    return max;
+}
+
+void Histogram::Read(HistogramSnapshot* out) const noexcept {
+    *out = HistogramSnapshot{};
+    for (const Shard& shard : shards_) {
+        out->count += shard.count.load(std::memory_order_relaxed);
+        out->sum += shard.sum.load(std::memory_order_relaxed);
+        const uint64_t max = shard.max.load(std::memory_order_relaxed);
+        out->max = max > out->max ? max : out->max;
+        for (size_t index = 0; index < HISTOGRAM_BUCKET_COUNT; ++index) {
+            out->buckets[index] += shard.buckets[index].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool MetricsRegistry::Register(const char* name, const Counter& counter) noexcept {
+    return Add(Entry{name, MetricKind::Counter, &counter, nullptr});
+}
+
+bool MetricsRegistry::Register(const char* name, const Gauge& gauge) noexcept {
+    return Add(Entry{name, MetricKind::Gauge, &gauge, nullptr});
+}
+
+bool MetricsRegistry::Register(const char* name, const Histogram& histogram) noexcept {
+    return Add(Entry{name, MetricKind::Histogram, &histogram, nullptr});
+}
+
+bool MetricsRegistry::Register(const char* name, MetricKind kind, Sampler sampler) noexcept {
+    if (kind == MetricKind::Histogram || sampler == nullptr) {
+        return false;
+    }
+    return Add(Entry{name, kind, nullptr, sampler});
+}
+
+bool MetricsRegistry::Add(const Entry& entry) noexcept {
+    // Runs from static constructors, possibly before the Logger is usable, so failures are
+    // reported through the return value only
+    if (entry.name == nullptr) {
+        return false;
+    }
+    AcquireSRWLockExclusive(&lock_);
+    const size_t count = count_.load(std::memory_order_relaxed);
+    bool added = count < MAX_METRICS;
+    for (size_t index = 0; added && index < count; ++index) {
+        added = std::strcmp(entries_[index].name, entry.name) != 0;
+    }
+    if (added) {
+        entries_[count] = entry;
+        // Publishes the entry to lock-free readers
+        count_.store(count + 1, std::memory_order_release);
+    }
+    ReleaseSRWLockExclusive(&lock_);
+    return added;
+}
+
+size_t MetricsRegistry::GetCount() noexcept {
+    return count_.load(std::memory_order_acquire);
+}
+
+bool MetricsRegistry::Read(size_t index, MetricSample* out) noexcept {
+    if (index >= GetCount()) {
+        return false;
+    }
+    const Entry& entry = entries_[index];
+    out->name = entry.name;
+    out->kind = entry.kind;
+    out->value = 0;
+    if (entry.sampler != nullptr) {
+        out->value = entry.sampler();
+    } else if (entry.kind == MetricKind::Counter) {
+        out->value = static_cast<int64_t>(static_cast<const Counter*>(entry.metric)->Get());
+    } else if (entry.kind == MetricKind::Gauge) {
+        out->value = static_cast<const Gauge*>(entry.metric)->Get();
+    } else {
+        static_cast<const Histogram*>(entry.metric)->Read(&out->histogram);
+    }
+    return true;
+}
+
+} // namespace Utils
+} // namespace Sentinel
@@ -0,0 +1,344 @@
+/**
+ * @file Metrics.hpp
+ * @brief Process-wide registry of counters, gauges and latency histograms.
+ *
+ * @details Sentinel measures other processes but had no numbers about itself: how long the
+ * exception handler runs, how full the log queue is, how long an audit pass takes. This
+ * module is the one place those numbers live, so the Service can ask for all of them at
+ * once (see Comms/MetricsSnapshot.hpp).
+ * - Counter and Gauge are single atomics; updating one is a relaxed fetch_add or store.
+ * - Histogram records values into log-linear buckets in the style of HdrHistogram: eight
+ *   sub-buckets per power of two, so every bucket is within 12.5% of the values in it,
+ *   over the whole 64-bit range and with a fixed 4 KiB of buckets. Each histogram holds
+ *   SHARD_COUNT such bucket sets on separate cache lines and a thread records into the
+ *   shard selected by its thread id, so concurrent writers rarely share a line. Shards
+ *   are merged when the histogram is read.
+ * - A metric that already exists as state elsewhere (a queue's depth) is registered as a
+ *   sampler function, evaluated only when a snapshot is taken.
+ *
+ * Metrics are objects with static storage duration that register themselves by name with
+ * a MetricRegistration at namespace scope. The registry and all metric types are constant
+ * initialized, so registration from static constructors does not depend on initialization
+ * order, and metrics can be updated before main() and from the exception handler.
+ *
+ * @security Metrics carry counts and durations only, never addresses or names from the
+ * monitored system.
+ *
+ * @performance Recording never allocates, locks or enters the kernel and is safe inside the
+ * Vectored Exception Handler. Reading a histogram sums SHARD_COUNT x HISTOGRAM_BUCKET_COUNT
+ * counters and is meant for snapshots, not hot paths.
+ */
+
+#pragma once
+
+#include <Windows.h>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace Sentinel {
+namespace Utils {
+
+enum class MetricKind : uint8_t {
+    Counter = 0,
+    Gauge = 1,
+    Histogram = 2,
+};
+
+/** @brief Sub-buckets per power of two are 2^HISTOGRAM_SUB_BUCKET_BITS. */
+inline constexpr unsigned HISTOGRAM_SUB_BUCKET_BITS = 3;
+
+inline constexpr size_t HISTOGRAM_SUB_BUCKETS = size_t{1} << HISTOGRAM_SUB_BUCKET_BITS;
+
+/** @brief Values below HISTOGRAM_SUB_BUCKETS are exact; every octave above gets its own row. */
+inline constexpr size_t HISTOGRAM_BUCKET_COUNT = (64 - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKETS;
+
+/**
+ * @brief Bucket holding @p value.
+ */
+constexpr size_t HistogramBucketIndex(uint64_t value) noexcept {
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    const unsigned exponent = static_cast<unsigned>(std::bit_width(value)) - 1;
+    const unsigned shift = exponent - HISTOGRAM_SUB_BUCKET_BITS;
+    const size_t subBucket = static_cast<size_t>(value >> shift) & (HISTOGRAM_SUB_BUCKETS - 1);
+    return (shift + 1) * HISTOGRAM_SUB_BUCKETS + subBucket;
+}
+
+/**
+ * @brief Smallest value in bucket @p index.
+ */
+constexpr uint64_t HistogramBucketLowerBound(size_t index) noexcept {
+    if (index < HISTOGRAM_SUB_BUCKETS) {
+        return index;
+    }
+    const size_t shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+    return (HISTOGRAM_SUB_BUCKETS + index % HISTOGRAM_SUB_BUCKETS) << shift;
+}
+
+/**
+ * @brief Largest value in bucket @p index.
+ */
+constexpr uint64_t HistogramBucketUpperBound(size_t index) noexcept {
+    if (index < HISTOGRAM_SUB_BUCKETS) {
+        return index;
+    }
+    const size_t shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+    return HistogramBucketLowerBound(index) + ((uint64_t{1} << shift) - 1);
+}
+
+static_assert(HistogramBucketIndex(UINT64_MAX) == HISTOGRAM_BUCKET_COUNT - 1, "buckets must cover 64 bits");
+static_assert(HistogramBucketUpperBound(HISTOGRAM_BUCKET_COUNT - 1) == UINT64_MAX, "buckets must cover 64 bits");
+
+/**
+ * @class Counter
+ * @brief Monotonic event count.
+ *
+ * @threadsafe All methods are thread-safe and async-signal safe.
+ */
+class Counter {
+public:
+    constexpr Counter() noexcept = default;
+
+    Counter(const Counter&) = delete;
+    Counter& operator=(const Counter&) = delete;
+
+    void Add(uint64_t count = 1) noexcept { value_.fetch_add(count, std::memory_order_relaxed); }
+    uint64_t Get() const noexcept { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+/**
+ * @class Gauge
+ * @brief Current level of something that goes up and down.
+ *
+ * @threadsafe All methods are thread-safe and async-signal safe.
+ */
+class Gauge {
+public:
+    constexpr Gauge() noexcept = default;
+
+    Gauge(const Gauge&) = delete;
+    Gauge& operator=(const Gauge&) = delete;
+
+    void Set(int64_t value) noexcept { value_.store(value, std::memory_order_relaxed); }
+    void Add(int64_t delta) noexcept { value_.fetch_add(delta, std::memory_order_relaxed); }
+    int64_t Get() const noexcept { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+/**
+ * @brief Merged contents of a Histogram.
+ *
+ * @details A concurrent Record may be counted in some fields and not yet in others, so the
+ * fields of a snapshot taken under load agree only approximately.
+ */
+struct HistogramSnapshot {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    uint64_t buckets[HISTOGRAM_BUCKET_COUNT] = {};
+
+    /**
+     * @brief Upper bound of the bucket holding the @p quantile (0.0 to 1.0) of the values,
+     * capped at max; 0 if nothing was recorded.
+     */
+    uint64_t ValueAtQuantile(double quantile) const noexcept;
+
+    /** @brief Mean of the recorded values; 0 if nothing was recorded. */
+    uint64_t Mean() const noexcept { return count != 0 ? sum / count : 0; }
+};
+
+// Shards are cache-line aligned so that threads recording into different shards never
+// share a line; silence the padding warning (C4324) that /W4 /WX would turn into an error.
+#pragma warning(push)
+#pragma warning(disable : 4324) // structure was padded due to alignment specifier
+
+/**
+ * @class Histogram
+ * @brief Lock-free log-linear histogram with per-thread shards.
+ *
+ * Usage example:
+ * @code
+ * static Histogram scanLatency;
+ * static const MetricRegistration scanLatencyMetric("auditor.scan_ns", scanLatency);
+ *
+ * {
+ *     ScopedTimer timer(scanLatency);
+ *     Scan();
+ * }
+ * @endcode
+ *
+ * @threadsafe Record is thread-safe and async-signal safe. Read may run concurrently with
+ * Record.
+ */
+class Histogram {
+public:
+    /** @brief Number of shards; a power of two. */
+    static constexpr size_t SHARD_COUNT = 8;
+
+    constexpr Histogram() noexcept = default;
+
+    Histogram(const Histogram&) = delete;
+    Histogram& operator=(const Histogram&) = delete;
+
+    void Record(uint64_t value) noexcept {
+        // Thread ids are multiples of four
+        Shard& shard = shards_[(GetCurrentThreadId() >> 2) & (SHARD_COUNT - 1)];
+        shard.buckets[HistogramBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        shard.count.fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(value, std::memory_order_relaxed);
+        uint64_t max = shard.max.load(std::memory_order_relaxed);
+        while (value > max && !shard.max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * @brief Merges all shards into @p out.
+     */
+    void Read(HistogramSnapshot* out) const noexcept;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> max{0};
+        std::atomic<uint64_t> buckets[HISTOGRAM_BUCKET_COUNT]{};
+    };
+
+    Shard shards_[SHARD_COUNT];
+};
+
+#pragma warning(pop)
+
+/**
+ * @brief Converts a QueryPerformanceCounter interval to nanoseconds.
+ *
+ * @threadsafe Thread-safe and async-signal safe.
+ */
+uint64_t TicksToNanoseconds(LONGLONG ticks) noexcept;
+
+/**
+ * @class ScopedTimer
+ * @brief Records the lifetime of the object, in nanoseconds, into a Histogram.
+ *
+ * @threadsafe Async-signal safe; the timer itself belongs to one thread.
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram) noexcept : histogram_(histogram) { QueryPerformanceCounter(&start_); }
+
+    ~ScopedTimer() {
+        LARGE_INTEGER end;
+        QueryPerformanceCounter(&end);
+        histogram_.Record(TicksToNanoseconds(end.QuadPart - start_.QuadPart));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram& histogram_;
+    LARGE_INTEGER start_;
+};
+
+/**
+ * @brief One metric as read from the registry or decoded from a snapshot.
+ */
+struct MetricSample {
+    std::string_view name;
+    MetricKind kind = MetricKind::Counter;
+
+    /** @brief Value of a counter or gauge. */
+    int64_t value = 0;
+
+    /** @brief Contents of a histogram. */
+    HistogramSnapshot histogram;
+};
+
+/**
+ * @class MetricsRegistry
+ * @brief Fixed-capacity, append-only table of the process's metrics.
+ *
+ * @details Names are dotted, lower case and carry their unit, e.g. "crash.handler_ns".
+ * Registered metrics must outlive every reader; in practice they have static storage
+ * duration. There is no unregistration.
+ *
+ * @threadsafe All methods are thread-safe. Registration takes a lock; reading does not.
+ */
+class MetricsRegistry {
+public:
+    /** @brief Maximum number of registered metrics. */
+    static constexpr size_t MAX_METRICS = 64;
+
+    /** @brief Produces the current value of a sampled counter or gauge. */
+    using Sampler = int64_t (*)();
+
+    /**
+     * @return false if the registry is full or @p name is already registered.
+     */
+    static bool Register(const char* name, const Counter& counter) noexcept;
+    static bool Register(const char* name, const Gauge& gauge) noexcept;
+    static bool Register(const char* name, const Histogram& histogram) noexcept;
+
+    /**
+     * @brief Registers a counter or gauge whose value is computed by @p sampler when read.
+     */
+    static bool Register(const char* name, MetricKind kind, Sampler sampler) noexcept;
+
+    /** @brief Number of registered metrics; indices below it stay valid. */
+    static size_t GetCount() noexcept;
+
+    /**
+     * @brief Reads metric @p index into @p out.
+     *
+     * @return false if @p index is out of range.
+     */
+    static bool Read(size_t index, MetricSample* out) noexcept;
+
+private:
+    struct Entry {
+        const char* name;
+        MetricKind kind;
+        const void* metric;
+        Sampler sampler;
+    };
+
+    static bool Add(const Entry& entry) noexcept;
+
+    static Entry entries_[MAX_METRICS];
+    static std::atomic<size_t> count_;
+    static SRWLOCK lock_;
+};
+
+/**
+ * @class MetricRegistration
+ * @brief Registers a metric from a namespace-scope declaration.
+ *
+ * Usage example:
+ * @code
+ * static Counter framesDropped;
+ * static const MetricRegistration framesDroppedMetric("pipe.frames_dropped", framesDropped);
+ * @endcode
+ */
+class MetricRegistration {
+public:
+    MetricRegistration(const char* name, const Counter& counter) noexcept { MetricsRegistry::Register(name, counter); }
+    MetricRegistration(const char* name, const Gauge& gauge) noexcept { MetricsRegistry::Register(name, gauge); }
+    MetricRegistration(const char* name, const Histogram& histogram) noexcept {
+        MetricsRegistry::Register(name, histogram);
+    }
+    MetricRegistration(const char* name, MetricKind kind, MetricsRegistry::Sampler sampler) noexcept {
+        MetricsRegistry::Register(name, kind, sampler);
+    }
+};
+
+} // namespace Utils
+} // namespace Sentinel
@@ -0,0 +1,115 @@
+/**
+ * @file SlabPool.cpp
+ * @brief Implementation of the SLIST block pool.
+ */
+
+#include "Sentinel/Utils/SlabPool.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+#include <new>
+
+namespace Sentinel {
+namespace Utils {
+
+static_assert(sizeof(SLIST_ENTRY) <= 64, "slab block header must fit before the block");
+
+SlabPool::~SlabPool() {
+    if (slab_ != nullptr) {
+        VirtualFree(slab_, 0, MEM_RELEASE);
+        if (stats_ != nullptr) {
+            stats_->bytesReserved.Add(-static_cast<int64_t>(slabSize_));
+        }
+    }
+}
+
+bool SlabPool::Initialize(size_t blockSize, size_t blockCount, AllocatorStats* stats) {
+    if (slab_ != nullptr || blockSize == 0) {
+        Logger::LogError("SlabPool: already initialized or zero block size");
+        return false;
+    }
+    InitializeSListHead(&free_);
+    blockSize_ = blockSize;
+    stride_ = (BLOCK_OFFSET + blockSize + 63) & ~static_cast<size_t>(63);
+    stats_ = stats;
+    if (blockCount == 0) {
+        return true;
+    }
+
+    slabSize_ = stride_ * blockCount;
+    slab_ = static_cast<uint8_t*>(VirtualAlloc(nullptr, slabSize_, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+    if (slab_ == nullptr) {
+        Logger::Error("SlabPool: cannot allocate {} blocks of {} bytes ({})", blockCount, blockSize, GetLastError());
+        slabSize_ = 0;
+        return false;
+    }
+    // Pushed in reverse so the first blocks handed out are at the start of the slab
+    for (size_t i = blockCount; i-- > 0;) {
+        InterlockedPushEntrySList(&free_, reinterpret_cast<PSLIST_ENTRY>(slab_ + i * stride_));
+    }
+    if (stats_ != nullptr) {
+        stats_->bytesReserved.Add(static_cast<int64_t>(slabSize_));
+    }
+    return true;
+}
+
+uint8_t* SlabPool::Pop() noexcept {
+    PSLIST_ENTRY entry = InterlockedPopEntrySList(&free_);
+    if (entry == nullptr) {
+        return nullptr;
+    }
+    if (stats_ != nullptr) {
+        stats_->bytesInUse.Add(static_cast<int64_t>(blockSize_));
+    }
+    return reinterpret_cast<uint8_t*>(entry) + BLOCK_OFFSET;
+}
+
+void SlabPool::CountOverflow() noexcept {
+    overflowCount_.fetch_add(1, std::memory_order_relaxed);
+    if (stats_ != nullptr) {
+        stats_->overflows.Add();
+    }
+}
+
+uint8_t* SlabPool::Acquire() noexcept {
+    uint8_t* block = Pop();
+    if (block != nullptr) {
+        return block;
+    }
+    CountOverflow();
+    return new (std::nothrow) uint8_t[blockSize_];
+}
+
+void SlabPool::Release(uint8_t* block) noexcept {
+    if (block == nullptr) {
+        return;
+    }
+    if (Owns(block)) {
+        if (stats_ != nullptr) {
+            stats_->bytesInUse.Add(-static_cast<int64_t>(blockSize_));
+        }
+        InterlockedPushEntrySList(&free_, reinterpret_cast<PSLIST_ENTRY>(block - BLOCK_OFFSET));
+    } else {
+        delete[] block;
+    }
+}
+
+void* SlabPool::do_allocate(size_t bytes, size_t alignment) {
+    if (bytes <= blockSize_ && alignment <= BLOCK_ALIGNMENT) {
+        uint8_t* block = Pop();
+        if (block != nullptr) {
+            return block;
+        }
+    }
+    CountOverflow();
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void SlabPool::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    if (Owns(pointer)) {
+        Release(static_cast<uint8_t*>(pointer));
+    } else {
+        std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+    }
+}
+
+} // namespace Utils
+} // namespace Sentinel
@@ -0,0 +1,132 @@
+/**
+ * @file SlabPool.hpp
+ * @brief Lock-free pool of fixed-size blocks.
+ *
+ * @details Messages and records that are acquired and released at high rates (every
+ * message the Service receives, for one) each need a block that lives until it has been
+ * consumed. Taking those from the heap costs an allocator round trip per block, and under
+ * load the heap lock becomes shared by every producer. SlabPool carves one committed slab
+ * into equal blocks at startup and hands them out through an interlocked singly linked
+ * list (SLIST), so acquiring and releasing a block is a single interlocked
+ * compare-exchange with no lock.
+ *
+ * When the slab is exhausted, Acquire falls back to the heap rather than failing, so a
+ * burst degrades throughput instead of dropping messages; such overflow allocations are
+ * counted and freed again on release.
+ *
+ * The pool is also a std::pmr::memory_resource: requests that fit a block (and at most
+ * BLOCK_ALIGNMENT alignment) are served from the slab, larger ones by the heap, so node
+ * containers such as std::pmr::list can keep their nodes in it.
+ *
+ * @performance Slab blocks are cache-line aligned and never shared between two callers
+ * at once.
+ *
+ * @see PipeServer
+ * @see AllocatorStats
+ */
+
+#pragma once
+
+#include "Sentinel/Utils/AllocatorStats.hpp"
+#include <Windows.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+namespace Sentinel {
+namespace Utils {
+
+#pragma warning(push)
+#pragma warning(disable : 4324) // structure was padded due to alignment specifier
+
+/**
+ * @class SlabPool
+ * @brief Slab-backed SLIST of equal-sized blocks with heap overflow.
+ *
+ * Usage example:
+ * @code
+ * SlabPool pool;
+ * pool.Initialize(64 * 1024, 256);
+ * uint8_t* buffer = pool.Acquire();
+ * // ... fill and consume ...
+ * pool.Release(buffer);
+ * @endcode
+ *
+ * @threadsafe Acquire, Release and the memory_resource interface are thread-safe.
+ * Initialize must complete before any of them is called, and every block must be
+ * released before destruction.
+ */
+class SlabPool : public std::pmr::memory_resource {
+public:
+    /** @brief Alignment of every slab block. */
+    static constexpr size_t BLOCK_ALIGNMENT = 64;
+
+    SlabPool() = default;
+
+    /**
+     * @brief Frees the slab.
+     */
+    ~SlabPool() override;
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    /**
+     * @brief Commits @p blockCount blocks of @p blockSize bytes.
+     *
+     * @param stats Metrics to update, or nullptr.
+     * @return false (and logs) if the pool is already initialized or the slab cannot be
+     *         allocated.
+     */
+    bool Initialize(size_t blockSize, size_t blockCount, AllocatorStats* stats = nullptr);
+
+    /**
+     * @brief Returns a block of GetBlockSize() bytes, or nullptr only if the heap
+     * fallback fails as well.
+     */
+    uint8_t* Acquire() noexcept;
+
+    /**
+     * @brief Returns @p block (from Acquire) to the pool. nullptr is ignored.
+     */
+    void Release(uint8_t* block) noexcept;
+
+    size_t GetBlockSize() const noexcept { return blockSize_; }
+
+    /** @brief Blocks allocated from the heap because the slab was empty or too small. */
+    uint64_t GetOverflowCount() const noexcept { return overflowCount_.load(std::memory_order_relaxed); }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+private:
+    // Each slab block is an SLIST entry followed, one cache line in, by the block
+    static constexpr size_t BLOCK_OFFSET = 64;
+
+    /** @brief Pops a slab block, or nullptr if the slab is empty. */
+    uint8_t* Pop() noexcept;
+
+    /** @brief true if @p block lies in the slab. */
+    bool Owns(const void* block) const noexcept {
+        return static_cast<const uint8_t*>(block) >= slab_ && static_cast<const uint8_t*>(block) < slab_ + slabSize_;
+    }
+
+    /** @brief Counts an allocation the slab could not serve. */
+    void CountOverflow() noexcept;
+
+    SLIST_HEADER free_;
+    uint8_t* slab_ = nullptr;
+    size_t slabSize_ = 0;
+    size_t stride_ = 0;
+    size_t blockSize_ = 0;
+    std::atomic<uint64_t> overflowCount_{0};
+    AllocatorStats* stats_ = nullptr;
+};
+
+#pragma warning(pop)
+
+} // namespace Utils
+} // namespace Sentinel
@@ -0,0 +1,180 @@
+/**
+ * @file ThreadPool.cpp
+ * @brief Implementation of the work-stealing thread pool.
+ */
+
+#include "Sentinel/Utils/ThreadPool.hpp"
+#include <cstdint>
+
+namespace Sentinel {
+namespace Utils {
+
+// Identifies the pool and deque owned by the calling thread, if it is a worker
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local size_t currentWorkerIndex = SIZE_MAX;
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0) {
+            threadCount = 1;
+        }
+    }
+
+    queues_.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    // Workers start only after every deque exists: any of them may be stolen from at once
+    workers_.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers_.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wakeCondition_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::Shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+size_t ThreadPool::CurrentWorkerIndex() const noexcept {
+    return currentPool == this ? currentWorkerIndex : SIZE_MAX;
+}
+
+void ThreadPool::Submit(Task task) {
+    size_t index = CurrentWorkerIndex();
+    if (index == SIZE_MAX) {
+        index = nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    }
+
+    // Count before publishing so pendingCount_ never drops below the number of queued tasks
+    pendingCount_.fetch_add(1, std::memory_order_release);
+    {
+        WorkerQueue& queue = *queues_[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        // Pairs with the predicate check in WorkerLoop so the wakeup cannot be lost
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+    wakeCondition_.notify_one();
+}
+
+bool ThreadPool::TryTake(size_t home, Task& task) {
+    const size_t queueCount = queues_.size();
+    {
+        // Own deque: newest first
+        WorkerQueue& queue = *queues_[home];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            pendingCount_.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+
+    // Other deques: oldest first
+    for (size_t offset = 1; offset < queueCount; ++offset) {
+        WorkerQueue& victim = *queues_[(home + offset) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            pendingCount_.fetch_sub(1, std::memory_order_acq_rel);
+            stealCount_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+    currentPool = this;
+    currentWorkerIndex = index;
+
+    for (;;) {
+        Task task;
+        if (TryTake(index, task)) {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wakeCondition_.wait(lock, [this]() {
+            return stopping_ || pendingCount_.load(std::memory_order_acquire) > 0;
+        });
+        // Queued work still runs during shutdown; exit only once it is gone
+        if (stopping_ && pendingCount_.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::RunChunks(size_t chunkCount, const std::function<void(size_t)>& chunkBody) {
+    struct Completion {
+        size_t remaining;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    Completion completion;
+    completion.remaining = chunkCount;
+
+    // Chunks go out round-robin so that every worker starts with local work
+    const size_t queueCount = queues_.size();
+    const size_t first = nextQueue_.fetch_add(chunkCount, std::memory_order_relaxed);
+    pendingCount_.fetch_add(chunkCount, std::memory_order_release);
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+        WorkerQueue& queue = *queues_[(first + chunk) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back([&chunkBody, &completion, chunk]() {
+            chunkBody(chunk);
+            // Decrement and notify under the lock: the waiter may destroy completion as
+            // soon as it observes zero
+            std::lock_guard<std::mutex> completionLock(completion.mutex);
+            if (--completion.remaining == 0) {
+                completion.done.notify_all();
+            }
+        });
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+    wakeCondition_.notify_all();
+
+    // Help instead of blocking; once nothing is left to take, every remaining chunk is
+    // already running somewhere and waiting is safe
+    const size_t worker = CurrentWorkerIndex();
+    const size_t home = worker == SIZE_MAX ? 0 : worker;
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(completion.mutex);
+            if (completion.remaining == 0) {
+                return;
+            }
+        }
+        Task task;
+        if (!TryTake(home, task)) {
+            break;
+        }
+        task();
+    }
+
+    std::unique_lock<std::mutex> lock(completion.mutex);
+    completion.done.wait(lock, [&completion]() { return completion.remaining == 0; });
+}
+
+} // namespace Utils
+} // namespace Sentinel
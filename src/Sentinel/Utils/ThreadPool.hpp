@@ -0,0 +1,170 @@
+/**
+ * @file ThreadPool.hpp
+ * @brief Process-wide work-stealing thread pool.
+ *
+ * @details This module exists so that Sentinel's parallel stages share one set of worker
+ * threads instead of each stage - or each pass of a stage - creating its own std::threads.
+ * Thread creation costs tens of microseconds and a fresh stack per thread, and independent
+ * pools oversubscribe the machine as soon as two of them are busy at once.
+ *
+ * Every worker owns a task deque. A worker pushes and pops its own tasks at the back
+ * (LIFO, so recently produced data is still in cache) and, when its deque is empty, steals
+ * from the front of the other workers' deques (FIFO, so thieves take the oldest, usually
+ * largest, pieces of work). Tasks submitted from outside the pool are spread round-robin
+ * over the worker deques, and stealing evens out the remaining imbalance.
+ *
+ * ParallelFor splits an index range into chunks and blocks until all of them have run. The
+ * calling thread executes chunks itself while it waits, so ParallelFor may be called from
+ * inside a pool task without deadlocking the pool.
+ *
+ * @performance Each deque has its own lock, so contention only arises when a thief and the
+ * owner touch the same deque. Idle workers sleep on a condition variable and cost nothing.
+ *
+ * @see ResourceAuditor::Audit
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Sentinel {
+namespace Utils {
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of worker threads with per-worker deques and work stealing.
+ *
+ * Usage example:
+ * @code
+ * ThreadPool& pool = ThreadPool::Shared();
+ * pool.Submit([]() { Logger::LogInfo("running on a worker"); });
+ * pool.ParallelFor(items.size(), 256, [&](size_t begin, size_t end) {
+ *     for (size_t i = begin; i < end; ++i) {
+ *         results[i] = Process(items[i]);
+ *     }
+ * });
+ * @endcode
+ *
+ * @threadsafe All methods are thread-safe.
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Starts @p threadCount workers (0 = one per logical processor).
+     */
+    explicit ThreadPool(size_t threadCount = 0);
+
+    /**
+     * @brief Runs every queued task, then joins the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Returns the pool shared by all Sentinel components, created on first use.
+     */
+    static ThreadPool& Shared();
+
+    /**
+     * @brief Queues @p task for execution on a worker.
+     *
+     * @details From a worker thread the task goes to that worker's own deque; otherwise
+     * to the next deque in round-robin order.
+     */
+    void Submit(Task task);
+
+    /**
+     * @brief Runs body(begin, end) over [0, count) in chunks of @p grain and waits.
+     *
+     * @details Chunk boundaries depend only on @p count and @p grain, so callers that
+     * write results by index obtain the same output regardless of scheduling. A single
+     * chunk runs inline on the calling thread.
+     *
+     * @param count Size of the index range.
+     * @param grain Indices per chunk (0 is treated as 1).
+     * @param body Callable invoked as body(size_t begin, size_t end); must be thread-safe.
+     */
+    template <typename Body>
+    void ParallelFor(size_t count, size_t grain, Body&& body) {
+        if (count == 0) {
+            return;
+        }
+        if (grain == 0) {
+            grain = 1;
+        }
+        const size_t chunkCount = (count + grain - 1) / grain;
+        if (chunkCount == 1) {
+            body(static_cast<size_t>(0), count);
+            return;
+        }
+        RunChunks(chunkCount, [&body, count, grain](size_t chunk) {
+            const size_t begin = chunk * grain;
+            const size_t end = begin + grain < count ? begin + grain : count;
+            body(begin, end);
+        });
+    }
+
+    /** @brief Number of worker threads. */
+    size_t GetThreadCount() const noexcept { return workers_.size(); }
+
+    /** @brief Number of tasks taken from another worker's deque so far. */
+    uint64_t GetStealCount() const noexcept { return stealCount_.load(std::memory_order_relaxed); }
+
+private:
+#pragma warning(push)
+#pragma warning(disable : 4324) // structure was padded due to alignment specifier
+    /**
+     * @brief One worker's deque, padded so neighbouring locks do not share a cache line.
+     */
+    struct alignas(64) WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+#pragma warning(pop)
+
+    /**
+     * @brief Submits @p chunkCount invocations of @p chunkBody and helps run them until done.
+     */
+    void RunChunks(size_t chunkCount, const std::function<void(size_t)>& chunkBody);
+
+    /**
+     * @brief Pops a task from deque @p home, or steals one from another deque.
+     *
+     * @param home Index of the deque to try first.
+     * @return true if @p task was filled in.
+     */
+    bool TryTake(size_t home, Task& task);
+
+    /** @brief Index of the calling worker in this pool, or SIZE_MAX if not a worker. */
+    size_t CurrentWorkerIndex() const noexcept;
+
+    void WorkerLoop(size_t index);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    // Tasks queued but not yet taken; guards sleeping against lost wakeups
+    std::atomic<size_t> pendingCount_{0};
+    std::mutex sleepMutex_;
+    std::condition_variable wakeCondition_;
+    bool stopping_ = false;
+
+    std::atomic<size_t> nextQueue_{0};
+    std::atomic<uint64_t> stealCount_{0};
+};
+
+} // namespace Utils
+} // namespace Sentinel
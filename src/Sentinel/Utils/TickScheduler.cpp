@@ -0,0 +1,77 @@
+/**
+ * @file TickScheduler.cpp
+ * @brief Implementation of the staggered periodic job scheduler.
+ */
+
+#include "Sentinel/Utils/TickScheduler.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+#include <numeric>
+
+namespace Sentinel {
+namespace Utils {
+
+uint32_t TickScheduler::ChoosePhase(uint32_t interval) const {
+    // Candidates are tried from the next tick onwards, so among equal loads the job starts soonest
+    const uint32_t first = static_cast<uint32_t>(tick_ % interval);
+    uint32_t best = first;
+    double bestLoad = 0.0;
+    for (uint32_t offset = 0; offset < interval; ++offset) {
+        const uint32_t phase = (first + offset) % interval;
+        double load = 0.0;
+        for (const Job& job : jobs_) {
+            const uint32_t common = std::gcd(interval, job.interval);
+            if (phase % common == job.phase % common) {
+                load += static_cast<double>(job.cost) * common / job.interval;
+            }
+        }
+        if (offset == 0 || load < bestLoad) {
+            best = phase;
+            bestLoad = load;
+        }
+    }
+    return best;
+}
+
+uint64_t TickScheduler::Add(uint32_t intervalTicks, std::function<void()> job, uint32_t cost) {
+    if (intervalTicks == 0 || intervalTicks > MAX_INTERVAL || cost == 0 || !job) {
+        Logger::Error("TickScheduler: rejected job with interval {} and cost {}", intervalTicks, cost);
+        return INVALID_JOB;
+    }
+    const uint64_t id = nextId_++;
+    jobs_.push_back(Job{id, intervalTicks, ChoosePhase(intervalTicks), cost, std::move(job)});
+    return id;
+}
+
+void TickScheduler::Remove(uint64_t id) {
+    for (size_t i = 0; i < jobs_.size(); ++i) {
+        if (jobs_[i].id == id) {
+            jobs_.erase(jobs_.begin() + static_cast<ptrdiff_t>(i));
+            return;
+        }
+    }
+}
+
+size_t TickScheduler::RunTick() {
+    size_t ran = 0;
+    for (Job& job : jobs_) {
+        if (tick_ % job.interval == job.phase) {
+            job.run();
+            ++ran;
+        }
+    }
+    ++tick_;
+    return ran;
+}
+
+uint64_t TickScheduler::GetCostAt(uint64_t tick) const noexcept {
+    uint64_t cost = 0;
+    for (const Job& job : jobs_) {
+        if (tick % job.interval == job.phase) {
+            cost += job.cost;
+        }
+    }
+    return cost;
+}
+
+} // namespace Utils
+} // namespace Sentinel
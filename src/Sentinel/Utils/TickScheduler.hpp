@@ -0,0 +1,109 @@
+/**
+ * @file TickScheduler.hpp
+ * @brief Periodic jobs spread across the ticks of a sampling loop.
+ *
+ * @details A sampler that serves many targets has per-target work that is too expensive
+ * for every tick but must run regularly - hashing a target's code regions, for one. If
+ * every such job started on tick 0 and ran every N ticks, every N-th tick would do all of
+ * the work and the others none, so CPU use would spike instead of staying flat.
+ *
+ * TickScheduler gives each job a phase when it is added: the job runs on the ticks t with
+ * t % interval == phase. The phase is the one whose ticks currently carry the least
+ * expected cost. Two jobs with intervals a and b and phases p and q meet on some tick only
+ * if p == q (mod gcd(a, b)), and then on one tick in lcm(a, b), so a candidate phase is
+ * charged cost * gcd / otherInterval for every job it would meet. For equal intervals this
+ * places one job per phase before doubling up; mixed intervals are balanced on average.
+ *
+ * @performance Add is O(interval * jobs); RunTick is O(jobs) plus the jobs themselves.
+ *
+ * @see MultiProcessCollector
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Sentinel {
+namespace Utils {
+
+/**
+ * @class TickScheduler
+ * @brief Runs each added job every interval ticks, at a phase chosen to flatten load.
+ *
+ * Usage example:
+ * @code
+ * TickScheduler scheduler;
+ * for (Target& target : targets) {
+ *     scheduler.Add(30, [&target]() { target.HashCode(); });
+ * }
+ * while (running) {
+ *     Sample();
+ *     scheduler.RunTick();  // about targets.size() / 30 hashes per tick
+ * }
+ * @endcode
+ *
+ * @threadsafe Not thread-safe. Jobs may not call Add or Remove on their own scheduler.
+ */
+class TickScheduler {
+public:
+    /** @brief Returned by Add on failure. */
+    static constexpr uint64_t INVALID_JOB = 0;
+
+    /** @brief Largest accepted interval, to bound the phase search. */
+    static constexpr uint32_t MAX_INTERVAL = 3600;
+
+    /**
+     * @brief Adds a job that runs every @p intervalTicks ticks, starting within the next
+     * @p intervalTicks ticks.
+     *
+     * @param cost Relative cost of one run, used to balance dissimilar jobs (e.g. bytes
+     *        hashed in KB). Must be at least 1.
+     * @return Id for Remove, or INVALID_JOB if the interval or cost is out of range.
+     */
+    uint64_t Add(uint32_t intervalTicks, std::function<void()> job, uint32_t cost = 1);
+
+    /**
+     * @brief Removes job @p id. Unknown ids are ignored.
+     */
+    void Remove(uint64_t id);
+
+    /**
+     * @brief Runs the jobs due on the current tick, then advances to the next tick.
+     *
+     * @return Number of jobs run.
+     */
+    size_t RunTick();
+
+    /** @brief Index of the next tick RunTick will run. */
+    uint64_t GetTick() const noexcept { return tick_; }
+
+    /** @brief Number of scheduled jobs. */
+    size_t GetJobCount() const noexcept { return jobs_.size(); }
+
+    /**
+     * @brief Sum of the costs of the jobs due on tick @p tick.
+     */
+    uint64_t GetCostAt(uint64_t tick) const noexcept;
+
+private:
+    struct Job {
+        uint64_t id;
+        uint32_t interval;
+        uint32_t phase;
+        uint32_t cost;
+        std::function<void()> run;
+    };
+
+    /** @brief Least loaded phase in [0, interval) for a job of @p interval ticks. */
+    uint32_t ChoosePhase(uint32_t interval) const;
+
+    std::vector<Job> jobs_;
+    uint64_t tick_ = 0;
+    uint64_t nextId_ = 1;
+};
+
+} // namespace Utils
+} // namespace Sentinel
@@ -0,0 +1,144 @@
+/**
+ * @file Bytecode.cpp
+ * @brief Implementation of the bytecode decoder.
+ */
+
+#include "Sentinel/Virtualization/Bytecode.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+#include <array>
+#include <cstring>
+
+namespace Sentinel {
+namespace Virtualization {
+
+// Marks bytecode offsets that do not start an instruction
+static constexpr uint32_t NOT_AN_INSTRUCTION = 0xFFFFFFFFu;
+
+// Largest accepted bytecode size; offsets and indices must fit in 32 bits
+static constexpr size_t MAX_CODE_SIZE = 16 * 1024 * 1024;
+
+struct OpcodeInfo {
+    bool valid;
+    HandlerId handler;
+    OperandKind operand;
+};
+
+// Bytecode encoding -> handler and operand kind
+static constexpr std::array<OpcodeInfo, 256> BuildOpcodeTable() {
+    std::array<OpcodeInfo, 256> table{};
+    for (OpcodeInfo& info : table) {
+        info = {false, HandlerId::Count, OperandKind::None};
+    }
+#define SENTINEL_VM_OPCODE_INFO(name, encoding, operand, pops, pushes) \
+    table[encoding] = {true, HandlerId::name, OperandKind::operand};
+    SENTINEL_VM_OPCODES(SENTINEL_VM_OPCODE_INFO)
+#undef SENTINEL_VM_OPCODE_INFO
+    return table;
+}
+
+static constexpr std::array<OpcodeInfo, 256> OPCODE_TABLE = BuildOpcodeTable();
+
+static constexpr size_t OperandSize(OperandKind kind) {
+    switch (kind) {
+    case OperandKind::Imm64:
+        return 8;
+    case OperandKind::Target:
+        return 4;
+    case OperandKind::Register:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+bool Program::Decode(const uint8_t* code, size_t size) {
+    instructions_.clear();
+    verified_ = false;
+
+    if (code == nullptr && size != 0) {
+        Utils::Logger::LogError("Program::Decode: null bytecode");
+        return false;
+    }
+    if (size > MAX_CODE_SIZE) {
+        Utils::Logger::Error("Program::Decode: bytecode of {} bytes exceeds the {} byte limit", size, MAX_CODE_SIZE);
+        return false;
+    }
+
+    // One extra slot so that a target equal to size resolves to the implicit Halt
+    std::vector<uint32_t> indexOfOffset(size + 1, NOT_AN_INSTRUCTION);
+    // Same resource as instructions_, so the final move is a pointer swap
+    std::pmr::vector<DecodedInstruction> decoded(instructions_.get_allocator());
+    std::vector<size_t> branches;
+    decoded.reserve(size / 2 + 1);
+
+    // Pass 1: split the bytecode into instructions and widen the operands
+    size_t offset = 0;
+    while (offset < size) {
+        const uint8_t encoding = code[offset];
+        const OpcodeInfo& info = OPCODE_TABLE[encoding];
+        if (!info.valid) {
+            Utils::Logger::Error("Program::Decode: unknown opcode 0x{:02X} at offset {}", encoding, offset);
+            return false;
+        }
+        const size_t operandSize = OperandSize(info.operand);
+        if (size - offset - 1 < operandSize) {
+            Utils::Logger::Error("Program::Decode: truncated operand at offset {}", offset);
+            return false;
+        }
+
+        DecodedInstruction instruction{};
+        instruction.handler = info.handler;
+        instruction.sourceOffset = static_cast<uint32_t>(offset);
+        const uint8_t* operand = code + offset + 1;
+        switch (info.operand) {
+        case OperandKind::Imm64:
+            std::memcpy(&instruction.operand, operand, sizeof(uint64_t));
+            break;
+        case OperandKind::Target: {
+            uint32_t target = 0;
+            std::memcpy(&target, operand, sizeof(uint32_t));
+            instruction.operand = target;
+            branches.push_back(decoded.size());
+            break;
+        }
+        case OperandKind::Register:
+            if (operand[0] >= VM_REGISTER_COUNT) {
+                Utils::Logger::Error("Program::Decode: register r{} out of range at offset {}", operand[0], offset);
+                return false;
+            }
+            instruction.operand = operand[0];
+            break;
+        default:
+            break;
+        }
+
+        indexOfOffset[offset] = static_cast<uint32_t>(decoded.size());
+        decoded.push_back(instruction);
+        offset += 1 + operandSize;
+    }
+
+    // Execution can never fall off the end: the last slot is always a Halt
+    DecodedInstruction halt{};
+    halt.handler = HandlerId::Halt;
+    halt.sourceOffset = static_cast<uint32_t>(size);
+    indexOfOffset[size] = static_cast<uint32_t>(decoded.size());
+    decoded.push_back(halt);
+
+    // Pass 2: translate byte-offset targets into instruction indices
+    for (size_t index : branches) {
+        DecodedInstruction& instruction = decoded[index];
+        const uint64_t target = instruction.operand;
+        if (target > size || indexOfOffset[static_cast<size_t>(target)] == NOT_AN_INSTRUCTION) {
+            Utils::Logger::Error("Program::Decode: branch at offset {} targets {}, which is not an instruction",
+                                 instruction.sourceOffset, target);
+            return false;
+        }
+        instruction.operand = indexOfOffset[static_cast<size_t>(target)];
+    }
+
+    instructions_ = std::move(decoded);
+    return true;
+}
+
+} // namespace Virtualization
+} // namespace Sentinel
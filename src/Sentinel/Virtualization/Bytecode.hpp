@@ -0,0 +1,248 @@
+/**
+ * @file Bytecode.hpp
+ * @brief Instruction set of the integrity VM and its pre-decoded program form.
+ *
+ * @details Integrity checks are distributed as compact bytecode: a one-byte opcode
+ * followed by an operand whose size the opcode determines. That form is cheap to store
+ * and encrypt but slow to interpret, because every step would have to parse variable-length
+ * operands and translate byte offsets. Program::Decode therefore converts the bytecode
+ * once into an array of fixed-size DecodedInstruction records:
+ * - Operands are widened to 64 bits, so a handler reads its operand with a single load.
+ * - Jump and call targets are translated from byte offsets to instruction indices, and a
+ *   target that does not start an instruction rejects the program.
+ * - An implicit Halt is appended, so execution can never run past the last instruction.
+ *
+ * Bytecode encoding (little-endian):
+ * | Operand kind | Encoding after the opcode byte              |
+ * |--------------|---------------------------------------------|
+ * | None         | -                                           |
+ * | Imm64        | 8-byte immediate                            |
+ * | Target       | 4-byte absolute byte offset into the code   |
+ * | Register     | 1-byte register index (< VM_REGISTER_COUNT) |
+ *
+ * Stack effects are written as (before -- after) with the top of stack on the right.
+ * Comparisons push 1 or 0; shifts and rotates use the low six bits of the count.
+ * HashCrc32c and HashSha256 hash the whole range [addr, addr + len) in one instruction
+ * (see RegionHash); HashSha256 pushes the digest as four little-endian 64-bit words, d0
+ * holding digest bytes 0-7.
+ *
+ * @see Interpreter
+ * @see RegionHash
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace Sentinel {
+namespace Virtualization {
+
+/** @brief Number of general-purpose VM registers addressed by LoadReg/StoreReg. */
+static constexpr size_t VM_REGISTER_COUNT = 16;
+
+/**
+ * @brief Size of an operand in the bytecode encoding.
+ */
+enum class OperandKind : uint8_t {
+    None = 0,
+    Imm64 = 1,
+    Target = 2,
+    Register = 3
+};
+
+/**
+ * @brief Instruction table: X(name, encoding, operand kind, pops, pushes).
+ *
+ * @details The encodings are part of the bytecode format and must never be renumbered.
+ * pops is the stack depth an instruction requires, pushes the depth it leaves in their
+ * place; the verifier derives every stack bound from these two columns.
+ * The interpreter expands this list into its dispatch table, so an opcode added here
+ * without a handler fails to compile.
+ */
+#define SENTINEL_VM_OPCODES(X)                                             \
+    X(Nop,        0x00, None,     0, 0)  /* ( -- ) */                      \
+    X(Halt,       0x01, None,     0, 0)  /* ( -- ) result = top */         \
+    X(Push,       0x02, Imm64,    0, 1)  /* ( -- imm ) */                  \
+    X(Pop,        0x03, None,     1, 0)  /* ( a -- ) */                    \
+    X(Dup,        0x04, None,     1, 2)  /* ( a -- a a ) */                \
+    X(Swap,       0x05, None,     2, 2)  /* ( a b -- b a ) */              \
+    X(Over,       0x06, None,     2, 3)  /* ( a b -- a b a ) */            \
+    X(Add,        0x10, None,     2, 1)  /* ( a b -- a+b ) */              \
+    X(Sub,        0x11, None,     2, 1)  /* ( a b -- a-b ) */              \
+    X(Mul,        0x12, None,     2, 1)  /* ( a b -- a*b ) */              \
+    X(And,        0x13, None,     2, 1)  /* ( a b -- a&b ) */              \
+    X(Or,         0x14, None,     2, 1)  /* ( a b -- a|b ) */              \
+    X(Xor,        0x15, None,     2, 1)  /* ( a b -- a^b ) */              \
+    X(Shl,        0x16, None,     2, 1)  /* ( a b -- a<<b ) */             \
+    X(Shr,        0x17, None,     2, 1)  /* ( a b -- a>>b ) */             \
+    X(Rotl,       0x18, None,     2, 1)  /* ( a b -- rotl(a,b) ) */        \
+    X(Not,        0x19, None,     1, 1)  /* ( a -- ~a ) */                 \
+    X(Eq,         0x20, None,     2, 1)  /* ( a b -- a==b ) */             \
+    X(Ne,         0x21, None,     2, 1)  /* ( a b -- a!=b ) */             \
+    X(LtU,        0x22, None,     2, 1)  /* ( a b -- a<b ) */              \
+    X(GtU,        0x23, None,     2, 1)  /* ( a b -- a>b ) */              \
+    X(Jmp,        0x30, Target,   0, 0)  /* ( -- ) */                      \
+    X(Jz,         0x31, Target,   1, 0)  /* ( a -- ) jump if a == 0 */     \
+    X(Jnz,        0x32, Target,   1, 0)  /* ( a -- ) jump if a != 0 */     \
+    X(Call,       0x33, Target,   0, 0)  /* ( -- ) */                      \
+    X(Ret,        0x34, None,     0, 0)  /* ( -- ) */                      \
+    X(LoadReg,    0x40, Register, 0, 1)  /* ( -- r ) */                    \
+    X(StoreReg,   0x41, Register, 1, 0)  /* ( a -- ) r = a */              \
+    X(Load8,      0x50, None,     1, 1)  /* ( addr -- u8 ) */              \
+    X(Load16,     0x51, None,     1, 1)  /* ( addr -- u16 ) */             \
+    X(Load32,     0x52, None,     1, 1)  /* ( addr -- u32 ) */             \
+    X(Load64,     0x53, None,     1, 1)  /* ( addr -- u64 ) */             \
+    X(HashCrc32c, 0x60, None,     2, 1)  /* ( addr len -- crc32c ) */      \
+    X(HashSha256, 0x61, None,     2, 4)  /* ( addr len -- d0 d1 d2 d3 ) */
+
+/**
+ * @brief Handlers that exist only in decoded programs: X(name, span).
+ *
+ * @details These are produced by the runtime (never by Decode) and have no bytecode
+ * encoding:
+ * - Yield leaves the interpreter and asks the caller to continue at the absolute
+ *   instruction index in its operand; SecureProgram uses it to chain decrypted windows.
+ * - The rest are superinstructions installed by Verifier. A superinstruction replaces
+ *   the handler of the first of the span instructions it fuses and reads its operands
+ *   from the following, unchanged slots, so instruction indices stay valid and a branch
+ *   into the middle of a fused sequence still executes the original instructions.
+ *
+ * | Superinstruction | Fused sequence                                                    |
+ * |------------------|-------------------------------------------------------------------|
+ * | AddRegImm        | LoadReg a; Push k; Add; StoreReg a                                |
+ * | IncJltReg        | LoadReg a; Push k; Add; Dup; StoreReg a; LoadReg b; LtU; Jnz t    |
+ * | HashStepByte     | LoadReg h; LoadReg p; Load8; Xor; Push r; Rotl; Push m; Mul; StoreReg h |
+ * | HashLoopByte     | HashStepByte at t followed by IncJltReg on p with k = 1 back to t |
+ */
+#define SENTINEL_VM_INTERNAL_HANDLERS(X) \
+    X(Yield, 1)                          \
+    X(AddRegImm, 4)                      \
+    X(IncJltReg, 8)                      \
+    X(HashStepByte, 9)                   \
+    X(HashLoopByte, 17)
+
+/**
+ * @brief Bytecode opcodes; see SENTINEL_VM_OPCODES for encodings and stack effects.
+ */
+enum class Opcode : uint8_t {
+#define SENTINEL_VM_OPCODE_ENUM(name, encoding, operand, pops, pushes) name = encoding,
+    SENTINEL_VM_OPCODES(SENTINEL_VM_OPCODE_ENUM)
+#undef SENTINEL_VM_OPCODE_ENUM
+};
+
+/**
+ * @brief Dense handler numbers used in decoded programs: SENTINEL_VM_OPCODES in order,
+ * then SENTINEL_VM_INTERNAL_HANDLERS.
+ *
+ * @details Bytecode encodings are sparse so that related opcodes share a range; handler
+ * numbers are dense so that the interpreter's dispatch table has no holes.
+ */
+enum class HandlerId : uint32_t {
+#define SENTINEL_VM_HANDLER_ENUM(name, encoding, operand, pops, pushes) name,
+    SENTINEL_VM_OPCODES(SENTINEL_VM_HANDLER_ENUM)
+#undef SENTINEL_VM_HANDLER_ENUM
+#define SENTINEL_VM_INTERNAL_HANDLER_ENUM(name, span) name,
+    SENTINEL_VM_INTERNAL_HANDLERS(SENTINEL_VM_INTERNAL_HANDLER_ENUM)
+#undef SENTINEL_VM_INTERNAL_HANDLER_ENUM
+    Count
+};
+
+/**
+ * @brief Number of instruction slots covered by @p handler: 1 for plain handlers, the
+ * fused sequence length for superinstructions.
+ */
+inline constexpr uint32_t GetHandlerSpan(HandlerId handler) noexcept {
+    switch (handler) {
+#define SENTINEL_VM_HANDLER_SPAN(name, span) \
+    case HandlerId::name:                    \
+        return span;
+        SENTINEL_VM_INTERNAL_HANDLERS(SENTINEL_VM_HANDLER_SPAN)
+#undef SENTINEL_VM_HANDLER_SPAN
+    default:
+        return 1;
+    }
+}
+
+/**
+ * @brief One instruction of a decoded program.
+ *
+ * @details Sixteen bytes, so four instructions share a cache line and the interpreter
+ * advances with a fixed stride.
+ */
+struct DecodedInstruction {
+    /** @brief Handler that executes the instruction (not the bytecode encoding). */
+    HandlerId handler;
+
+    /** @brief Byte offset of the instruction in the original bytecode, for diagnostics. */
+    uint32_t sourceOffset;
+
+    /** @brief Immediate value, target instruction index or register index. */
+    uint64_t operand;
+};
+static_assert(sizeof(DecodedInstruction) == 16, "DecodedInstruction must stay 16 bytes");
+
+/**
+ * @class Program
+ * @brief Immutable, pre-decoded integrity check ready for execution.
+ *
+ * Usage example:
+ * @code
+ * Program program;
+ * if (!program.Decode(bytecode.data(), bytecode.size())) {
+ *     return false;
+ * }
+ * Interpreter vm;
+ * ExecutionResult result = vm.Execute(program);
+ * @endcode
+ *
+ * A program set loaded together can keep its instructions in one Utils::Arena, off the
+ * process heap, by passing the arena to the constructor.
+ *
+ * @threadsafe A decoded program is read-only and may be executed by several interpreters
+ * at once. Decode must not run concurrently with execution.
+ */
+class Program {
+public:
+    Program() = default;
+
+    /**
+     * @brief Creates an empty program whose instructions are allocated from @p resource.
+     */
+    explicit Program(std::pmr::memory_resource* resource) : instructions_(resource) {}
+
+    /**
+     * @brief Decodes @p size bytes of bytecode, replacing any previous contents.
+     *
+     * @return false (and logs the offending offset) if the bytecode contains an unknown
+     *         opcode, a truncated operand, an invalid register or a jump target that does
+     *         not start an instruction. The program is empty afterwards.
+     */
+    bool Decode(const uint8_t* code, size_t size);
+
+    /** @brief Decoded instructions, including the trailing implicit Halt. */
+    const DecodedInstruction* GetInstructions() const noexcept { return instructions_.data(); }
+
+    /** @brief Number of decoded instructions, including the trailing implicit Halt. */
+    size_t GetInstructionCount() const noexcept { return instructions_.size(); }
+
+    /** @brief false for a default-constructed program or after a failed Decode. */
+    bool IsValid() const noexcept { return !instructions_.empty(); }
+
+    /**
+     * @brief true once Verifier has proven the program's stack and call bounds; the
+     * interpreter then runs it without per-instruction stack checks.
+     */
+    bool IsVerified() const noexcept { return verified_; }
+
+private:
+    friend class Verifier;
+
+    std::pmr::vector<DecodedInstruction> instructions_;
+    bool verified_ = false;
+};
+
+} // namespace Virtualization
+} // namespace Sentinel
@@ -0,0 +1,455 @@
+/**
+ * @file Interpreter.cpp
+ * @brief Implementation of the threaded-dispatch interpreter.
+ */
+
+#include "Sentinel/Virtualization/Interpreter.hpp"
+#include "Sentinel/Virtualization/RegionHash.hpp"
+#include "Sentinel/Utils/Metrics.hpp"
+#include <bit>
+#include <cstring>
+
+// Labels-as-values is a GNU extension; MSVC falls back to replicated switch dispatch
+#if defined(__GNUC__) || defined(__clang__)
+#define SENTINEL_VM_COMPUTED_GOTO 1
+#else
+#define SENTINEL_VM_COMPUTED_GOTO 0
+#endif
+
+namespace Sentinel {
+namespace Virtualization {
+
+// Dispatched handlers (a fused superinstruction counts once) and the duration of Execute
+// calls; two snapshots of both give the interpreter's instruction rate
+static Utils::Counter instructionCount;
+static const Utils::MetricRegistration instructionCountMetric("vm.instructions", instructionCount);
+static Utils::Histogram executeTime;
+static const Utils::MetricRegistration executeTimeMetric("vm.execute_ns", executeTime);
+
+bool Interpreter::AddReadableRegion(const void* base, size_t size) noexcept {
+    const uint64_t address = reinterpret_cast<uintptr_t>(base);
+    if (regionCount_ >= MAX_REGIONS || size == 0 || address + size < address) {
+        return false;
+    }
+    regions_[regionCount_++] = {address, size};
+    return true;
+}
+
+const char* Interpreter::GetDispatchMode() noexcept {
+#if SENTINEL_VM_COMPUTED_GOTO
+    return "computed-goto";
+#else
+    return "replicated-switch";
+#endif
+}
+
+// Handler plumbing. Every handler ends in VM_NEXT or VM_JUMP, which expand to a complete
+// dispatch of their own; there is no shared dispatch loop to return to.
+// Every dispatch bumps a register-resident counter that is published once per Run.
+#if SENTINEL_VM_COMPUTED_GOTO
+#define VM_DISPATCH()                                            \
+    {                                                            \
+        ++dispatches;                                            \
+        goto* dispatchTable[static_cast<uint32_t>(ip->handler)]; \
+    }
+#else
+#define VM_CASE(name, encoding, operand, pops, pushes) \
+    case HandlerId::name:                              \
+        goto Op_##name;
+#define VM_INTERNAL_CASE(name, span) \
+    case HandlerId::name:            \
+        goto Op_##name;
+#define VM_DISPATCH()                                       \
+    {                                                       \
+        ++dispatches;                                       \
+        switch (ip->handler) {                              \
+            SENTINEL_VM_OPCODES(VM_CASE)                    \
+            SENTINEL_VM_INTERNAL_HANDLERS(VM_INTERNAL_CASE) \
+        default:                                            \
+            __assume(0);                                    \
+        }                                                   \
+    }
+#endif
+
+#define VM_NEXT()      \
+    {                  \
+        ++ip;          \
+        VM_DISPATCH(); \
+    }
+
+#define VM_FAULT(code)           \
+    {                            \
+        status = VmStatus::code; \
+        goto fault;              \
+    }
+
+// Taken branches and calls are the only way to execute an instruction twice, so charging
+// them bounds the total instruction count
+#define VM_JUMP(index)                               \
+    {                                                \
+        if (budget-- == 0) VM_FAULT(BudgetExhausted) \
+        ip = code + (index);                         \
+        VM_DISPATCH();                               \
+    }
+
+// Stack depth is sp - stack_; the top of stack is cached in tos. Verified programs have
+// proven stack bounds, so both checks compile away in RunLoop<false>
+#define VM_NEED(count)                                         \
+    if constexpr (Checked) {                                   \
+        if (sp < stackBase + (count)) VM_FAULT(StackUnderflow) \
+    }
+
+#define VM_ROOM(count)                                         \
+    if constexpr (Checked) {                                   \
+        if (sp > stackLimit - (count)) VM_FAULT(StackOverflow) \
+    }
+
+#define VM_PUSH(value) \
+    {                  \
+        *sp++ = tos;   \
+        tos = (value); \
+    }
+
+#define VM_BINARY(expression)      \
+    {                              \
+        VM_NEED(2)                 \
+        const uint64_t a = sp[-1]; \
+        const uint64_t b = tos;    \
+        tos = (expression);        \
+        --sp;                      \
+    }                              \
+    VM_NEXT()
+
+#define VM_LOAD(type)                                                                    \
+    {                                                                                    \
+        VM_NEED(1)                                                                       \
+        if (!IsReadable(tos, sizeof(type))) VM_FAULT(MemoryFault)                        \
+        const void* source = reinterpret_cast<const void*>(static_cast<uintptr_t>(tos)); \
+        type loaded;                                                                     \
+        std::memcpy(&loaded, source, sizeof(type));                                      \
+        tos = loaded;                                                                    \
+    }                                                                                    \
+    VM_NEXT()
+
+void Interpreter::Reset() noexcept {
+    stackDepth_ = 0;
+    cachedTop_ = 0;
+    callDepth_ = 0;
+    budgetLeft_ = branchBudget_;
+}
+
+ExecutionResult Interpreter::Execute(const Program& program) noexcept {
+    if (!program.IsValid()) {
+        return ExecutionResult{};
+    }
+    Utils::ScopedTimer timer(executeTime);
+    Reset();
+    return Run(program.GetInstructions(), 0, static_cast<uint32_t>(program.GetInstructionCount()), 0,
+               !program.IsVerified());
+}
+
+ExecutionResult Interpreter::Run(const DecodedInstruction* code, uint32_t base, uint32_t count, uint32_t entry,
+                                 bool checked) noexcept {
+    return checked ? RunLoop<true>(code, base, count, entry) : RunLoop<false>(code, base, count, entry);
+}
+
+template <bool Checked>
+ExecutionResult Interpreter::RunLoop(const DecodedInstruction* code, uint32_t base, uint32_t count,
+                                     uint32_t entry) noexcept {
+    ExecutionResult result;
+
+#if SENTINEL_VM_COMPUTED_GOTO
+    static const void* const dispatchTable[] = {
+#define VM_LABEL(name, encoding, operand, pops, pushes) &&Op_##name,
+        SENTINEL_VM_OPCODES(VM_LABEL)
+#undef VM_LABEL
+#define VM_INTERNAL_LABEL(name, span) &&Op_##name,
+        SENTINEL_VM_INTERNAL_HANDLERS(VM_INTERNAL_LABEL)
+#undef VM_INTERNAL_LABEL
+    };
+    static_assert(sizeof(dispatchTable) / sizeof(dispatchTable[0]) == static_cast<size_t>(HandlerId::Count),
+                  "dispatch table must cover every handler");
+#endif
+
+    // Hot state lives in locals so the compiler can keep it in registers
+    const DecodedInstruction* ip = code + entry;
+    uint64_t* const stackBase = stack_;
+    uint64_t* const stackLimit = stack_ + STACK_CAPACITY;
+    uint64_t* sp = stackBase + stackDepth_;
+    uint64_t tos = cachedTop_;
+    uint32_t* const callBase = callStack_;
+    uint32_t* const callLimit = callStack_ + CALL_DEPTH;
+    uint32_t* rsp = callBase + callDepth_;
+    uint64_t* const registers = registers_;
+    uint64_t budget = budgetLeft_;
+    uint64_t dispatches = 0;
+    VmStatus status = VmStatus::Halted;
+
+    VM_DISPATCH();
+
+Op_Nop:
+    VM_NEXT();
+
+Op_Halt:
+    instructionCount.Add(dispatches);
+    result.status = VmStatus::Halted;
+    result.value = sp > stackBase ? tos : 0;
+    result.offset = ip->sourceOffset;
+    return result;
+
+Op_Push:
+    VM_ROOM(1)
+    VM_PUSH(ip->operand)
+    VM_NEXT();
+
+Op_Pop:
+    VM_NEED(1)
+    tos = *--sp;
+    VM_NEXT();
+
+Op_Dup:
+    VM_NEED(1)
+    VM_ROOM(1)
+    *sp++ = tos;
+    VM_NEXT();
+
+Op_Swap:
+    VM_NEED(2)
+    {
+        const uint64_t below = sp[-1];
+        sp[-1] = tos;
+        tos = below;
+    }
+    VM_NEXT();
+
+Op_Over:
+    VM_NEED(2)
+    VM_ROOM(1)
+    {
+        const uint64_t below = sp[-1];
+        VM_PUSH(below)
+    }
+    VM_NEXT();
+
+Op_Add:
+    VM_BINARY(a + b);
+Op_Sub:
+    VM_BINARY(a - b);
+Op_Mul:
+    VM_BINARY(a * b);
+Op_And:
+    VM_BINARY(a & b);
+Op_Or:
+    VM_BINARY(a | b);
+Op_Xor:
+    VM_BINARY(a ^ b);
+Op_Shl:
+    VM_BINARY(a << (b & 63));
+Op_Shr:
+    VM_BINARY(a >> (b & 63));
+Op_Rotl:
+    VM_BINARY(std::rotl(a, static_cast<int>(b & 63)));
+
+Op_Not:
+    VM_NEED(1)
+    tos = ~tos;
+    VM_NEXT();
+
+Op_Eq:
+    VM_BINARY(a == b ? 1u : 0u);
+Op_Ne:
+    VM_BINARY(a != b ? 1u : 0u);
+Op_LtU:
+    VM_BINARY(a < b ? 1u : 0u);
+Op_GtU:
+    VM_BINARY(a > b ? 1u : 0u);
+
+Op_Jmp:
+    VM_JUMP(ip->operand);
+
+Op_Jz:
+    VM_NEED(1)
+    {
+        const uint64_t condition = tos;
+        tos = *--sp;
+        if (condition == 0) VM_JUMP(ip->operand)
+    }
+    VM_NEXT();
+
+Op_Jnz:
+    VM_NEED(1)
+    {
+        const uint64_t condition = tos;
+        tos = *--sp;
+        if (condition != 0) VM_JUMP(ip->operand)
+    }
+    VM_NEXT();
+
+Op_Call:
+    if constexpr (Checked) {
+        if (rsp == callLimit) VM_FAULT(CallDepthExceeded)
+    }
+    *rsp++ = base + static_cast<uint32_t>(ip - code + 1);
+    VM_JUMP(ip->operand);
+
+Op_Ret:
+    if constexpr (Checked) {
+        if (rsp == callBase) VM_FAULT(ReturnUnderflow)
+    }
+    {
+        const uint32_t target = *--rsp;
+        if (target - base >= count) {
+            // Returning into another window
+            result.value = target;
+            goto yield;
+        }
+        ip = code + (target - base);
+    }
+    VM_DISPATCH();
+
+Op_LoadReg:
+    VM_ROOM(1)
+    VM_PUSH(registers[ip->operand])
+    VM_NEXT();
+
+Op_StoreReg:
+    VM_NEED(1)
+    registers[ip->operand] = tos;
+    tos = *--sp;
+    VM_NEXT();
+
+Op_Load8:
+    VM_LOAD(uint8_t);
+Op_Load16:
+    VM_LOAD(uint16_t);
+Op_Load32:
+    VM_LOAD(uint32_t);
+Op_Load64:
+    VM_LOAD(uint64_t);
+
+    // Region hashes check the whole range once; an empty range hashes nothing and needs no
+    // region
+Op_HashCrc32c:
+    VM_NEED(2)
+    {
+        const uint64_t address = sp[-1];
+        const uint64_t length = tos;
+        if (length != 0 && !IsReadable(address, length)) VM_FAULT(MemoryFault)
+        const void* source = reinterpret_cast<const void*>(static_cast<uintptr_t>(address));
+        tos = RegionHash::Crc32c(source, static_cast<size_t>(length));
+        --sp;
+    }
+    VM_NEXT();
+
+Op_HashSha256:
+    VM_NEED(2)
+    VM_ROOM(2)
+    {
+        const uint64_t address = sp[-1];
+        const uint64_t length = tos;
+        if (length != 0 && !IsReadable(address, length)) VM_FAULT(MemoryFault)
+        const void* source = reinterpret_cast<const void*>(static_cast<uintptr_t>(address));
+        const Sha256Digest digest = RegionHash::Sha256(source, static_cast<size_t>(length));
+        uint64_t words[4];
+        std::memcpy(words, digest.bytes, sizeof(words));
+        sp[-1] = words[0];
+        sp[0] = words[1];
+        sp[1] = words[2];
+        sp += 2;
+        tos = words[3];
+    }
+    VM_NEXT();
+
+    // Superinstructions read their operands from the unchanged slots of the sequence they
+    // replace; see SENTINEL_VM_INTERNAL_HANDLERS for the slot layout
+Op_AddRegImm:
+    registers[ip->operand] += ip[1].operand;
+    ip += GetHandlerSpan(HandlerId::AddRegImm);
+    VM_DISPATCH();
+
+Op_IncJltReg:
+    {
+        const uint64_t value = registers[ip->operand] + ip[1].operand;
+        registers[ip->operand] = value;
+        if (value < registers[ip[5].operand]) VM_JUMP(ip[7].operand)
+    }
+    ip += GetHandlerSpan(HandlerId::IncJltReg);
+    VM_DISPATCH();
+
+Op_HashStepByte:
+    {
+        const uint64_t address = registers[ip[1].operand];
+        if (!IsReadable(address, 1)) {
+            // Report the fault at the fused Load8
+            ip += 2;
+            VM_FAULT(MemoryFault)
+        }
+        const uint8_t byte = *reinterpret_cast<const uint8_t*>(static_cast<uintptr_t>(address));
+        const uint64_t mixed = registers[ip->operand] ^ byte;
+        registers[ip[8].operand] = std::rotl(mixed, static_cast<int>(ip[4].operand & 63)) * ip[6].operand;
+    }
+    ip += GetHandlerSpan(HandlerId::HashStepByte);
+    VM_DISPATCH();
+
+Op_HashLoopByte:
+    // The whole loop in one step: the byte range is checked once instead of per byte and
+    // the back edges are charged to the budget in bulk. If either cannot be satisfied,
+    // the loop runs step by step so it faults exactly where the original would
+    {
+        const uint64_t start = registers[ip[1].operand];
+        const uint64_t end = registers[ip[14].operand];
+        const uint64_t iterations = end > start ? end - start : 1;
+        if (iterations - 1 <= budget && IsReadable(start, iterations)) {
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(static_cast<uintptr_t>(start));
+            const int rotation = static_cast<int>(ip[4].operand & 63);
+            const uint64_t multiplier = ip[6].operand;
+            uint64_t hash = registers[ip->operand];
+            for (uint64_t i = 0; i < iterations; ++i) {
+                hash = std::rotl(hash ^ bytes[i], rotation) * multiplier;
+            }
+            registers[ip->operand] = hash;
+            registers[ip[1].operand] = start + iterations;
+            budget -= iterations - 1;
+            ip += GetHandlerSpan(HandlerId::HashLoopByte);
+            VM_DISPATCH();
+        }
+    }
+    goto Op_HashStepByte;
+
+Op_Yield:
+    result.value = ip->operand;
+
+yield:
+    instructionCount.Add(dispatches);
+    stackDepth_ = static_cast<size_t>(sp - stackBase);
+    cachedTop_ = tos;
+    callDepth_ = static_cast<size_t>(rsp - callBase);
+    budgetLeft_ = budget;
+    result.status = VmStatus::Yielded;
+    result.offset = ip->sourceOffset;
+    return result;
+
+fault:
+    instructionCount.Add(dispatches);
+    result.status = status;
+    result.value = 0;
+    result.offset = ip->sourceOffset;
+    return result;
+}
+
+#undef VM_LOAD
+#undef VM_BINARY
+#undef VM_PUSH
+#undef VM_ROOM
+#undef VM_NEED
+#undef VM_JUMP
+#undef VM_FAULT
+#undef VM_NEXT
+#undef VM_DISPATCH
+#if !SENTINEL_VM_COMPUTED_GOTO
+#undef VM_INTERNAL_CASE
+#undef VM_CASE
+#endif
+
+} // namespace Virtualization
+} // namespace Sentinel
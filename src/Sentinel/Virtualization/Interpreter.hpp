@@ -0,0 +1,240 @@
+/**
+ * @file Interpreter.hpp
+ * @brief Threaded-dispatch interpreter for decoded integrity check programs.
+ *
+ * @details Integrity checks run continuously on every host, so the fixed cost of each VM
+ * instruction is paid millions of times per second. The interpreter keeps that cost to a
+ * few machine instructions:
+ * - Programs are pre-decoded (see Program), so a handler never parses bytecode.
+ * - Dispatch is threaded: every handler ends with its own indirect jump to the next
+ *   handler instead of returning to a shared `switch`. Each jump site then has its own
+ *   branch-predictor history, which predicts the recurring opcode sequences of a check
+ *   loop far better than a single shared jump.
+ * - The top of the operand stack lives in a local variable that the compiler keeps in a
+ *   register; only the elements below it are in memory. Binary operations therefore read
+ *   one stack slot instead of two and write none.
+ * - The operand stack is a fixed, cache-line-aligned array inside the interpreter, so
+ *   pushes never allocate and stack bounds checks are a single pointer comparison.
+ *
+ * Dispatch is implemented per compiler:
+ * - GCC and clang: labels-as-values (computed goto) through a table of handler addresses.
+ * - MSVC, which has no labels-as-values: every handler ends with a replicated copy of the
+ *   dispatch `switch` whose cases jump to the handler labels. `__assume(0)` on the default
+ *   case removes the range check, so each copy compiles to one bounds-free jump table
+ *   lookup, and each handler keeps its own indirect branch.
+ *
+ * Loads and region hashes read host memory and are only allowed inside regions
+ * registered with AddReadableRegion. Taken branches and calls consume a branch budget, so a looping or
+ * malicious program terminates with VmStatus::BudgetExhausted.
+ *
+ * Programs proven safe by Verifier run in an unchecked instantiation of the dispatch loop
+ * without stack and call depth checks, and with the superinstructions the verifier
+ * installed.
+ *
+ * @security Unverified programs are checked for stack depth, call depth and memory bounds
+ * on every instruction that needs them; verified programs only for memory bounds, since
+ * load addresses are runtime values. The registered regions must remain mapped for the
+ * duration of Execute; the interpreter does not probe them.
+ *
+ * @see Program
+ * @see Verifier
+ */
+
+#pragma once
+
+#include "Sentinel/Virtualization/Bytecode.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace Sentinel {
+namespace Virtualization {
+
+/**
+ * @brief Outcome of Interpreter::Execute.
+ */
+enum class VmStatus : uint8_t {
+    /** @brief The program reached Halt. */
+    Halted = 0,
+
+    /** @brief A push would exceed Interpreter::STACK_CAPACITY. */
+    StackOverflow = 1,
+
+    /** @brief An instruction needed more operands than the stack held. */
+    StackUnderflow = 2,
+
+    /** @brief A call would exceed Interpreter::CALL_DEPTH. */
+    CallDepthExceeded = 3,
+
+    /** @brief Ret executed with no active call. */
+    ReturnUnderflow = 4,
+
+    /** @brief A load touched memory outside every readable region. */
+    MemoryFault = 5,
+
+    /** @brief The program took more branches than the configured budget. */
+    BudgetExhausted = 6,
+
+    /** @brief The program was empty or failed to decode. */
+    InvalidProgram = 7,
+
+    /**
+     * @brief Execution left a decrypted window; value holds the instruction index to
+     * continue at. Only seen by SecureProgram, never returned from Execute.
+     */
+    Yielded = 8
+};
+
+/**
+ * @brief Result of one program execution.
+ */
+struct ExecutionResult {
+    VmStatus status = VmStatus::InvalidProgram;
+
+    /** @brief Top of stack at Halt (0 if the stack was empty or execution faulted). */
+    uint64_t value = 0;
+
+    /** @brief Bytecode offset of the halting or faulting instruction. */
+    uint32_t offset = 0;
+};
+
+#pragma warning(push)
+#pragma warning(disable : 4324) // structure was padded due to alignment specifier
+
+/**
+ * @class Interpreter
+ * @brief Executes decoded programs with threaded dispatch and a register-cached stack top.
+ *
+ * Usage example:
+ * @code
+ * Interpreter vm;
+ * vm.AddReadableRegion(textBase, textSize);
+ * vm.SetRegister(0, reinterpret_cast<uint64_t>(textBase));
+ * ExecutionResult result = vm.Execute(program);
+ * if (result.status != VmStatus::Halted || result.value != expectedDigest) {
+ *     Logger::LogError("Integrity check failed");
+ * }
+ * @endcode
+ *
+ * @threadsafe Not thread-safe; use one interpreter per thread. Programs may be shared.
+ */
+class Interpreter {
+public:
+    /** @brief Operand stack capacity in 64-bit elements. */
+    static constexpr size_t STACK_CAPACITY = 256;
+
+    /** @brief Maximum nesting of Call instructions. */
+    static constexpr size_t CALL_DEPTH = 64;
+
+    /** @brief Maximum number of readable memory regions. */
+    static constexpr size_t MAX_REGIONS = 8;
+
+    /** @brief Default number of taken branches and calls allowed per execution. */
+    static constexpr uint64_t DEFAULT_BRANCH_BUDGET = 1ull << 24;
+
+    Interpreter() = default;
+
+    Interpreter(const Interpreter&) = delete;
+    Interpreter& operator=(const Interpreter&) = delete;
+
+    /**
+     * @brief Allows loads from [base, base + size).
+     *
+     * @return false if MAX_REGIONS regions are already registered or the range wraps.
+     */
+    bool AddReadableRegion(const void* base, size_t size) noexcept;
+
+    /** @brief Removes every readable region. */
+    void ClearReadableRegions() noexcept { regionCount_ = 0; }
+
+    /**
+     * @brief Sets the number of taken branches and calls allowed per execution (0 = default).
+     */
+    void SetBranchBudget(uint64_t budget) noexcept {
+        branchBudget_ = budget == 0 ? DEFAULT_BRANCH_BUDGET : budget;
+    }
+
+    /**
+     * @brief Reads register @p index; registers carry inputs and outputs across executions.
+     */
+    uint64_t GetRegister(size_t index) const noexcept {
+        return index < VM_REGISTER_COUNT ? registers_[index] : 0;
+    }
+
+    /** @brief Writes register @p index; out-of-range indices are ignored. */
+    void SetRegister(size_t index, uint64_t value) noexcept {
+        if (index < VM_REGISTER_COUNT) {
+            registers_[index] = value;
+        }
+    }
+
+    /**
+     * @brief Runs @p program from its first instruction until Halt or a fault.
+     *
+     * @details The operand and call stacks start empty on every execution; registers keep
+     * their values.
+     */
+    ExecutionResult Execute(const Program& program) noexcept;
+
+    /** @brief Name of the dispatch technique compiled in, for diagnostics. */
+    static const char* GetDispatchMode() noexcept;
+
+private:
+    friend class SecureProgram;
+
+    /** @brief Empties the operand and call stacks and refills the branch budget. */
+    void Reset() noexcept;
+
+    /**
+     * @brief Runs the window @p code, which holds instructions [base, base + count) of a
+     * program followed by any Yield stubs, starting at code[entry].
+     *
+     * @details Call pushes and Ret pops absolute instruction indices, so a return into
+     * another window yields instead of jumping. On Yield, the stack state is saved so the
+     * next Run continues the same execution.
+     *
+     * @param checked false only for verified programs: skips stack and call depth checks.
+     */
+    ExecutionResult Run(const DecodedInstruction* code, uint32_t base, uint32_t count, uint32_t entry,
+                        bool checked) noexcept;
+
+    /** @brief Run's dispatch loop, instantiated with and without stack and call checks. */
+    template <bool Checked>
+    ExecutionResult RunLoop(const DecodedInstruction* code, uint32_t base, uint32_t count, uint32_t entry) noexcept;
+
+    struct MemoryRegion {
+        uint64_t base;
+        uint64_t size;
+    };
+
+    /** @brief true if [address, address + length) lies inside one readable region. */
+    bool IsReadable(uint64_t address, uint64_t length) const noexcept {
+        for (size_t i = 0; i < regionCount_; ++i) {
+            const MemoryRegion& region = regions_[i];
+            if (address - region.base < region.size && region.size - (address - region.base) >= length) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Element k of a stack of depth d lives in slot k for k < d, the top in a register;
+    // slot 0 absorbs the undefined top spilled by the first push
+    alignas(64) uint64_t stack_[STACK_CAPACITY];
+    uint32_t callStack_[CALL_DEPTH];
+    uint64_t registers_[VM_REGISTER_COUNT] = {};
+
+    MemoryRegion regions_[MAX_REGIONS] = {};
+    size_t regionCount_ = 0;
+    uint64_t branchBudget_ = DEFAULT_BRANCH_BUDGET;
+
+    // Execution state carried from one Run to the next across a Yield
+    size_t stackDepth_ = 0;
+    uint64_t cachedTop_ = 0;
+    size_t callDepth_ = 0;
+    uint64_t budgetLeft_ = 0;
+};
+
+#pragma warning(pop)
+
+} // namespace Virtualization
+} // namespace Sentinel
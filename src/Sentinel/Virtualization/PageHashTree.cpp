@@ -0,0 +1,165 @@
+/**
+ * @file PageHashTree.cpp
+ * @brief Implementation of the incremental page hash tree.
+ */
+
+#include "Sentinel/Virtualization/PageHashTree.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace Sentinel {
+namespace Virtualization {
+
+// Inner nodes hash their two children in place from the node array
+static_assert(sizeof(Sha256Digest) == 32, "node hashing assumes tightly packed digests");
+
+// Domain separation of the two kinds of hash input, as in RFC 6962: without it a region
+// whose page is exactly two digests long would hash like an inner node
+static constexpr uint8_t LEAF_PREFIX = 0x00;
+static constexpr uint8_t NODE_PREFIX = 0x01;
+
+bool PageHashTree::Build(const void* base, size_t size, const PageHashTreeConfig& config) {
+    nodes_.clear();
+    pageCount_ = 0;
+
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    const size_t pageSize = info.dwPageSize;
+    if (base == nullptr || size == 0 || reinterpret_cast<uintptr_t>(base) % pageSize != 0) {
+        Utils::Logger::LogError("PageHashTree: region must be non-empty and page-aligned");
+        return false;
+    }
+    const size_t pages = (size + pageSize - 1) / pageSize;
+    if (pages > UINT32_MAX) {
+        Utils::Logger::Error("PageHashTree: region of {} pages is too large", pages);
+        return false;
+    }
+
+    base_ = static_cast<const uint8_t*>(base);
+    size_ = size;
+    pageSize_ = pageSize;
+    pageCount_ = static_cast<uint32_t>(pages);
+    leafBase_ = std::bit_ceil(pages);
+    nodes_.assign(2 * leafBase_, Sha256Digest{});
+
+    // Resetting before hashing means a write racing with Build is reported by the first
+    // Refresh instead of being lost
+    mode_ = PageTrackingMode::Sampling;
+    if (config.useWriteWatch && ResetWriteWatch(const_cast<void*>(base), size) == 0) {
+        mode_ = PageTrackingMode::WriteWatch;
+        writtenPages_.resize(pages);
+    }
+    samplePages_ = std::min(config.samplePagesPerRefresh, pageCount_);
+    sampleCursor_ = 0;
+
+    for (uint32_t i = 0; i < pageCount_; ++i) {
+        const size_t offset = static_cast<size_t>(i) * pageSize_;
+        nodes_[leafBase_ + i] =
+            RegionHash::Sha256(LEAF_PREFIX, base_ + offset, std::min(pageSize_, size_ - offset));
+    }
+    for (size_t node = leafBase_ - 1; node >= 1; --node) {
+        nodes_[node] = HashNode(node);
+    }
+
+    changed_.reserve(pages);
+    dirtyNodes_.reserve(pages);
+    pagesHashed_ = 0;
+
+    Utils::Logger::Info("PageHashTree: {} pages, {} tracking", pageCount_,
+                        mode_ == PageTrackingMode::WriteWatch ? "write-watch" : "sampling");
+    return true;
+}
+
+size_t PageHashTree::Refresh(uint32_t* changedPages, size_t capacity) {
+    if (nodes_.empty()) {
+        return 0;
+    }
+    changed_.clear();
+
+    if (mode_ == PageTrackingMode::WriteWatch) {
+        ULONG_PTR count = writtenPages_.size();
+        ULONG granularity = 0;
+        if (GetWriteWatch(WRITE_WATCH_FLAG_RESET, const_cast<uint8_t*>(base_), size_, writtenPages_.data(), &count,
+                          &granularity) == 0) {
+            for (ULONG_PTR i = 0; i < count; ++i) {
+                const size_t offset = static_cast<size_t>(static_cast<const uint8_t*>(writtenPages_[i]) - base_);
+                CheckPage(static_cast<uint32_t>(offset / pageSize_));
+            }
+        } else {
+            // Sampling still runs, so the pass degrades instead of failing
+            Utils::Logger::Error("PageHashTree: GetWriteWatch failed ({})", GetLastError());
+        }
+    }
+
+    for (uint32_t i = 0; i < samplePages_; ++i) {
+        CheckPage(sampleCursor_);
+        sampleCursor_ = sampleCursor_ + 1 == pageCount_ ? 0 : sampleCursor_ + 1;
+    }
+    return CommitChanges(changedPages, capacity);
+}
+
+size_t PageHashTree::FullScan(uint32_t* changedPages, size_t capacity) {
+    if (nodes_.empty()) {
+        return 0;
+    }
+    changed_.clear();
+
+    // Writes before this point are covered by the scan; later ones by the next Refresh
+    if (mode_ == PageTrackingMode::WriteWatch) {
+        ResetWriteWatch(const_cast<uint8_t*>(base_), size_);
+    }
+    for (uint32_t i = 0; i < pageCount_; ++i) {
+        CheckPage(i);
+    }
+    return CommitChanges(changedPages, capacity);
+}
+
+void PageHashTree::CheckPage(uint32_t index) {
+    const size_t offset = static_cast<size_t>(index) * pageSize_;
+    const Sha256Digest digest =
+        RegionHash::Sha256(LEAF_PREFIX, base_ + offset, std::min(pageSize_, size_ - offset));
+    ++pagesHashed_;
+
+    Sha256Digest& leaf = nodes_[leafBase_ + index];
+    if (!(digest == leaf)) {
+        leaf = digest;
+        changed_.push_back(index);
+    }
+}
+
+size_t PageHashTree::CommitChanges(uint32_t* changedPages, size_t capacity) {
+    // A page written while a pass hashed it twice is staged twice
+    std::sort(changed_.begin(), changed_.end());
+    changed_.erase(std::unique(changed_.begin(), changed_.end()), changed_.end());
+
+    // All nodes of one level are rehashed before the next, so an ancestor shared by
+    // several changed pages is hashed once. A single-page tree is its own root
+    dirtyNodes_.clear();
+    if (leafBase_ > 1) {
+        for (uint32_t index : changed_) {
+            dirtyNodes_.push_back((leafBase_ + index) / 2);
+        }
+    }
+    while (!dirtyNodes_.empty()) {
+        dirtyNodes_.erase(std::unique(dirtyNodes_.begin(), dirtyNodes_.end()), dirtyNodes_.end());
+        for (size_t& node : dirtyNodes_) {
+            nodes_[node] = HashNode(node);
+            node /= 2;
+        }
+        if (dirtyNodes_.front() == 0) {
+            break;
+        }
+    }
+
+    const size_t reported = std::min(changed_.size(), capacity);
+    std::copy_n(changed_.begin(), reported, changedPages);
+    return changed_.size();
+}
+
+Sha256Digest PageHashTree::HashNode(size_t node) const noexcept {
+    return RegionHash::Sha256(NODE_PREFIX, &nodes_[2 * node], 2 * sizeof(Sha256Digest));
+}
+
+} // namespace Virtualization
+} // namespace Sentinel
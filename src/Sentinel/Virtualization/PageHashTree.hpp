@@ -0,0 +1,179 @@
+/**
+ * @file PageHashTree.hpp
+ * @brief Incremental integrity hashing of a memory region through a per-page Merkle tree.
+ *
+ * @details Re-hashing a 50 MB module image on every integrity pass costs tens of
+ * milliseconds of CPU time for a result that is almost always "unchanged". PageHashTree
+ * instead keeps a SHA-256 digest of every page of one region as the leaves of a binary
+ * Merkle tree, so that a pass only re-hashes the pages that may have changed:
+ * - Regions allocated with MEM_WRITE_WATCH report their written pages through
+ *   GetWriteWatch, so a pass re-hashes exactly the pages written since the previous one.
+ * - Other regions - in particular image sections, which cannot be write-watched - are
+ *   verified by rotating sampling: each pass re-hashes the next samplePagesPerRefresh
+ *   pages, so the whole region is covered every pageCount / samplePagesPerRefresh passes.
+ *   Sampling also runs in write-watch mode as a second line of defense.
+ *
+ * A page whose digest differs is reported and its leaf replaced; every changed leaf's
+ * path to the root is then recomputed, with shared ancestors hashed once, so the root
+ * costs O(log n) node hashes per change instead of a pass over the region. FullScan
+ * re-hashes every page and is meant as a rare background job.
+ *
+ * The root identifies the region's current content and can be compared against a root
+ * computed elsewhere (for example, from the on-disk image by the Service).
+ *
+ * Tree layout: leaves are SHA-256(0x00 || page) for every page, partial last page
+ * included; inner nodes are SHA-256(0x01 || left || right). The tree is complete: missing
+ * leaves up to the next power of two are all-zero digests. The prefixes keep leaf and
+ * node inputs apart even when a page is exactly 64 bytes long, so no node can be
+ * presented as a leaf.
+ *
+ * @security Sampling detects a modification only once the rotation reaches the page, and
+ * misses one that is reverted before then. Protect code sections with a full-coverage
+ * period short enough for the threat model, and keep FullScan on the background
+ * schedule. The region must stay committed and readable while the tree exists.
+ *
+ * @see RegionHash
+ */
+
+#pragma once
+
+#include "Sentinel/Virtualization/RegionHash.hpp"
+#include <Windows.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Sentinel {
+namespace Virtualization {
+
+/**
+ * @brief How PageHashTree finds pages to re-hash.
+ */
+enum class PageTrackingMode : uint8_t {
+    /** @brief GetWriteWatch reports written pages; sampling adds coverage. */
+    WriteWatch = 0,
+
+    /** @brief Rotating sampling only. */
+    Sampling = 1
+};
+
+/**
+ * @brief Configuration for PageHashTree::Build.
+ */
+struct PageHashTreeConfig {
+    /** @brief Use GetWriteWatch when the region was allocated with MEM_WRITE_WATCH. */
+    bool useWriteWatch = true;
+
+    /** @brief Pages re-hashed per Refresh by rotating sampling; 0 disables sampling. */
+    uint32_t samplePagesPerRefresh = 64;
+};
+
+/**
+ * @class PageHashTree
+ * @brief Merkle tree of page digests over one region, updated incrementally.
+ *
+ * Usage example:
+ * @code
+ * PageHashTree tree;
+ * if (!tree.Build(textBase, textSize)) {
+ *     return false;
+ * }
+ * // every integrity pass
+ * uint32_t changed[64];
+ * size_t count = tree.Refresh(changed, 64);
+ * if (count != 0) {
+ *     ReportModifiedPages(changed, (std::min)(count, size_t{64}));
+ * }
+ * @endcode
+ *
+ * @threadsafe Not thread-safe. Refresh and FullScan must not run concurrently with each
+ * other or with Build.
+ */
+class PageHashTree {
+public:
+    PageHashTree() = default;
+
+    PageHashTree(const PageHashTree&) = delete;
+    PageHashTree& operator=(const PageHashTree&) = delete;
+
+    /**
+     * @brief Hashes every page of [base, base + size) and builds the tree.
+     *
+     * @param base Start of the region; must be page-aligned.
+     * @return false (and logs) if the arguments are invalid or the region has more than
+     *         UINT32_MAX pages.
+     */
+    bool Build(const void* base, size_t size, const PageHashTreeConfig& config = PageHashTreeConfig{});
+
+    /**
+     * @brief Re-hashes the pages that may have changed and updates the tree.
+     *
+     * @param changedPages Receives indices of pages whose digest changed, ascending.
+     * @param capacity Number of entries in @p changedPages.
+     * @return Number of changed pages. Only the first @p capacity indices are written, but
+     *         every change is applied to the tree.
+     */
+    size_t Refresh(uint32_t* changedPages, size_t capacity);
+
+    /**
+     * @brief Re-hashes every page; same contract as Refresh.
+     */
+    size_t FullScan(uint32_t* changedPages, size_t capacity);
+
+    /** @brief Digest identifying the current content of the whole region; zero before a successful Build. */
+    const Sha256Digest& GetRoot() const noexcept { return nodes_.empty() ? ZERO_DIGEST : nodes_[1]; }
+
+    /**
+     * @brief Digest of page @p index as of the last pass that hashed it; zero if @p index is
+     * not below GetPageCount() (always so before a successful Build).
+     */
+    const Sha256Digest& GetPageDigest(uint32_t index) const noexcept {
+        return index < pageCount_ ? nodes_[leafBase_ + index] : ZERO_DIGEST;
+    }
+
+    uint32_t GetPageCount() const noexcept { return pageCount_; }
+
+    PageTrackingMode GetMode() const noexcept { return mode_; }
+
+    /** @brief Pages hashed by Refresh and FullScan since Build. */
+    uint64_t GetPagesHashed() const noexcept { return pagesHashed_; }
+
+private:
+    /**
+     * @brief Hashes page @p index and stages it for a path update if its digest changed.
+     */
+    void CheckPage(uint32_t index);
+
+    /**
+     * @brief Recomputes the ancestors of the staged leaves and reports the staged pages.
+     */
+    size_t CommitChanges(uint32_t* changedPages, size_t capacity);
+
+    Sha256Digest HashNode(size_t node) const noexcept;
+
+    // Returned by the accessors when there is no tree or no such page
+    static constexpr Sha256Digest ZERO_DIGEST{};
+
+    const uint8_t* base_ = nullptr;
+    size_t size_ = 0;
+    size_t pageSize_ = 0;
+    uint32_t pageCount_ = 0;
+    PageTrackingMode mode_ = PageTrackingMode::Sampling;
+    uint32_t samplePages_ = 0;
+    uint32_t sampleCursor_ = 0;
+
+    // Heap-ordered complete tree: node 1 is the root, node n has children 2n and 2n + 1,
+    // and leaf i is node leafBase_ + i
+    std::vector<Sha256Digest> nodes_;
+    size_t leafBase_ = 0;
+
+    // Per-pass scratch, sized at Build so that passes do not allocate
+    std::vector<PVOID> writtenPages_;
+    std::vector<uint32_t> changed_;
+    std::vector<size_t> dirtyNodes_;
+
+    uint64_t pagesHashed_ = 0;
+};
+
+} // namespace Virtualization
+} // namespace Sentinel
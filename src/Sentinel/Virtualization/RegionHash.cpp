@@ -0,0 +1,409 @@
+/**
+ * @file RegionHash.cpp
+ * @brief Implementation of the SHA-256 and CRC32C kernels.
+ */
+
+#include "Sentinel/Virtualization/RegionHash.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+#if defined(_M_X64)
+#include <intrin.h>
+#include <immintrin.h>
+#define SENTINEL_REGION_HASH_X64 1
+#endif
+
+// MSVC emits SHA and SSE4.2 intrinsics in any function; clang and GCC need the target
+// enabled per function
+#if defined(SENTINEL_REGION_HASH_X64) && (defined(__clang__) || defined(__GNUC__))
+#define SENTINEL_TARGET_SHA __attribute__((target("sha,ssse3,sse4.1")))
+#define SENTINEL_TARGET_CRC32C __attribute__((target("sse4.2,pclmul")))
+#else
+#define SENTINEL_TARGET_SHA
+#define SENTINEL_TARGET_CRC32C
+#endif
+
+namespace Sentinel {
+namespace Virtualization {
+
+// FIPS 180-4 round constants and initial hash value
+alignas(16) static constexpr uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static constexpr uint32_t SHA256_INITIAL[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                               0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+static constexpr size_t SHA256_BLOCK_BYTES = 64;
+
+// Castagnoli polynomial, bit-reflected
+static constexpr uint32_t CRC32C_POLYNOMIAL = 0x82F63B78;
+
+// The parallel CRC32C kernel runs one dependency chain per lane over adjacent pages
+static constexpr size_t CRC32C_LANES = 4;
+static constexpr size_t CRC32C_LANE_BYTES = 4096;
+
+using CompressFunction = void (*)(uint32_t* state, const uint8_t* blocks, size_t blockCount) noexcept;
+
+static inline uint32_t LoadBigEndian32(const uint8_t* bytes) noexcept {
+    return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+           (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+}
+
+static void CompressPortable(uint32_t* state, const uint8_t* blocks, size_t blockCount) noexcept {
+    for (; blockCount != 0; --blockCount, blocks += SHA256_BLOCK_BYTES) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = LoadBigEndian32(blocks + i * 4);
+        }
+        for (int i = 16; i < 64; ++i) {
+            const uint32_t s0 = std::rotr(w[i - 15], 7) ^ std::rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            const uint32_t s1 = std::rotr(w[i - 2], 17) ^ std::rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i) {
+            const uint32_t s1 = std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25);
+            const uint32_t choice = (e & f) ^ (~e & g);
+            const uint32_t t1 = h + s1 + choice + SHA256_K[i] + w[i];
+            const uint32_t s0 = std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22);
+            const uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+            const uint32_t t2 = s0 + majority;
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+// Hashes prefix || data: compresses every whole block in place, then the padded tail;
+// shared by all kernels
+static Sha256Digest HashWith(CompressFunction compress, const uint8_t* prefix, size_t prefixLength,
+                             const void* data, size_t length) noexcept {
+    uint32_t state[8];
+    std::memcpy(state, SHA256_INITIAL, sizeof(state));
+    const uint64_t bits = static_cast<uint64_t>(prefixLength + length) * 8;
+
+    // The prefix (shorter than a block) is completed into a first block from the data
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint8_t first[SHA256_BLOCK_BYTES];
+    size_t buffered = prefixLength;
+    if (prefixLength != 0) {
+        std::memcpy(first, prefix, prefixLength);
+        const size_t taken = (std::min)(SHA256_BLOCK_BYTES - prefixLength, length);
+        std::memcpy(first + prefixLength, bytes, taken);
+        buffered += taken;
+        bytes += taken;
+        length -= taken;
+        if (buffered == SHA256_BLOCK_BYTES) {
+            compress(state, first, 1);
+            buffered = 0;
+        }
+    }
+
+    const size_t wholeBlocks = length / SHA256_BLOCK_BYTES;
+    if (wholeBlocks != 0) {
+        compress(state, bytes, wholeBlocks);
+    }
+
+    // Padding: 0x80, zeros, then the message length in bits as a big-endian 64-bit value
+    uint8_t tail[2 * SHA256_BLOCK_BYTES] = {};
+    size_t remainder = length % SHA256_BLOCK_BYTES;
+    if (buffered != 0) {
+        // Only reached when the data ended inside the first block
+        std::memcpy(tail, first, buffered);
+        remainder = buffered;
+    } else if (remainder != 0) {
+        std::memcpy(tail, bytes + wholeBlocks * SHA256_BLOCK_BYTES, remainder);
+    }
+    tail[remainder] = 0x80;
+    const size_t tailBlocks = remainder < SHA256_BLOCK_BYTES - 8 ? 1 : 2;
+    for (size_t i = 0; i < 8; ++i) {
+        tail[tailBlocks * SHA256_BLOCK_BYTES - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+    }
+    compress(state, tail, tailBlocks);
+
+    Sha256Digest digest;
+    for (size_t i = 0; i < 8; ++i) {
+        digest.bytes[i * 4] = static_cast<uint8_t>(state[i] >> 24);
+        digest.bytes[i * 4 + 1] = static_cast<uint8_t>(state[i] >> 16);
+        digest.bytes[i * 4 + 2] = static_cast<uint8_t>(state[i] >> 8);
+        digest.bytes[i * 4 + 3] = static_cast<uint8_t>(state[i]);
+    }
+    return digest;
+}
+
+static constexpr std::array<uint32_t, 256> BuildCrc32cTable() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) != 0 ? (crc >> 1) ^ CRC32C_POLYNOMIAL : crc >> 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+static constexpr std::array<uint32_t, 256> CRC32C_TABLE = BuildCrc32cTable();
+
+#if defined(SENTINEL_REGION_HASH_X64)
+
+// Four rounds of the SHA-NI schedule. Group g consumes message vector g; the next message
+// vectors are expanded while these rounds run (msg1 from group 1, msg2 from group 3 on)
+#define SHA_NI_ROUNDS(g, current, previous, next)                                        \
+    {                                                                                    \
+        const __m128i* constants = reinterpret_cast<const __m128i*>(SHA256_K + (g) * 4); \
+        __m128i message = _mm_add_epi32(current, _mm_load_si128(constants));             \
+        cdgh = _mm_sha256rnds2_epu32(cdgh, abef, message);                               \
+        if constexpr ((g) >= 3 && (g) <= 14) {                                           \
+            next = _mm_add_epi32(next, _mm_alignr_epi8(current, previous, 4));           \
+            next = _mm_sha256msg2_epu32(next, current);                                  \
+        }                                                                                \
+        message = _mm_shuffle_epi32(message, 0x0E);                                      \
+        abef = _mm_sha256rnds2_epu32(abef, cdgh, message);                               \
+        if constexpr ((g) >= 1 && (g) <= 12) {                                           \
+            previous = _mm_sha256msg1_epu32(previous, current);                          \
+        }                                                                                \
+    }
+
+SENTINEL_TARGET_SHA
+static void CompressShaNi(uint32_t* state, const uint8_t* blocks, size_t blockCount) noexcept {
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bll, 0x0405060700010203ll);
+
+    // The rounds instructions want the state as {A,B,E,F} and {C,D,G,H}
+    const __m128i dcba = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);
+    const __m128i hgfe = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B);
+    __m128i abef = _mm_alignr_epi8(dcba, hgfe, 8);
+    __m128i cdgh = _mm_blend_epi16(hgfe, dcba, 0xF0);
+
+    for (; blockCount != 0; --blockCount, blocks += SHA256_BLOCK_BYTES) {
+        const __m128i abefSaved = abef;
+        const __m128i cdghSaved = cdgh;
+
+        __m128i m0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks)), byteSwap);
+        __m128i m1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 16)), byteSwap);
+        __m128i m2 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 32)), byteSwap);
+        __m128i m3 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 48)), byteSwap);
+
+        SHA_NI_ROUNDS(0, m0, m3, m1)
+        SHA_NI_ROUNDS(1, m1, m0, m2)
+        SHA_NI_ROUNDS(2, m2, m1, m3)
+        SHA_NI_ROUNDS(3, m3, m2, m0)
+        SHA_NI_ROUNDS(4, m0, m3, m1)
+        SHA_NI_ROUNDS(5, m1, m0, m2)
+        SHA_NI_ROUNDS(6, m2, m1, m3)
+        SHA_NI_ROUNDS(7, m3, m2, m0)
+        SHA_NI_ROUNDS(8, m0, m3, m1)
+        SHA_NI_ROUNDS(9, m1, m0, m2)
+        SHA_NI_ROUNDS(10, m2, m1, m3)
+        SHA_NI_ROUNDS(11, m3, m2, m0)
+        SHA_NI_ROUNDS(12, m0, m3, m1)
+        SHA_NI_ROUNDS(13, m1, m0, m2)
+        SHA_NI_ROUNDS(14, m2, m1, m3)
+        SHA_NI_ROUNDS(15, m3, m2, m0)
+
+        abef = _mm_add_epi32(abef, abefSaved);
+        cdgh = _mm_add_epi32(cdgh, cdghSaved);
+    }
+
+    const __m128i feba = _mm_shuffle_epi32(abef, 0x1B);
+    const __m128i dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(feba, dchg, 0xF0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(dchg, feba, 8));
+}
+
+#undef SHA_NI_ROUNDS
+
+// Multiplies two bit-reflected polynomials modulo the CRC32C polynomial
+static uint32_t MultiplyModP(uint32_t a, uint32_t b) noexcept {
+    uint32_t product = 0;
+    for (uint32_t mask = 1u << 31; mask != 0; mask >>= 1) {
+        if ((a & mask) != 0) {
+            product ^= b;
+        }
+        b = (b & 1) != 0 ? (b >> 1) ^ CRC32C_POLYNOMIAL : b >> 1;
+    }
+    return product;
+}
+
+// x^exponent modulo the CRC32C polynomial, bit-reflected
+static uint32_t PowerOfXModP(uint64_t exponent) noexcept {
+    uint32_t result = 1u << 31;
+    uint32_t square = 1u << 30;
+    for (; exponent != 0; exponent >>= 1) {
+        if ((exponent & 1) != 0) {
+            result = MultiplyModP(result, square);
+        }
+        square = MultiplyModP(square, square);
+    }
+    return result;
+}
+
+// Multipliers that advance a CRC state past 1, 2 and 3 lanes of zero bytes. A 32x32-bit
+// carry-less product is reduced by the crc32 instruction, which contributes x^32 and the
+// product's reflection another x; both are divided out of the constant up front
+struct LaneShifts {
+    uint32_t multiplier[CRC32C_LANES - 1];
+};
+
+static LaneShifts ComputeLaneShifts() noexcept {
+    LaneShifts shifts{};
+    for (size_t i = 0; i < CRC32C_LANES - 1; ++i) {
+        shifts.multiplier[i] = PowerOfXModP((i + 1) * CRC32C_LANE_BYTES * 8 - 33);
+    }
+    return shifts;
+}
+
+SENTINEL_TARGET_CRC32C
+static inline uint64_t ShiftCrc(uint64_t crc, uint32_t multiplier) noexcept {
+    const __m128i product = _mm_clmulepi64_si128(_mm_cvtsi32_si128(static_cast<int>(crc)),
+                                                 _mm_cvtsi32_si128(static_cast<int>(multiplier)), 0x00);
+    return _mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(product)));
+}
+
+SENTINEL_TARGET_CRC32C
+static uint32_t Crc32cSse42(const uint8_t* bytes, size_t length, uint32_t crc) noexcept {
+    static const LaneShifts shifts = ComputeLaneShifts();
+
+    uint64_t state = ~crc;
+    while (length >= CRC32C_LANES * CRC32C_LANE_BYTES) {
+        uint64_t lane0 = state;
+        uint64_t lane1 = 0;
+        uint64_t lane2 = 0;
+        uint64_t lane3 = 0;
+        for (size_t offset = 0; offset < CRC32C_LANE_BYTES; offset += 8) {
+            uint64_t word0, word1, word2, word3;
+            std::memcpy(&word0, bytes + offset, 8);
+            std::memcpy(&word1, bytes + CRC32C_LANE_BYTES + offset, 8);
+            std::memcpy(&word2, bytes + 2 * CRC32C_LANE_BYTES + offset, 8);
+            std::memcpy(&word3, bytes + 3 * CRC32C_LANE_BYTES + offset, 8);
+            lane0 = _mm_crc32_u64(lane0, word0);
+            lane1 = _mm_crc32_u64(lane1, word1);
+            lane2 = _mm_crc32_u64(lane2, word2);
+            lane3 = _mm_crc32_u64(lane3, word3);
+        }
+        // CRC is linear: each lane's state is carried past the lanes that follow it
+        state = ShiftCrc(lane0, shifts.multiplier[2]) ^ ShiftCrc(lane1, shifts.multiplier[1]) ^
+                ShiftCrc(lane2, shifts.multiplier[0]) ^ lane3;
+        bytes += CRC32C_LANES * CRC32C_LANE_BYTES;
+        length -= CRC32C_LANES * CRC32C_LANE_BYTES;
+    }
+    for (; length >= 8; length -= 8, bytes += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes, 8);
+        state = _mm_crc32_u64(state, word);
+    }
+    uint32_t narrow = static_cast<uint32_t>(state);
+    for (; length != 0; --length) {
+        narrow = _mm_crc32_u8(narrow, *bytes++);
+    }
+    return ~narrow;
+}
+
+static bool DetectSha() noexcept {
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool ssse3 = (info[2] & (1 << 9)) != 0;
+    const bool sse41 = (info[2] & (1 << 19)) != 0;
+    __cpuidex(info, 7, 0);
+    return ssse3 && sse41 && (info[1] & (1 << 29)) != 0;
+}
+
+static bool DetectCrc32c() noexcept {
+    int info[4];
+    __cpuid(info, 1);
+    const bool pclmul = (info[2] & (1 << 1)) != 0;
+    const bool sse42 = (info[2] & (1 << 20)) != 0;
+    return pclmul && sse42;
+}
+
+#endif // SENTINEL_REGION_HASH_X64
+
+Sha256Digest RegionHash::Sha256Portable(const void* data, size_t length) noexcept {
+    return HashWith(&CompressPortable, nullptr, 0, data, length);
+}
+
+Sha256Digest RegionHash::Sha256(const void* data, size_t length) noexcept {
+#if defined(SENTINEL_REGION_HASH_X64)
+    if (IsShaSupported()) {
+        return HashWith(&CompressShaNi, nullptr, 0, data, length);
+    }
+#endif
+    return HashWith(&CompressPortable, nullptr, 0, data, length);
+}
+
+Sha256Digest RegionHash::Sha256(uint8_t prefix, const void* data, size_t length) noexcept {
+#if defined(SENTINEL_REGION_HASH_X64)
+    if (IsShaSupported()) {
+        return HashWith(&CompressShaNi, &prefix, 1, data, length);
+    }
+#endif
+    return HashWith(&CompressPortable, &prefix, 1, data, length);
+}
+
+uint32_t RegionHash::Crc32cPortable(const void* data, size_t length, uint32_t crc) noexcept {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) {
+        crc = CRC32C_TABLE[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t RegionHash::Crc32c(const void* data, size_t length, uint32_t crc) noexcept {
+#if defined(SENTINEL_REGION_HASH_X64)
+    if (IsCrc32cSupported()) {
+        return Crc32cSse42(static_cast<const uint8_t*>(data), length, crc);
+    }
+#endif
+    return Crc32cPortable(data, length, crc);
+}
+
+bool RegionHash::IsShaSupported() noexcept {
+#if defined(SENTINEL_REGION_HASH_X64)
+    static const bool supported = DetectSha();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+bool RegionHash::IsCrc32cSupported() noexcept {
+#if defined(SENTINEL_REGION_HASH_X64)
+    static const bool supported = DetectCrc32c();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+} // namespace Virtualization
+} // namespace Sentinel
@@ -0,0 +1,101 @@
+/**
+ * @file RegionHash.hpp
+ * @brief Hardware-accelerated SHA-256 and CRC32C over memory regions.
+ *
+ * @details Integrity checks mostly hash .text sections and other integrity-critical
+ * regions of the target, often several megabytes per pass. Expressed as a byte loop in
+ * VM bytecode that costs several VM instructions per byte; the VM instead exposes these
+ * kernels as single opcodes (HashSha256, HashCrc32c) over a whole address range.
+ *
+ * Two algorithms cover the two kinds of check:
+ * - SHA-256 for tamper evidence against an adversary. The kernel uses the SHA extensions
+ *   (SHA-NI: sha256rnds2/msg1/msg2), which run the compression rounds in hardware at
+ *   several times the speed of the portable kernel used on processors without them.
+ * - CRC32C for fast change detection (for example, verifying many pages per pass). The
+ *   kernel runs the SSE4.2 crc32 instruction on four pages in parallel - four
+ *   independent dependency chains hide its 3-cycle latency - and joins the four partial
+ *   CRCs with carry-less multiplication (PCLMULQDQ). A table-driven kernel covers
+ *   processors without SSE4.2.
+ *
+ * Kernels are selected once per process from CPUID. Every kernel of an algorithm
+ * produces identical results; the *Portable functions are exposed for verification and
+ * benchmarking.
+ *
+ * @security CRC32C is linear and trivially forgeable; use it only where the adversary
+ * cannot choose the data, or as a prefilter before a SHA-256 comparison. Neither function
+ * validates its input range; callers (the interpreter) check readability first.
+ *
+ * @performance SentinelBench (bench/) reports the throughput of every kernel.
+ *
+ * @see Interpreter
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Sentinel {
+namespace Virtualization {
+
+/**
+ * @brief A SHA-256 digest in its canonical byte order.
+ */
+struct Sha256Digest {
+    uint8_t bytes[32];
+
+    bool operator==(const Sha256Digest& other) const noexcept = default;
+};
+
+/**
+ * @class RegionHash
+ * @brief SHA-256 and CRC32C kernels for one contiguous memory range.
+ *
+ * Usage example:
+ * @code
+ * Sha256Digest digest = RegionHash::Sha256(textBase, textSize);
+ * if (!(digest == expected)) {
+ *     ReportTampering();
+ * }
+ * uint32_t crc = RegionHash::Crc32c(page, 4096);
+ * @endcode
+ *
+ * @threadsafe All methods are thread-safe.
+ */
+class RegionHash {
+public:
+    /**
+     * @brief Computes the SHA-256 digest of [data, data + length) with the fastest kernel.
+     */
+    static Sha256Digest Sha256(const void* data, size_t length) noexcept;
+
+    /**
+     * @brief Computes SHA-256(@p prefix || data) without copying the data, for
+     * domain-separated hashing (e.g. Merkle leaves and nodes).
+     */
+    static Sha256Digest Sha256(uint8_t prefix, const void* data, size_t length) noexcept;
+
+    /** @brief Portable SHA-256 kernel; same contract as Sha256. */
+    static Sha256Digest Sha256Portable(const void* data, size_t length) noexcept;
+
+    /**
+     * @brief Computes the CRC32C (Castagnoli) of [data, data + length) with the fastest
+     * kernel.
+     *
+     * @param crc CRC of the preceding data, to continue a running checksum; 0 to start.
+     * @return The standard CRC32C: Crc32c("123456789", 9) == 0xE3069283.
+     */
+    static uint32_t Crc32c(const void* data, size_t length, uint32_t crc = 0) noexcept;
+
+    /** @brief Table-driven CRC32C kernel; same contract as Crc32c. */
+    static uint32_t Crc32cPortable(const void* data, size_t length, uint32_t crc = 0) noexcept;
+
+    /** @brief Returns true if the processor supports the SHA extensions. Detected once. */
+    static bool IsShaSupported() noexcept;
+
+    /** @brief Returns true if the processor supports SSE4.2 and PCLMULQDQ. Detected once. */
+    static bool IsCrc32cSupported() noexcept;
+};
+
+} // namespace Virtualization
+} // namespace Sentinel
@@ -0,0 +1,342 @@
+/**
+ * @file SecureProgram.cpp
+ * @brief Implementation of window-granular program encryption.
+ */
+
+#include "Sentinel/Virtualization/SecureProgram.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+#include "Sentinel/Utils/Metrics.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace Sentinel {
+namespace Virtualization {
+
+// Instructions per window in CacheLine mode
+static constexpr uint32_t CACHE_LINE_INSTRUCTIONS = 64 / sizeof(DecodedInstruction);
+
+// The arena is allocated and locked in whole pages
+static constexpr size_t ARENA_PAGE_SIZE = 4096;
+
+static constexpr ULONG AES_KEY_BYTES = 32;
+static constexpr size_t AES_BLOCK_BYTES = 16;
+static_assert(sizeof(DecodedInstruction) == AES_BLOCK_BYTES, "one counter block per instruction");
+
+// Window decryption included; instructions are counted by the interpreter ("vm.instructions")
+static Utils::Histogram executeTime;
+static const Utils::MetricRegistration executeTimeMetric("vm.secure_execute_ns", executeTime);
+
+static bool IsBranch(HandlerId handler) {
+    return handler == HandlerId::Jmp || handler == HandlerId::Jz || handler == HandlerId::Jnz ||
+           handler == HandlerId::Call;
+}
+
+// Instructions after which a new basic block starts
+static bool EndsBlock(HandlerId handler) {
+    return IsBranch(handler) || handler == HandlerId::Ret || handler == HandlerId::Halt;
+}
+
+static DecodedInstruction MakeYield(uint32_t target, uint32_t sourceOffset) {
+    DecodedInstruction yield{};
+    yield.handler = HandlerId::Yield;
+    yield.sourceOffset = sourceOffset;
+    yield.operand = target;
+    return yield;
+}
+
+SecureProgram::~SecureProgram() {
+    Release();
+}
+
+void SecureProgram::Release() {
+    if (arena_ != nullptr) {
+        SecureZeroMemory(arena_, arenaSize_);
+        VirtualUnlock(arena_, arenaSize_);
+        VirtualFree(arena_, 0, MEM_RELEASE);
+        arena_ = nullptr;
+        keystream_ = nullptr;
+    }
+    arenaSize_ = 0;
+    arenaInstructions_ = 0;
+
+    if (key_ != nullptr) {
+        BCryptDestroyKey(key_);
+        key_ = nullptr;
+    }
+    if (algorithm_ != nullptr) {
+        BCryptCloseAlgorithmProvider(algorithm_, 0);
+        algorithm_ = nullptr;
+    }
+
+    windows_.clear();
+    windowOfInstruction_.clear();
+    sealed_.clear();
+    verified_ = false;
+    nonce_ = 0;
+    decryptionCount_ = 0;
+}
+
+std::vector<uint32_t> SecureProgram::FindWindowStarts(const Program& program, const SecureProgramConfig& config) {
+    const DecodedInstruction* code = program.GetInstructions();
+    const uint32_t count = static_cast<uint32_t>(program.GetInstructionCount());
+    std::vector<uint32_t> starts;
+
+    if (config.granularity == DecryptionGranularity::Instruction ||
+        config.granularity == DecryptionGranularity::CacheLine) {
+        const uint32_t step = config.granularity == DecryptionGranularity::Instruction ? 1 : CACHE_LINE_INSTRUCTIONS;
+        for (uint32_t index = 0; index < count; index += step) {
+            starts.push_back(index);
+        }
+        starts.push_back(count);
+        return starts;
+    }
+
+    // Leaders: the entry point, every branch target and every instruction after a branch
+    std::vector<bool> leader(count + 1, false);
+    leader[0] = true;
+    for (uint32_t index = 0; index < count; ++index) {
+        if (IsBranch(code[index].handler)) {
+            leader[static_cast<size_t>(code[index].operand)] = true;
+        }
+        if (EndsBlock(code[index].handler)) {
+            leader[index + 1] = true;
+        }
+    }
+
+    const uint32_t maxBlock = config.maxBlockInstructions == 0 ? 1 : config.maxBlockInstructions;
+    uint32_t blockStart = 0;
+    for (uint32_t index = 0; index < count; ++index) {
+        if (leader[index] || index - blockStart == maxBlock) {
+            starts.push_back(index);
+            blockStart = index;
+        }
+    }
+    starts.push_back(count);
+    return starts;
+}
+
+bool SecureProgram::Seal(const Program& program, const SecureProgramConfig& config) {
+    Release();
+
+    if (!program.IsValid()) {
+        Utils::Logger::LogError("SecureProgram::Seal: program is not decoded");
+        return false;
+    }
+
+    const DecodedInstruction* code = program.GetInstructions();
+    const uint32_t count = static_cast<uint32_t>(program.GetInstructionCount());
+    const std::vector<uint32_t> starts = FindWindowStarts(program, config);
+
+    // Build the window images: the window's instructions, a Yield for falling off its
+    // end, then one Yield stub per distinct target outside the window
+    // Reserved for the worst case - every instruction a branch leaving its window - so the
+    // plaintext is never reallocated, which would leave an unwiped copy behind
+    std::pmr::vector<DecodedInstruction> image(sealed_.get_allocator());
+    image.reserve(2 * static_cast<size_t>(count) + (starts.size() - 1));
+    const size_t reserved = image.capacity();
+    windowOfInstruction_.resize(count);
+    uint32_t largestImage = 0;
+
+    for (size_t w = 0; w + 1 < starts.size(); ++w) {
+        const uint32_t begin = starts[w];
+        const uint32_t end = starts[w + 1];
+        const uint32_t imageIndex = static_cast<uint32_t>(image.size());
+
+        image.insert(image.end(), code + begin, code + end);
+        image.push_back(MakeYield(end, code[end - 1].sourceOffset));
+
+        // A superinstruction reads the slots after it, so one that would run past the
+        // window falls back to its first plain instruction (always a LoadReg)
+        for (uint32_t local = 0; local < end - begin; ++local) {
+            DecodedInstruction& instruction = image[imageIndex + local];
+            if (local + GetHandlerSpan(instruction.handler) > end - begin) {
+                instruction.handler = HandlerId::LoadReg;
+            }
+        }
+
+        for (uint32_t local = 0; local < end - begin; ++local) {
+            DecodedInstruction& instruction = image[imageIndex + local];
+            if (!IsBranch(instruction.handler)) {
+                continue;
+            }
+            const uint32_t target = static_cast<uint32_t>(instruction.operand);
+            if (target >= begin && target < end) {
+                instruction.operand = target - begin;
+                continue;
+            }
+            // Reuse the fall-through Yield or an earlier stub with the same target
+            uint32_t stub = static_cast<uint32_t>(image.size()) - imageIndex;
+            for (uint32_t candidate = end - begin; candidate < stub; ++candidate) {
+                if (image[imageIndex + candidate].operand == target) {
+                    stub = candidate;
+                    break;
+                }
+            }
+            if (stub == image.size() - imageIndex) {
+                image.push_back(MakeYield(target, instruction.sourceOffset));
+            }
+            image[imageIndex + local].operand = stub;
+        }
+
+        Window window{};
+        window.begin = begin;
+        window.count = end - begin;
+        window.imageIndex = imageIndex;
+        window.imageCount = static_cast<uint32_t>(image.size()) - imageIndex;
+        largestImage = std::max(largestImage, window.imageCount);
+        for (uint32_t index = begin; index < end; ++index) {
+            windowOfInstruction_[index] = static_cast<uint32_t>(windows_.size());
+        }
+        windows_.push_back(window);
+    }
+
+    if (image.capacity() != reserved) {
+        // Cannot happen with the bound above; refuse rather than leave plaintext behind
+        Utils::Logger::LogError("SecureProgram::Seal: window image outgrew its reservation");
+        SecureZeroMemory(image.data(), image.size() * sizeof(DecodedInstruction));
+        Release();
+        return false;
+    }
+
+    // Key and nonce come from the system RNG; the raw key exists only for the import
+    NTSTATUS status = BCryptOpenAlgorithmProvider(&algorithm_, BCRYPT_AES_ALGORITHM, nullptr, 0);
+    if (BCRYPT_SUCCESS(status)) {
+        status = BCryptSetProperty(algorithm_, BCRYPT_CHAINING_MODE,
+                                   reinterpret_cast<PUCHAR>(const_cast<wchar_t*>(BCRYPT_CHAIN_MODE_ECB)),
+                                   sizeof(BCRYPT_CHAIN_MODE_ECB), 0);
+    }
+    uint8_t keyBytes[AES_KEY_BYTES];
+    if (BCRYPT_SUCCESS(status)) {
+        status = BCryptGenRandom(nullptr, keyBytes, AES_KEY_BYTES, BCRYPT_USE_SYSTEM_PREFERRED_RNG);
+    }
+    if (BCRYPT_SUCCESS(status)) {
+        status = BCryptGenRandom(nullptr, reinterpret_cast<PUCHAR>(&nonce_), sizeof(nonce_),
+                                 BCRYPT_USE_SYSTEM_PREFERRED_RNG);
+    }
+    if (BCRYPT_SUCCESS(status)) {
+        status = BCryptGenerateSymmetricKey(algorithm_, &key_, nullptr, 0, keyBytes, AES_KEY_BYTES, 0);
+    }
+    SecureZeroMemory(keyBytes, sizeof(keyBytes));
+    if (!BCRYPT_SUCCESS(status)) {
+        Utils::Logger::Error("SecureProgram::Seal: AES key setup failed (0x{:08X})", static_cast<uint32_t>(status));
+        SecureZeroMemory(image.data(), image.size() * sizeof(DecodedInstruction));
+        Release();
+        return false;
+    }
+
+    // Arena: the largest window image followed by an equally sized keystream buffer
+    const size_t windowBytes = static_cast<size_t>(largestImage) * sizeof(DecodedInstruction);
+    arenaSize_ = (2 * windowBytes + ARENA_PAGE_SIZE - 1) & ~(ARENA_PAGE_SIZE - 1);
+    arena_ = static_cast<DecodedInstruction*>(VirtualAlloc(nullptr, arenaSize_, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+    if (arena_ == nullptr) {
+        Utils::Logger::Error("SecureProgram::Seal: VirtualAlloc of {} bytes failed ({})", arenaSize_, GetLastError());
+        SecureZeroMemory(image.data(), image.size() * sizeof(DecodedInstruction));
+        Release();
+        return false;
+    }
+    // Locked so decrypted instructions are never written to the page file
+    if (!VirtualLock(arena_, arenaSize_)) {
+        Utils::Logger::Error("SecureProgram::Seal: VirtualLock failed ({})", GetLastError());
+        SecureZeroMemory(image.data(), image.size() * sizeof(DecodedInstruction));
+        Release();
+        return false;
+    }
+    keystream_ = reinterpret_cast<uint8_t*>(arena_) + windowBytes;
+    arenaInstructions_ = largestImage;
+
+    // Encrypt in place, one arena-sized chunk of keystream at a time
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(image.data());
+    for (size_t index = 0; index < image.size(); index += arenaInstructions_) {
+        const uint32_t chunk = static_cast<uint32_t>(std::min<size_t>(arenaInstructions_, image.size() - index));
+        if (!GenerateKeystream(static_cast<uint32_t>(index), chunk, keystream_)) {
+            SecureZeroMemory(image.data(), image.size() * sizeof(DecodedInstruction));
+            Release();
+            return false;
+        }
+        uint8_t* block = bytes + index * AES_BLOCK_BYTES;
+        for (size_t i = 0; i < chunk * AES_BLOCK_BYTES; ++i) {
+            block[i] ^= keystream_[i];
+        }
+    }
+    SecureZeroMemory(keystream_, windowBytes);
+
+    sealed_ = std::move(image);
+    verified_ = program.IsVerified();
+    return true;
+}
+
+bool SecureProgram::GenerateKeystream(uint32_t imageIndex, uint32_t count, uint8_t* keystream) const {
+    // Counter block of sealed instruction i: the nonce, then i
+    const ULONG length = count * static_cast<ULONG>(AES_BLOCK_BYTES);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint64_t counter = static_cast<uint64_t>(imageIndex) + i;
+        std::memcpy(keystream + i * AES_BLOCK_BYTES, &nonce_, sizeof(nonce_));
+        std::memcpy(keystream + i * AES_BLOCK_BYTES + sizeof(nonce_), &counter, sizeof(counter));
+    }
+
+    ULONG written = 0;
+    const NTSTATUS status =
+        BCryptEncrypt(key_, keystream, length, nullptr, nullptr, 0, keystream, length, &written, 0);
+    if (!BCRYPT_SUCCESS(status) || written != length) {
+        SecureZeroMemory(keystream, length);
+        Utils::Logger::Error("SecureProgram: keystream generation failed (0x{:08X})", static_cast<uint32_t>(status));
+        return false;
+    }
+    return true;
+}
+
+bool SecureProgram::DecryptWindow(const Window& window) {
+    if (!GenerateKeystream(window.imageIndex, window.imageCount, keystream_)) {
+        return false;
+    }
+
+    const size_t length = static_cast<size_t>(window.imageCount) * AES_BLOCK_BYTES;
+    const uint8_t* source = reinterpret_cast<const uint8_t*>(sealed_.data() + window.imageIndex);
+    uint8_t* target = reinterpret_cast<uint8_t*>(arena_);
+    for (size_t i = 0; i < length; i += sizeof(uint64_t)) {
+        uint64_t cipher;
+        uint64_t key;
+        std::memcpy(&cipher, source + i, sizeof(cipher));
+        std::memcpy(&key, keystream_ + i, sizeof(key));
+        cipher ^= key;
+        std::memcpy(target + i, &cipher, sizeof(cipher));
+    }
+    SecureZeroMemory(keystream_, length);
+
+    ++decryptionCount_;
+    return true;
+}
+
+ExecutionResult SecureProgram::Execute(Interpreter& vm) {
+    Utils::ScopedTimer timer(executeTime);
+    ExecutionResult result;
+    if (windows_.empty()) {
+        return result;
+    }
+
+    vm.Reset();
+    uint64_t next = 0;
+    for (;;) {
+        if (next >= windowOfInstruction_.size()) {
+            result = ExecutionResult{};
+            break;
+        }
+        const Window& window = windows_[windowOfInstruction_[static_cast<size_t>(next)]];
+        if (!DecryptWindow(window)) {
+            result = ExecutionResult{};
+            break;
+        }
+
+        result = vm.Run(arena_, window.begin, window.count, static_cast<uint32_t>(next) - window.begin, !verified_);
+        SecureZeroMemory(arena_, static_cast<size_t>(window.imageCount) * sizeof(DecodedInstruction));
+
+        if (result.status != VmStatus::Yielded) {
+            break;
+        }
+        next = result.value;
+    }
+    return result;
+}
+
+} // namespace Virtualization
+} // namespace Sentinel
@@ -0,0 +1,194 @@
+/**
+ * @file SecureProgram.hpp
+ * @brief Encrypted-at-rest VM program executed window by window from a locked arena.
+ *
+ * @details Module C keeps integrity check bytecode encrypted in memory and decrypts only
+ * what is about to run. The original plan decrypted a single instruction per
+ * STATUS_GUARD_PAGE_VIOLATION, which costs a kernel exception round trip - microseconds -
+ * for every VM instruction. SecureProgram keeps the confidentiality guarantee but decrypts
+ * explicitly, one window at a time, and never takes an exception:
+ * 1. Seal splits a decoded program into windows of the configured granularity, rewrites
+ *    every branch that leaves its window into a Yield stub, and encrypts the result with
+ *    AES-256 in counter mode under a per-program random key.
+ * 2. Execute decrypts the window holding the next instruction into a small VirtualLock'ed
+ *    scratch arena, runs it, wipes the arena with SecureZeroMemory, and continues with
+ *    the window named by the Yield that ended it.
+ *
+ * The granularity is the security/performance tradeoff:
+ * | Granularity | Plaintext exposed at once           | Decryptions                   |
+ * |-------------|-------------------------------------|-------------------------------|
+ * | Instruction | 1 instruction                       | one per executed instruction  |
+ * | CacheLine   | 4 instructions (64 bytes)           | about one per 4 instructions  |
+ * | BasicBlock  | one block (<= maxBlockInstructions) | one per block entered         |
+ *
+ * A loop whose body is a single basic block runs entirely inside one decryption, so
+ * BasicBlock is the production setting; Instruction reproduces the original exposure
+ * profile for high-value checks.
+ *
+ * @security Seal encrypts its working copy in place, sized up front so it is never
+ * reallocated, so no plaintext survives in the SecureProgram; the caller should discard
+ * its Program. When both live in a Utils::Arena, the arena zeroes the Program's storage
+ * as it is freed, so sharing an arena with longer-lived data is safe. Counter mode lets any window be
+ * decrypted independently; the counter is the window's position in the sealed image, so
+ * no two windows share keystream. The key lives only inside the CNG key object. Window
+ * boundaries (not contents) are stored in the clear.
+ *
+ * @performance One BCryptEncrypt call per window generates its keystream with AES-NI;
+ * there are no system calls or exceptions on the execution path.
+ *
+ * @see Interpreter
+ * @see CrashInterceptor::HandlerRoutine
+ */
+
+#pragma once
+
+#include "Sentinel/Virtualization/Bytecode.hpp"
+#include "Sentinel/Virtualization/Interpreter.hpp"
+#include <Windows.h>
+#include <bcrypt.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace Sentinel {
+namespace Virtualization {
+
+/**
+ * @brief How much of a sealed program is decrypted at once.
+ */
+enum class DecryptionGranularity : uint8_t {
+    /** @brief Every instruction is its own window. */
+    Instruction = 0,
+
+    /** @brief Windows are aligned groups of four instructions (one 64-byte line). */
+    CacheLine = 1,
+
+    /** @brief Windows are basic blocks, split at maxBlockInstructions. */
+    BasicBlock = 2
+};
+
+/**
+ * @brief Configuration for SecureProgram::Seal.
+ */
+struct SecureProgramConfig {
+    DecryptionGranularity granularity = DecryptionGranularity::BasicBlock;
+
+    /** @brief Longest window in BasicBlock mode; longer blocks are split. */
+    uint32_t maxBlockInstructions = 64;
+};
+
+/**
+ * @class SecureProgram
+ * @brief Holds a program encrypted and runs it through a wiped scratch arena.
+ *
+ * Usage example:
+ * @code
+ * SecureProgram sealed;
+ * if (!sealed.Seal(program)) {
+ *     return false;
+ * }
+ * ExecutionResult result = sealed.Execute(vm);
+ * @endcode
+ *
+ * @threadsafe Not thread-safe: Execute uses a single scratch arena. Use one SecureProgram
+ * per executing thread.
+ */
+class SecureProgram {
+public:
+    SecureProgram() = default;
+
+    /**
+     * @brief Creates an empty sealed program whose encrypted image is allocated from
+     * @p resource (typically the Utils::Arena that holds the plain programs).
+     */
+    explicit SecureProgram(std::pmr::memory_resource* resource) : sealed_(resource) {}
+
+    /**
+     * @brief Wipes and frees the arena and destroys the key.
+     */
+    ~SecureProgram();
+
+    SecureProgram(const SecureProgram&) = delete;
+    SecureProgram& operator=(const SecureProgram&) = delete;
+
+    /**
+     * @brief Encrypts @p program into windows of the configured granularity.
+     *
+     * @details The caller should discard its own copy of @p program afterwards.
+     *
+     * @return false (and logs) if the program is invalid or a CNG or memory call fails.
+     */
+    bool Seal(const Program& program, const SecureProgramConfig& config = SecureProgramConfig{});
+
+    /**
+     * @brief Runs the sealed program on @p vm from its first instruction.
+     *
+     * @return VmStatus::InvalidProgram if nothing is sealed or a window fails to decrypt.
+     */
+    ExecutionResult Execute(Interpreter& vm);
+
+    /** @brief Number of windows the program was split into. */
+    size_t GetWindowCount() const noexcept { return windows_.size(); }
+
+    /** @brief Windows decrypted since sealing. */
+    uint64_t GetDecryptionCount() const noexcept { return decryptionCount_; }
+
+private:
+    /**
+     * @brief One window: program instructions [begin, begin + count) plus Yield stubs,
+     * stored at sealed_[imageIndex, imageIndex + imageCount).
+     */
+    struct Window {
+        uint32_t begin;
+        uint32_t count;
+        uint32_t imageIndex;
+        uint32_t imageCount;
+    };
+
+    /**
+     * @brief Returns the first instruction of every window in ascending order, followed
+     * by the program's instruction count.
+     */
+    static std::vector<uint32_t> FindWindowStarts(const Program& program, const SecureProgramConfig& config);
+
+    /**
+     * @brief Generates keystream for sealed instructions [imageIndex, imageIndex + count)
+     * into @p keystream.
+     */
+    bool GenerateKeystream(uint32_t imageIndex, uint32_t count, uint8_t* keystream) const;
+
+    /**
+     * @brief Decrypts @p window into the arena.
+     */
+    bool DecryptWindow(const Window& window);
+
+    /**
+     * @brief Destroys the key, wipes and frees the arena and forgets the sealed image.
+     */
+    void Release();
+
+    std::vector<Window> windows_;
+
+    // Index into windows_ of the window holding each program instruction
+    std::vector<uint32_t> windowOfInstruction_;
+
+    // Encrypted window images, one 16-byte AES block per instruction
+    std::pmr::vector<DecodedInstruction> sealed_;
+    bool verified_ = false;
+
+    BCRYPT_ALG_HANDLE algorithm_ = nullptr;
+    BCRYPT_KEY_HANDLE key_ = nullptr;
+    uint64_t nonce_ = 0;
+
+    // Locked scratch memory: decrypted window, then keystream of the same size
+    DecodedInstruction* arena_ = nullptr;
+    uint8_t* keystream_ = nullptr;
+    size_t arenaSize_ = 0;
+    uint32_t arenaInstructions_ = 0;
+
+    uint64_t decryptionCount_ = 0;
+};
+
+} // namespace Virtualization
+} // namespace Sentinel
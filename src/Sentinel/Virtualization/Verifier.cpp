@@ -0,0 +1,294 @@
+/**
+ * @file Verifier.cpp
+ * @brief Implementation of the load-time verifier and superinstruction fusion.
+ */
+
+#include "Sentinel/Virtualization/Verifier.hpp"
+#include "Sentinel/Virtualization/Interpreter.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <unordered_map>
+#include <vector>
+
+namespace Sentinel {
+namespace Virtualization {
+
+namespace {
+
+struct StackEffect {
+    int32_t pops;
+    int32_t pushes;
+};
+
+// Stack effect per handler; internal handlers never reach the verifier
+constexpr std::array<StackEffect, static_cast<size_t>(HandlerId::Count)> BuildEffectTable() {
+    std::array<StackEffect, static_cast<size_t>(HandlerId::Count)> table{};
+#define SENTINEL_VM_OPCODE_EFFECT(name, encoding, operand, pops, pushes) \
+    table[static_cast<size_t>(HandlerId::name)] = {pops, pushes};
+    SENTINEL_VM_OPCODES(SENTINEL_VM_OPCODE_EFFECT)
+#undef SENTINEL_VM_OPCODE_EFFECT
+    return table;
+}
+
+constexpr std::array<StackEffect, static_cast<size_t>(HandlerId::Count)> EFFECT_TABLE = BuildEffectTable();
+
+// First handler number that has no bytecode encoding
+constexpr HandlerId FIRST_INTERNAL_HANDLER = HandlerId::Yield;
+
+constexpr int32_t UNVISITED = INT32_MIN;
+
+/**
+ * @brief Proven properties of one function (or of the entry code), relative to the stack
+ * depth at its entry.
+ */
+struct FunctionSummary {
+    bool complete = false;
+
+    // Lowest and highest depth reached, including inside callees
+    int32_t low = 0;
+    int32_t high = 0;
+
+    // Depth at every Ret; meaningful only if returns
+    int32_t net = 0;
+    bool returns = false;
+
+    uint32_t callDepth = 0;
+};
+
+/**
+ * @brief Abstract interpretation of stack depth over one program.
+ */
+class StackAnalysis {
+public:
+    StackAnalysis(const DecodedInstruction* code, uint32_t count) : code_(code), count_(count) {}
+
+    /**
+     * @brief Analyzes the function entered at @p entry; @p nesting is its call depth.
+     */
+    bool Analyze(uint32_t entry, uint32_t nesting, bool isEntryCode, FunctionSummary& summary);
+
+    size_t GetFunctionCount() const noexcept { return functions_.size(); }
+
+private:
+    bool Fail(uint32_t index, const char* reason) const {
+        Utils::Logger::Error("Verifier: {} at offset {}", reason, code_[index].sourceOffset);
+        return false;
+    }
+
+    const DecodedInstruction* code_;
+    uint32_t count_;
+    std::unordered_map<uint32_t, FunctionSummary> functions_;
+};
+
+bool StackAnalysis::Analyze(uint32_t entry, uint32_t nesting, bool isEntryCode, FunctionSummary& summary) {
+    // Bounding the nesting here also bounds the recursion of this analysis
+    if (nesting > Interpreter::CALL_DEPTH) {
+        return Fail(entry, "call nesting exceeds the call stack");
+    }
+
+    std::vector<int32_t> depthAt(count_, UNVISITED);
+    std::vector<uint32_t> worklist;
+    depthAt[entry] = 0;
+    worklist.push_back(entry);
+
+    FunctionSummary result;
+    while (!worklist.empty()) {
+        const uint32_t index = worklist.back();
+        worklist.pop_back();
+        const DecodedInstruction& instruction = code_[index];
+        const int32_t depth = depthAt[index];
+
+        if (static_cast<uint32_t>(instruction.handler) >= static_cast<uint32_t>(FIRST_INTERNAL_HANDLER)) {
+            return Fail(index, "internal handler in an unverified program");
+        }
+        const StackEffect effect = EFFECT_TABLE[static_cast<size_t>(instruction.handler)];
+        result.low = std::min(result.low, depth - effect.pops);
+        const int32_t after = depth - effect.pops + effect.pushes;
+        result.high = std::max(result.high, after);
+
+        // Successors inherit a depth; a second, different depth means the stack height
+        // would depend on the path taken
+        auto visit = [&](uint64_t successor, int32_t successorDepth) {
+            if (successor >= count_) {
+                return Fail(index, "branch target outside the program");
+            }
+            int32_t& known = depthAt[static_cast<size_t>(successor)];
+            if (known == UNVISITED) {
+                known = successorDepth;
+                worklist.push_back(static_cast<uint32_t>(successor));
+            } else if (known != successorDepth) {
+                return Fail(static_cast<uint32_t>(successor), "inconsistent stack depth");
+            }
+            return true;
+        };
+
+        bool ok = true;
+        switch (instruction.handler) {
+        case HandlerId::Halt:
+            break;
+        case HandlerId::Ret:
+            if (isEntryCode) {
+                return Fail(index, "Ret outside a called function");
+            }
+            if (result.returns && result.net != depth) {
+                return Fail(index, "returns with inconsistent stack depth");
+            }
+            result.returns = true;
+            result.net = depth;
+            break;
+        case HandlerId::Jmp:
+            ok = visit(instruction.operand, after);
+            break;
+        case HandlerId::Jz:
+        case HandlerId::Jnz:
+            ok = visit(instruction.operand, after) && visit(index + 1ull, after);
+            break;
+        case HandlerId::Call: {
+            const uint32_t target = static_cast<uint32_t>(instruction.operand);
+            if (target >= count_) {
+                return Fail(index, "call target outside the program");
+            }
+            auto known = functions_.find(target);
+            if (known == functions_.end()) {
+                // Inserted incomplete first, so a call back into it is detected as recursion
+                functions_.emplace(target, FunctionSummary{});
+                FunctionSummary callee;
+                if (!Analyze(target, nesting + 1, false, callee)) {
+                    return false;
+                }
+                known = functions_.find(target);
+                known->second = callee;
+            } else if (!known->second.complete) {
+                return Fail(index, "recursive call");
+            }
+            const FunctionSummary& callee = known->second;
+            result.low = std::min(result.low, depth + callee.low);
+            result.high = std::max(result.high, depth + callee.high);
+            result.callDepth = std::max(result.callDepth, callee.callDepth + 1);
+            // A callee that only halts never comes back
+            if (callee.returns) {
+                ok = visit(index + 1ull, depth + callee.net);
+            }
+            break;
+        }
+        default:
+            ok = visit(index + 1ull, after);
+            break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+
+    result.complete = true;
+    summary = result;
+    return true;
+}
+
+} // namespace
+
+bool Verifier::Verify(Program& program, VerificationReport* report) {
+    if (!program.IsValid()) {
+        Utils::Logger::LogError("Verifier: program is not decoded");
+        return false;
+    }
+    if (program.IsVerified()) {
+        return true;
+    }
+
+    const uint32_t count = static_cast<uint32_t>(program.instructions_.size());
+    StackAnalysis analysis(program.instructions_.data(), count);
+    FunctionSummary entry;
+    if (!analysis.Analyze(0, 0, true, entry)) {
+        return false;
+    }
+    if (entry.low < 0) {
+        Utils::Logger::LogError("Verifier: operand stack underflow is reachable");
+        return false;
+    }
+    if (entry.high > static_cast<int32_t>(Interpreter::STACK_CAPACITY)) {
+        Utils::Logger::Error("Verifier: stack depth {} exceeds the capacity of {}", entry.high,
+                             Interpreter::STACK_CAPACITY);
+        return false;
+    }
+    if (entry.callDepth > Interpreter::CALL_DEPTH) {
+        Utils::Logger::Error("Verifier: call depth {} exceeds the call stack", entry.callDepth);
+        return false;
+    }
+
+    const uint32_t fused = Fuse(program.instructions_.data(), count);
+    program.verified_ = true;
+
+    if (report != nullptr) {
+        report->maxStackDepth = static_cast<uint32_t>(entry.high);
+        report->maxCallDepth = entry.callDepth;
+        report->functionCount = static_cast<uint32_t>(analysis.GetFunctionCount()) + 1;
+        report->fusedCount = fused;
+    }
+    return true;
+}
+
+uint32_t Verifier::Fuse(DecodedInstruction* code, uint32_t count) {
+    // Patterns are matched on the original handlers, so a slot already covered by a
+    // superinstruction may still start another one: fused handlers read only operands
+    auto matches = [code, count](uint32_t at, std::initializer_list<HandlerId> sequence) {
+        if (at + sequence.size() > count) {
+            return false;
+        }
+        uint32_t index = at;
+        for (HandlerId handler : sequence) {
+            if (code[index++].handler != handler) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    uint32_t fused = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        // LoadReg a; Push k; Add; Dup; StoreReg a; LoadReg b; LtU; Jnz t
+        if (matches(i, {HandlerId::LoadReg, HandlerId::Push, HandlerId::Add, HandlerId::Dup, HandlerId::StoreReg,
+                        HandlerId::LoadReg, HandlerId::LtU, HandlerId::Jnz}) &&
+            code[i + 4].operand == code[i].operand) {
+            code[i].handler = HandlerId::IncJltReg;
+            ++fused;
+            continue;
+        }
+        // LoadReg h; LoadReg p; Load8; Xor; Push r; Rotl; Push m; Mul; StoreReg h
+        if (matches(i, {HandlerId::LoadReg, HandlerId::LoadReg, HandlerId::Load8, HandlerId::Xor, HandlerId::Push,
+                        HandlerId::Rotl, HandlerId::Push, HandlerId::Mul, HandlerId::StoreReg}) &&
+            code[i + 8].operand == code[i].operand) {
+            code[i].handler = HandlerId::HashStepByte;
+            ++fused;
+            continue;
+        }
+        // LoadReg a; Push k; Add; StoreReg a
+        if (matches(i, {HandlerId::LoadReg, HandlerId::Push, HandlerId::Add, HandlerId::StoreReg}) &&
+            code[i + 3].operand == code[i].operand) {
+            code[i].handler = HandlerId::AddRegImm;
+            ++fused;
+        }
+    }
+
+    // A hash step followed by "p += 1; loop while p < end" back to the step is a whole loop
+    constexpr uint32_t STEP_SPAN = GetHandlerSpan(HandlerId::HashStepByte);
+    for (uint32_t i = 0; i + STEP_SPAN < count; ++i) {
+        if (code[i].handler != HandlerId::HashStepByte || code[i + STEP_SPAN].handler != HandlerId::IncJltReg) {
+            continue;
+        }
+        const DecodedInstruction* tail = code + i + STEP_SPAN;
+        const uint64_t hash = code[i].operand;
+        const uint64_t pointer = code[i + 1].operand;
+        const uint64_t end = tail[5].operand;
+        if (tail[0].operand == pointer && tail[1].operand == 1 && tail[7].operand == i && hash != pointer &&
+            hash != end && pointer != end) {
+            code[i].handler = HandlerId::HashLoopByte;
+        }
+    }
+    return fused;
+}
+
+} // namespace Virtualization
+} // namespace Sentinel
@@ -0,0 +1,93 @@
+/**
+ * @file Verifier.hpp
+ * @brief Load-time safety proof and superinstruction fusion for decoded VM programs.
+ *
+ * @details Checking stack depth before every push and pop costs a compare and a branch per
+ * VM instruction, on every execution, for properties that do not depend on input data.
+ * Verifier proves them once when a program is loaded:
+ * - Every instruction is reached with one fixed stack depth, whichever path leads to it,
+ *   so a loop cannot grow or shrink the stack per iteration.
+ * - No instruction pops below the bottom of the stack or pushes past
+ *   Interpreter::STACK_CAPACITY, including through calls: each Call target is analyzed
+ *   as a function with its own relative stack bounds and net stack effect, which its
+ *   callers then apply.
+ * - Calls are not recursive and nest at most Interpreter::CALL_DEPTH deep, and the entry
+ *   code never executes Ret.
+ * - Every branch target is an instruction of the program.
+ *
+ * A verified program is then rewritten with superinstructions (see
+ * SENTINEL_VM_INTERNAL_HANDLERS) for the sequences integrity checks spend their time in:
+ * register increments, load-add-compare-branch loop tails, and byte hash updates, up to
+ * a complete byte hash loop executed as one native loop.
+ *
+ * Memory bounds cannot be proven at load time: load addresses are host pointers computed
+ * at run time. Loads therefore keep their single region check; a fused hash loop checks
+ * its whole byte range once instead of once per byte.
+ *
+ * @see Interpreter
+ * @see SENTINEL_VM_INTERNAL_HANDLERS
+ */
+
+#pragma once
+
+#include "Sentinel/Virtualization/Bytecode.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace Sentinel {
+namespace Virtualization {
+
+/**
+ * @brief What Verifier::Verify proved and changed.
+ */
+struct VerificationReport {
+    /** @brief Deepest operand stack any execution can reach. */
+    uint32_t maxStackDepth = 0;
+
+    /** @brief Deepest call nesting any execution can reach. */
+    uint32_t maxCallDepth = 0;
+
+    /** @brief Number of analyzed functions, including the entry code. */
+    uint32_t functionCount = 0;
+
+    /** @brief Number of installed superinstructions. */
+    uint32_t fusedCount = 0;
+};
+
+/**
+ * @class Verifier
+ * @brief Proves a decoded program's stack and call bounds and installs superinstructions.
+ *
+ * Usage example:
+ * @code
+ * Program program;
+ * if (!program.Decode(bytecode.data(), bytecode.size()) || !Verifier::Verify(program)) {
+ *     return false;
+ * }
+ * ExecutionResult result = vm.Execute(program); // runs without stack checks
+ * @endcode
+ *
+ * @threadsafe Verify modifies the program; it must not run concurrently with execution.
+ */
+class Verifier {
+public:
+    /**
+     * @brief Verifies @p program and, on success, marks it verified and fuses it.
+     *
+     * @param report Receives the proven bounds on success (optional).
+     * @return false (and logs the offending instruction) if any property does not hold;
+     *         the program is then left unchanged and unverified. Returns true at once for
+     *         an already verified program.
+     */
+    static bool Verify(Program& program, VerificationReport* report = nullptr);
+
+private:
+    /**
+     * @brief Installs superinstructions in a verified instruction stream.
+     * @return Number of superinstructions installed.
+     */
+    static uint32_t Fuse(DecodedInstruction* code, uint32_t count);
+};
+
+} // namespace Virtualization
+} // namespace Sentinel
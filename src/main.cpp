@@ -3,23 +3,59 @@
  * @brief Simple test application to demonstrate the Sentinel functionality.
  */
 
+#include "Sentinel/Utils/Bootstrap.hpp"
+#include "Sentinel/Utils/EtwTrace.hpp"
 #include "Sentinel/Utils/Logger.hpp"
+#include "Sentinel/Utils/ThreadPool.hpp"
 #include "Sentinel/Bedrock/CrashInterceptor.hpp"
+#include "Sentinel/Bedrock/StackTrace.hpp"
+#include "Sentinel/Internals/ResourceAuditor.hpp"
 #include <thread>
 #include <chrono>
 
 int main() {
     using namespace Sentinel::Utils;
     using namespace Sentinel::Bedrock;
+    using namespace Sentinel::Internals;
+    
+    // Declare every startup step; independent ones run concurrently on the shared pool
+    CrashInterceptor interceptor;
+    ResourceAuditor auditor;
+    Bootstrap bootstrap;
+    
+    // Required on this thread before Start, so the handler is in place before any other
+    // startup step runs; nothing else depends on it, so a failure here skips nothing
+    bootstrap.Add("crash-interceptor", {}, [&interceptor]() { return interceptor.Initialize(); });
+    
+    // Make log and crash events available to ETW sessions (no cost until one enables us)
+    bootstrap.Add("etw", {}, []() { return EtwTrace::Register(); });
+    
+    // Switch to asynchronous mode: log calls enqueue, a background thread writes
+    bootstrap.Add("console", {}, []() {
+        Logger::InitializeConsole();
+        return true;
+    });
+    bootstrap.Add("async-logger", {"console"}, []() { return Logger::EnableAsync(); });
+    
+    // Module B: resolve the native API now, take the first (largest) snapshot off the attach path
+    bootstrap.Add("auditor", {}, [&auditor]() { return auditor.Initialize(); });
+    bootstrap.Add("first-snapshot", {"auditor"}, [&auditor]() { return auditor.Snapshot(); },
+                  StartupMode::Deferred);
+    
+    // Symbols are only needed to render crash reports; warm them in the background
+    bootstrap.Add("symbols", {}, []() { return SymbolResolver::Preload(); }, StartupMode::Deferred);
+    
+    bootstrap.Require("crash-interceptor");
+    if (!bootstrap.Start()) {
+        Logger::LogError("Some startup steps failed; see above");
+    }
+    bootstrap.RunDeferred();
     
-    // Test basic logging
     Logger::LogInfo("Sentinel System Monitor - Build System Test");
     Logger::LogInfo("Testing thread-safe logger with colored output");
+    bootstrap.ReportTimings();
     
-    // Initialize Crash Interceptor
-    Logger::LogInfo("Initializing Crash Interceptor (Module A: Bedrock)...");
-    CrashInterceptor interceptor;
-    if (interceptor.Initialize()) {
+    if (bootstrap.GetState("crash-interceptor") == SubsystemState::Succeeded) {
         Logger::LogInfo("Crash Interceptor is now monitoring for critical exceptions");
     } else {
         Logger::LogError("Failed to initialize Crash Interceptor");
@@ -28,26 +64,37 @@ int main() {
     // Test error logging
     Logger::LogError("This is a test error message");
     
-    // Test multi-threaded logging
+    // Test multi-threaded logging (bench/SentinelStress runs this setup under sustained load)
     Logger::LogInfo("Starting multi-threaded test...");
     
     auto threadFunc = [](int id) {
         for (int i = 0; i < 3; ++i) {
-            Logger::LogInfo("Thread " + std::to_string(id) + " - Message " + std::to_string(i));
+            Logger::Info("Thread {} - Message {}", id, i);
             std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
     };
     
-    std::thread t1(threadFunc, 1);
-    std::thread t2(threadFunc, 2);
-    std::thread t3(threadFunc, 3);
-    
-    t1.join();
-    t2.join();
-    t3.join();
+    // Run the writers on the shared pool rather than on dedicated threads
+    ThreadPool& pool = ThreadPool::Shared();
+    Logger::Info("Shared thread pool running {} workers", pool.GetThreadCount());
+    pool.ParallelFor(3, 1, [&threadFunc](size_t begin, size_t end) {
+        for (size_t id = begin; id < end; ++id) {
+            threadFunc(static_cast<int>(id) + 1);
+        }
+    });
     
     Logger::LogInfo("Multi-threaded test completed successfully");
     Logger::LogInfo("Logger demonstration complete");
     
+    // Let the background startup steps finish before their output sinks go away
+    bootstrap.Require("first-snapshot");
+    bootstrap.Require("symbols");
+    bootstrap.ReportTimings();
+    
+    // Forward any pending crash records, then drain queued records and stop the consumer
+    CrashInterceptor::FlushCrashRecords();
+    Logger::Shutdown();
+    EtwTrace::Unregister();
+    
     return 0;
 }
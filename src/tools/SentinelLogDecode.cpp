@@ -0,0 +1,112 @@
+/**
+ * @file SentinelLogDecode.cpp
+ * @brief Offline decoder that renders Sentinel binary logs as text.
+ *
+ * @details Binary mode (Logger::EnableBinaryLog) moves formatting off the monitored
+ * process entirely; this tool performs it afterwards. Output lines carry the time since
+ * the file header was written, the thread id and the severity:
+ * @code
+ * [+0.001234s] [tid 4711] [INFO] Thread 1 - Message 0
+ * @endcode
+ *
+ * Usage: SentinelLogDecode <file>
+ */
+
+#include "Sentinel/Utils/BinaryLog.hpp"
+#include "Sentinel/Utils/Logger.hpp"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace Sentinel::Utils;
+
+static const char* LevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug:
+            return "DEBUG";
+        case LogLevel::Info:
+            return "INFO";
+        case LogLevel::Warning:
+            return "WARN";
+        case LogLevel::Error:
+            return "ERROR";
+        default:
+            return "?";
+    }
+}
+
+int wmain(int argc, wchar_t* argv[]) {
+    if (argc != 2) {
+        std::fprintf(stderr, "Usage: SentinelLogDecode <binary-log-file>\n");
+        return 1;
+    }
+
+    std::ifstream input(std::filesystem::path(argv[1]), std::ios::binary);
+    if (!input) {
+        std::fprintf(stderr, "Failed to open input file\n");
+        return 1;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    std::unordered_map<uint32_t, std::string> formats;
+    BinaryLogFileHeader header{};
+    bool haveHeader = false;
+    DecodedEvent event;
+    size_t offset = 0;
+    size_t decoded = 0;
+
+    while (offset < data.size()) {
+        // A file header may appear at any record boundary (one per appending session);
+        // format ids are per process, so each header starts a fresh format table
+        if (data.size() - offset >= sizeof(BinaryLogFileHeader) &&
+            std::memcmp(data.data() + offset, BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC)) == 0) {
+            std::memcpy(&header, data.data() + offset, sizeof(header));
+            formats.clear();
+            haveHeader = true;
+            offset += sizeof(header);
+            std::printf("--- session: pid %u ---\n", header.processId);
+            continue;
+        }
+
+        if (!haveHeader || data.size() - offset < 3) {
+            std::fprintf(stderr, "Malformed log at offset %zu\n", offset);
+            return 2;
+        }
+
+        uint16_t recordSize = 0;
+        std::memcpy(&recordSize, data.data() + offset, sizeof(recordSize));
+        if (recordSize < 3 || recordSize > data.size() - offset) {
+            std::fprintf(stderr, "Truncated record at offset %zu\n", offset);
+            return 2;
+        }
+        const uint8_t* record = data.data() + offset;
+        const auto type = static_cast<BinaryRecordType>(record[2]);
+
+        if (type == BinaryRecordType::FormatDefinition && recordSize >= 7) {
+            uint32_t id = 0;
+            std::memcpy(&id, record + 3, sizeof(id));
+            formats[id].assign(reinterpret_cast<const char*>(record + 7), recordSize - 7u);
+        } else if (type == BinaryRecordType::Event && BinaryLogDecoder::DecodeEvent(record, recordSize, event)) {
+            auto found = formats.find(event.formatId);
+            std::string text = (found != formats.end())
+                ? BinaryLogDecoder::FormatEvent(found->second, event.args)
+                : std::string("<unknown format ") + std::to_string(event.formatId) + ">";
+
+            const double seconds = header.qpcFrequency > 0
+                ? static_cast<double>(event.timestamp - header.qpcAtOpen) / static_cast<double>(header.qpcFrequency)
+                : 0.0;
+            std::printf("[+%.6fs] [tid %u] [%s] %s\n", seconds, event.threadId,
+                        LevelName(event.level), text.c_str());
+            ++decoded;
+        }
+        offset += recordSize;
+    }
+
+    std::fprintf(stderr, "Decoded %zu records\n", decoded);
+    return 0;
+}